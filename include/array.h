@@ -30,15 +30,10 @@ typedef struct inst array_data;
 typedef struct inst array_iter;
 
 /**
- * Arrays are implemented as AVL trees much like property directories
+ * Dictionaries are hash tables whose keys are put in order when needed.
+ * The details are private to array.c.
  */
-typedef struct array_tree_t {
-    struct array_tree_t *left;      /**< The left child node  */
-    struct array_tree_t *right;     /**< The right child node */
-    array_iter key;                 /**< Key for this node    */
-    array_data data;                /**< Data for this node   */
-    short height;                   /**< Height of node       */
-} array_tree;
+typedef struct array_dict_t array_dict;
 
 /**
  * Linked list node structure for stk_arrays. This is used to track what
@@ -75,7 +70,7 @@ typedef struct stk_array_t {
     int pinned;         /**< if pinned, don't dup array on changes */
     union {
         array_data *packed; /**< pointer to packed array */
-        array_tree *dict;   /**< pointer to dictionary AVL tree */
+        array_dict *dict;   /**< pointer to dictionary hash table */
     } data;                 /**< Two different array types */
     stk_array_list list_node; /**< list array is on, typically of all allocated
                                *   to a MUF program
@@ -962,6 +962,23 @@ void do_pose(dbref player, const char *message);
  */
 void do_process_status(dbref player);
 
+/**
+ * Implementation of the \@profile command
+ *
+ * Defined in wiz.c
+ *
+ * This controls the sampling profiler.  'arg' may be "start", "stop",
+ * "clear" or "write"; anything else shows whether the profiler is running
+ * and how many samples it has taken.  "write" saves the samples to the
+ * file named by the file_profile tune, in collapsed stack format.
+ *
+ * This does not do any permission checking.
+ *
+ * @param player the player doing the call
+ * @param arg the action to take
+ */
+void do_profile(dbref player, const char *arg);
+
 /**
  * Implementation of \@program
  *
@@ -22,6 +22,12 @@
 #define MUF_NOTE_PROP           "_note"             /**< Notes */
 #define MUF_VERSION_PROP        "_version"          /**< Version */
 
+/**
+ * Flag for do_compile's force_err_display that also lists how many
+ * optimizations of each kind were made.
+ */
+#define COMPILE_SHOW_OPTIMIZATIONS  2
+
 /**
  * @var IN_FOR
  *      integer primitive ID for FOR primitive
@@ -82,7 +88,9 @@ void clear_primitives(void);
  * @param descr the descriptor of the person compiling
  * @param in_player the player compiling
  * @param in_program the program to compile
- * @param force_err_disp boolean - true to always show compile errors
+ * @param force_err_disp boolean - true to always show compile errors.
+ *        COMPILE_SHOW_OPTIMIZATIONS may be or'ed in to also list the
+ *        optimizations made.
  */
 void do_compile(int descr, dbref in_player, dbref in_program,
                 int force_err_disp);
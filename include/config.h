@@ -68,6 +68,51 @@ typedef int dbref;  /**< Type wrapper for dbref - must support negatives */
  */
 #define SPAWN_HOST_RESOLVER
 
+/**
+ * Look up host names and ident user names from threads inside the server
+ * instead of in a separate fb-resolver process.  Host names are kept in a
+ * cache, connections from the same address share a lookup, and ident
+ * queries never hold anything up.
+ *
+ * This replaces SPAWN_HOST_RESOLVER, and is ignored on systems without
+ * POSIX threads.
+ */
+#define ASYNC_HOST_RESOLVER
+
+/**
+ * Use the Linux epoll interface for the network event loop instead of
+ * select().  With epoll, each connection is registered once and the cost
+ * of each pass through the main loop depends on how many connections are
+ * active rather than how many are connected.  It also lifts the
+ * FD_SETSIZE (usually 1024) limit on the number of connections.
+ *
+ * This is ignored on systems that do not have epoll.
+ */
+#define USE_EPOLL
+
+/**
+ * Keep a journal of changed objects between database dumps.  Every
+ * dump_journal_interval, the objects changed since the last look are
+ * appended to a journal file next to the output database; at startup,
+ * any journal is replayed on top of the database that was loaded.  This
+ * keeps the amount of work lost in a crash small without having to dump
+ * the whole database more often.
+ *
+ * This is ignored with DISKBASE and on Windows.
+ */
+#define DB_JOURNAL
+
+/**
+ * Dispatch MUF instructions through a table of computed goto labels
+ * ("threaded code") rather than a switch statement.  Each instruction
+ * jumps straight to the next one's handler, which branch predictors cope
+ * with much better than the single jump a switch compiles to.
+ *
+ * This needs the "labels as values" extension of GCC and Clang, and is
+ * ignored by other compilers.
+ */
+#define MUF_THREADED_DISPATCH
+
 /**
  * This is similar to the X-Forwarded-For request header in HTTP.
  * The purpose is to provide administrators running a FORWARDED
@@ -110,6 +155,38 @@ typedef int dbref;  /**< Type wrapper for dbref - must support negatives */
 #define MUF_RE_CACHE_ITEMS 64   /**< size of the regex cache */
 #define MATCH_ARR_SIZE 30       /**< size of the matches array */
 
+/* Defines for the MUF interpreter */
+#define MUF_SAFEPOINT_INTERVAL 1024 /**< max instructions between full checks */
+
+/* Defines for the sampling profiler */
+#define PROFILE_MAX_FRAMES 64   /**< max MUF or MPI frames kept per sample */
+#define PROFILE_MAX_STACKS 65536    /**< max different stacks counted */
+
+/* Defines for the SMTP_SEND mail queue */
+#define SMTP_QUEUE_MAX 64       /**< max mail jobs waiting to be sent */
+#define SMTP_QUEUE_TIMEOUT 300  /**< seconds a mail job may take to send */
+#define SMTP_QUEUE_WORKERS 2    /**< max mail jobs being sent at once */
+
+/* Defines for the in-server host resolver */
+#define RESOLVER_THREADS 4          /**< max host name lookups at once */
+#define RESOLVER_QUEUE_MAX 1024     /**< max connections being looked up */
+#define RESOLVER_CACHE_SIZE 8192    /**< max host names cached */
+#define RESOLVER_CACHE_TTL 86400    /**< seconds a host name is cached */
+#define RESOLVER_RETRY_TIME 1800    /**< seconds before retrying a failure */
+#define RESOLVER_IDENT_TIMEOUT 30   /**< seconds to wait for an ident reply */
+
+/* Defines for connection output */
+#define OUTPUT_BLOCK_SIZE 4096  /**< min bytes allocated per output block */
+#define OUTPUT_IOV_MAX 16       /**< max output blocks per writev() */
+
+/* Defines for the logger */
+#define LOG_BUFFER_SIZE 65536   /**< bytes of log lines waiting to be written */
+#define LOG_MAX_FILES 16        /**< max log files kept open at once */
+
+/* Defines for the binary database dump format */
+#define DB_BINARY_SECTION_SIZE 4096 /**< objects per section of a dump */
+#define DB_LOAD_THREADS 4       /**< max threads decoding a dump at startup */
+
 /* Database and server limits */
 #define MAX_COMMAND_LEN 2048    /**< max process_command arg length */
 #define MAX_COMPLEXITY 18       /**< max nested stackranges (CHECKARGS) */
@@ -212,6 +289,26 @@ typedef int dbref;  /**< Type wrapper for dbref - must support negatives */
 # define USE_SSL
 #endif
 
+#if defined(USE_EPOLL) && !defined(__linux__)
+# undef USE_EPOLL
+#endif
+
+#if defined(DB_JOURNAL) && (defined(DISKBASE) || defined(WIN32))
+# undef DB_JOURNAL
+#endif
+
+#if defined(ASYNC_HOST_RESOLVER) && (!defined(HAVE_PTHREAD_H) || defined(WIN32))
+# undef ASYNC_HOST_RESOLVER
+#endif
+
+#ifdef ASYNC_HOST_RESOLVER
+# undef SPAWN_HOST_RESOLVER
+#endif
+
+#if defined(MUF_THREADED_DISPATCH) && !defined(__GNUC__)
+# undef MUF_THREADED_DISPATCH
+#endif
+
 /*
  * Include all the good standard headers here.
  * Not anymore!
@@ -699,6 +699,8 @@ struct program_specific {
     struct line *first;         /**< first line */
     struct publics *pubs;       /**< public subroutine addresses */
     struct mcp_binding *mcpbinds;   /**< MCP message bindings. */
+    struct prop_cache *propcaches;  /**< Inline caches, sorted by address */
+    int propcachecount;             /**< Number of inline caches */
     struct timeval proftime;    /**< profiling time spent in this program. */
     time_t profstart;           /**< time when profiling started for this prog */
     unsigned int profuses;      /**< \#calls to this program while profiling */
@@ -723,7 +725,7 @@ struct program_specific {
  * @param x the program to initialize a program specific structure for
  */
 #define ALLOC_PROGRAM_SP(x)     { \
-    PROGRAM_SP(x) = malloc(sizeof(struct program_specific)); \
+    PROGRAM_SP(x) = calloc(1, sizeof(struct program_specific)); \
 }
 
 /**
@@ -1155,6 +1157,36 @@ struct program_specific {
  */
 #define PROGRAM_MCPBINDS(x)         (PROGRAM_SP(x)->mcpbinds)
 
+/**
+ * Getter for a program specific field
+ *
+ * The field fetched is obviously named as the section after PROGRAM_
+ * Forgive the generic comment -- there are a million of these and they
+ * all work the same.
+ *
+ * This does not check for nulls, so it will segfault if the program specific
+ * pointer is NULL.
+ *
+ * @param x the program to fetch the field for
+ * @return the contents of the field
+ */
+#define PROGRAM_PROPCACHES(x)       (PROGRAM_SP(x)->propcaches)
+
+/**
+ * Getter for a program specific field
+ *
+ * The field fetched is obviously named as the section after PROGRAM_
+ * Forgive the generic comment -- there are a million of these and they
+ * all work the same.
+ *
+ * This does not check for nulls, so it will segfault if the program specific
+ * pointer is NULL.
+ *
+ * @param x the program to fetch the field for
+ * @return the contents of the field
+ */
+#define PROGRAM_PROPCACHECOUNT(x)   (PROGRAM_SP(x)->propcachecount)
+
 /**
  * Setter for a program specific field
  *
@@ -1171,6 +1203,23 @@ struct program_specific {
  */
 #define PROGRAM_SET_MCPBINDS(x,y)   (PROGRAM_SP(x)->mcpbinds = y)
 
+/**
+ * Setter for a program specific field
+ *
+ * The field set is obviously named as the section after PROGRAM_
+ * Forgive the generic comment -- there are a million of these and they
+ * all work the same.
+ *
+ * This does not check for nulls, so it will segfault if the program specific
+ * pointer is NULL.
+ *
+ * @param x the program to fetch the field for
+ * @param y the value to set
+ * @param z the number of caches in 'y'
+ */
+#define PROGRAM_SET_PROPCACHES(x,y,z) \
+    (PROGRAM_SP(x)->propcaches = y, PROGRAM_SP(x)->propcachecount = z)
+
 /**
  * Players an things share the same _specific structure at this time.
  * Probably to help support zombies.
@@ -1255,7 +1304,7 @@ struct player_specific {
  * @param y the value to set
  * @return the contents of the field
  */
-#define THING_SET_HOME(x,y)     (PLAYER_SP(x)->home = y)
+#define THING_SET_HOME(x,y)     db_set_home(x, y)
 
 /**
  * Fetch an object's player specific structure
@@ -1461,7 +1510,7 @@ struct player_specific {
  * @param y the value to set
  * @return the contents of the field
  */
-#define PLAYER_SET_HOME(x,y)        (PLAYER_SP(x)->home = y)
+#define PLAYER_SET_HOME(x,y)        db_set_home(x, y)
 
 /**
  * Setter for a player specific field
@@ -1656,9 +1705,11 @@ struct object {
     dbref contents;     /**< Head of the object's contents db list */
     dbref exits;        /**< Head of the object's exits db list */
     dbref next;         /**< pointer to next in contents/exits chain */
-    struct plist *properties;   /**< Root of properties tree */
+    struct propdir *properties; /**< Root property directory */
 #ifdef DISKBASE
     long propsfpos;     /**< File position for properties in the DB file */
+    long propsflen;     /**< Length of the properties in the DB file */
+    size_t propsbytes;  /**< Memory charged to the property cache */
     time_t propstime;   /**< Last time props were used */
     dbref nextold;      /**< Ringqueue for diskbase next db */
     dbref prevold;      /**< Ringqueue for diskbase previous db */
@@ -1717,6 +1768,13 @@ typedef struct objnode {
     struct objnode *next;   /**< Linked list */
 } objnode;
 
+/*
+ * Kinds of reverse reference kept for each object.  @see db_referrers
+ */
+#define REFS_OWNED  0   /**< Objects owned by the object */
+#define REFS_LINKED 1   /**< Exits, things, players and rooms linked to it */
+#define REFS_KINDS  2   /**< Number of reverse reference kinds */
+
 /*
  * These (particularly db) are used all over the place.  Very important
  * externs.
@@ -1900,6 +1958,20 @@ dbref create_room(dbref player, const char *name, dbref parent, char *error);
  */
 dbref create_thing(dbref player, const char *name, dbref location, char *error);
 
+/**
+ * Copy the list of objects referring to 'target' in a given way
+ *
+ * Use this instead of db_referrers when the objects are going to be
+ * changed while going through the list.
+ *
+ * @param target the object being referred to
+ * @param kind REFS_OWNED or REFS_LINKED
+ * @param[out] count the number of objects in the list
+ * @return a sorted copy of the list, to be freed by the caller, or NULL
+ *         if there are none
+ */
+dbref *db_copy_referrers(dbref target, int kind, int *count);
+
 /**
  * Free the memory for the whole database
  *
@@ -1927,6 +1999,26 @@ void db_free(void);
  */
 void db_free_object(dbref i);
 
+/**
+ * Grow the DB to a new size.
+ *
+ * 'newtop' will be the number of elements in the DB.  This won't let you
+ * shrink the DB, 'newtop' must be greater than db_top
+ *
+ * @param newtop the new DB size
+ */
+void db_grow(dbref newtop);
+
+/**
+ * Find the next object after 'after' that refers to 'target'
+ *
+ * @param target the object being referred to
+ * @param kind REFS_OWNED or REFS_LINKED
+ * @param after the dbref to start after, or NOTHING to start at the top
+ * @return the lowest referring dbref greater than 'after', or NOTHING
+ */
+dbref db_next_referrer(dbref target, int kind, dbref after);
+
 /**
  * Read the FuzzBall DB from the given file handle.
  *
@@ -1934,11 +2026,106 @@ void db_free_object(dbref i);
  * there is a problem loading the database, chances are it will trigger
  * an abort() as there is no gentle error handling in this process.
  *
+ * Both the text format and the binary format are understood; which one
+ * the file is in is worked out from its first few bytes.
+ *
  * @param f the file handle to load from
  * @return the dbtop value or #-1 if the header is invalid
  */
 dbref db_read(FILE * f);
 
+/**
+ * Read a database object in the text format from the given file handle
+ *
+ * This reads everything after the object's "#dbref" line, replacing
+ * whatever was in 'objno', which must already be empty.  Players are
+ * added to the player hash.  If any read fails, this abort()s.
+ *
+ * @param f the file handle
+ * @param objno the object ref we are loading
+ */
+void db_read_object(FILE * f, dbref objno);
+
+/**
+ * Get the objects referring to 'target' in a given way
+ *
+ * The list is sorted by dbref and belongs to the index; it changes as
+ * soon as any owner or link does, so copy it first if you are going to
+ * change the objects in it.
+ *
+ * @param target the object being referred to
+ * @param kind REFS_OWNED for objects it owns, REFS_LINKED for objects
+ *             linked to it
+ * @param[out] count the number of objects in the list
+ * @return the objects, or NULL if there are none
+ */
+const dbref *db_referrers(dbref target, int kind, int *count);
+
+/**
+ * Rebuild the reverse reference indexes from scratch
+ *
+ * This is done after the database is loaded, and after anything that
+ * edits object fields directly, like \@sanfix.
+ */
+void db_reindex(void);
+
+/**
+ * Set the dropto of a room, keeping the link index up to date
+ *
+ * This does not set the room dirty.
+ *
+ * @param room the room to change
+ * @param dropto the new dropto
+ */
+void db_set_dropto(dbref room, dbref dropto);
+
+/**
+ * Set the destinations of an exit, keeping the link index up to date
+ *
+ * The exit takes over 'dest', which must be allocated with malloc (or
+ * be NULL if 'ndest' is 0).  The old destination array is freed, so
+ * don't edit it in place; the index needs the old destinations.
+ *
+ * This does not set the exit dirty.
+ *
+ * @param exit the exit to change
+ * @param ndest the number of destinations
+ * @param dest the destinations
+ */
+void db_set_exit_dests(dbref exit, int ndest, dbref *dest);
+
+/**
+ * Set the home of a thing or player, keeping the link index up to date
+ *
+ * This does not set the object dirty.  It is normally used through
+ * THING_SET_HOME or PLAYER_SET_HOME.
+ *
+ * @param obj the thing or player to change
+ * @param home the new home
+ */
+void db_set_home(dbref obj, dbref home);
+
+/**
+ * Set the owner of an object, keeping the ownership index up to date
+ *
+ * This does not set the object dirty.
+ *
+ * @param obj the object to change
+ * @param owner the new owner
+ */
+void db_set_owner(dbref obj, dbref owner);
+
+/**
+ * Remove an object from the reverse reference indexes
+ *
+ * This drops the object's own owner and links from the indexes; the
+ * lists of objects referring to it are left alone.  It must be called
+ * while the object's exit destinations, if any, are still in place.
+ *
+ * @param obj the object to remove
+ */
+void db_unindex_object(dbref obj);
+
 /**
  * Write the database out to a given file handle
  *
@@ -1949,6 +2136,9 @@ dbref db_read(FILE * f);
  *
  * The dump ends with ***END OF DUMP***
  *
+ * If the dbdump_binary \@tune parameter is set, the binary format is
+ * written instead.  @see db_binary_write
+ *
  * If there is an error writing, this abort()s the program.
  *
  * @param f the file handle to write to
@@ -1956,6 +2146,18 @@ dbref db_read(FILE * f);
  */
 dbref db_write(FILE * f);
 
+/**
+ * Write an object in the text format to a given file handle
+ *
+ * This writes everything that goes after the object's "#dbref" line in
+ * a text dump; the caller writes that line.  db_read_object reads it
+ * back.
+ *
+ * @param f the file handle
+ * @param i the object dbref to write to the file handle
+ */
+void db_write_object(FILE * f, dbref i);
+
 /**
  * Calculate the environmental distance between 'from' and 'to'.
  *
@@ -0,0 +1,65 @@
+/** @file dbbinary.h
+ *
+ * Header for the binary database dump format.
+ *
+ * The binary format holds the same information as the Foxen9 text format,
+ * but stores numbers as fixed width binary values and strings with a
+ * length prefix, so neither writing nor reading it has to format or parse
+ * text.  Objects are written in sections, with an index at the end of the
+ * file, which lets the sections be decoded in parallel at startup.
+ *
+ * Which format is written is chosen with the dbdump_binary \@tune
+ * parameter; either format can be read.  It is not available with
+ * DISKBASE, which relies on the text format to find properties on disk.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include "config.h"
+
+#ifndef DISKBASE
+#ifndef DBBINARY_H
+#define DBBINARY_H
+
+#include <stdio.h>
+
+/**
+ * Check if a database file is in the binary format
+ *
+ * The file position is not changed.
+ *
+ * @param f the file handle to check
+ * @return boolean true if the file starts like a binary dump
+ */
+int db_binary_check(FILE * f);
+
+/**
+ * Read a binary database dump from the given file handle
+ *
+ * This loads the objects and the tune parameters; the caller handles
+ * the rest of the start up work, just as with the text format.  The
+ * object sections are decoded by DB_LOAD_THREADS threads where the
+ * platform supports it.
+ *
+ * On failure, the problem is logged and the database may be partly
+ * loaded, so it should not be used.
+ *
+ * @param f the file handle to load from
+ * @return the db_top value or -1 if the file is not a valid dump
+ */
+dbref db_binary_read(FILE * f);
+
+/**
+ * Write the database to the given file handle in the binary format
+ *
+ * Objects are written DB_BINARY_SECTION_SIZE at a time, so only one
+ * section needs to be held in memory.  If there is an error writing,
+ * this abort()s the program, as the text writer does.
+ *
+ * @param f the file handle to write to
+ * @return db_top value
+ */
+dbref db_binary_write(FILE * f);
+
+#endif /* !DBBINARY_H */
+#endif /* !DISKBASE */
@@ -76,6 +76,44 @@ int fetch_propvals(dbref obj, const char *dir);
  */
 extern pid_t global_dumper_pid;
 
+/**
+ * Map the database file into memory for reading properties from
+ *
+ * Properties are read from input_file until this is called.  Reading
+ * them from memory instead means a fetch costs no system calls unless
+ * the pages have to come off the disk, and lets prefetchprops ask for
+ * those pages ahead of time.
+ *
+ * If the file can't be mapped, properties are read from input_file as
+ * before.
+ *
+ * @param f the database file, which must stay open while it is mapped
+ */
+void map_propfile(FILE * f);
+
+/**
+ * Start reading an area's properties off the disk ahead of time
+ *
+ * This asks the system to read in the properties of 'loc', its contents
+ * and its exits, if they are not loaded yet, without waiting for them.
+ * It is done when something arrives in a room, so that the disk reads
+ * overlap with each other and with the rest of the move, rather than
+ * happening one at a time as look_room and friends fetch them.
+ *
+ * This does nothing if the database file is not mapped.
+ *
+ * @param loc the location being entered
+ */
+void prefetchprops(dbref loc);
+
+/**
+ * Reset the property cache hit and miss counts
+ *
+ * This is done after each database dump.  Misses start at 1 so the hit
+ * ratio can always be worked out.
+ */
+void clear_propcache_stats(void);
+
 /**
  * @var the number of cache "hits" (successful use of cache) we get
  */
@@ -149,5 +187,13 @@ void unloadprops_with_prejudice(dbref obj);
  */
 void undirtyprops(dbref obj);
 
+/**
+ * Stop reading properties from the mapped database file
+ *
+ * This must be called before input_file is closed.  It is harmless to
+ * call if the file is not mapped.
+ */
+void unmap_propfile(void);
+
 #endif /* !DISKPROP_H */
 #endif /* DISKBASE */
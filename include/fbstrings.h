@@ -36,6 +36,25 @@
  */
 struct shared_string *alloc_prog_string(const char * s);
 
+/**
+ * Append to a shared string, reusing it where possible
+ *
+ * This takes over the caller's reference to 'ss' and returns a string
+ * holding both, with one reference for the caller.  If nothing else
+ * refers to 'ss', it is extended in place, so a string built up by
+ * appending to it over and over is only copied when it runs out of room.
+ * New or moved strings get twice the room they need, up to BUFFER_LEN.
+ *
+ * This will abort() if malloc fails.
+ *
+ * @param ss the string to append to, which must not be NULL
+ * @param s the data to append
+ * @param len the length of 's'
+ * @return a shared string with the data of 'ss' followed by 's'
+ */
+struct shared_string *append_prog_string(struct shared_string *ss,
+                                         const char *s, size_t len);
+
 /**
  * Create a copy of the given string.  If the string is NULL or empty,
  * return NULL.
@@ -52,6 +71,52 @@ struct shared_string *alloc_prog_string(const char * s);
 char *alloc_string(const char * string);
 #endif
 
+/**
+ * Get the interned copy of a string, adding it if need be.  If the
+ * string is NULL or empty, return NULL.
+ *
+ * This is for strings that live in the database, such as object names,
+ * property names and property values, where the same text turns up
+ * over and over.  Every user of the same string shares one read-only
+ * copy; anything that wants to change it must make its own copy.  Each
+ * call adds a reference, to be dropped with free_interned.
+ *
+ * This will abort() if malloc fails.  It is not safe to call from more
+ * than one thread.
+ *
+ * @param s the string
+ * @return the interned string; it does not move until it is freed
+ */
+const char *alloc_interned(const char *s);
+
+/**
+ * Release a string from alloc_interned.  When nothing uses the string
+ * any more, it is freed.
+ *
+ * @param s the interned string, or NULL to do nothing
+ */
+void free_interned(const char *s);
+
+/**
+ * Add references to a string from alloc_interned.  This is how a copy
+ * of something holding an interned string shares it.
+ *
+ * @param s the interned string, or NULL to do nothing
+ * @param count the number of references to add
+ */
+void hold_interned(const char *s, unsigned int count);
+
+/**
+ * Get statistics on the interned string table
+ *
+ * @param strings the number of distinct strings
+ * @param uses the number of references to them
+ * @param bytes the bytes the strings take, not counting overhead
+ * @param saved the bytes saved by sharing them
+ */
+void interned_stats(size_t *strings, size_t *uses, size_t *bytes,
+                    size_t *saved);
+
 /**
  * This is a method that works similar to strcasecmp except it
  * sorts alphabetically or numerically as appropriate.  For instance*
@@ -25,16 +25,29 @@ union u_hash_data {
 struct t_hash_entry {
     struct t_hash_entry *next;  /**< Pointer for conflict resolution */
     const char *name;           /**< The name of the item */
+    unsigned int hashval;       /**< Hash of the name, before the modulo */
     union u_hash_data dat;      /**< Data value for item */
 };
 
+/**
+ * A hash table
+ *
+ * A table that is all zeroes is empty and ready to use; the buckets are
+ * allocated by the first add_hash, and the table grows as entries are
+ * added.
+ */
+struct t_hash_table {
+    struct t_hash_entry **buckets;  /**< Entry chains, or NULL if none */
+    unsigned int size;              /**< Buckets, always a power of two */
+    unsigned int count;             /**< Entries in the table */
+};
+
 typedef union u_hash_data hash_data;    /**< Union hash data type */
 typedef struct t_hash_entry hash_entry; /**< entry for hash table */
-typedef hash_entry *hash_tab;           /**< A hash table itself */
+typedef struct t_hash_table hash_tab;   /**< A hash table itself */
 
-#define PLAYER_HASH_SIZE   (1024)       /**< Table for player lookups */
-#define COMP_HASH_SIZE     (256)        /**< Table for compiler keywords */
-#define DEFHASHSIZE        (256)        /**< Table for compiler $defines */
+#define HASH_MIN_SIZE      (16)         /**< Buckets in a new table */
+#define HASH_MAX_LOAD      (2)          /**< Entries per bucket before growing */
 
 /**
  * Add a string to a hash table
@@ -42,22 +55,14 @@ typedef hash_entry *hash_tab;           /**< A hash table itself */
  * Will supercede old values in the table, returns pointer to
  * the hash entry, or NULL on failure.
  *
- * The name is copied when a new entry is added.
+ * The name is copied when a new entry is added.  The table doubles in
+ * size whenever it has more than HASH_MAX_LOAD entries per bucket.
  *
  * @param name the name of the entry to add
  * @param data the data to store
  * @param table the hash stable to store it in
- * @param size the page size of the hash table
- */
-hash_entry *add_hash(const char *name, hash_data data, hash_tab * table,
-                     unsigned int size);
-
-/*
- * @todo All these functions take a size parameter.  Wouldn't it make more
- *       sense to have a hash header struct that keeps track of that?  Its
- *       Maybe its not worth the effort, but it seems like something that
- *       would be easy to break if we're not careful.
  */
+hash_entry *add_hash(const char *name, hash_data data, hash_tab * table);
 
 /**
  * Lookup a name in a hash table
@@ -67,10 +72,9 @@ hash_entry *add_hash(const char *name, hash_data data, hash_tab * table,
  *
  * @param s the string to look up
  * @param table the table to look the string up in
- * @param size the hash page size
  * @return NULL if not found, otherwise a pointer to the data union
  */
-hash_data *find_hash(const char *s, hash_tab * table, unsigned size);
+hash_data *find_hash(const char *s, hash_tab * table);
 
 /**
  * Free a hash table entry associated with a name
@@ -82,18 +86,14 @@ hash_data *find_hash(const char *s, hash_tab * table, unsigned size);
  *
  * @param name the name of the hash entry to free
  * @param table the table to delete from
- * @param size the page size
  * @return 0 on success, -1 if 'name' was not found.
  */
-int free_hash(const char *name, hash_tab * table, unsigned size);
+int free_hash(const char *name, hash_tab * table);
 
 /**
  * Compute hash value for a string (case-insensitive)
  *
- * This particular hash function is fairly simple.  Note that it
- * throws away the information from the 0x20 bit in the character.
- * This means that upper and lower case letters will hash to the
- * same value.
+ * Upper and lower case letters hash to the same value.
  *
  * @param s the string to hash
  * @param hash_size the hash value will be between 0 and hash_size-1
@@ -105,12 +105,11 @@ unsigned int hash(const char *s, unsigned int hash_size);
  * Kill an entire hash table, by freeing every entry
  *
  * This will optionally also delete the data pointers if freeptrs is
- * true.
+ * true.  The table is left empty, and can be used again.
  *
  * @param table the hash table to operate on
- * @param size the page size
  * @param freeptrs boolean if true, free the data union value.
  */
-void kill_hash(hash_tab * table, unsigned size, int freeptrs);
+void kill_hash(hash_tab * table, int freeptrs);
 
 #endif /* !HASHTAB_H */
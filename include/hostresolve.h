@@ -0,0 +1,53 @@
+/** @file hostresolve.h
+ *
+ * Header for looking up the host and user names of new connections from
+ * inside the server.
+ *
+ * Host names are looked up by a small pool of threads and kept in a cache
+ * shared by every connection; ident queries are made from the main loop
+ * without blocking.  When both are done, the connection's host and user
+ * names are filled in.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#ifndef HOSTRESOLVE_H
+#define HOSTRESOLVE_H
+
+#include "config.h"
+
+#ifdef ASYNC_HOST_RESOLVER
+
+#include "interface.h"
+
+/**
+ * Start looking up the host and user names of a new connection
+ *
+ * 'd' must still have the host name and user name it was given when it
+ * was accepted: the address as text, and the client's port number.  They
+ * are replaced when the lookups finish, unless something else has changed
+ * them in the meantime.
+ *
+ * If too many lookups are already in progress, this does nothing and the
+ * connection keeps its address.
+ *
+ * @param d the new connection
+ * @param addr the client's address
+ * @param addrlen the length of 'addr'
+ * @param lport the server port the client connected to
+ */
+void host_resolve_add(struct descriptor_data *d, const struct sockaddr *addr,
+                      socklen_t addrlen, in_port_t lport);
+
+/**
+ * Move host and user name lookups along
+ *
+ * This is called from the main loop after the network event loop has
+ * waited.  It collects host names from the lookup threads, talks to ident
+ * servers, and updates connections whose lookups are done.
+ */
+void host_resolve_process(void);
+
+#endif /* ASYNC_HOST_RESOLVER */
+
+#endif /* !HOSTRESOLVE_H */
@@ -38,6 +38,7 @@ struct line {
 struct shared_string {
     int links;                  /**< number of pointers to this struct */
     size_t length;              /**< length of string data */
+    size_t size;                /**< bytes allocated for data, with the NUL */
     char data[1];               /**< shared string data */
 };
 
@@ -105,6 +106,7 @@ struct muf_proc_data {
 #define RES_VAR          4      /**< no of reserved variables */
 
 #define STACK_SIZE       1024   /**< maximum size of stack */
+#define STACK_INITIAL    16     /**< size of a new stack, doubled as needed */
 
 /**
  * If 'x' is NULL, return an empty string, otherwise return ->data
@@ -102,10 +102,14 @@ struct text_block {
     struct text_block *nxt; /**< Next block in the queue                  */
     char *start;            /**< Pointer into buf, advanced during writes */
     char *buf;              /**< The whole buffer                         */
+    size_t size;            /**< Bytes allocated for buf                  */
 };
 
 /**
  * The head of a text queue
+ *
+ * Output queues pack many messages into each block, so there 'lines'
+ * counts blocks.
  */
 struct text_queue {
     int lines;                  /**< Lines in the queue */
@@ -113,6 +117,20 @@ struct text_queue {
     struct text_block **tail;   /**< End of the queue   */
 };
 
+/**
+ * A message being sent to everyone in a room
+ *
+ * Splitting a message into lines and stripping its ANSI codes is the same
+ * work for every player who hears it, so it is done once per rendering
+ * instead of once per player.  Each rendering is a run of '\0' terminated
+ * lines, each ending in "\r\n", with an empty string after the last one.
+ * Renderings are made the first time a player needs them.
+ */
+struct broadcast {
+    const char *msg;    /**< The message as given                   */
+    char *lines[2];     /**< [0] has all ANSI stripped, [1] bad ANSI */
+};
+
 /**
  * Information about a descriptor / connection to the MUCK.
  */
@@ -170,6 +188,8 @@ struct descriptor_data {
     int quota;                      /**< Command burst quota                 */
     struct descriptor_data *next;   /**< Linked list of descriptors          */
     struct descriptor_data *prev;   /**< Double linked list                  */
+    struct descriptor_data *con_next; /**< Next older connected descriptor   */
+    struct descriptor_data *con_prev; /**< Next newer connected descriptor   */
     McpFrame mcpframe;              /**< MCP Frame information               */
 
     /* Fields for dealing with Telnet screen size */
@@ -225,9 +245,24 @@ extern struct descriptor_data *descriptor_list;
  */
 extern struct descriptor_data *descriptor_list_tail;
 
+/**
+ * @var connected_list
+ *      The list of connected (logged in) descriptors, in the same order as
+ *      descriptor_list.  Linked through con_next.
+ */
+extern struct descriptor_data *connected_list;
+
+/**
+ * @var connected_list_tail
+ *      The list of connected descriptors, but from the tail of the linked
+ *      list.  Linked through con_prev.
+ */
+extern struct descriptor_data *connected_list_tail;
+
 /**
  * @var global_dumpdone
- *      Boolean, true if has the forked dump process has completed.
+ *      Non-zero if the forked dump process has completed: 1 if it saved
+ *      the database, 2 if it failed.
  */
 extern short global_dumpdone;
 
@@ -332,16 +367,10 @@ int dbref_first_descr(dbref c);
 /**
  * Get the descriptor_data associated with a given descriptor number
  *
- * For UNIX, 'c' is the descriptor and is just an index in the table.
- * For Windows, 'c' gets hashed with gethash_descr then that index's
- * value is returned.
- *
- * @see gethash_descr
- *
- * @param i the descriptor to lookup
+ * @param c the descriptor to lookup
  * @return the descriptor_data corresponding to c or NULL if not found
  */
-struct descriptor_data *descrdata_by_descr(int i);
+struct descriptor_data *descrdata_by_descr(int c);
 
 /**
  * Output status of connections to the log file via log_status
@@ -449,15 +478,13 @@ void ignore_remove_from_all_players(dbref Player);
 void ignore_remove_player(dbref Player, dbref Who);
 
 /**
- * Fetch a descriptor number from an index in the descriptor table.
+ * Validate a descriptor number.
  *
- * Note that for UNIX, 'index' is always going to be the same as the
- * returned descriptor.  This is more for the benefit of Windows,
- * which has sort of a complicated descriptor abstraction going on
- * (or at least that's how it seems to work).
+ * This is used to check that a descriptor number taken from a player's
+ * descriptor list still refers to a live connection.
  *
- * @param index the index in the descriptor table to fetch
- * @return the descriptor associated with that index
+ * @param index the descriptor number to check
+ * @return the descriptor if it is a live connection, -1 otherwise
  */
 int index_descr(int index);
 
@@ -563,6 +590,47 @@ int notify_filtered(dbref from, dbref player, const char *msg, int ispriv);
 int notify_listeners(dbref who, dbref xprog, dbref obj, dbref room, const char *msg,
                      int isprivate);
 
+/**
+ * notify_listeners for one of the recipients of a room broadcast
+ *
+ * If 'bc' is given, players get its shared renderings of the message
+ * rather than having it split and stripped of ANSI just for them.
+ * Listeners and everything other than players are handled exactly as
+ * notify_listeners does.
+ *
+ * @see notify_listeners
+ *
+ * @param who the person sending the message
+ * @param xprog the program that originated the message
+ * @param obj the target of the message
+ * @param room the room that the message is sourced in
+ * @param msg the message to send
+ * @param isprivate boolean, usually false.  See notify_listeners
+ * @param bc the broadcast of 'msg', or NULL to render it just for 'obj'
+ * @return boolean result from notify filtered or 0 if obj is not player/thing
+ */
+int notify_listeners_shared(dbref who, dbref xprog, dbref obj, dbref room,
+                            const char *msg, int isprivate,
+                            struct broadcast *bc);
+
+/**
+ * Start a broadcast of a message
+ *
+ * Nothing is rendered until a player needs it.  The message must stay
+ * valid until broadcast_free is called.
+ *
+ * @param bc the broadcast to set up
+ * @param msg the message to send
+ */
+void broadcast_init(struct broadcast *bc, const char *msg);
+
+/**
+ * Free the renderings of a broadcast message
+ *
+ * @param bc the broadcast to clean up
+ */
+void broadcast_free(struct broadcast *bc);
+
 /**
  * Notify the given player (or zombie) without triggering listen propqueue.
  *
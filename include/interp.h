@@ -97,13 +97,29 @@ struct tryvars {
     struct tryvars *next;   /**< Linked list support for nested try's        */
 };
 
+/**
+ * An argument stack array that was replaced while a primitive was running.
+ *
+ * Primitives often hold pointers to items they have popped while they
+ * push their results, so the old array is kept until the primitive returns.
+ */
+struct retired_stack {
+    struct inst *st;                /**< The old array          */
+    struct retired_stack *next;     /**< Next old array, if any */
+};
+
 /**
  * A program's "argument stack" which is the MUF stack from the developer's
  * perspective.
+ *
+ * Stacks start at STACK_INITIAL items and are doubled as needed, up to
+ * STACK_SIZE items.
  */
 struct stack {
-    int top;                    /**< Top index number in stack */
-    struct inst st[STACK_SIZE]; /**< The stack itself          */
+    int top;                        /**< Top index number in stack       */
+    int size;                       /**< Number of items allocated       */
+    struct inst *st;                /**< The stack itself                */
+    struct retired_stack *retired;  /**< Arrays replaced by CHECKOFLOW   */
 };
 
 /**
@@ -111,8 +127,9 @@ struct stack {
  * such as function calls.
  */
 struct sysstack {
-    int top;                            /**< Top index number in stack */
-    struct stack_addr st[STACK_SIZE];   /**< The stack itself          */
+    int top;                    /**< Top index number in stack */
+    int size;                   /**< Number of items allocated */
+    struct stack_addr *st;      /**< The stack itself          */
 };
 
 /**
@@ -120,7 +137,8 @@ struct sysstack {
  */
 struct callstack {
     int top;                /**< Top index number in stack */
-    dbref st[STACK_SIZE];   /**< The stack itself */
+    int size;               /**< Number of items allocated */
+    dbref *st;              /**< The stack itself          */
 };
 
 /**
@@ -313,6 +331,23 @@ struct frame {
     stk_array_list *prev_array_active_list; /**< Previous active list */
 };
 
+/**
+ * Inline cache for a property primitive whose path is a constant
+ *
+ * The compiler makes one for each GETPROP, GETPROPSTR, GETPROPVAL and
+ * GETPROPFVAL whose path is pushed by the instruction right before it,
+ * with the path already split up.  The property last found is kept until
+ * a property is added or removed anywhere (see props_serial).
+ */
+struct prop_cache {
+    struct inst *pc;            /**< The primitive instruction           */
+    struct shared_string *path; /**< The constant path                   */
+    char *parts;                /**< Path split up for propdir_get_parts */
+    dbref obj;                  /**< Object last looked up, or NOTHING   */
+    unsigned int serial;        /**< props_serial at that time           */
+    struct plist *prop;         /**< What was found, or NULL             */
+};
+
 /**
  * Structure to keep track of public functions (basically library functions)
  */
@@ -583,17 +618,25 @@ do { \
  * Check for overflow if 'x' items were to be pushed onto the stack
  *
  * Do this before pushing items onto the stack to make sure you don't
- * segfault the MUCK.  It will do an abort_interp if there's not enough
- * room, which will return your function for you.
+ * segfault the MUCK.  The stack is grown if it is too small; if it would
+ * go over STACK_SIZE, this does an abort_interp, which will return your
+ * function for you.
+ *
+ * Growing the stack moves it, so 'arg' is reloaded.  Items popped before
+ * the check stay readable until the primitive returns.
  *
  * @see abort_interp
+ * @see grow_argument_stack
  *
  * If DEBUG is defined, this will set the number of expected pushes
  * on the frame structure.
  */
 #define CHECKOFLOW(x) do { \
-        if ((*top + (x - 1)) >= STACK_SIZE) \
-            abort_interp("Stack Overflow!"); \
+        if ((*top + (x - 1)) >= fr->argument.size) { \
+            if (!grow_argument_stack(fr, *top + (x), 1)) \
+                abort_interp("Stack Overflow!"); \
+            arg = fr->argument.st; \
+        } \
         fr->expect_push_to = *top + (x); \
     } while (0)
 #else
@@ -601,17 +644,25 @@ do { \
  * Check for overflow if 'x' items were to be pushed onto the stack
  *
  * Do this before pushing items onto the stack to make sure you don't
- * segfault the MUCK.  It will do an abort_interp if there's not enough
- * room, which will return your function for you.
+ * segfault the MUCK.  The stack is grown if it is too small; if it would
+ * go over STACK_SIZE, this does an abort_interp, which will return your
+ * function for you.
+ *
+ * Growing the stack moves it, so 'arg' is reloaded.  Items popped before
+ * the check stay readable until the primitive returns.
  *
  * @see abort_interp
+ * @see grow_argument_stack
  *
  * If DEBUG is defined, this will set the number of expected pushes
  * on the frame structure.
  */
 #define CHECKOFLOW(x) do { \
-        if ((*top + (x - 1)) >= STACK_SIZE) \
-            abort_interp("Stack Overflow!"); \
+        if ((*top + (x - 1)) >= fr->argument.size) { \
+            if (!grow_argument_stack(fr, *top + (x), 1)) \
+                abort_interp("Stack Overflow!"); \
+            arg = fr->argument.st; \
+        } \
     } while (0)
 #endif
 
@@ -1004,6 +1055,76 @@ struct forvars *pop_for(struct forvars * from);
  */
 struct tryvars *pop_try(struct tryvars * trystack);
 
+/**
+ * Get a cleared frame, from the free frames list if there is one
+ *
+ * The frame's stacks are allocated at their initial size and are empty.
+ *
+ * @return the new frame
+ */
+struct frame *alloc_frame(void);
+
+/**
+ * Make room for at least 'count' items on a frame's argument stack
+ *
+ * The stack is doubled in size until it is big enough.  If 'retire' is
+ * true, the old array is kept until release_retired_stacks() is called
+ * instead of being freed, so that pointers into it stay usable.  This is
+ * what CHECKOFLOW does, as primitives often hold pointers to the items
+ * they popped.
+ *
+ * @param fr the frame
+ * @param count the number of items needed
+ * @param retire boolean if true keep the old array around
+ * @return boolean true if there is room, false if 'count' is over STACK_SIZE
+ */
+int grow_argument_stack(struct frame *fr, int count, int retire);
+
+/**
+ * Free argument stack arrays kept by grow_argument_stack()
+ *
+ * @param fr the frame
+ */
+void release_retired_stacks(struct frame *fr);
+
+/**
+ * Make room for at least 'count' items on a frame's system stack
+ *
+ * @param fr the frame
+ * @param count the number of items needed
+ * @return boolean true if there is room, false if 'count' is over STACK_SIZE
+ */
+int grow_system_stack(struct frame *fr, int count);
+
+/**
+ * Make room for at least 'count' items on a frame's caller stack
+ *
+ * @param fr the frame
+ * @param count the number of items needed
+ * @return boolean true if there is room, false if 'count' is over STACK_SIZE
+ */
+int grow_caller_stack(struct frame *fr, int count);
+
+/**
+ * Get the memory used by a frame and its stacks, in bytes
+ *
+ * @param fr the frame
+ * @return the number of bytes used by 'fr'
+ */
+size_t frame_memory(struct frame *fr);
+
+/**
+ * Get statistics about MUF frames
+ *
+ * 'bytes' covers every frame, including the free frames list, and their
+ * stacks.
+ *
+ * @param inuse set to the number of frames in use
+ * @param pooled set to the number of frames on the free frames list
+ * @param bytes set to the memory used by all frames, in bytes
+ */
+void frame_stats(int *inuse, int *pooled, size_t *bytes);
+
 /**
  * Clean up a given frame, and return it to the free frames list.
  *
@@ -0,0 +1,82 @@
+/** @file journal.h
+ *
+ * Header for the database change journal.
+ *
+ * Between full dumps, the objects that have been changed (those with
+ * OBJECT_CHANGED set) are appended to a journal file every
+ * dump_journal_interval, in the same text form the dump uses.  Each record
+ * is a whole object, so replaying the journal on top of the last complete
+ * dump brings every journaled object back to its last saved state.
+ *
+ * There are two journal files next to the output database:
+ *
+ * - "<dumpfile>.journal" gets the changes since the last dump started.
+ * - "<dumpfile>.journal.old" holds the changes from before that, until the
+ *   dump finishes and they are no longer needed.
+ *
+ * Changes to \@tune parameters and macros are only saved by full dumps.
+ *
+ * This is only available if DB_JOURNAL is defined.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "config.h"
+
+#ifdef DB_JOURNAL
+
+/**
+ * Remove both journal files
+ *
+ * This is used after the whole database has been saved by the main
+ * process, such as at shutdown or by panic(), when nothing in the journal
+ * is needed any more.
+ */
+void journal_discard(void);
+
+/**
+ * Note that a forked dump has finished saving the database
+ *
+ * The changes in the old journal are all in the new dump, so the old
+ * journal is removed.
+ */
+void journal_dump_done(void);
+
+/**
+ * Append the changed objects to the journal
+ *
+ * The OBJECT_CHANGED flag is cleared on every object that is written.
+ * Nothing is written if no object has changed.  If the journal cannot be
+ * written, the error is logged and the flags are left alone, so the
+ * objects are tried again next time.
+ */
+void journal_flush(void);
+
+/**
+ * Replay the journals for the output database
+ *
+ * This is called by db_read, after the objects are loaded but before the
+ * indexes are built, and replays the old journal and then the current
+ * one.  Only complete batches of changes are replayed; anything after
+ * the last one, such as a batch cut short by a crash, is logged and
+ * removed.
+ *
+ * Nothing is done when converting a database with -convert, and the
+ * other journal calls do nothing either.
+ */
+void journal_replay(void);
+
+/**
+ * Start a new journal for a dump that is about to begin
+ *
+ * The current journal becomes the old journal, which is kept until
+ * the dump finishes.  If the old journal is still there because the last
+ * dump never finished, the current journal is added to the end of it.
+ */
+void journal_rotate(void);
+
+#endif /* DB_JOURNAL */
+#endif /* !JOURNAL_H */
@@ -15,6 +15,8 @@
 /**
  * Log a string to a file, with sprinf-style replacements
  *
+ * The string is raw, no timestamp is prefixed.
+ *
  * @param myfilename the file to write to
  * @param format the format string with sprinf-style replacements
  * @param ... whatever sprintf replacement variables
@@ -60,6 +62,37 @@ void log_gripe(const char *format, ...);
  */
 void log_muf(const char *format, ...);
 
+/**
+ * Close and reopen the log files
+ *
+ * This is for log rotation: once the old files have been moved away,
+ * this makes the next lines go to new files under the configured names.
+ * It is safe to call from a signal handler.
+ */
+void log_reopen(void);
+
+/**
+ * Start writing log lines from a background thread
+ *
+ * Until this is called, and in any process fork()ed after it, log lines
+ * are written to the open files as they are logged.  Afterwards they are
+ * collected in a buffer, and a writer thread writes them out at least
+ * every tp_log_flush_msec milliseconds.
+ *
+ * This should be called after the server has gone into the background,
+ * as the thread would not survive the fork().
+ */
+void log_start(void);
+
+/**
+ * Stop the background log writer
+ *
+ * This waits for every line logged so far to be written.  Later lines are
+ * written as they are logged.  It does nothing if the writer isn't
+ * running.
+ */
+void log_stop(void);
+
 /**
  * Log a program's text to the program log file
  *
@@ -396,7 +396,7 @@ int new_mfunc(const char *funcname, const char *buf);
 int new_mvar(const char *varname, char *buf);
 
 /**
- * Purge all the hash entries for MPI functions.
+ * Purge all the hash entries for MPI functions, and the compiled MPI cache.
  *
  * This is used to clean up MPI memory.  It should only be used on server
  * shutdown.
@@ -0,0 +1,57 @@
+/** @file mufcache.h
+ *
+ * Header for the on-disk cache of compiled MUF programs.
+ *
+ * Compiled programs are written to muf/<dbref>.mc next to their source so
+ * that, after a restart or \@uncompile, they can be loaded instead of
+ * compiled again.  A cache file is only used if it was written by the same
+ * server build from the same source text, and none of the _defs/ the
+ * compile used have changed since.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#ifndef MUFCACHE_H
+#define MUFCACHE_H
+
+#include "config.h"
+
+/**
+ * Load a program's compiled code from its cache file
+ *
+ * The program's source must be loaded into PROGRAM_FIRST, as it is when
+ * do_compile is called, so that it can be checked against the cache.
+ *
+ * On success, the code, size, start address and publics of the program
+ * are set.  Any code the program already had must have been freed first.
+ * On failure, the program is not touched.
+ *
+ * @param program the program to load
+ * @return true if the program was loaded, false if it must be compiled
+ */
+int muf_cache_load(dbref program);
+
+/**
+ * Remove a program's cache file, if it has one
+ *
+ * @param program the program whose cache file should be removed
+ */
+void muf_cache_remove(dbref program);
+
+/**
+ * Write a freshly compiled program to its cache file
+ *
+ * 'deps' lists the objects whose _defs/ were included by the compile.
+ * Their current _defs/ are recorded in the cache file, and the file is
+ * only used again while they stay the same.
+ *
+ * Failures are logged, but are otherwise harmless; the program will just
+ * be compiled the next time it is needed.
+ *
+ * @param program the program that was just compiled
+ * @param deps the objects whose _defs/ were used by the compile
+ * @param depcount the number of entries in 'deps'
+ */
+void muf_cache_save(dbref program, const dbref *deps, int depcount);
+
+#endif /* !MUFCACHE_H */
@@ -174,7 +174,7 @@ int muf_event_exists(struct frame *fr, const char *eventid);
  *
  * 'pat' is intended to be something akin to this:
  *
- * **%10s %4s %4s %6s %4s %7s %-10.10s %-12s %.512s
+ * **%10s %4s %4s %6s %4s %4s %7s %-10.10s %-12s %.512s
  *
  * That's the format used in the only place this is called.
  *
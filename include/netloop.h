@@ -0,0 +1,96 @@
+/** @file netloop.h
+ *
+ * Header for the network event loop backends used by the main player
+ * interaction loop.  Depending on the platform this is either a select()
+ * based backend or an epoll() based one; the interface is the same.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#ifndef NETLOOP_H
+#define NETLOOP_H
+
+#include "config.h"
+
+#define NETLOOP_READ    0x1 /**< Interested in / ready for reading */
+#define NETLOOP_WRITE   0x2 /**< Interested in / ready for writing */
+
+/**
+ * Initialize the network event loop backend.
+ *
+ * This must be called once before any other netloop call.  If the backend
+ * cannot be initialized, this will panic.
+ */
+void netloop_init(void);
+
+/**
+ * Get the name of the compiled in event loop backend
+ *
+ * @return a constant string such as "epoll" or "select"
+ */
+const char *netloop_backend_name(void);
+
+/**
+ * Get the number of descriptors the event loop backend can watch
+ *
+ * For select() this is FD_SETSIZE; for other backends it is effectively
+ * unlimited.
+ *
+ * @return the maximum number of descriptors that can be watched
+ */
+long netloop_max_descriptors(void);
+
+/**
+ * Set the events we are interested in for a given descriptor
+ *
+ * Interest is persistent; it remains in effect for every following call
+ * to netloop_wait until it is changed or the descriptor is forgotten.
+ * Setting the same interest again is cheap and does not result in a
+ * system call, so callers may simply set the interest they want on every
+ * pass of the main loop.
+ *
+ * Setting an interest of 0 stops watching the descriptor entirely.
+ *
+ * @see netloop_forget
+ *
+ * @param fd the descriptor
+ * @param events a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ * @return 0 on success, -1 if the descriptor cannot be watched
+ */
+int netloop_set(int fd, int events);
+
+/**
+ * Forget about a descriptor
+ *
+ * This must be called before a watched descriptor is closed so that the
+ * descriptor number can be safely reused.
+ *
+ * @param fd the descriptor to forget about
+ */
+void netloop_forget(int fd);
+
+/**
+ * Wait for activity on the watched descriptors
+ *
+ * Signals that are blocked during normal operation are unblocked for the
+ * duration of the wait if pselect support is available.
+ *
+ * @param timeout how long to wait at most
+ * @return the number of ready descriptors, 0 on timeout, or -1 on error
+ *         with errno set.
+ */
+int netloop_wait(struct timeval *timeout);
+
+/**
+ * Which events are ready on a given descriptor after netloop_wait?
+ *
+ * Errors and hangups are reported as whichever events the descriptor
+ * was being watched for, so that the normal read or write path notices
+ * the problem.
+ *
+ * @param fd the descriptor to check
+ * @return a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ */
+int netloop_ready(int fd);
+
+#endif /* !NETLOOP_H */
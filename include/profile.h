@@ -0,0 +1,114 @@
+/** @file profile.h
+ *
+ * Header for the sampling profiler for MUF and MPI.
+ *
+ * While the profiler is running, a timer fires every profile_sample_msec
+ * milliseconds of CPU time the server uses.  The timer only sets a flag;
+ * the MUF interpreter, the MPI parser and the main loop check it at their
+ * next step and record where the server is.  A MUF sample is the call
+ * stack of the running program down to the line being run, and an MPI
+ * sample is the stack of MPI functions being run, with the objects they
+ * run on.  CPU time outside of both is recorded as "(server)".
+ *
+ * Samples are kept as counts of identical stacks, and \@profile write
+ * saves them in the collapsed stack format that flame graph tools read:
+ * one line per stack, with its frames joined by ';' and then its count.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <signal.h>
+#include <time.h>
+
+#include "config.h"
+#include "inst.h"
+
+/**
+ * @var set by the timer when a sample is due, and cleared by taking one
+ */
+extern volatile sig_atomic_t profile_sample_due;
+
+/**
+ * Start the profiler
+ *
+ * Samples are added to any that have been taken before.  Starting a
+ * running profiler picks up a new profile_sample_msec.
+ *
+ * @return true if the profiler is running, false if it is not supported
+ */
+int profile_start(void);
+
+/**
+ * Stop the profiler
+ *
+ * The samples taken so far are kept until they are cleared.
+ */
+void profile_stop(void);
+
+/**
+ * Throw away all the samples taken so far
+ */
+void profile_clear(void);
+
+/**
+ * Get the state of the profiler
+ *
+ * Any of the pointers may be NULL.
+ *
+ * @param running set to true if the profiler is running
+ * @param samples set to the number of samples taken
+ * @param stacks set to the number of different stacks seen
+ * @return the time the profiler was last started or cleared
+ */
+time_t profile_status(int *running, long *samples, int *stacks);
+
+/**
+ * Write the samples taken so far to a file in collapsed stack format
+ *
+ * @param filename the file to write, which is replaced
+ * @return the number of stacks written, or -1 if the file can't be written
+ */
+int profile_write(const char *filename);
+
+/**
+ * Take a sample of a running MUF program
+ *
+ * This is called by the interpreter when profile_sample_due is set, with
+ * its own copies of the program counter and system stack.
+ *
+ * @param program the program being run
+ * @param pc the instruction about to be run
+ * @param sys the system stack, holding the return addresses of callers
+ * @param stop the top of the system stack
+ */
+void profile_sample_muf(dbref program, struct inst *pc,
+                        struct stack_addr *sys, int stop);
+
+/**
+ * Note that an MPI function is about to be run
+ *
+ * This keeps the stack of running MPI functions, and takes a sample if
+ * one is due.  Each call must be matched by a call to profile_mpi_leave.
+ * 'name' must stay valid until then.
+ *
+ * @param what the object the MPI is running on
+ * @param name the name of the function
+ */
+void profile_mpi_enter(dbref what, const char *name);
+
+/**
+ * Note that the last MPI function passed to profile_mpi_enter has finished
+ */
+void profile_mpi_leave(void);
+
+/**
+ * Take a sample outside of MUF and MPI
+ *
+ * This is called by the main loop when profile_sample_due is set.
+ */
+void profile_sample_server(void);
+
+#endif /* !PROFILE_H */
@@ -26,7 +26,7 @@
  * Perhaps it is there to ensure a minimum size of 4 bytes for the union.
  */
 union pdata_u {
-    char *str;              /**< String data */
+    const char *str;        /**< String data */
     struct boolexp *lok;    /**< Boolean/lock data */
     int val;                /**< Integer data */
     double fval;            /**< Float data */
@@ -46,25 +46,49 @@ typedef struct pdata PData; /**< Data struct for setting data */
 
 /**
  * Property struct
+ *
+ * Properties live in the 'props' block of their directory, so a PropPtr
+ * only stays good until that directory is changed.  The key is interned
+ * (see alloc_interned) and does not move.
  */
 struct plist {
-    unsigned short flags;   /**< Flags */
-    short height;           /**< AVL book-keeping  */
+    const char *key;        /**< key */
     union pdata_u data;     /**< The different kinds of types */
-    struct plist *left;     /**< Left node */
-    struct plist *right;    /**< Right node */
-    struct plist *dir;      /**< Directory node */
-    char key[1];            /**< key */
+    struct propdir *dir;    /**< Directory under this property */
+    unsigned short flags;   /**< Flags */
+};
+
+/**
+ * Property directory struct
+ *
+ * The properties of a directory, sorted case-insensitively by name.  An
+ * empty directory is always NULL rather than a propdir with no props.
+ */
+struct propdir {
+    unsigned int count;     /**< Properties in use */
+    unsigned int size;      /**< Properties there is room for */
+    struct plist props[];   /**< The properties */
 };
 
 /** property node pointer type */
 typedef struct plist *PropPtr;
 
+/** property directory pointer type */
+typedef struct propdir *PropDirPtr;
+
+/**
+ * @var changed whenever a property is added to or removed from any
+ *      directory, which may move the properties around it.  A PropPtr
+ *      saved along with this value is still good while it is unchanged.
+ */
+extern unsigned int props_serial;
+
 /* propload queue types */
 #define PROPS_UNLOADED 0x0  /**< Unloaded props */
 #define PROPS_LOADED   0x1  /**< Props loaded */
 #define PROPS_PRIORITY 0x2  /**< Props priority */
 #define PROPS_CHANGED  0x3  /**< PRops changed */
+#define PROPS_PROBATION 0x4 /**< Props loaded, not used again yet */
 
 /* property value types */
 #define PROP_DIRTYP   0x0   /**< Prop dirty type */
@@ -271,16 +295,16 @@ void add_property(dbref player, const char *pname, const char *strval,
                   int value);
 
 /**
- * This allocates a property node for use in the property AVL tree.  The
+ * This allocates a property node that is not in any directory.  The
  * note has the given name (memory is copied over) and is set dirty, but
- * otherwise is a blank slate ready to be added to the AVL.
+ * otherwise is a blank slate.  Property locks use these.
  *
  * Chances are, you do not want to use this method.  It is exposed because
  * it is used in boolexp.c and props.c
  *
  * @internal
  * @param name String property name (memory will be copied)
- * @return allocated PropPtr AVL node.
+ * @return allocated PropPtr node.
  */
 PropPtr alloc_propnode(const char *name);
 
@@ -309,15 +333,15 @@ void clear_property_flags(dbref player, const char *pname, int flags);
 void clear_propnode(PropPtr p);
 
 /**
- * This copies all the properties on an object and returns the root node.
+ * This copies all the properties on an object and returns the root directory.
  * It is used, for example, by \@clone and COPYOBJ to copy all the
  * properties on an object. Always copies "system" properties.
  *
  * @param old DBREF of original object.
  * @param copy_hidden_props if true, this copies hidden properties
- * @return a struct plist that is a copy of all properties on 'old'.
+ * @return a property directory that is a copy of all properties on 'old'.
  */
-struct plist *copy_prop(dbref old, int copy_hidden_props);
+PropDirPtr copy_prop(dbref old, int copy_hidden_props);
 
 /**
  * This copies the properties from 'from' onto 'to'.  It does not blow
@@ -355,7 +379,8 @@ void copy_properties_onto(dbref from, dbref to);
  * @param old The source property list
  * @param copy_hidden_props if true, this copies hidden properties
  */
-void copy_proplist(dbref obj, PropPtr * newer, PropPtr old, int copy_hidden_props);
+void copy_proplist(dbref obj, PropDirPtr * newer, PropDirPtr old,
+                   int copy_hidden_props);
 
 /**
  * Starts a recursive dump of props to the given file handle for the
@@ -387,7 +412,7 @@ void db_dump_props(FILE * f, dbref obj);
  * @param f DB File handle.
  * @param obj DBREF of object who's properties we are loading.
  * @param pos Position to load the property from, or 0 to load in squence.
- * @param pnode If we have an existing property AVL node to load into.
+ * @param pnode If we have an existing property node to load into.
  *              This may be NULL if you do not have it.
  * @param pdir This is used exclusively for error display.  This is
  *             usually a propdir but can be NULL.
@@ -413,7 +438,7 @@ void db_getprops(FILE * f, dbref obj, const char *pdir);
 
 /**
  * Delete a property from the given prop set, with the given property
- * name.  It removes it from the AVL of 'list'.  Does not save it to
+ * name.  It removes it from the directory 'list'.  Does not save it to
  * the database right away.
  *
  * This is something of a low level call -- you probably want
@@ -421,22 +446,22 @@ void db_getprops(FILE * f, dbref obj, const char *pdir);
  *
  * @see remove_property
  *
- * @param list Pointer to a PropPtr which is (usually) the root of the
- *             property AVL tree.
+ * @param list Pointer to the property directory; it becomes NULL when
+ *             the last property is deleted.
  * @param name The name of the property to delete
  * @return Returns the pointer that 'list' is pointing to.  Because 'list'
  *         is modified, there is probably no reason to use the return
  *         value.
  */
-PropPtr delete_prop(PropPtr * list, char *name);
+PropDirPtr delete_prop(PropDirPtr * list, const char *name);
 
 /**
- * Recursively deletes an entire proplist AVL with 'p' as the root,
- * and frees 'p' itself.
+ * Recursively deletes an entire property directory, and frees the
+ * directory itself.
  *
- * @param p The proplist to delete.
+ * @param p The property directory to delete.
  */
-void delete_proplist(PropPtr p);
+void delete_proplist(PropDirPtr p);
 
 /**
  * This function takes a property and generates a line akin to what
@@ -541,14 +566,14 @@ void exec_or_notify_prop(int descr, dbref player, dbref thing,
                          const char *propname, const char *whatcalled);
 
 /**
- * Finds the first node ("leftmost") on the property AVL list 'p' or
- * returns NULL if p has no nodes on it.
+ * Finds the first node on the property directory 'p' or returns NULL if
+ * p has no nodes on it.
  *
- * @param p PropPtr of the root of the AVL property list you want to scan.
+ * @param p the property directory you want to scan.
  *
- * @return First/leftmost node on proplist.
+ * @return First node on proplist.
  */
-PropPtr first_node(PropPtr p);
+PropPtr first_node(PropDirPtr p);
 
 /**
  * Returns a pointer to the first property on an object for the given
@@ -563,7 +588,7 @@ PropPtr first_node(PropPtr p);
  * @param player the DBREF of the object to get the properties from.
  * @param dir The string name of the propdir
  * @param list pointer to a proplist.  We will use this field to return
- *        the root node to you.
+ *        the property directory to you.
  * @param name pointer to a string buffer - this will be used to return
  *        the property name to you.
  * @param maxlen the size of the buffer.
@@ -572,8 +597,8 @@ PropPtr first_node(PropPtr p);
  *         the property list is empty.  If there is no property, then
  *         name will be an empty string.
  */
-PropPtr first_prop(dbref player, const char *dir, PropPtr * list, char *name,
-                   size_t maxlen);
+PropPtr first_prop(dbref player, const char *dir, PropDirPtr * list,
+                   char *name, size_t maxlen);
 
 /**
  * Returns a pointer to the first property on an object for the given
@@ -589,7 +614,7 @@ PropPtr first_prop(dbref player, const char *dir, PropPtr * list, char *name,
  * @param player the DBREF of the object to get the properties from.
  * @param dir The string name of the propdir
  * @param list pointer to a proplist.  We will use this field to return
- *        the root node to you.
+ *        the property directory to you.
  * @param name pointer to a string buffer - this will be used to return
  *        the property name to you.
  * @param maxlen the size of the buffer.
@@ -598,7 +623,7 @@ PropPtr first_prop(dbref player, const char *dir, PropPtr * list, char *name,
  *         the property list is empty.  If there is no property, then
  *         name will be an empty string.
  */
-PropPtr first_prop_nofetch(dbref player, const char *dir, PropPtr * list,
+PropPtr first_prop_nofetch(dbref player, const char *dir, PropDirPtr * list,
                            char *name, size_t maxlen);
 
 /**
@@ -788,31 +813,34 @@ int has_property_strict(int descr, dbref player, dbref what, const char *pname,
 int is_propdir(dbref player, const char *dir);
 
 /**
- * This finds a prop named 'key' in the AVL proplist 'avl'.  It is basically
- * a primitive for looking up items in the AVLs.
+ * This finds a prop named 'key' in the property directory 'dir'.  It is
+ * basically a primitive for looking up items in the directories.
  *
- * @param avl the AVL to search
+ * @param dir the property directory to search
  * @param key the key to look up
  *
  * @return the found node, or NULL if not found.
  */
-PropPtr locate_prop(PropPtr avl, char *key);
+PropPtr locate_prop(PropDirPtr dir, const char *key);
 
 /**
- * This creates a new node in the AVL then returns the created node
- * so that you might populate it with data.  If the key already
- * exists, then the existing node is returned.
+ * This creates a new node in a property directory then returns the
+ * created node so that you might populate it with data.  If the key
+ * already exists, then the existing node is returned.
+ *
+ * The directory may move to make room, so 'dir' is updated, and any
+ * other PropPtr into it is no longer good.
  *
- * @param avl the AVL to add a property to.
- * @param key the key to add to the AVL.
+ * @param dir the property directory to add a property to.
+ * @param key the key to add to the directory.
  *
- * @return the newly created AVL node.
+ * @return the newly created node.
  */
-PropPtr new_prop(PropPtr *avl, char *key);
+PropPtr new_prop(PropDirPtr * dir, const char *key);
 
 /**
- * next_node locates and returns the next node in the AVL (prop directory)
- * or NULL if there is no more.  It is used for traversing a prop AVL.
+ * next_node locates and returns the next node in the prop directory
+ * or NULL if there is no more.  It is used for traversing a prop directory.
  *
  * Name should be a single prop name and not a prop path; this is not for
  * navigating a whole property path.  If you want to navigate a path,
@@ -821,12 +849,12 @@ PropPtr new_prop(PropPtr *avl, char *key);
  * @see propdir_next_elem
  * @see next_prop_name
  *
- * @param ptr the AVL to navigate
+ * @param ptr the property directory to navigate
  * @param name The "previous name" ... what is returned is the next name
  *        after this one
  * @return the property we found, or NULL
  */
-PropPtr next_node(PropPtr ptr, char *name);
+PropPtr next_node(PropDirPtr ptr, const char *name);
 
 /**
  * next_prop is a wrapper around next_node to provide a slightly different
@@ -836,7 +864,7 @@ PropPtr next_node(PropPtr ptr, char *name);
  * @see propdir_next_elem
  * @see next_prop_name
  *
- * Given the root of an AVL 'list' and a property 'prop', this function
+ * Given a property directory 'list' and a property 'prop', this function
  * returns the next property after 'prop' or NULL if there is no next
  * property.
  *
@@ -847,14 +875,14 @@ PropPtr next_node(PropPtr ptr, char *name);
  *
  * maxlen is the length of your buffer.
  *
- * @param list the AVL prop list root
+ * @param list the property directory
  * @param prop the 'previous' node - we will get the next node after this one
  * @param name a buffer to copy the property name into
  * @param maxlen the length of that buffer.
  *
  * @return the next property node or NULL if no more.
  */
-PropPtr next_prop(PropPtr list, PropPtr prop, char *name, size_t maxlen);
+PropPtr next_prop(PropDirPtr list, PropPtr prop, char *name, size_t maxlen);
 
 /**
  * next_prop_name returns the string name of the next property on a
@@ -908,14 +936,14 @@ void parse_oprop(int descr, dbref player, dbref dest, dbref exit,
  *
  * @see remove_property
  *
- * @param root The root property node to start your search
+ * @param root The root property directory to start your search
  * @param path the path you are searching for to delete.
  *
- * @return the updated root node with the property removed.  Because this
+ * @return the updated root directory with the property removed.  Because this
  *         mutates the passed structure, this is equivalent to the 'root'
  *         parameter.
  */
-PropPtr propdir_delete_elem(PropPtr root, char *path);
+PropDirPtr propdir_delete_elem(PropDirPtr root, char *path);
 
 /**
  * This gets the first element of a propdir given a certain path.
@@ -930,7 +958,7 @@ PropPtr propdir_delete_elem(PropPtr root, char *path);
  *
  * @return the first element of the given path or NULL if not found.
  */
-PropPtr propdir_first_elem(PropPtr root, char *path);
+PropPtr propdir_first_elem(PropDirPtr root, char *path);
 
 /**
  * Fetches a given property from the property path structure 'root'.
@@ -949,7 +977,24 @@ PropPtr propdir_first_elem(PropPtr root, char *path);
  *
  * @return the found property or NULL if not found.
  */
-PropPtr propdir_get_elem(PropPtr root, char *path);
+PropPtr propdir_get_elem(PropDirPtr root, char *path);
+
+/**
+ * Fetches a given property from the property path structure 'root',
+ * with the path already split up.
+ *
+ * This is for callers that look up the same path over and over, and
+ * finds the same property propdir_get_elem would.
+ *
+ * @see propdir_get_elem
+ *
+ * @param root The root of the property directory tree
+ * @param parts the names in the path, each followed by a '\0', with an
+ *              empty name after the last one
+ *
+ * @return the found property or NULL if not found.
+ */
+PropPtr propdir_get_parts(PropDirPtr root, const char *parts);
 
 /**
  * This is basically the equivalent of the POSIX "dirname", which retrieves
@@ -993,7 +1038,7 @@ const char *propdir_name(const char *name);
  * @return the newly created node, or the existing node at the given path,
  *         or NULL on error
  */
-PropPtr propdir_new_elem(PropPtr * root, char *path);
+PropPtr propdir_new_elem(PropDirPtr * root, char *path);
 
 /**
  * Returns pointer to the next property after the given one in the given
@@ -1007,19 +1052,19 @@ PropPtr propdir_new_elem(PropPtr * root, char *path);
  *
  * @return the next property in the propdir or NULL if no more.
  */
-PropPtr propdir_next_elem(PropPtr root, char *path);
+PropPtr propdir_next_elem(PropDirPtr root, char *path);
 
 /**
  * Returns the path of the first unloaded propdir in a given path,
  * or NULL if all the propdirs to the path are loaded.  You will
  * probably never use this call.
  *
- * @param root The root propdir node
+ * @param root The root property directory
  * @param path The path to operate on.
  *
  * @return path name as described above, or NULL.
  */
-const char *propdir_unloaded(PropPtr root, const char *path);
+const char *propdir_unloaded(PropDirPtr root, const char *path);
 
 /**
  * A reflist is a space-delimited set of DBREFs in a string, each
@@ -1299,17 +1344,17 @@ void set_property_nofetch(dbref player, const char *pname, PData * dat);
 size_t size_properties(dbref player, int load);
 
 /**
- * Calculates the size of the given property directory AVL list.  This
+ * Calculates the size of the given property directory.  This
  * will iterate over the entire structure to give the entire size.  It
  * is the low level equivalent of size_properties.
  *
  * @see size_properties
  *
- * @param avl the Property directory AVL to check
+ * @param dir the Property directory to check
  * @return the size of the loaded properties in memory -- this does NOT
  *         do any diskbase loading.
  */
-size_t size_proplist(PropPtr avl);
+size_t size_proplist(PropDirPtr dir);
 
 /**
  * This function is a progressive iteration over the entire database,
@@ -0,0 +1,51 @@
+/** @file smtpqueue.h
+ *
+ * Header for the outbound mail queue used by SMTP_SEND.
+ *
+ * Mail is delivered by short lived child processes using the SMTP client
+ * library so that a slow or unreachable mail server cannot hold up the
+ * MUCK.  When a job finishes, the MUF program that queued it is sent an
+ * "SMTP.<id>" event.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#ifndef SMTPQUEUE_H
+#define SMTPQUEUE_H
+
+#include "config.h"
+#include "interp.h"
+
+/**
+ * Add a mail to the outbound queue
+ *
+ * The current SMTP @tune settings are used to deliver the message.  If
+ * there is a free worker slot, delivery starts right away; otherwise the
+ * job waits in the queue until one frees up.
+ *
+ * When delivery finishes, an "SMTP.<id>" event is sent to the process
+ * in 'fr' if it is still around.  The event data is a dictionary with
+ * the keys "id", "status" (0 on success, -2 on failure) and "error".
+ *
+ * On Windows there are no worker processes, so the mail is sent before
+ * this call returns, but the event is delivered in the same way.
+ *
+ * @param fr the frame of the MUF program sending the mail
+ * @param to the recipient's email address
+ * @param to_name the recipient's name, which may be empty
+ * @param subject the subject line
+ * @param body the body of the message
+ * @return the job ID, which is always positive, or -2 if the queue is full
+ */
+int smtp_queue_add(struct frame *fr, const char *to, const char *to_name,
+                   const char *subject, const char *body);
+
+/**
+ * Check for finished mail jobs and start waiting ones
+ *
+ * This is called from the main loop after the network event loop has
+ * waited, and looks at the status pipes of the running workers.
+ */
+void smtp_queue_process(void);
+
+#endif /* !SMTPQUEUE_H */
@@ -356,9 +356,9 @@ int in_timequeue(int pid);
  * Return the seconds until the the next event will run
  *
  * This may be -1 if either the next event is is set to when = -1, or
- * if there is nothing on the queue.  It could be 0 if there is something
- * available to run immediately.  Otherwise, it will be the seconds until
- * the next run.
+ * if there is nothing on the queue waiting to run by time; READ entries
+ * are not counted.  It could be 0 if there is something available to run
+ * immediately.  Otherwise, it will be the seconds until the next run.
  *
  * @param now the current timestamp
  * @return seconds until next run, -1, or 0
@@ -414,8 +414,8 @@ void propqueue(int descr, dbref player, dbref where, dbref trigger, dbref what,
 /**
  * Function to purge the free_timenode_list
  *
- * This is only used by the MUCK shutdown sequence, if MEMORY_CLEANUP is
- * defined.
+ * This also frees the timequeue's run heap and lookup tables.  It is only
+ * used by the MUCK shutdown sequence, if MEMORY_CLEANUP is defined.
  */
 void purge_timenode_free_pool(void);
 
@@ -107,6 +107,7 @@ extern const char *tp_cpennies;                 /**< Tune variable */
 extern const char *tp_cpenny;                   /**< Tune variable */
 extern const char *tp_create_fail_mesg;         /**< Tune variable */
 extern bool        tp_dark_sleepers;            /**< Tune variable */
+extern bool        tp_dbdump_binary;            /**< Tune variable */
 extern bool        tp_dbdump_warning;           /**< Tune variable */
 extern dbref       tp_default_room_parent;      /**< Tune variable */
 extern const char *tp_description_default;      /**< Tune variable */
@@ -115,6 +116,7 @@ extern bool        tp_do_mpi_parsing;           /**< Tune variable */
 extern bool        tp_do_mpi_sex_parsing;       /**< Tune variable */
 extern bool        tp_do_welcome_parsing;       /**< Tune variable */
 extern int         tp_dump_interval;            /**< Tune variable */
+extern int         tp_dump_journal_interval;    /**< Tune variable */
 extern int         tp_dump_warntime;            /**< Tune variable */
 extern const char *tp_dumpdone_mesg;            /**< Tune variable */
 extern bool        tp_dumpdone_warning;         /**< Tune variable */
@@ -150,6 +152,7 @@ extern const char *tp_file_mpihelp;             /**< Tune variable */
 extern const char *tp_file_mpihelp_dir;         /**< Tune variable */
 extern const char *tp_file_news;                /**< Tune variable */
 extern const char *tp_file_news_dir;            /**< Tune variable */
+extern const char *tp_file_profile;             /**< Tune variable */
 extern const char *tp_file_welcome_screen;      /**< Tune variable */
 extern bool        tp_force_mlev1_name_notify;  /**< Tune variable */
 extern int         tp_free_frames_pool;         /**< Tune variable */
@@ -170,6 +173,7 @@ extern int         tp_listen_mlev;              /**< Tune variable */
 extern bool        tp_lock_envcheck;            /**< Tune variable */
 extern bool        tp_log_commands;             /**< Tune variable */
 extern bool        tp_log_failed_commands;      /**< Tune variable */
+extern int         tp_log_flush_msec;           /**< Tune variable */
 extern bool        tp_log_hosts;                /**< Tune variable */
 extern bool        tp_log_interactive;          /**< Tune variable */
 extern bool        tp_log_programs;             /**< Tune variable */
@@ -179,6 +183,7 @@ extern bool        tp_m3_huh;                   /**< Tune variable */
 extern int         tp_max_force_level;          /**< Tune variable */
 extern int         tp_max_instr_count;          /**< Tune variable */
 extern int         tp_max_interp_recursion;     /**< Tune variable */
+extern int         tp_max_loaded_kb;            /**< Tune variable */
 extern int         tp_max_loaded_objs;          /**< Tune variable */
 extern int         tp_max_ml4_nested_interp_loop_count; /**< Tune variable */
 extern int         tp_max_ml4_preempt_count;    /**< Tune variable */
@@ -192,10 +197,12 @@ extern int         tp_max_propfetch;            /**< Tune variable */
 extern int         tp_maxidle;                  /**< Tune variable */
 extern int         tp_mcp_muf_mlev;             /**< Tune variable */
 extern int         tp_movepennies_muf_mlev;     /**< Tune variable */
+extern bool        tp_mpi_compile_cache;            /**< Tune variable */
 extern bool        tp_mpi_continue_after_logout;    /**< Tune variable */
 extern int         tp_mpi_max_commands;         /**< Tune variable */
 extern const char *tp_muckname;                 /**< Tune variable */
 extern bool        tp_muf_comments_strict;      /**< Tune variable */
+extern bool        tp_muf_compile_cache;        /**< Tune variable */
 extern const char *tp_new_program_flags;        /**< Tune variable */
 extern int         tp_object_cost;              /**< Tune variable */
 extern bool        tp_optimize_muf;             /**< Tune variable */
@@ -215,6 +222,7 @@ extern const char *tp_playermax_warnmesg;       /**< Tune variable */
 extern bool        tp_pname_history_reporting;  /**< Tune variable */
 extern int         tp_pname_history_threshold;  /**< Tune variable */
 extern int         tp_process_timer_limit;      /**< Tune variable */
+extern int         tp_profile_sample_msec;      /**< Tune variable */
 extern bool        tp_quiet_moves;              /**< Tune variable */
 extern bool        tp_realms_control;           /**< Tune variable */
 extern bool        tp_recognize_null_command;   /**< Tune variable */
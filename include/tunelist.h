@@ -54,6 +54,7 @@ bool        tp_consistent_lock_source;              /**> Described below */
 const char *tp_cpennies;                            /**> Described below */
 const char *tp_cpenny;                              /**> Described below */
 bool        tp_dark_sleepers;                       /**> Described below */
+bool        tp_dbdump_binary;                       /**> Described below */
 bool        tp_dbdump_warning;                      /**> Described below */
 dbref       tp_default_room_parent;                 /**> Described below */
 const char *tp_description_default;                 /**> Described below */
@@ -64,6 +65,7 @@ bool        tp_do_mpi_sex_parsing;                  /**> Described below
                                                          mpi_parsing.    */
 bool        tp_do_welcome_parsing;                  /**> Described below */
 int         tp_dump_interval;                       /**> Described below */
+int         tp_dump_journal_interval;               /**> Described below */
 int         tp_dump_warntime;                       /**> Described below */
 const char *tp_dumpdone_mesg;                       /**> Described below */
 bool        tp_dumpdone_warning;                    /**> Described below */
@@ -99,6 +101,7 @@ const char *tp_file_mpihelp;                        /**> Described below */
 const char *tp_file_mpihelp_dir;                    /**> Described below */
 const char *tp_file_news;                           /**> Described below */
 const char *tp_file_news_dir;                       /**> Described below */
+const char *tp_file_profile;                        /**> Described below */
 const char *tp_file_welcome_screen;                 /**> Described below */
 bool        tp_force_mlev1_name_notify;             /**> Described below */
 int         tp_free_frames_pool;                    /**> Described below */
@@ -119,6 +122,7 @@ int         tp_listen_mlev;                         /**> Described below */
 bool        tp_lock_envcheck;                       /**> Described below */
 bool        tp_log_commands;                        /**> Described below */
 bool        tp_log_failed_commands;                 /**> Described below */
+int         tp_log_flush_msec;                      /**> Described below */
 bool        tp_log_hosts;                           /**> Described below */
 bool        tp_log_interactive;                     /**> Described below */
 bool        tp_log_programs;                        /**> Described below */
@@ -128,6 +132,7 @@ bool        tp_m3_huh;                              /**> Described below */
 int         tp_max_force_level;                     /**> Described below */
 int         tp_max_instr_count;                     /**> Described below */
 int         tp_max_interp_recursion;                /**> Described below */
+int         tp_max_loaded_kb;                       /**> Described below */
 int         tp_max_loaded_objs;                     /**> Described below */
 int         tp_max_ml4_nested_interp_loop_count;    /**> Described below */
 int         tp_max_ml4_preempt_count;               /**> Described below */
@@ -141,10 +146,12 @@ int         tp_max_propfetch;                       /**> Described below */
 int         tp_maxidle;                             /**> Described below */
 int         tp_mcp_muf_mlev;                        /**> Described below */
 int         tp_movepennies_muf_mlev;                /**> Described below */
+bool        tp_mpi_compile_cache;                   /**> Described below */
 bool        tp_mpi_continue_after_logout;           /**> Described below */
 int         tp_mpi_max_commands;                    /**> Described below */
 const char *tp_muckname;                            /**> Described below */
 bool        tp_muf_comments_strict;                 /**> Described below */
+bool        tp_muf_compile_cache;                   /**> Described below */
 const char *tp_new_program_flags;                   /**> Described below */
 int         tp_object_cost;                         /**> Described below */
 bool        tp_optimize_muf;                        /**> Described below */
@@ -164,6 +171,7 @@ const char *tp_playermax_warnmesg;                  /**> Described below */
 bool        tp_pname_history_reporting;             /**> Described below */
 int         tp_pname_history_threshold;             /**> Described below */
 int         tp_process_timer_limit;                 /**> Described below */
+int         tp_profile_sample_msec;                 /**> Described below */
 bool        tp_quiet_moves;                         /**> Described below */
 bool        tp_realms_control;                      /**> Described below */
 bool        tp_recognize_null_command;              /**> Described below */
@@ -494,6 +502,18 @@ struct tune_entry tune_list[] = {
         MLEV_WIZARD,
         true
     },
+    {
+        "dbdump_binary",
+        "Save the database in the binary dump format",
+        "DB Dumps",
+        "BINARYDB",
+        TP_TYPE_BOOLEAN,
+        .defaultval.b=false,
+        .currentval.b=&tp_dbdump_binary,
+        0,
+        MLEV_WIZARD,
+        true
+    },
     {
         "dbdump_warning",
         "Enable warnings for upcoming database dumps",
@@ -592,6 +612,18 @@ struct tune_entry tune_list[] = {
         MLEV_WIZARD,
         true
     },
+    {
+        "dump_journal_interval",
+        "Interval between journal writes of changed objects",
+        "DB Dumps",
+        "JOURNAL",
+        TP_TYPE_TIMESPAN,
+        .defaultval.t=60,
+        .currentval.t=&tp_dump_journal_interval,
+        0,
+        MLEV_WIZARD,
+        true
+    },
     {
         "dump_warntime",
         "Interval between warning and dump",
@@ -1012,6 +1044,18 @@ struct tune_entry tune_list[] = {
         MLEV_GOD,
         true
     },
+    {
+        "file_profile",
+        "Sampling profiler output",
+        "Files",
+        "",
+        TP_TYPE_STRING,
+        .defaultval.s="logs/profile",
+        .currentval.s=&tp_file_profile,
+        MLEV_WIZARD,
+        MLEV_GOD,
+        true
+    },
     {
         "file_welcome_screen",
         "Opening screen",
@@ -1252,6 +1296,18 @@ struct tune_entry tune_list[] = {
         MLEV_WIZARD,
         true
     },
+    {
+        "log_flush_msec",
+        "Max. millisecs log lines wait to be written (0 = at once)",
+        "Logging",
+        "",
+        TP_TYPE_INTEGER,
+        .defaultval.n=1000,
+        .currentval.n=&tp_log_flush_msec,
+        MLEV_WIZARD,
+        MLEV_WIZARD,
+        true
+    },
     {
         "log_hosts",
         "Log hosts during connection events",
@@ -1365,6 +1421,18 @@ struct tune_entry tune_list[] = {
         true,
         true
     },
+    {
+        "max_loaded_kb",
+        "Max. kilobytes of proploaded properties (0 = no limit)",
+        "Tuning",
+        "DISKBASE",
+        TP_TYPE_INTEGER,
+        .defaultval.n=16384,
+        .currentval.n=&tp_max_loaded_kb,
+        0,
+        MLEV_WIZARD,
+        true
+    },
     {
         "max_loaded_objs",
         "Max. percent of proploaded database objects",
@@ -1521,6 +1589,18 @@ struct tune_entry tune_list[] = {
         MLEV_WIZARD,
         true
     },
+    {
+        "mpi_compile_cache",
+        "Cache compiled forms of frequently used MPI",
+        "MPI",
+        "",
+        TP_TYPE_BOOLEAN,
+        .defaultval.b=true,
+        .currentval.b=&tp_mpi_compile_cache,
+        0,
+        MLEV_WIZARD,
+        true
+    },
     {
         "mpi_continue_after_logout",
         "Continue executing MPI after logout",
@@ -1569,6 +1649,18 @@ struct tune_entry tune_list[] = {
         MLEV_WIZARD,
         true
     },
+    {
+        "muf_compile_cache",
+        "Keep compiled MUF programs on disk for faster loading",
+        "MUF",
+        "",
+        TP_TYPE_BOOLEAN,
+        .defaultval.b=true,
+        .currentval.b=&tp_muf_compile_cache,
+        0,
+        MLEV_WIZARD,
+        true
+    },
     {
         "new_program_flags",
         "Initial flags for newly created programs",
@@ -1806,6 +1898,18 @@ struct tune_entry tune_list[] = {
         MLEV_WIZARD,
         true
     },
+    {
+        "profile_sample_msec",
+        "Millisecs of CPU time between profiler samples",
+        "Tuning",
+        "",
+        TP_TYPE_INTEGER,
+        .defaultval.n=10,
+        .currentval.n=&tp_profile_sample_msec,
+        MLEV_WIZARD,
+        MLEV_WIZARD,
+        true
+    },
     {
         "quiet_moves",
         "Suppress basic arrive and depart notifications",
@@ -6,7 +6,9 @@
  * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
  */
 
+#include <ctype.h>
 #include <float.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -483,580 +485,588 @@ array_tree_compare_internal(const array_iter * a, const array_iter * b, int case
     }
 }
 
-/**
- * Find a given key in the tree avl
- *
- * @private
- * @param avl the avl tree
- * @param key the key to find
- * @return the found node
- */
-static array_tree *
-array_tree_find(array_tree * avl, array_iter * key)
-{
-    int cmpval;
-
-    assert(key != NULL);
-
-    while (avl) {
-        cmpval = array_tree_compare(key, &(avl->key), 0);
+/*****************************************************************
+ *  Dictionary Handling Routines
+ *
+ *  A dictionary keeps its entries in blocks that never move, so a
+ *  pointer to a value stays good while other keys are added.  Keys are
+ *  found through an open addressing hash table of entry pointers.  They
+ *  are only put in order when something needs the order (first, next,
+ *  ranges, and so on), and that order is kept until a key is added out
+ *  of order.
+ *
+ *  Two keys are the same if array_tree_compare says so.  That ignores
+ *  case in strings and lets a float equal a number very close to it.
+ *  Strings and whole numbers hash in a way that agrees with this, but
+ *  other floats, arrays, and locks can't, so they are found with a binary
+ *  search of the ordered entries instead.
+ *****************************************************************/
 
-        if (cmpval > 0) {
-            avl = avl->right;
-        } else if (cmpval < 0) {
-            avl = avl->left;
-        } else {
-            break;
-        }
-    }
+#define ARRAY_DICT_BLOCK0 4     /**< Entries in the first block */
+#define ARRAY_DICT_BLOCKS 28    /**< Max blocks; each is twice the last */
+#define ARRAY_DICT_SLOTS0 8     /**< Smallest hash table */
 
-    return avl;
-}
+/**
+ * An entry in a dictionary
+ */
+typedef struct array_dict_entry_t {
+    array_iter key;         /**< Key, or PROG_CLEARED if unused */
+    array_data data;        /**< Value */
+    unsigned int hash;      /**< Hash of the key, if hashed */
+    short hashed;           /**< Boolean: is this in the hash table? */
+    struct array_dict_entry_t *next_unused; /**< Unused entry list */
+} array_dict_entry;
 
 /**
- * Get the height of the given node
- *
- * This has 'friendly' node handling, returning 0 on a NULL
- *
- * @private
- * @param node the node to be computed
- * @return the height of the given node
+ * A dictionary
  */
-static short
-array_tree_height_of(array_tree * node)
-{
-    if (node != NULL)
-        return node->height;
-    else
-        return 0;
-}
+struct array_dict_t {
+    array_dict_entry *blocks[ARRAY_DICT_BLOCKS]; /**< Entry storage */
+    array_dict_entry *unused;   /**< Unused entries, to be used again */
+    int used;                   /**< Entries ever handed out */
+    int count;                  /**< Entries with keys */
+    array_dict_entry **slots;   /**< The hash table */
+    int slot_mask;              /**< Hash table size - 1 */
+    int slots_filled;           /**< Hash table slots that aren't empty */
+    int hashed;                 /**< Entries in the hash table */
+    int fuzzy_numbers;          /**< Float keys that aren't hashed */
+    array_dict_entry **order;   /**< Entries in key order, or NULL */
+    int order_count;            /**< Entries in 'order' */
+    int order_size;             /**< Room in 'order' */
+    int order_hint;             /**< Where the last key was found */
+};
 
 /**
- * Compute the height difference between the left and right nodes on a node
- *
  * @private
- * @param node the node to compute the height difference for
- * @return the height difference.  Negative means left is 'taller'.
+ * @var marks a hash table slot whose entry was deleted
  */
-static int
-array_tree_height_diff(array_tree * node)
-{
-    if (node != NULL)
-        return (array_tree_height_of(node->right) - array_tree_height_of(node->left));
-    else
-        return 0;
-}
+static array_dict_entry array_dict_deleted;
 
 /**
- * Adjusts the height of node 'node'
+ * Mix the bits of an integer for a hash table
  *
  * @private
- * @param node the node to do the height correction on.
+ * @param x the integer
+ * @return the hash
  */
-static void
-array_tree_fixup_height(array_tree * node)
+static unsigned int
+array_dict_hash_int(unsigned int x)
 {
-    if (node != NULL)
-        node->height = (short) (1 +
-                        MAX(array_tree_height_of(node->left),
-                        array_tree_height_of(node->right)));
+    x ^= x >> 16;
+    x *= 0x45d9f3bU;
+    x ^= x >> 16;
+    x *= 0x45d9f3bU;
+    x ^= x >> 16;
+    return x;
 }
 
 /**
- * Does a 'single left' rotation on node a.  Used in balancing.
+ * Hash a dictionary key
+ *
+ * Keys that are equal according to array_tree_compare get the same hash,
+ * when the key can be hashed at all.
  *
  * @private
- * @param a the node to rotate
- * @return the rotated node
+ * @param key the key
+ * @param hash set to the hash of the key
+ * @return boolean true if the key can be found by its hash, false if it
+ *         must be looked for in the ordered entries
  */
-static array_tree *
-array_tree_rotate_left_single(array_tree * a)
+static int
+array_dict_hash(const array_iter * key, unsigned int *hash)
 {
-    array_tree *b;
-    assert(a != NULL);
-    b = a->right;
+    switch (key->type) {
+        case PROG_STRING: {
+            unsigned int h = 2166136261U;
 
-    a->right = b->left;
-    b->left = a;
+            for (const char *s = DoNullInd(key->data.string); *s; s++) {
+                h ^= (unsigned char) tolower(*s);
+                h *= 16777619U;
+            }
 
-    array_tree_fixup_height(a);
-    array_tree_fixup_height(b);
+            *hash = h;
+            return 1;
+        }
 
-    return b;
+        case PROG_INTEGER:
+            *hash = array_dict_hash_int((unsigned int) key->data.number);
+            return 1;
+
+        case PROG_FLOAT: {
+            double f = key->data.fnumber;
+
+            /*
+             * A whole number in int range only equals itself, whether it
+             * is an int or a float.  Anything else may be equal to some
+             * number near it.
+             */
+            if (f >= INT_MIN && f <= INT_MAX && f == floor(f)) {
+                *hash = array_dict_hash_int((unsigned int) (int) f);
+                return 1;
+            }
+
+            *hash = 0;
+            return 0;
+        }
+
+        case PROG_ARRAY:
+        case PROG_LOCK:
+            *hash = 0;
+            return 0;
+
+        case PROG_ADD:
+            *hash = array_dict_hash_int((unsigned int) key->data.addr->progref
+                                        ^ (unsigned int) (size_t) key->data.addr->data);
+            return 1;
+
+        default:
+            *hash = array_dict_hash_int((unsigned int) key->data.number
+                                        ^ ((unsigned int) key->type << 24));
+            return 1;
+    }
 }
 
 /**
- * Does a 'double left' rotation on node a.  Used in balancing.
+ * Get an entry of a dictionary by its number
+ *
+ * Block b holds ARRAY_DICT_BLOCK0 << b entries, so entry n is in the
+ * block for the highest bit of n + ARRAY_DICT_BLOCK0.
  *
  * @private
- * @param a the node to rotate
- * @return the rotated node
+ * @param d the dictionary
+ * @param i the entry number
+ * @return the entry, which may not have been allocated yet
  */
-static array_tree *
-array_tree_rotate_left_double(array_tree * a)
+static array_dict_entry *
+array_dict_entry_at(array_dict * d, int i)
 {
-    array_tree *b, *c;
-    assert(a != NULL);
-    b = a->right;
-    c = b->left;
+    unsigned int n = (unsigned int) i + ARRAY_DICT_BLOCK0;
+    int b = 0;
 
-    assert(b != NULL);
-    assert(c != NULL);
+    while (n >= (ARRAY_DICT_BLOCK0 << (b + 1)))
+        b++;
 
-    a->right = c->left;
-    b->left = c->right;
-    c->left = a;
-    c->right = b;
+    if (!d->blocks[b]) {
+        d->blocks[b] = malloc(sizeof(array_dict_entry)
+                              * (size_t) (ARRAY_DICT_BLOCK0 << b));
 
-    array_tree_fixup_height(a);
-    array_tree_fixup_height(b);
-    array_tree_fixup_height(c);
+        if (!d->blocks[b]) {
+            fprintf(stderr, "array_dict_entry_at(): Out of Memory!\n");
+            abort();
+        }
+    }
 
-    return c;
+    return &d->blocks[b][n - (ARRAY_DICT_BLOCK0 << b)];
 }
 
 /**
- * Does a 'single right' rotation on node a.  Used in balancing.
+ * Compare two dictionary entries by key, for qsort
  *
  * @private
- * @param a the node to rotate
- * @return the rotated node
+ * @param a pointer to the first entry pointer
+ * @param b pointer to the second entry pointer
+ * @return similar to strcmp
  */
-static array_tree *
-array_tree_rotate_right_single(array_tree * a)
+static int
+array_dict_compare_entries(const void *a, const void *b)
 {
-    array_tree *b;
-    assert(a != NULL);
-    b = a->left;
-
-    a->left = b->right;
-    b->right = a;
-
-    array_tree_fixup_height(a);
-    array_tree_fixup_height(b);
-
-    return (b);
+    return array_tree_compare(&(*(array_dict_entry * const *) a)->key,
+                              &(*(array_dict_entry * const *) b)->key, 0);
 }
 
 /**
- * Does a 'double right' rotation on node a.  Used in balancing.
+ * Put the entries of a dictionary in key order, if they aren't already
  *
  * @private
- * @param a the node to rotate
- * @return the rotated node
+ * @param d the dictionary
  */
-static array_tree *
-array_tree_rotate_right_double(array_tree * a)
+static void
+array_dict_sort(array_dict * d)
 {
-    array_tree *b, *c;
-    assert(a != NULL);
-    b = a->left;
-    c = b->right;
+    array_dict_entry *e;
 
-    assert(b != NULL);
-    assert(c != NULL);
+    if (d->order)
+        return;
+
+    d->order_size = d->count ? d->count : 1;
+    d->order = malloc(sizeof(array_dict_entry *) * (size_t) d->order_size);
+
+    if (!d->order) {
+        fprintf(stderr, "array_dict_sort(): Out of Memory!\n");
+        abort();
+    }
 
-    a->left = c->right;
-    b->right = c->left;
-    c->right = a;
-    c->left = b;
+    d->order_count = 0;
+    d->order_hint = 0;
 
-    array_tree_fixup_height(a);
-    array_tree_fixup_height(b);
-    array_tree_fixup_height(c);
+    for (int i = 0; i < d->used; i++) {
+        e = array_dict_entry_at(d, i);
 
-    return c;
+        if (e->key.type != PROG_CLEARED)
+            d->order[d->order_count++] = e;
+    }
+
+    qsort(d->order, (size_t) d->order_count, sizeof(array_dict_entry *),
+          array_dict_compare_entries);
 }
 
 /**
- * Rebalance the AVL tree
- *
- * This is an essential part of AVL that, honestly, its been too many
- * years since college for me to remember exactly how it works.  But
- * basically it reorganizes the structure to make sure the nodes are
- * in the right order, and is done after an insert or delete.
+ * Find where a key is, or would be, in the ordered entries
  *
  * @private
- * @param a the tree to rebalance
- * @return the re-balanced tree.
+ * @param d the dictionary
+ * @param key the key
+ * @param after boolean if true, find the first key after 'key', rather
+ *              than the first key that is not before it
+ * @return the position in d->order
  */
-static array_tree *
-array_tree_balance_node(array_tree * a)
+static int
+array_dict_search(array_dict * d, const array_iter * key, int after)
 {
-    int dh;
-    dh = array_tree_height_diff(a);
+    int lo = 0, hi, mid;
 
-    if (abs(dh) < 2) {
-        array_tree_fixup_height(a);
-    } else {
-        if (dh == 2) {
-            if (array_tree_height_diff(a->right) >= 0) {
-                a = array_tree_rotate_left_single(a);
-            } else {
-                a = array_tree_rotate_left_double(a);
-            }
-        } else if (array_tree_height_diff(a->left) <= 0) {
-            a = array_tree_rotate_right_single(a);
-        } else {
-            a = array_tree_rotate_right_double(a);
-        }
+    array_dict_sort(d);
+    hi = d->order_count;
+
+    /* Walking through the keys in order looks at the same place again. */
+    if (d->order_hint < hi
+        && !array_tree_compare(key, &d->order[d->order_hint]->key, 0))
+        return d->order_hint + (after ? 1 : 0);
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+
+        if (array_tree_compare(&d->order[mid]->key, key, 0) < (after ? 1 : 0))
+            lo = mid + 1;
+        else
+            hi = mid;
     }
 
-    return a;
+    return lo;
 }
 
 /**
- * Alocate a new node with the given key.
- *
- * It initializes the data with an integer 0
+ * Find a key in a dictionary
  *
  * @private
- * @param key to initialize - its data is copied.
- * @return the allocated node
+ * @param d the dictionary, which may be NULL
+ * @param key the key to find
+ * @return the entry, or NULL if the key isn't there
  */
-static array_tree *
-array_tree_alloc_node(array_iter * key)
+static array_dict_entry *
+array_dict_find(array_dict * d, const array_iter * key)
 {
-    array_tree *new_node;
+    array_dict_entry *e;
+    unsigned int hash;
+    int i;
+
     assert(key != NULL);
 
-    new_node = calloc(1, sizeof(array_tree));
-    if (!new_node) {
-        fprintf(stderr, "array_tree_alloc_node(): Out of Memory!\n");
-        abort();
+    if (!d || !d->count)
+        return NULL;
+
+    if (!array_dict_hash(key, &hash) || (d->fuzzy_numbers
+        && (key->type == PROG_INTEGER || key->type == PROG_FLOAT))) {
+        i = array_dict_search(d, key, 0);
+
+        if (i < d->order_count
+            && !array_tree_compare(key, &d->order[i]->key, 0)) {
+            d->order_hint = i;
+            return d->order[i];
+        }
+
+        return NULL;
     }
 
-    new_node->left = NULL;
-    new_node->right = NULL;
-    new_node->height = 1;
+    if (!d->slots)
+        return NULL;
+
+    for (i = (int) (hash & (unsigned int) d->slot_mask); (e = d->slots[i]);
+         i = (i + 1) & d->slot_mask) {
+        if (e != &array_dict_deleted && e->hash == hash
+            && !array_tree_compare(key, &e->key, 0))
+            return e;
+    }
 
-    copyinst(key, &(new_node->key));
-    new_node->data.type = PROG_INTEGER;
-    new_node->data.data.number = 0;
-    return new_node;
+    return NULL;
 }
 
 /**
- * Insert a new node into the AVL tree
- *
- * Note that this uses a static variable to keep track if we need to balance
- * the tree.  That makes this call not threadsafe; however how Fuzzball
- * is constructed means there is little risk of one call of this
- * inappropriately interfering with another.
- *
- * Note that if the pointer that avl points to is NULL, it will be replaced
- * with a valid node.
+ * Rebuild the hash table of a dictionary with room for more entries
  *
  * @private
- * @param avl the AVL tree to work on.
- * @param key the key to add
- * @return the created node, or the existing node if the key is already there
+ * @param d the dictionary
  */
-static array_tree *
-array_tree_insert(array_tree ** avl, array_iter * key)
+static void
+array_dict_rehash(array_dict * d)
 {
-    array_tree *ret;
-    array_tree *p = *avl;
-    int cmp;
-    static short balancep;
+    array_dict_entry **old = d->slots;
+    int oldsize = old ? d->slot_mask + 1 : 0;
+    int size = ARRAY_DICT_SLOTS0;
+    int i;
 
-    assert(avl != NULL);
-    assert(key != NULL);
+    while (size < (d->hashed + 1) * 2)
+        size *= 2;
 
-    if (p) {
-        cmp = array_tree_compare(key, &(p->key), 0);
+    d->slots = calloc((size_t) size, sizeof(array_dict_entry *));
 
-        if (cmp > 0) {
-            ret = array_tree_insert(&(p->right), key);
-        } else if (cmp < 0) {
-            ret = array_tree_insert(&(p->left), key);
-        } else {
-            balancep = 0;
-            return (p);
-        }
+    if (!d->slots) {
+        fprintf(stderr, "array_dict_rehash(): Out of Memory!\n");
+        abort();
+    }
 
-        if (0 != balancep) {
-            *avl = array_tree_balance_node(p);
-        }
+    d->slot_mask = size - 1;
+    d->slots_filled = d->hashed;
 
-        return ret;
-    } else {
-        p = *avl = array_tree_alloc_node(key);
-        balancep = 1;
-        return (p);
+    for (int j = 0; j < oldsize; j++) {
+        if (old[j] && old[j] != &array_dict_deleted) {
+            for (i = (int) (old[j]->hash & (unsigned int) d->slot_mask);
+                 d->slots[i]; i = (i + 1) & d->slot_mask) ;
+
+            d->slots[i] = old[j];
+        }
     }
+
+    free(old);
 }
 
 /**
- * Get the last node in the tree.
+ * Add a key to a dictionary
  *
- * The last node is the rightmost one.
+ * The key must not be in the dictionary already.  The new entry's value
+ * is the integer 0.  The caller keeps arr->items up to date.
  *
  * @private
- * @param list the array to scan
- * @return pointer to 'last node'
+ * @param arr the dictionary array
+ * @param key the key to add; it is copied
+ * @return the new entry
  */
-static array_tree *
-array_tree_last_node(array_tree * list)
+static array_dict_entry *
+array_dict_add(stk_array * arr, const array_iter * key)
 {
-    if (!list)
-        return NULL;
+    array_dict *d = arr->data.dict;
+    array_dict_entry *e;
+    int i;
+
+    if (!d) {
+        d = arr->data.dict = calloc(1, sizeof(array_dict));
 
-    while (list->right)
-        list = list->right;
+        if (!d) {
+            fprintf(stderr, "array_dict_add(): Out of Memory!\n");
+            abort();
+        }
+    }
+
+    if (d->unused) {
+        e = d->unused;
+        d->unused = e->next_unused;
+    } else {
+        e = array_dict_entry_at(d, d->used++);
+    }
+
+    copyinst((array_iter *) key, &e->key);
+    e->data.type = PROG_INTEGER;
+    e->data.line = 0;
+    e->data.data.number = 0;
+    e->next_unused = NULL;
+    e->hashed = (short) array_dict_hash(key, &e->hash);
+    d->count++;
+
+    if (e->hashed) {
+        if ((d->slots_filled + 1) * 4 > (d->slot_mask + 1) * 3)
+            array_dict_rehash(d);
+
+        for (i = (int) (e->hash & (unsigned int) d->slot_mask);
+             d->slots[i] && d->slots[i] != &array_dict_deleted;
+             i = (i + 1) & d->slot_mask) ;
+
+        if (!d->slots[i])
+            d->slots_filled++;
+
+        d->slots[i] = e;
+        d->hashed++;
+    } else if (key->type == PROG_FLOAT) {
+        d->fuzzy_numbers++;
+    }
+
+    /* Keys added in order, as when copying, keep the order good. */
+    if (d->order) {
+        if (!d->order_count || array_tree_compare(key,
+                &d->order[d->order_count - 1]->key, 0) > 0) {
+            if (d->order_count == d->order_size) {
+                d->order_size *= 2;
+                d->order = realloc(d->order, sizeof(array_dict_entry *)
+                                   * (size_t) d->order_size);
+
+                if (!d->order) {
+                    fprintf(stderr, "array_dict_add(): Out of Memory!\n");
+                    abort();
+                }
+            }
+
+            d->order[d->order_count++] = e;
+        } else {
+            free(d->order);
+            d->order = NULL;
+        }
+    }
 
-    return (list);
+    return e;
 }
 
 /**
- * Remove a given key from an AVL tree structure
+ * Remove an entry from a dictionary
  *
- * This does the 'low level' work, you probably want array_tree_delete
- * instead.
+ * This does not touch the ordered entries, which the caller must fix.
  *
  * @private
- * @param key the key to delete
- * @param root the root node to start from.
- * @return the node to delete (it's removed from the tree)
+ * @param d the dictionary
+ * @param e the entry to remove
  */
-static array_tree *
-array_tree_remove_node(array_iter * key, array_tree ** root)
+static void
+array_dict_remove(array_dict * d, array_dict_entry * e)
 {
-    array_tree *save;
-    array_tree *tmp;
-    array_tree *avl;
-    int cmpval;
-    assert(root != NULL);
-    assert(*root != NULL);
-    assert(key != NULL);
-    avl = *root;
-
-    save = avl;
-
-    if (avl) {
-        /* Traverse the tree based on comparison */
-        cmpval = array_tree_compare(key, &(avl->key), 0);
-
-        if (cmpval < 0) {
-            /* Move left if less */
-            save = array_tree_remove_node(key, &(avl->left));
-        } else if (cmpval > 0) {
-            /* Move right if more */
-            save = array_tree_remove_node(key, &(avl->right));
-        } else if (!(avl->left)) { /* we found the node - if it has no left,
-                                    * switch this node to become the right.
-                                    */
-            avl = avl->right;
-        } else if (!(avl->right)) { /* If it has no right, switch it to become
-                                     * the left.
-                                     */
-            avl = avl->left;
-        } else {
-            /* Otherwise, recurse into the left to find the node to
-             * bring up to the current position.
-             */
-            tmp = array_tree_remove_node(&((array_tree_last_node(avl->left))->key),
-                                         &(avl->left));
-            if (!tmp) {    /* this shouldn't be possible. */
-                panic("array_tree_remove_node() returned NULL !");
-            }
+    if (e->hashed) {
+        int i;
 
-            tmp->left = avl->left;
-            tmp->right = avl->right;
-            avl = tmp;
-        }
+        for (i = (int) (e->hash & (unsigned int) d->slot_mask);
+             d->slots[i] != e; i = (i + 1) & d->slot_mask) ;
 
-        /* If we found the node, then blank out the left/right */
-        if (save) {
-            save->left = NULL;
-            save->right = NULL;
-        }
-
-        /* Re-balance the tree */
-        *root = array_tree_balance_node(avl);
+        d->slots[i] = &array_dict_deleted;
+        d->hashed--;
+    } else if (e->key.type == PROG_FLOAT) {
+        d->fuzzy_numbers--;
     }
 
-    return save;
+    CLEAR(&e->key);
+    CLEAR(&e->data);
+    e->key.type = PROG_CLEARED;
+    e->next_unused = d->unused;
+    d->unused = e;
+    d->count--;
 }
 
 /**
- * Remove a given key from an AVL tree structure
- *
- * This is the higher level wrapper around array_tree_remove_node
+ * Remove a key from a dictionary
  *
- * @see array_tree_remove_node
+ * The key is found through the hash table where it can be, so this
+ * doesn't put the entries in key order.  If they already are, the key is
+ * taken out of the ordered entries too.
  *
  * @private
- * @param key the key to delete
- * @param avl the root node to start from.
- * @return the node to delete (it's removed from the tree)
+ * @param d the dictionary, which may be NULL
+ * @param key the key to remove
+ * @return boolean true if the key was there
  */
-static array_tree *
-array_tree_delete(array_iter * key, array_tree * avl)
+static int
+array_dict_delete(array_dict * d, const array_iter * key)
 {
-    array_tree *save;
-    assert(key != NULL);
-    assert(avl != NULL);
+    array_dict_entry *e = array_dict_find(d, key);
+    int i;
+
+    if (!e)
+        return 0;
 
-    if ((save = array_tree_remove_node(key, &avl))) {
-        CLEAR(&(save->key));
-        CLEAR(&(save->data));
-        free(save);
+    if (d->order) {
+        i = array_dict_search(d, &e->key, 0);
+        memmove(&d->order[i], &d->order[i + 1],
+                sizeof(array_dict_entry *) * (size_t) (d->order_count - i - 1));
+        d->order_count--;
+        d->order_hint = 0;
     }
 
-    return avl;
+    array_dict_remove(d, e);
+    return 1;
 }
 
 /**
- * Delete all the nodes in a tree, recursively.
+ * Free a dictionary and everything in it
  *
  * @private
- * @param p the tree to clear out
+ * @param d the dictionary, which may be NULL
  */
 static void
-array_tree_delete_all(array_tree * p)
+array_dict_free(array_dict * d)
 {
-    if (p == NULL)
+    array_dict_entry *e;
+
+    if (!d)
         return;
 
-    array_tree_delete_all(p->left);
-    p->left = NULL;
-    array_tree_delete_all(p->right);
-    p->right = NULL;
-    CLEAR(&(p->key));
-    CLEAR(&(p->data));
-    free(p);
-}
+    for (int i = 0; i < d->used; i++) {
+        e = array_dict_entry_at(d, i);
 
-/**
- * Get the first node in the tree.
- *
- * The first node is the leftmost one.
- *
- * @private
- * @param list the list to scan.
- * @return a pointer to the first node in the tree.
- */
-static array_tree *
-array_tree_first_node(array_tree * list)
-{
-    if (list == NULL)
-        return ((array_tree *) NULL);
+        if (e->key.type != PROG_CLEARED) {
+            CLEAR(&e->key);
+            CLEAR(&e->data);
+        }
+    }
 
-    while (list->left)
-        list = list->left;
+    for (int b = 0; b < ARRAY_DICT_BLOCKS; b++) {
+        free(d->blocks[b]);
+    }
 
-    return (list);
+    free(d->slots);
+    free(d->order);
+    free(d);
 }
 
 /**
- * Get the next previous in the AVL tree
+ * Find the range of keys in a dictionary between two keys
  *
- * @TODO: This has a lot of overlap with prop AVL trees.  Can we merge
- *        the implementations?
+ * This leaves the entries in order, with the range running from
+ * d->order[*first] to d->order[*last].
  *
  * @private
- * @param ptr the source node
- * @param key the next key
- *
- * @return the previous node in the AVL or NULL if there is no previous.
+ * @param d the dictionary, which may be NULL
+ * @param start the lowest key of the range, which need not be there
+ * @param end the highest key of the range, which need not be there
+ * @param first set to the position of the first key in the range
+ * @param last set to the position of the last key in the range
+ * @return boolean true if there are any keys in the range
  */
-static array_tree *
-array_tree_prev_node(array_tree * ptr, array_iter * key)
+static int
+array_dict_range(array_dict * d, const array_iter * start,
+                 const array_iter * end, int *first, int *last)
 {
-    array_tree *from;
-    int cmpval;
-
-    if (ptr == NULL)
-        return NULL;
-
-    if (key == NULL)
-        return NULL;
-
-    cmpval = array_tree_compare(key, &(ptr->key), 0);
-
-    /* If cmpval is greater than our current node, then we need to go right.
-     * If we have a right node, then return it, otherwise the current node
-     * is the previous.
-     */
-    if (cmpval > 0) {
-        from = array_tree_prev_node(ptr->right, key);
-
-        if (from)
-            return from;
-
-        return ptr;
-    } else if (cmpval < 0) {
-        /* If the cmpval is less than our current node, search left */
-        return array_tree_prev_node(ptr->left, key);
-    } else if (ptr->left) {
-        /* Othewise, we match, and we want the rightmost node of oru
-         * left node.
-         */
-        from = ptr->left;
-
-        while (from->right)
-            from = from->right;
+    if (!d || !d->count)
+        return 0;
 
-        return from;
-    } else {
-        /* Otherwise not found */
-        return NULL;
-    }
+    *first = array_dict_search(d, start, 0);
+    *last = array_dict_search(d, end, 1) - 1;
+    return *first <= *last;
 }
 
 /**
- * Get the next node in the AVL tree
+ * Get the entry next to a key in a dictionary, in key order
  *
- * @TODO: This has a lot of overlap with prop AVL trees.  Can we merge
- *        the implementations?
+ * The key itself need not be in the dictionary.
  *
  * @private
- * @param ptr the source node
- * @param key the previous key
- *
- * @return the next node in the AVL or NULL if there is no next.
- */
-static array_tree *
-array_tree_next_node(array_tree * ptr, array_iter * key)
+ * @param d the dictionary, which may be NULL
+ * @param key the key to start from
+ * @param after boolean true for the entry after the key, false for the
+ *              one before it
+ * @return the entry, or NULL if there isn't one
+ */
+static array_dict_entry *
+array_dict_step(array_dict * d, const array_iter * key, int after)
 {
-    array_tree *from;
-    int cmpval;
+    int i;
 
-    if (ptr == NULL)
+    if (!d || !d->count)
         return NULL;
 
-    if (key == NULL)
-        return NULL;
+    i = array_dict_search(d, key, after);
 
-    cmpval = array_tree_compare(key, &(ptr->key), 0);
+    if (!after)
+        i--;
 
-    /* If the node value is less than the key, go left.
-     * Otherwise, go right
-     */
-    if (cmpval < 0) {
-        from = array_tree_next_node(ptr->left, key);
-
-        if (from)
-            return from;
-
-        return ptr;
-    } else if (cmpval > 0) {
-        return array_tree_next_node(ptr->right, key);
-    } else if (ptr->right) {
-        /* We found the key -- the next key will be the leftmost node
-         * of our right node.
-         */
-        from = ptr->right;
-
-        while (from->left)
-            from = from->left;
-
-        return from;
-    } else {
-        /* If we have no right node, there's no next.  Return NULL */
+    if (i < 0 || i >= d->order_count)
         return NULL;
-    }
+
+    d->order_hint = i;
+    return d->order[i];
 }
 
 /*****************************************************************
@@ -1208,18 +1218,19 @@ array_decouple(stk_array * arr)
         }
 
         case ARRAY_DICTIONARY:{
-            array_iter idx;
-            array_data *val;
+            array_dict *d = arr->data.dict;
+            array_dict_entry *e;
 
-            /* When iterating over the dictionary, 'array_setitem' will
-             * make a copy of the item provided.
+            /* The keys are already known to be different, so they can
+             * go straight in without looking for them first.
              */
-            if (array_first(arr, &idx)) {
-                do {
-                    val = array_getitem(arr, &idx);
-                    assert(val != NULL);
-                    array_setitem(&nu, &idx, val);
-                } while (array_next(arr, &idx));
+            for (int i = 0; d && i < d->used; i++) {
+                e = array_dict_entry_at(d, i);
+
+                if (e->key.type != PROG_CLEARED) {
+                    copyinst(&e->data, &array_dict_add(nu, &e->key)->data);
+                    nu->items++;
+                }
             }
 
             return nu;
@@ -1263,7 +1274,7 @@ array_free(stk_array * arr)
             break;
         }
         case ARRAY_DICTIONARY:
-            array_tree_delete_all(arr->data.dict);
+            array_dict_free(arr->data.dict);
             break;
         default:{
             assert(0);      /* should never get here */
@@ -1322,14 +1333,13 @@ array_first(stk_array * arr, array_iter * item)
             return 1;
         }
         case ARRAY_DICTIONARY:{
-            array_tree *p;
+            array_dict *d = arr->data.dict;
 
-            p = array_tree_first_node(arr->data.dict);
-
-            if (p == NULL)
+            if (!d || !d->count)
                 return 0;
 
-            copyinst(&p->key, item);
+            array_dict_sort(d);
+            copyinst(&d->order[0]->key, item);
             return 1;
         }
         default:
@@ -1366,14 +1376,13 @@ array_last(stk_array * arr, array_iter * item)
             return 1;
         }
         case ARRAY_DICTIONARY:{
-            array_tree *p;
+            array_dict *d = arr->data.dict;
 
-            p = array_tree_last_node(arr->data.dict);
-
-            if (p == NULL)
+            if (!d || !d->count)
                 return 0;
 
-            copyinst(&p->key, item);
+            array_dict_sort(d);
+            copyinst(&d->order[d->order_count - 1]->key, item);
             return 1;
         }
         default:
@@ -1436,9 +1445,9 @@ array_prev(stk_array * arr, array_iter * item)
             return 1;
         }
         case ARRAY_DICTIONARY:{
-            array_tree *p;
+            array_dict_entry *p;
 
-            p = array_tree_prev_node(arr->data.dict, item);
+            p = array_dict_step(arr->data.dict, item, 0);
             CLEAR(item);
 
             if (!p)
@@ -1507,9 +1516,9 @@ array_next(stk_array * arr, array_iter * item)
             return 1;
         }
         case ARRAY_DICTIONARY:{
-            array_tree *p;
+            array_dict_entry *p;
 
-            p = array_tree_next_node(arr->data.dict, item);
+            p = array_dict_step(arr->data.dict, item, 1);
             CLEAR(item);
 
             if (!p)
@@ -1558,9 +1567,9 @@ array_getitem(stk_array * arr, array_iter * idx)
             return &arr->data.packed[idx->data.number];
 
         case ARRAY_DICTIONARY:{
-            array_tree *p;
+            array_dict_entry *p;
 
-            p = array_tree_find(arr->data.dict, idx);
+            p = array_dict_find(arr->data.dict, idx);
 
             if (!p) {
                 return NULL;
@@ -1650,20 +1659,20 @@ array_setitem(stk_array ** harr, array_iter * idx, array_data * item)
             /* @TODO: This is a copy/paste from array_insertitem.  This
              *        should definitely not be duplicated.
              */
-            array_tree *p;
+            array_dict_entry *p;
 
             if (arr->links > 1 && !arr->pinned) {
                 arr->links--;
                 arr = *harr = array_decouple(arr);
             }
 
-            p = array_tree_find(arr->data.dict, idx);
+            p = array_dict_find(arr->data.dict, idx);
 
             if (p) {
                 CLEAR(&p->data);
             } else {
                 arr->items++;
-                p = array_tree_insert(&arr->data.dict, idx);
+                p = array_dict_add(arr, idx);
             }
 
             copyinst(item, &p->data);
@@ -1739,20 +1748,20 @@ array_insertitem(stk_array ** harr, array_iter * idx, array_data * item)
         }
 
         case ARRAY_DICTIONARY:{
-            array_tree *p;
+            array_dict_entry *p;
 
             if (arr->links > 1 && !arr->pinned) {
                 arr->links--;
                 arr = *harr = array_decouple(arr);
             }
 
-            p = array_tree_find(arr->data.dict, idx);
+            p = array_dict_find(arr->data.dict, idx);
 
             if (p) {
                 CLEAR(&p->data);
             } else {
                 arr->items++;
-                p = array_tree_insert(&arr->data.dict, idx);
+                p = array_dict_add(arr, idx);
             }
 
             copyinst(item, &p->data);
@@ -1895,42 +1904,21 @@ array_getrange(stk_array * arr, array_iter * start, array_iter * end, int pin)
         }
 
         case ARRAY_DICTIONARY:{
-            array_tree *s;
-            array_tree *e;
+            array_dict *d = arr->data.dict;
+            array_dict_entry *e;
+            int first, last;
 
             nu = new_array_dictionary(pin);
-            s = array_tree_find(arr->data.dict, start);
 
-            /* Do sanity checks */
-            if (!s) {
-                s = array_tree_next_node(arr->data.dict, start);
-
-                if (!s) {
-                    return nu;
-                }
-            }
-
-            e = array_tree_find(arr->data.dict, end);
-
-            if (!e) {
-                e = array_tree_prev_node(arr->data.dict, end);
-
-                if (!e) {
-                    return nu;
-                }
-            }
-
-            if (array_tree_compare(&s->key, &e->key, 0) > 0) {
+            if (!array_dict_range(d, start, end, &first, &last)) {
                 return nu;
             }
 
-            while (s) {
-                array_setitem(&nu, &s->key, &s->data);
-
-                if (s == e)
-                    break;
-
-                s = array_tree_next_node(arr->data.dict, &s->key);
+            /* The keys go in already in order. */
+            for (int i = first; i <= last; i++) {
+                e = d->order[i];
+                copyinst(&e->data, &array_dict_add(nu, &e->key)->data);
+                nu->items++;
             }
 
             return nu;
@@ -2298,33 +2286,10 @@ array_delrange(stk_array ** harr, array_iter * start, array_iter * end)
         }
 
         case ARRAY_DICTIONARY:{
-            array_tree *s;
-            array_tree *e;
-
-            /* Find the keys in the range and do some sanity checking.
-             * Start must be 'before' end.
-             */
-            s = array_tree_find(arr->data.dict, start);
-
-            if (!s) {
-                s = array_tree_next_node(arr->data.dict, start);
+            array_dict *d;
 
-                if (!s) {
-                    return arr->items;
-                }
-            }
-
-            e = array_tree_find(arr->data.dict, end);
-
-            if (!e) {
-                e = array_tree_prev_node(arr->data.dict, end);
-
-                if (!e) {
-                    return arr->items;
-                }
-            }
-
-            if (array_tree_compare(&s->key, &e->key, 0) > 0) {
+            /* Find the keys in the range.  There may not be any. */
+            if (!array_dict_range(arr->data.dict, start, end, &sidx, &eidx)) {
                 return arr->items;
             }
 
@@ -2334,21 +2299,21 @@ array_delrange(stk_array ** harr, array_iter * start, array_iter * end)
             if (arr->links > 1 && !arr->pinned) {
                 arr->links--;
                 arr = *harr = array_decouple(arr);
+                array_dict_range(arr->data.dict, start, end, &sidx, &eidx);
             }
 
-            copyinst(&s->key, &idx);
+            d = arr->data.dict;
 
-            /* Iterate over the structure and delete nodes as we go along */
-            while (s && array_tree_compare(&s->key, &e->key, 0) <= 0) {
-                arr->data.dict = array_tree_delete(&s->key, arr->data.dict);
+            for (int i = sidx; i <= eidx; i++) {
+                array_dict_remove(d, d->order[i]);
                 arr->items--;
-
-                if (s == e) break;
-
-                s = array_tree_next_node(arr->data.dict, &idx);
             }
 
-            CLEAR(&idx);
+            /* Close the gap, which leaves the rest in order. */
+            memmove(&d->order[sidx], &d->order[eidx + 1],
+                    sizeof(array_dict_entry *) * (size_t) (d->order_count - eidx - 1));
+            d->order_count -= eidx - sidx + 1;
+            d->order_hint = 0;
             return arr->items;
         }
 
@@ -2365,7 +2330,8 @@ array_delrange(stk_array ** harr, array_iter * start, array_iter * end)
 /**
  * Delete an item from an array
  *
- * This just uses array_delrange under the hood.
+ * Dictionaries look the key up directly, so deleting keys doesn't need
+ * them in key order.  Other arrays use array_delrange under the hood.
  *
  * @see array_delrange
  *
@@ -2376,6 +2342,7 @@ array_delrange(stk_array ** harr, array_iter * start, array_iter * end)
 int
 array_delitem(stk_array ** harr, array_iter * item)
 {
+    stk_array *arr;
     array_iter idx;
     int result;
 
@@ -2383,6 +2350,25 @@ array_delitem(stk_array ** harr, array_iter * item)
     assert(*harr != NULL);
     assert(item != NULL);
 
+    arr = *harr;
+
+    if (arr->type == ARRAY_DICTIONARY) {
+        if (!array_dict_find(arr->data.dict, item))
+            return arr->items;
+
+        /* If this array has multiple references and its not
+         * pinned, we need to make a copy to make changes on.
+         */
+        if (arr->links > 1 && !arr->pinned) {
+            arr->links--;
+            arr = *harr = array_decouple(arr);
+        }
+
+        array_dict_delete(arr->data.dict, item);
+        arr->items--;
+        return arr->items;
+    }
+
     copyinst(item, &idx);
     result = array_delrange(harr, item, &idx);
     CLEAR(&idx);
@@ -2932,7 +2918,7 @@ array_free_all_on_list(stk_array_list *list) {
                 arr->data.packed[0].data.number = 0;
                 break;
             case ARRAY_DICTIONARY:
-                array_tree_delete_all(arr->data.dict);
+                array_dict_free(arr->data.dict);
                 arr->data.dict = NULL;
                 break;
             default:
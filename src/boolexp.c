@@ -97,7 +97,8 @@ copy_bool(struct boolexp *old)
             switch (PropType(old->data.prop_check)) {
                 case PROP_STRTYP:
                     SetPDataStr(o->data.prop_check,
-                                alloc_string(PropDataStr(old->data.prop_check)));
+                                PropDataStr(old->data.prop_check));
+                    hold_interned(PropDataStr(o->data.prop_check), 1);
                     break;
                 default:
                     SetPDataVal(o->data.prop_check, PropDataVal(old->data.prop_check));
@@ -731,7 +732,7 @@ parse_boolprop(char *buf)
     b->sub1 = b->sub2 = 0;
     b->data.thing = NOTHING;
     b->data.prop_check = p = alloc_propnode(type);
-    SetPDataStr(p, alloc_string(strval));
+    SetPDataStr(p, alloc_interned(strval));
     SetPType(p, PROP_STRTYP);
     free(x);
     return b;
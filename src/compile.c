@@ -6,7 +6,9 @@
  */
 
 #include <ctype.h>
+#include <float.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,6 +33,7 @@
 #include "log.h"
 #include "match.h"
 #include "mcp.h"
+#include "mufcache.h"
 #include "props.h"
 #include "timequeue.h"
 #include "tune.h"
@@ -73,7 +76,7 @@
 #define v_abort_compile(ST,C) { do_abort_compile(ST,C); return; }
 #define free_prog(i) free_prog_real(i,__FILE__,__LINE__);
 
-static hash_tab primitive_list[COMP_HASH_SIZE];
+static hash_tab primitive_list;
 
 /**
  * @var the array that has all of our primitive names.
@@ -124,6 +127,26 @@ struct PROC_LIST {
 
 #define IMMFLAG_REFERENCED      1   /* Referenced by a jump */
 
+/* The kinds of optimization the optimizer counts */
+#define OPTIM_FOLD      0   /* Constant expressions folded */
+#define OPTIM_DEADCODE  1   /* Unreachable instructions removed */
+#define OPTIM_JUMP      2   /* Jumps simplified */
+#define OPTIM_PEEPHOLE  3   /* Instruction sequences simplified */
+#define OPTIM_FUSE      4   /* Sequences replaced by one primitive */
+#define OPTIM_KINDS     5   /* Number of kinds */
+
+/**
+ * @private
+ * @var the names of the OPTIM_* kinds, for compiler output
+ */
+static const char *optim_kind_names[OPTIM_KINDS] = {
+    "Constant expressions folded",
+    "Unreachable instructions removed",
+    "Jumps simplified",
+    "Peephole rewrites",
+    "Superinstructions formed"
+};
+
 struct INTERMEDIATE {
     int no;                     /* which number instruction this is */
     struct inst in;             /* instruction itself */
@@ -173,7 +196,15 @@ typedef struct COMPILE_STATE_T {
     int descr;                  /* the descriptor that initiated compiling */
     int force_err_display;      /* If true, always show compiler errors. */
     struct INTERMEDIATE *nextinst;
-    hash_tab defhash[DEFHASHSIZE];
+    hash_tab defhash;
+
+    /* Things the compiled code depends on, for the compiled program cache */
+    dbref *deps;                /* objects whose _defs/ were included */
+    int depcount;               /* number of entries in deps */
+    int depmax;                 /* allocated size of deps */
+    int cacheable;              /* 0 if the result can't be cached */
+
+    int optimizations[OPTIM_KINDS]; /* optimizations made, by OPTIM_* */
 } COMPSTATE;
 
 /* These are globally available as externs */
@@ -339,9 +370,13 @@ cleanup(COMPSTATE * cstat)
 
     cstat->procs = 0;
 
-    kill_hash(cstat->defhash, DEFHASHSIZE, 1);
+    kill_hash(&cstat->defhash, 1);
     free_addresses(cstat);
 
+    free(cstat->deps);
+    cstat->deps = NULL;
+    cstat->depcount = cstat->depmax = 0;
+
     for (int i = RES_VAR; i < MAX_VAR && cstat->variables[i]; i++) {
         free((void *) cstat->variables[i]);
         cstat->variables[i] = 0;
@@ -581,7 +616,7 @@ size_pubs(struct publics *mypubs)
 static char *
 expand_def(COMPSTATE * cstat, const char *defname)
 {
-    hash_data *exp = find_hash(defname, cstat->defhash, DEFHASHSIZE);
+    hash_data *exp = find_hash(defname, &cstat->defhash);
 
     /*
      * If the definition is not in our definition hash, is it a macro?
@@ -590,7 +625,16 @@ expand_def(COMPSTATE * cstat, const char *defname)
      */
     if (!exp) {
         if (*defname == BEGINMACRO) {
-            return (macro_expansion(&defname[1]));
+            char *expansion = macro_expansion(&defname[1]);
+
+            /*
+             * The compiled program cache doesn't track the macros, so it
+             * can't tell if one has been changed.
+             */
+            if (expansion)
+                cstat->cacheable = 0;
+
+            return expansion;
         } else {
             return (NULL);
         }
@@ -613,11 +657,11 @@ expand_def(COMPSTATE * cstat, const char *defname)
 static void
 kill_def(COMPSTATE * cstat, const char *defname)
 {
-    hash_data *exp = find_hash(defname, cstat->defhash, DEFHASHSIZE);
+    hash_data *exp = find_hash(defname, &cstat->defhash);
 
     if (exp) {
         free(exp->pval);
-        (void) free_hash(defname, cstat->defhash, DEFHASHSIZE);
+        (void) free_hash(defname, &cstat->defhash);
     }
 }
 
@@ -638,7 +682,7 @@ insert_def(COMPSTATE * cstat, const char *defname, const char *deff)
 
     (void) kill_def(cstat, defname);
     hd.pval = strdup(deff);
-    (void) add_hash(defname, hd, cstat->defhash, DEFHASHSIZE);
+    (void) add_hash(defname, hd, &cstat->defhash);
 }
 
 /**
@@ -677,7 +721,25 @@ include_defs(COMPSTATE * cstat, dbref i)
     char dirname[BUFFER_LEN];
     char temp[BUFFER_LEN];
     const char *tmpptr;
-    PropPtr j, pptr;
+    PropPtr j;
+    PropDirPtr pptr;
+    int k;
+
+    /* Remember where definitions came from, for the compiled program cache */
+    for (k = 0; k < cstat->depcount && cstat->deps[k] != i; k++) ;
+
+    if (k == cstat->depcount) {
+        if (cstat->depcount == cstat->depmax) {
+            cstat->depmax = cstat->depmax ? cstat->depmax * 2 : 8;
+            cstat->deps = realloc(cstat->deps, sizeof(dbref) * (size_t)cstat->depmax);
+
+            if (!cstat->deps) {
+                panic("include_defs(): Out of memory");
+            }
+        }
+
+        cstat->deps[cstat->depcount++] = i;
+    }
 
     snprintf(dirname, sizeof(dirname), "/%s/", DEFINES_PROPDIR);
     j = first_prop(i, dirname, &pptr, temp, sizeof(temp));
@@ -846,9 +908,7 @@ static void
 init_defs(COMPSTATE * cstat)
 {
     /* initialize hash table */
-    for (int i = 0; i < DEFHASHSIZE; i++) {
-        cstat->defhash[i] = NULL;
-    }
+    memset(&cstat->defhash, 0, sizeof(cstat->defhash));
 
     /* Create standard server defines */
     include_internal_defs(cstat);
@@ -1112,8 +1172,8 @@ MaybeOptimizeVarsAt(COMPSTATE * cstat, struct INTERMEDIATE *first, int AtNo,
  * the memory of the removed item in the linked list.  The
  * number of words book-keeping is also updated.
  *
- * The offset lists aren't updated which is a little fishy to me,
- * but this seems to work so I won't complain about it.
+ * The offset lists aren't updated, as OptimizeIntermediate points
+ * each address straight at its target before optimizing.
  *
  * NULL checking is done so if the next node does not exist, this
  * will not crash.
@@ -1237,57 +1297,794 @@ IntermediateIsPrimitive(struct INTERMEDIATE *ptr, int primnum)
 }
 
 /**
- * Is the given INTERMEDIATE an integer of value 'val'?
+ * Remove an INTERMEDIATE by moving the one after it into its place
+ *
+ * This is RemoveIntermediate for when 'curr' may end up holding the target
+ * of a jump.  'curr' takes over the flags the moved instruction had in
+ * 'Flags', so later optimizations still leave it alone.
  *
  * @private
- * @param ptr the intermediate to check
- * @param val the value to check for
- * @return boolean true if ptr is an integer of value val, false otherwise
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param curr the INTERMEDIATE node to remove from the list
+ */
+static void
+ReplaceWithNextIntermediate(COMPSTATE * cstat, int *Flags,
+                            struct INTERMEDIATE *curr)
+{
+    if (!curr->next)
+        return;
+
+    Flags[curr->no] |= Flags[curr->next->no];
+    RemoveIntermediate(cstat, curr);
+}
+
+/**
+ * Find the INTERMEDIATE an address refers to
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param addr the address, an index into 'addrlist' and 'addroffsets'
+ * @return the INTERMEDIATE, or NULL if the address is past the end
+ */
+static struct INTERMEDIATE *
+IntermediateTarget(COMPSTATE * cstat, int addr)
+{
+    struct INTERMEDIATE *ptr = cstat->addrlist[addr];
+
+    for (int i = cstat->addroffsets[addr]; ptr && i > 0; i--)
+        ptr = ptr->next;
+
+    return ptr;
+}
+
+/**
+ * Warn about a constant expression that can't be folded
+ *
+ * Each warning is only given once for each instruction, as the optimizer
+ * can look at the same instructions several times.
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param op the primitive the warning is about
+ * @param flag the INTMEDFLG_* for the warning
+ * @param msg the warning
+ * @param force_err_display boolean if true, the warning is displayed
+ *        to cstat->player
+ */
+static void
+ConstantWarning(COMPSTATE * cstat, struct INTERMEDIATE *op, int flag,
+                const char *msg, int force_err_display)
+{
+    if (op->flags & flag)
+        return;
+
+    op->flags |= flag;
+
+    if (force_err_display) {
+        notifyf(cstat->player, "Warning on line %i: %s", op->in.line, msg);
+    }
+}
+
+/**
+ * Fold an integer constant followed by a primitive that uses it
+ *
+ * Handles NOT and INTOSTR on an integer, and STRLEN on a string.
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param curr the constant
+ * @return boolean true if the constant and primitive were folded
  */
 static int
-IntermediateIsInteger(struct INTERMEDIATE *ptr, int val)
+FoldUnaryConstant(COMPSTATE * cstat, int *Flags, struct INTERMEDIATE *curr)
 {
-    if (ptr && ptr->in.type == PROG_INTEGER) {
-        if (ptr->in.data.number == val) {
-            return 1;
+    struct INTERMEDIATE *op = curr->next;
+    char buf[BUFFER_LEN];
+
+    if (!ContiguousIntermediates(Flags, op, 1) || op->in.type != PROG_PRIMITIVE)
+        return 0;
+
+    if (curr->in.type == PROG_INTEGER) {
+        if (op->in.data.number == get_primitive("not")) {
+            curr->in.data.number = !curr->in.data.number;
+        } else if (op->in.data.number == get_primitive("intostr")) {
+            snprintf(buf, sizeof(buf), "%d", curr->in.data.number);
+            curr->in.type = PROG_STRING;
+            curr->in.data.string = alloc_prog_string(buf);
+        } else {
+            return 0;
         }
+    } else if (curr->in.type == PROG_STRING) {
+        if (op->in.data.number == get_primitive("strlen")) {
+            int len = curr->in.data.string ? curr->in.data.string->length : 0;
+
+            free(curr->in.data.string);
+            curr->in.type = PROG_INTEGER;
+            curr->in.data.number = len;
+        } else {
+            return 0;
+        }
+    } else {
+        return 0;
     }
 
-    return 0;
+    RemoveNextIntermediate(cstat, curr);
+    cstat->optimizations[OPTIM_FOLD]++;
+    return 1;
+}
+
+/**
+ * Fold two integer constants and the operator after them into one
+ *
+ * If the result would overflow, or the operation divides by zero, the
+ * code is left alone so it fails when run, and a warning is given.
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param curr the first constant
+ * @param force_err_display boolean if true, warnings will be displayed
+ *        to cstat->player
+ * @return boolean true if the constants were folded
+ */
+static int
+FoldIntegers(COMPSTATE * cstat, struct INTERMEDIATE *curr,
+             int force_err_display)
+{
+    struct INTERMEDIATE *op = curr->next->next;
+    int a = curr->in.data.number;
+    int b = curr->next->in.data.number;
+    int prim = op->in.data.number;
+    double tl;
+    int result;
+
+    if (prim == get_primitive("+")) {
+        tl = (double) a + (double) b;
+
+        if (!arith_good(tl)) {
+            ConstantWarning(cstat, op, INTMEDFLG_OVERFLOW,
+                            "Constant addition leads to overflow",
+                            force_err_display);
+            return 0;
+        }
+
+        result = a + b;
+    } else if (prim == get_primitive("-")) {
+        tl = (double) a - (double) b;
+
+        if (!arith_good(tl)) {
+            ConstantWarning(cstat, op, INTMEDFLG_OVERFLOW,
+                            "Constant subtraction leads to overflow",
+                            force_err_display);
+            return 0;
+        }
+
+        result = a - b;
+    } else if (prim == get_primitive("*")) {
+        tl = (double) a * (double) b;
+
+        if (!arith_good(tl)) {
+            ConstantWarning(cstat, op, INTMEDFLG_OVERFLOW,
+                            "Constant multiplication leads to overflow",
+                            force_err_display);
+            return 0;
+        }
+
+        result = a * b;
+    } else if (prim == get_primitive("/") || prim == get_primitive("%")) {
+        int divide = prim == get_primitive("/");
+
+        if (b == 0) {
+            ConstantWarning(cstat, op,
+                            divide ? INTMEDFLG_DIVBYZERO : INTMEDFLG_MODBYZERO,
+                            divide ? "Divide by zero" : "Modulus by zero",
+                            force_err_display);
+            return 0;
+        }
+
+        if (b == -1 && a == INT_MIN) {
+            ConstantWarning(cstat, op, INTMEDFLG_OVERFLOW, "Integer overflow",
+                            force_err_display);
+            return 0;
+        }
+
+        result = divide ? a / b : a % b;
+    } else if (prim == get_primitive("=")) {
+        result = a == b;
+    } else if (prim == get_primitive("!=")) {
+        result = a != b;
+    } else if (prim == get_primitive("<")) {
+        result = a < b;
+    } else if (prim == get_primitive(">")) {
+        result = a > b;
+    } else if (prim == get_primitive("<=")) {
+        result = a <= b;
+    } else if (prim == get_primitive(">=")) {
+        result = a >= b;
+    } else if (prim == get_primitive("bitor")) {
+        result = a | b;
+    } else if (prim == get_primitive("bitand")) {
+        result = a & b;
+    } else if (prim == get_primitive("bitxor")) {
+        result = a ^ b;
+    } else {
+        return 0;
+    }
+
+    curr->in.data.number = result;
+    return 1;
+}
+
+/**
+ * Fold two numeric constants, at least one a float, and their operator
+ *
+ * Only + - * and / are folded, and only when neither the operands nor the
+ * result are infinite or not a number, since the interpreter's handling
+ * of those depends on the ieee_bounds_handling tune parameter.
+ *
+ * @private
+ * @param curr the first constant
+ * @return boolean true if the constants were folded
+ */
+static int
+FoldFloats(struct INTERMEDIATE *curr)
+{
+    struct INTERMEDIATE *arg2 = curr->next;
+    int prim = arg2->next->in.data.number;
+    double a, b, result;
+
+    a = curr->in.type == PROG_FLOAT ? curr->in.data.fnumber
+                                    : curr->in.data.number;
+    b = arg2->in.type == PROG_FLOAT ? arg2->in.data.fnumber
+                                    : arg2->in.data.number;
+
+    if (no_good(a) || no_good(b))
+        return 0;
+
+    if (prim == get_primitive("+")) {
+        result = a + b;
+    } else if (prim == get_primitive("-")) {
+        result = a - b;
+    } else if (prim == get_primitive("*")) {
+        result = a * b;
+    } else if (prim == get_primitive("/") && fabs(b) >= DBL_EPSILON) {
+        result = a / b;
+    } else {
+        return 0;
+    }
+
+    if (no_good(result))
+        return 0;
+
+    curr->in.type = PROG_FLOAT;
+    curr->in.data.fnumber = result;
+    return 1;
+}
+
+/**
+ * Fold two string constants and a STRCAT or + after them into one
+ *
+ * The strings are left alone if the result would be too long.
+ *
+ * @private
+ * @param curr the first constant
+ * @return boolean true if the constants were folded
+ */
+static int
+FoldStrings(struct INTERMEDIATE *curr)
+{
+    struct shared_string *s1 = curr->in.data.string;
+    struct shared_string *s2 = curr->next->in.data.string;
+    int prim = curr->next->next->in.data.number;
+    int len1 = s1 ? s1->length : 0;
+    int len2 = s2 ? s2->length : 0;
+    char buf[BUFFER_LEN];
+
+    if (prim != get_primitive("strcat") && prim != get_primitive("+"))
+        return 0;
+
+    if (len1 + len2 > BUFFER_LEN - 1)
+        return 0;
+
+    memcpy(buf, DoNullInd(s1), (size_t)len1);
+    memcpy(buf + len1, DoNullInd(s2), (size_t)len2);
+    buf[len1 + len2] = '\0';
+
+    curr->in.data.string = alloc_prog_string(buf);
+    free(s1);
+    return 1;
+}
+
+/**
+ * Fold two string constants that are appended one after the other
+ *
+ * "a" strcat "b" strcat  ==>  "ab" strcat
+ *
+ * The strings are left alone if the result would be too long.
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param curr the first string
+ * @return boolean true if the strings were folded
+ */
+static int
+FoldStringAppends(COMPSTATE * cstat, int *Flags, struct INTERMEDIATE *curr)
+{
+    int StrcatNo = get_primitive("strcat");
+    struct INTERMEDIATE *next = curr->next;
+
+    if (curr->in.type != PROG_STRING || !ContiguousIntermediates(Flags, next, 3)
+        || !IntermediateIsPrimitive(next, StrcatNo)
+        || next->next->in.type != PROG_STRING
+        || !IntermediateIsPrimitive(next->next->next, StrcatNo))
+        return 0;
+
+    /* Move the second string next to the first, and fold them */
+    next->in = next->next->in;
+    next->next->in.type = PROG_PRIMITIVE;
+    next->next->in.data.number = StrcatNo;
+
+    if (!FoldStrings(curr)) {
+        next->next->in = next->in;
+        next->in.type = PROG_PRIMITIVE;
+        next->in.data.number = StrcatNo;
+        return 0;
+    }
+
+    RemoveNextIntermediate(cstat, curr);
+    RemoveNextIntermediate(cstat, curr);
+    cstat->optimizations[OPTIM_FOLD]++;
+    return 1;
+}
+
+/**
+ * Fold two constants followed by an operator into one constant
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param curr the first constant
+ * @param force_err_display boolean if true, warnings will be displayed
+ *        to cstat->player
+ * @return boolean true if the constants and operator were folded
+ */
+static int
+FoldBinaryConstant(COMPSTATE * cstat, int *Flags, struct INTERMEDIATE *curr,
+                   int force_err_display)
+{
+    struct INTERMEDIATE *arg2 = curr->next;
+    int type1 = curr->in.type;
+    int type2;
+    int folded = 0;
+
+    if (!ContiguousIntermediates(Flags, arg2, 2)
+        || arg2->next->in.type != PROG_PRIMITIVE)
+        return 0;
+
+    type2 = arg2->in.type;
+
+    if (type1 == PROG_INTEGER && type2 == PROG_INTEGER) {
+        folded = FoldIntegers(cstat, curr, force_err_display);
+    } else if ((type1 == PROG_INTEGER || type1 == PROG_FLOAT)
+               && (type2 == PROG_INTEGER || type2 == PROG_FLOAT)) {
+        folded = FoldFloats(curr);
+    } else if (type1 == PROG_STRING && type2 == PROG_STRING) {
+        folded = FoldStrings(curr);
+    }
+
+    if (!folded)
+        return 0;
+
+    RemoveNextIntermediate(cstat, curr);
+    RemoveNextIntermediate(cstat, curr);
+    cstat->optimizations[OPTIM_FOLD]++;
+    return 1;
 }
 
 /**
- * Is the given INTERMEDIATE an string of value 'val'?
+ * Simplify a jump
+ *
+ * - A jump or IF to an unconditional jump goes straight to where that
+ *   jump goes.
+ * - A jump to an EXIT becomes an EXIT.
+ * - A jump to the next instruction is removed, and an IF to the next
+ *   instruction becomes a POP.
+ * - A constant followed by IF either becomes a jump or is removed.
  *
  * @private
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param curr the instruction to look at
+ * @return boolean true if anything was changed
+ */
+static int
+OptimizeJump(COMPSTATE * cstat, int *Flags, struct INTERMEDIATE *curr)
+{
+    struct INTERMEDIATE *target;
+    int changed = 0;
+
+    /* constant if  ==>  jmp, or nothing */
+    if (curr->in.type == PROG_INTEGER && ContiguousIntermediates(Flags, curr->next, 1)
+        && curr->next->in.type == PROG_IF) {
+        if (curr->in.data.number) {
+            if (!curr->next->next)
+                return 0;
+
+            RemoveNextIntermediate(cstat, curr);
+            ReplaceWithNextIntermediate(cstat, Flags, curr);
+        } else {
+            curr->in.type = PROG_JMP;
+            curr->in.data.number = curr->next->in.data.number;
+            RemoveNextIntermediate(cstat, curr);
+        }
+
+        cstat->optimizations[OPTIM_JUMP]++;
+        return 1;
+    }
+
+    if (curr->in.type != PROG_JMP && curr->in.type != PROG_IF)
+        return 0;
+
+    /* Chains of jumps can loop, so give up after a while */
+    for (int hops = 0; hops < 8; hops++) {
+        target = IntermediateTarget(cstat, curr->in.data.number);
+
+        if (!target || target->in.type != PROG_JMP
+            || target->in.data.number == curr->in.data.number)
+            break;
+
+        curr->in.data.number = target->in.data.number;
+        changed = 1;
+    }
+
+    target = IntermediateTarget(cstat, curr->in.data.number);
+
+    if (curr->in.type == PROG_JMP && target
+        && IntermediateIsPrimitive(target, IN_RET)) {
+        curr->in.type = PROG_PRIMITIVE;
+        curr->in.data.number = IN_RET;
+        changed = 1;
+    } else if (target && target == curr->next) {
+        if (curr->in.type == PROG_JMP) {
+            ReplaceWithNextIntermediate(cstat, Flags, curr);
+        } else {
+            curr->in.type = PROG_PRIMITIVE;
+            curr->in.data.number = get_primitive("pop");
+        }
+
+        changed = 1;
+    }
+
+    if (changed)
+        cstat->optimizations[OPTIM_JUMP]++;
+
+    return changed;
+}
+
+/**
+ * Remove the instructions after a jump or EXIT that can never be reached
+ *
+ * Instructions are unreachable until the next one that is the target of a
+ * jump or the start of a procedure.
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param curr the instruction to look at
+ * @return boolean true if anything was removed
+ */
+static int
+RemoveUnreachable(COMPSTATE * cstat, int *Flags, struct INTERMEDIATE *curr)
+{
+    int removed = 0;
+
+    if (curr->in.type != PROG_JMP && !IntermediateIsPrimitive(curr, IN_RET)
+        && !IntermediateIsPrimitive(curr, IN_JMP))
+        return 0;
+
+    while (curr->next && !(Flags[curr->next->no] & IMMFLAG_REFERENCED)
+           && curr->next->in.type != PROG_FUNCTION) {
+        RemoveNextIntermediate(cstat, curr);
+        removed++;
+    }
+
+    cstat->optimizations[OPTIM_DEADCODE] += removed;
+    return removed > 0;
+}
+
+/*
+ * The peephole optimizations are kept in a table.  Each one is a short
+ * run of instructions to look for, and what to do to each of them when
+ * they are found.  None of the instructions after the first may be the
+ * target of a jump, and every optimization must remove at least one
+ * instruction.
+ */
+
+/* What an optimization does to an instruction it matched */
+typedef enum {
+    OI_KEEP,        /* leave it as it is */
+    OI_DELETE,      /* remove it */
+    OI_CHGPRIM,     /* replace it with the primitive 'newprim' */
+    OI_CHGTYPE      /* keep its value, but change its type to 'newtype' */
+} OI_ACTION;
+
+/* One instruction of an optimization */
+struct optim_step {
+    int type;               /* the instruction type to match */
+    int any;                /* if true, any value of 'type' matches */
+    int number;             /* the integer or variable number to match */
+    const char *text;       /* the primitive name or string to match */
+    OI_ACTION action;       /* what to do to the instruction */
+    int newtype;            /* the new type, for OI_CHGTYPE */
+    const char *newprim;    /* the new primitive, for OI_CHGPRIM */
+};
+
+#define OPTIM_MAX_STEPS 4   /* the most instructions an optimization matches */
+
+/* A run of instructions, and what to do with them */
+struct optimization {
+    int kind;                                   /* the OPTIM_* it counts as */
+    int count;                                  /* instructions matched */
+    struct optim_step steps[OPTIM_MAX_STEPS];   /* the instructions */
+};
+
+#define OI_PRIM(name, action, newprim) \
+    { PROG_PRIMITIVE, 0, 0, name, action, 0, newprim }
+#define OI_INT(val, action, newprim) \
+    { PROG_INTEGER, 0, val, NULL, action, 0, newprim }
+#define OI_STR(val, action, newprim) \
+    { PROG_STRING, 0, 0, val, action, 0, newprim }
+#define OI_VAR(val, action, newprim) \
+    { PROG_VAR, 0, val, NULL, action, 0, newprim }
+#define OI_TYPE(type, action, newtype) \
+    { type, 1, 0, NULL, action, newtype, NULL }
+
+/**
+ * @private
+ * @var the peephole optimizations, tried in order at each instruction
+ */
+static const struct optimization optimizations[] = {
+    /* me @ swap notify  ==>  tell */
+    { OPTIM_FUSE, 4, { OI_VAR(0, OI_CHGPRIM, "tell"),
+                       OI_PRIM("@", OI_DELETE, NULL),
+                       OI_PRIM("swap", OI_DELETE, NULL),
+                       OI_PRIM("notify", OI_DELETE, NULL) } },
+    /* me @ s notify  ==>  s tell */
+    { OPTIM_FUSE, 4, { OI_VAR(0, OI_DELETE, NULL),
+                       OI_PRIM("@", OI_DELETE, NULL),
+                       OI_TYPE(PROG_STRING, OI_KEEP, 0),
+                       OI_PRIM("notify", OI_CHGPRIM, "tell") } },
+    /* lvar @  ==>  lvar@ */
+    { OPTIM_FUSE, 2, { OI_TYPE(PROG_LVAR, OI_CHGTYPE, PROG_LVAR_AT),
+                       OI_PRIM("@", OI_DELETE, NULL) } },
+    /* lvar !  ==>  lvar! */
+    { OPTIM_FUSE, 2, { OI_TYPE(PROG_LVAR, OI_CHGTYPE, PROG_LVAR_BANG),
+                       OI_PRIM("!", OI_DELETE, NULL) } },
+    /* svar @  ==>  svar@ */
+    { OPTIM_FUSE, 2, { OI_TYPE(PROG_SVAR, OI_CHGTYPE, PROG_SVAR_AT),
+                       OI_PRIM("@", OI_DELETE, NULL) } },
+    /* svar !  ==>  svar! */
+    { OPTIM_FUSE, 2, { OI_TYPE(PROG_SVAR, OI_CHGTYPE, PROG_SVAR_BANG),
+                       OI_PRIM("!", OI_DELETE, NULL) } },
+    /* "" strcmp 0 =  ==>  not */
+    { OPTIM_FUSE, 4, { OI_STR("", OI_CHGPRIM, "not"),
+                       OI_PRIM("strcmp", OI_DELETE, NULL),
+                       OI_INT(0, OI_DELETE, NULL),
+                       OI_PRIM("=", OI_DELETE, NULL) } },
+    /* "" stringcmp 0 =  ==>  not */
+    { OPTIM_FUSE, 4, { OI_STR("", OI_CHGPRIM, "not"),
+                       OI_PRIM("stringcmp", OI_DELETE, NULL),
+                       OI_INT(0, OI_DELETE, NULL),
+                       OI_PRIM("=", OI_DELETE, NULL) } },
+    /* "" strcmp not  ==>  not */
+    { OPTIM_FUSE, 3, { OI_STR("", OI_DELETE, NULL),
+                       OI_PRIM("strcmp", OI_DELETE, NULL),
+                       OI_PRIM("not", OI_KEEP, NULL) } },
+    /* "" stringcmp not  ==>  not */
+    { OPTIM_FUSE, 3, { OI_STR("", OI_DELETE, NULL),
+                       OI_PRIM("stringcmp", OI_DELETE, NULL),
+                       OI_PRIM("not", OI_KEEP, NULL) } },
+    /* "" strcmp if  ==>  if */
+    { OPTIM_PEEPHOLE, 3, { OI_STR("", OI_DELETE, NULL),
+                           OI_PRIM("strcmp", OI_DELETE, NULL),
+                           OI_TYPE(PROG_IF, OI_KEEP, 0) } },
+    /* 0 =  ==>  not */
+    { OPTIM_FUSE, 2, { OI_INT(0, OI_CHGPRIM, "not"),
+                       OI_PRIM("=", OI_DELETE, NULL) } },
+    /* 1 +  ==>  ++ */
+    { OPTIM_FUSE, 2, { OI_INT(1, OI_CHGPRIM, "++"),
+                       OI_PRIM("+", OI_DELETE, NULL) } },
+    /* 1 -  ==>  -- */
+    { OPTIM_FUSE, 2, { OI_INT(1, OI_CHGPRIM, "--"),
+                       OI_PRIM("-", OI_DELETE, NULL) } },
+    /* 1 pick  ==>  dup */
+    { OPTIM_FUSE, 2, { OI_INT(1, OI_CHGPRIM, "dup"),
+                       OI_PRIM("pick", OI_DELETE, NULL) } },
+    /* 2 pick  ==>  over */
+    { OPTIM_FUSE, 2, { OI_INT(2, OI_CHGPRIM, "over"),
+                       OI_PRIM("pick", OI_DELETE, NULL) } },
+    /* 3 rotate  ==>  rot */
+    { OPTIM_FUSE, 2, { OI_INT(3, OI_CHGPRIM, "rot"),
+                       OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* -3 rotate  ==>  -rot */
+    { OPTIM_FUSE, 2, { OI_INT(-3, OI_CHGPRIM, "-rot"),
+                       OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* 2 rotate  ==>  swap */
+    { OPTIM_FUSE, 2, { OI_INT(2, OI_CHGPRIM, "swap"),
+                       OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* -2 rotate  ==>  swap */
+    { OPTIM_FUSE, 2, { OI_INT(-2, OI_CHGPRIM, "swap"),
+                       OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* 1 rotate  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_INT(1, OI_DELETE, NULL),
+                           OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* 0 rotate  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_INT(0, OI_DELETE, NULL),
+                           OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* -1 rotate  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_INT(-1, OI_DELETE, NULL),
+                           OI_PRIM("rotate", OI_DELETE, NULL) } },
+    /* rot rot swap  ==>  swap rot */
+    { OPTIM_PEEPHOLE, 3, { OI_PRIM("rot", OI_CHGPRIM, "swap"),
+                           OI_PRIM("rot", OI_KEEP, NULL),
+                           OI_PRIM("swap", OI_DELETE, NULL) } },
+    /* rot rot  ==>  -rot */
+    { OPTIM_PEEPHOLE, 2, { OI_PRIM("rot", OI_CHGPRIM, "-rot"),
+                           OI_PRIM("rot", OI_DELETE, NULL) } },
+    /* -rot -rot  ==>  rot */
+    { OPTIM_PEEPHOLE, 2, { OI_PRIM("-rot", OI_CHGPRIM, "rot"),
+                           OI_PRIM("-rot", OI_DELETE, NULL) } },
+    /* rot -rot  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_PRIM("rot", OI_DELETE, NULL),
+                           OI_PRIM("-rot", OI_DELETE, NULL) } },
+    /* -rot rot  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_PRIM("-rot", OI_DELETE, NULL),
+                           OI_PRIM("rot", OI_DELETE, NULL) } },
+    /* swap swap  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_PRIM("swap", OI_DELETE, NULL),
+                           OI_PRIM("swap", OI_DELETE, NULL) } },
+    /* dup pop  ==>  (nothing) */
+    { OPTIM_PEEPHOLE, 2, { OI_PRIM("dup", OI_DELETE, NULL),
+                           OI_PRIM("pop", OI_DELETE, NULL) } },
+    /* swap pop  ==>  nip */
+    { OPTIM_FUSE, 2, { OI_PRIM("swap", OI_CHGPRIM, "nip"),
+                       OI_PRIM("pop", OI_DELETE, NULL) } },
+    /* swap over  ==>  tuck */
+    { OPTIM_FUSE, 2, { OI_PRIM("swap", OI_CHGPRIM, "tuck"),
+                       OI_PRIM("over", OI_DELETE, NULL) } },
+    /* not not if  ==>  if */
+    { OPTIM_PEEPHOLE, 3, { OI_PRIM("not", OI_DELETE, NULL),
+                           OI_PRIM("not", OI_DELETE, NULL),
+                           OI_TYPE(PROG_IF, OI_KEEP, 0) } },
+    /* not not not  ==>  not */
+    { OPTIM_PEEPHOLE, 3, { OI_PRIM("not", OI_DELETE, NULL),
+                           OI_PRIM("not", OI_DELETE, NULL),
+                           OI_PRIM("not", OI_KEEP, NULL) } },
+    /* = not  ==>  != */
+    { OPTIM_FUSE, 2, { OI_PRIM("=", OI_CHGPRIM, "!="),
+                       OI_PRIM("not", OI_DELETE, NULL) } }
+};
+
+/**
+ * Does an INTERMEDIATE match one instruction of an optimization?
+ *
+ * @private
+ * @param step the instruction of the optimization
  * @param ptr the intermediate to check
- * @param val the value to check for
- * @return boolean true if ptr is an string of value val, false otherwise
+ * @return boolean true if 'ptr' matches 'step'
  */
 static int
-IntermediateIsString(struct INTERMEDIATE *ptr, const char *val)
+OptimStepMatches(const struct optim_step *step, struct INTERMEDIATE *ptr)
 {
-    const char *myval;
+    if (!ptr || ptr->in.type != step->type)
+        return 0;
+
+    if (step->any)
+        return 1;
 
-    if (ptr && ptr->in.type == PROG_STRING) {
-        myval = DoNullInd(ptr->in.data.string);
+    switch (step->type) {
+        case PROG_PRIMITIVE:
+            return ptr->in.data.number == get_primitive(step->text);
 
-        if (!strcmp(myval, val)) {
-            return 1;
+        case PROG_STRING:
+            return !strcmp(DoNullInd(ptr->in.data.string), step->text);
+
+        default:
+            return ptr->in.data.number == step->number;
+    }
+}
+
+/**
+ * Make a peephole optimization, if the code at an INTERMEDIATE matches it
+ *
+ * @private
+ * @param cstat the compile state structure
+ * @param Flags an array of flag information for the intermediates
+ * @param opt the optimization
+ * @param curr the instruction to start matching at
+ * @return boolean true if the optimization was made
+ */
+static int
+ApplyOptimization(COMPSTATE * cstat, int *Flags,
+                  const struct optimization *opt, struct INTERMEDIATE *curr)
+{
+    struct INTERMEDIATE *ptr = curr, *prev = NULL;
+    int keeps = 0;
+
+    for (int i = 0; i < opt->count; i++, ptr = ptr->next) {
+        if (!OptimStepMatches(&opt->steps[i], ptr))
+            return 0;
+
+        keeps += opt->steps[i].action != OI_DELETE;
+    }
+
+    if (!ContiguousIntermediates(Flags, curr->next, opt->count - 1))
+        return 0;
+
+    /* Removing the first instruction needs one after it to move up */
+    if (opt->steps[0].action == OI_DELETE && !keeps && !ptr)
+        return 0;
+
+    ptr = curr;
+
+    for (int i = 0; i < opt->count; i++) {
+        const struct optim_step *step = &opt->steps[i];
+        struct INTERMEDIATE *next = ptr->next;
+
+        switch (step->action) {
+            case OI_KEEP:
+                break;
+
+            case OI_DELETE:
+                if (prev) {
+                    RemoveNextIntermediate(cstat, prev);
+                    ptr = prev;
+                }
+
+                break;
+
+            case OI_CHGPRIM:
+                if (ptr->in.type == PROG_STRING)
+                    free(ptr->in.data.string);
+
+                ptr->in.type = PROG_PRIMITIVE;
+                ptr->in.data.number = get_primitive(step->newprim);
+                break;
+
+            case OI_CHGTYPE:
+                ptr->in.type = step->newtype;
+                break;
         }
+
+        prev = ptr;
+        ptr = next;
     }
 
-    return 0;
+    if (opt->steps[0].action == OI_DELETE)
+        ReplaceWithNextIntermediate(cstat, Flags, curr);
+
+    cstat->optimizations[opt->kind]++;
+    return 1;
 }
 
 /**
  * Iterates over all the intermediates in a COMPSTATE and tries to optimize
  *
- * Optimizations are mostly in the form of taking certain common (or sometimes
- * uncommon) series of primitives or other operations and boiling them
- * down.  For instance, the code "me @ swap notify" can be optimized to
- * simply "tell".  For older MUFs, this combination of operations is
- * incredibly common.
+ * At each instruction, this tries in turn:
+ *
+ * - Folding constant expressions, like "2 3 +" to "5".
+ * - Simplifying jumps, like an IF to a jump or a jump to an EXIT.
+ * - Removing code after a jump or EXIT that can't be reached.
+ * - The table of peephole optimizations, which take certain common (or
+ *   sometimes uncommon) series of primitives or other operations and boil
+ *   them down.  For instance, the code "me @ swap notify" can be optimized
+ *   to simply "tell".  For older MUFs, this combination of operations is
+ *   incredibly common.
+ *
+ * Whenever one succeeds, the same instruction is looked at again.  Each
+ * kind of optimization made is counted in cstat->optimizations.
  *
  * This potentially modifies the intermediates list in cstat.
  *
@@ -1303,34 +2100,9 @@ OptimizeIntermediate(COMPSTATE * cstat, int force_err_display)
     int *Flags;
     unsigned int i;
     size_t count = 0;
-    double tl = 0.0;
     int old_instr_count = cstat->nowords;
     int AtNo = get_primitive("@");
     int BangNo = get_primitive("!");
-    int SwapNo = get_primitive("swap");
-    int PopNo = get_primitive("pop");
-    int OverNo = get_primitive("over");
-    int PickNo = get_primitive("pick");
-    int NipNo = get_primitive("nip");
-    int TuckNo = get_primitive("tuck");
-    int DupNo = get_primitive("dup");
-    int RotNo = get_primitive("rot");
-    int RrotNo = get_primitive("-rot");
-    int RotateNo = get_primitive("rotate");
-    int NotNo = get_primitive("not");
-    int StrcmpNo = get_primitive("strcmp");
-    int StringcmpNo = get_primitive("stringcmp");
-    int EqualsNo = get_primitive("=");
-    int PlusNo = get_primitive("+");
-    int MinusNo = get_primitive("-");
-    int MultNo = get_primitive("*");
-    int DivNo = get_primitive("/");
-    int ModNo = get_primitive("%");
-    int DecrNo = get_primitive("--");
-    int IncrNo = get_primitive("++");
-    int NotequalsNo = get_primitive("!=");
-    int NotifyNo = get_primitive("notify");
-    int TellNo = get_primitive("tell");
 
     /*
      * Code assumes everything is setup nicely, if not, bad things will happen
@@ -1338,6 +2110,22 @@ OptimizeIntermediate(COMPSTATE * cstat, int force_err_display)
     if (!cstat->first_word)
         return 0;
 
+    /*
+     * Point each address straight at its target.  Some optimizations move
+     * an instruction up into the node before it, which would throw off an
+     * address that counts on from that node.
+     */
+    for (i = 0; i < cstat->addrcount; i++) {
+        struct INTERMEDIATE *ptr = cstat->addrlist[i];
+
+        while (cstat->addroffsets[i] > 0 && ptr->next) {
+            ptr = ptr->next;
+            cstat->addroffsets[i]--;
+        }
+
+        cstat->addrlist[i] = ptr;
+    }
+
     /* renumber the instruction chain */
     for (struct INTERMEDIATE *curr = cstat->first_word; curr; curr = curr->next)
         curr->no = count++;
@@ -1372,471 +2160,19 @@ OptimizeIntermediate(COMPSTATE * cstat, int force_err_display)
     for (struct INTERMEDIATE *curr = cstat->first_word; curr;) {
         int advance = 1;
 
-        /* @TODO So the structure here is very long form and seems pretty
-         *       copy/paste.  At the very least, instead of layering 3 if's
-         *       around an if-else, we could reduce these to a single if
-         *       around the if/else to make this less of a nested nightmare.
-         *
-         *       A better structure would probably be to make some kind of
-         *       mapping of in.type to callback functions to break this up
-         *       a bit.  There's a lot of copy/paste but for some of these
-         *       (like the integer and primitive calls) there's enough logic
-         *       variety that it probably can't be reduced much.
-         *
-         *       The primitive ID's loaded at the start of this function
-         *       could be put in a 'optimization context' struct so they are
-         *       easily passed around and added to.
-         */
-        switch (curr->in.type) {
-            case PROG_VAR:
-                /* me @ swap notify  ==>  tell */
-                /* me @ s notify  ==>  s tell */
-                if (curr->in.data.number == 0 &&
-                    IntermediateIsPrimitive(curr->next, AtNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 2)) {
-                        if (IntermediateIsPrimitive(curr->next->next->next, NotifyNo)) {
-                            if (curr->next->next->in.type == PROG_STRING) {
-                                curr->next->next->next->in.data.number = TellNo;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveIntermediate(cstat, curr);
-                            } else if (IntermediateIsPrimitive(curr->next->next, SwapNo)) {
-                                curr->in.type = PROG_PRIMITIVE;
-                                curr->in.data.number = TellNo;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                            }
-                        }
-                    }
-                }
-
-                break;
-            case PROG_LVAR:
-                /* lvar !  ==>  lvar! */
-                /* lvar @  ==>  lvar@ */
-                if (curr->next && curr->next->in.type == PROG_PRIMITIVE) {
-                    if (curr->next->in.data.number == AtNo) {
-                        if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                            curr->in.type = PROG_LVAR_AT;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-
-                    if (curr->next->in.data.number == BangNo) {
-                        if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                            curr->in.type = PROG_LVAR_BANG;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                break;
-            case PROG_SVAR:
-                /* svar !  ==>  svar! */
-                /* svar @  ==>  svar@ */
-                if (curr->next && curr->next->in.type == PROG_PRIMITIVE) {
-                    if (curr->next->in.data.number == AtNo) {
-                        if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                            curr->in.type = PROG_SVAR_AT;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-
-                    if (curr->next->in.data.number == BangNo) {
-                        if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                            curr->in.type = PROG_SVAR_BANG;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                break;
-            case PROG_STRING:
-                if (IntermediateIsString(curr, "")) {
-                    if (ContiguousIntermediates(Flags, curr->next, 3)) {
-                        /* "" strcmp 0 =  ==>   not */
-                        if (IntermediateIsPrimitive(curr->next, StrcmpNo)) {
-                            if (IntermediateIsInteger(curr->next->next, 0)) {
-                                if (IntermediateIsPrimitive(curr->next->next->next,
-                                    EqualsNo)) {
-                                    free(curr->in.data.string);
-
-                                    curr->in.type = PROG_PRIMITIVE;
-                                    curr->in.data.number = NotNo;
-                                    RemoveNextIntermediate(cstat, curr);
-                                    RemoveNextIntermediate(cstat, curr);
-                                    RemoveNextIntermediate(cstat, curr);
-                                    advance = 0;
-                                    break;
-                                }
-                            }
-                        }
-
-                        /* "" stringcmp 0 =  ==>   not */
-                        if (IntermediateIsPrimitive(curr->next, StringcmpNo)) {
-                            if (IntermediateIsInteger(curr->next->next, 0)) {
-                                if (IntermediateIsPrimitive(curr->next->next->next,
-                                    EqualsNo)) {
-                                    free(curr->in.data.string);
-
-                                    curr->in.type = PROG_PRIMITIVE;
-                                    curr->in.data.number = NotNo;
-                                    RemoveNextIntermediate(cstat, curr);
-                                    RemoveNextIntermediate(cstat, curr);
-                                    RemoveNextIntermediate(cstat, curr);
-                                    advance = 0;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
-
-                break;
-            case PROG_INTEGER:
-                /* consolidate constant integer calculations */
-                if (ContiguousIntermediates(Flags, curr->next, 2)) {
-                    if (curr->next->in.type == PROG_INTEGER) {
-                        /* Int Int +  ==>  Sum */
-                        if (IntermediateIsPrimitive(curr->next->next, PlusNo)) {
-                            tl = (double)curr->in.data.number + (double)curr->next->in.data.number;
-                            if (!arith_good(tl)) {
-                                if (!(curr->next->next->flags & INTMEDFLG_OVERFLOW)) {
-                                    curr->next->next->flags |= INTMEDFLG_OVERFLOW;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Constant addition leads to overflow",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else {
-                                curr->in.data.number += curr->next->in.data.number;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                                advance = 0;
-                            }
-                            break;
-                        }
-
-                        /* Int Int -  ==>  Diff */
-                        if (IntermediateIsPrimitive(curr->next->next, MinusNo)) {
-                            tl = (double)curr->in.data.number - (double)curr->next->in.data.number;
-                            if (!arith_good(tl)) {
-                                if (!(curr->next->next->flags & INTMEDFLG_OVERFLOW)) {
-                                    curr->next->next->flags |= INTMEDFLG_OVERFLOW;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Constant subtraction leads to overflow",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else {
-                                curr->in.data.number -= curr->next->in.data.number;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                                advance = 0;
-                            }
-                            break;
-                        }
-
-                        /* Int Int *  ==>  Prod */
-                        if (IntermediateIsPrimitive(curr->next->next, MultNo)) {
-                            tl = (double)curr->in.data.number * (double)curr->next->in.data.number;
-                            if (!arith_good(tl)) {
-                                if (!(curr->next->next->flags & INTMEDFLG_OVERFLOW)) {
-                                    curr->next->next->flags |= INTMEDFLG_OVERFLOW;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Constant multiplication leads to overflow",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else {
-                                curr->in.data.number *= curr->next->in.data.number;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                                advance = 0;
-                            }
-                            break;
-                        }
-
-                        /* Int Int /  ==>  Div  */
-                        if (IntermediateIsPrimitive(curr->next->next, DivNo)) {
-                            if (curr->next->in.data.number == 0) {
-                                if (!(curr->next->next->flags & INTMEDFLG_DIVBYZERO)) {
-                                    curr->next->next->flags |= INTMEDFLG_DIVBYZERO;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Divide by zero",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else if (curr->next->in.data.number == -1 &&
-                                       curr->in.data.number == INT_MIN) {
-                                if (!(curr->next->next->flags & INTMEDFLG_OVERFLOW)) {
-                                    curr->next->next->flags |= INTMEDFLG_OVERFLOW;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Integer overflow",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else {
-                                curr->in.data.number /= curr->next->in.data.number;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                                advance = 0;
-                            }
-
-                            break;
-                        }
-
-                        /* Int Int %  ==>  Mod */
-                        if (IntermediateIsPrimitive(curr->next->next, ModNo)) {
-                            if (curr->next->in.data.number == 0) {
-                                if (!(curr->next->next->flags & INTMEDFLG_MODBYZERO)) {
-                                    curr->next->next->flags |= INTMEDFLG_MODBYZERO;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Modulus by zero",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else if (curr->next->in.data.number == -1 &&
-                                       curr->in.data.number == INT_MIN) {
-                                if (!(curr->next->next->flags & INTMEDFLG_OVERFLOW)) {
-                                    curr->next->next->flags |= INTMEDFLG_OVERFLOW;
-
-                                    if (force_err_display) {
-                                        notifyf(cstat->player,
-                                                "Warning on line %i: Integer overflow",
-                                                curr->next->next->in.line);
-                                    }
-                                }
-                            } else {
-                                curr->in.data.number %= curr->next->in.data.number;
-                                RemoveNextIntermediate(cstat, curr);
-                                RemoveNextIntermediate(cstat, curr);
-                                advance = 0;
-                            }
-
-                            break;
-                        }
-                    }
-                }
-
-                /* 0 =  ==>  not */
-                if (IntermediateIsInteger(curr, 0)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, EqualsNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = NotNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                /* 1 +  ==>  ++ */
-                if (IntermediateIsInteger(curr, 1)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, PlusNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = IncrNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                /* 1 -  ==>  -- */
-                if (IntermediateIsInteger(curr, 1)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, MinusNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = DecrNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                /* 1 pick  ==>  dup */
-                if (IntermediateIsInteger(curr, 1)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, PickNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = DupNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                        }
-                    }
-                }
-
-                /* 2 pick  ==>  over */
-                if (IntermediateIsInteger(curr, 2)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, PickNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = OverNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                        }
-                    }
-                }
-
-                /* 3 rotate  ==>  rot */
-                if (IntermediateIsInteger(curr, 3)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, RotateNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = RotNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                        }
-                    }
-                }
-
-                /* -3 rotate  ==>  -rot */
-                if (IntermediateIsInteger(curr, -3)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, RotateNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = RrotNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                        }
-                    }
-                }
-
-                /* 2|-2 rotate  ==>  swap */
-                if (IntermediateIsInteger(curr, 2) || IntermediateIsInteger(curr, -2)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, RotateNo)) {
-                            curr->in.type = PROG_PRIMITIVE;
-                            curr->in.data.number = SwapNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                        }
-                    }
-                }
-
-                /* 1|0|-1 rotate  ==>  (nothing) */
-                if (IntermediateIsInteger(curr, 1) || IntermediateIsInteger(curr, 0) || IntermediateIsInteger(curr, -1)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, RotateNo)) {
-                            RemoveNextIntermediate(cstat, curr);
-                            RemoveIntermediate(cstat, curr);
-                            advance = 0;
-                        }
-                    }
-                }
-
-                break;
-            case PROG_PRIMITIVE:
-                /* rot rot swap  ==>  swap rot */
-                if (IntermediateIsPrimitive(curr, RotNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 2)) {
-                        if (IntermediateIsPrimitive(curr->next, RotNo)) {
-                            if (IntermediateIsPrimitive(curr->next->next, SwapNo)) {
-                                curr->in.data.number = SwapNo;
-                                curr->next->in.data.number = RotNo;
-                                RemoveNextIntermediate(cstat, curr->next);
-                                advance = 0;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                /* rot rot  ==>  -rot */
-                if (IntermediateIsPrimitive(curr, RotNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, RotNo)) {
-                            curr->in.data.number = RrotNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                /* -rot -rot  ==>  rot */
-                if (IntermediateIsPrimitive(curr, RrotNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, RrotNo)) {
-                            curr->in.data.number = RotNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                if (IntermediateIsPrimitive(curr, SwapNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        /* swap pop  ==>  nip */
-                        if (IntermediateIsPrimitive(curr->next, PopNo)) {
-                            curr->in.data.number = NipNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-
-                        /* swap over  ==>  tuck */
-                        if (IntermediateIsPrimitive(curr->next, OverNo)) {
-                            curr->in.data.number = TuckNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
-
-                /* not not if  ==>  if */
-                if (IntermediateIsPrimitive(curr, NotNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 2)) {
-                        if (IntermediateIsPrimitive(curr->next, NotNo)) {
-                            if (curr->next->next->in.type == PROG_IF) {
-                                RemoveIntermediate(cstat, curr);
-                                RemoveIntermediate(cstat, curr);
-                                advance = 0;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                /* = not  ==>  != */
-                if (IntermediateIsPrimitive(curr, EqualsNo)) {
-                    if (ContiguousIntermediates(Flags, curr->next, 1)) {
-                        if (IntermediateIsPrimitive(curr->next, NotNo)) {
-                            curr->in.data.number = NotequalsNo;
-                            RemoveNextIntermediate(cstat, curr);
-                            advance = 0;
-                            break;
-                        }
-                    }
-                }
+        if (FoldUnaryConstant(cstat, Flags, curr)
+            || FoldBinaryConstant(cstat, Flags, curr, force_err_display)
+            || FoldStringAppends(cstat, Flags, curr)
+            || OptimizeJump(cstat, Flags, curr)
+            || RemoveUnreachable(cstat, Flags, curr)) {
+            continue;
+        }
 
+        for (size_t j = 0; j < ARRAYSIZE(optimizations); j++) {
+            if (ApplyOptimization(cstat, Flags, &optimizations[j], curr)) {
+                advance = 0;
                 break;
+            }
         }
 
         if (advance) {
@@ -1879,91 +2215,6 @@ set_start(COMPSTATE * cstat)
     }
 }
 
-/* @TODO So this comment was already in here when I started.  I made a note
- *       above thinking about how to make the optimizers more generic and
- *       this idea takes it a step further.  Maybe a hybrid idea, of having
- *       a mapping of functions and then a few different helper methods to
- *       reduce redundant code would work.  I'm leaving this as-is as
- *       ideas for the future.
- *
- *
- * Genericized Optimizer ideas:
- *
- * const int OI_ANY = -121314;   // arbitrary unlikely-to-be-needed value.
- *
- * typedef enum {
- *     OI_KEEP,
- *     OI_CHGVAL,
- *     OI_CHGTYPE,
- *     OI_REPLACE,
- *     OI_DELETE
- * } OI_ACTION;
- *
- * OPTIM* option_new();
- * void optim_free(OPTIM* optim);
- * void optim_add_raw  (OPTIM* optim, struct INTERMEDIATE* originst,
- *                      OI_ACTION action, struct INTERMEDIATE* newinst);
- * void optim_add_type (OPTIM* optim, int origtype,
- *                      OI_ACTION action, int newtype);
- * void optim_add_prim (OPTIM* optim, const char* origprim,
- *                      OI_ACTION action, int newval);
- * void optim_add_int  (OPTIM* optim, int origval,
- *                      OI_ACTION action, int newval);
- * void optim_add_str  (OPTIM* optim, const char* origval,
- *                      OI_ACTION action, int newval);
- *
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_str (optim, "",       OI_DELETE, 0);
- * optim_add_prim(optim, "strcmp", OI_CHGVAL, get_primitive("not"));
- * optim_add_int (optim, 0,        OI_DELETE, 0);
- * optim_add_prim(optim, "=",      OI_DELETE, 0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_str(optim, "",        OI_DELETE, 0);
- * optim_add_prim(optim, "strcmp", OI_DELETE, 0);
- * optim_add_prim(optim, "not",    OI_KEEP,   0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_prim(optim, "rot",  OI_CHGVAL, get_primitive("swap"));
- * optim_add_prim(optim, "rot",  OI_KEEP,   0);
- * optim_add_prim(optim, "swap", OI_DELETE, 0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_type(optim, PROG_SVAR, OI_CHGTYPE, PROG_SVAR_AT);
- * optim_add_prim(optim, "@",       OI_DELETE,   0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_type(optim, PROG_SVAR, OI_CHGTYPE, PROG_SVAR_BANG);
- * optim_add_prim(optim, "!",       OI_DELETE,   0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_int (optim, 0,   OI_DELETE, 0);
- * optim_add_prim(optim, "=", OI_CHGVAL, get_primitive("not"));
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_prim(optim, "not",   OI_DELETE, 0);
- * optim_add_prim(optim, "not",   OI_DELETE, 0);
- * optim_add_type(optim, PROG_IF, OI_KEEP,   0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_int (optim, 0,       OI_DELETE,  0);
- * optim_add_type(optim, PROG_IF, OI_CHGTYPE, PROG_JMP);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_int (optim, 1,       OI_DELETE, 0);
- * optim_add_type(optim, PROG_IF, OI_DELETE, 0);
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_int (optim, 1,   OI_DELETE, 0);
- * optim_add_prim(optim, "+", OI_CHGVAL, get_primitive("++"));
- *
- * OPTIM* optim = optim_new(cstat);
- * optim_add_int (optim, 1,   OI_DELETE, 0);
- * optim_add_prim(optim, "-", OI_CHGVAL, get_primitive("--"));
- *
- */
-
 /**
  * Allocate an address structure
  *
@@ -2706,6 +2957,136 @@ next_word(COMPSTATE * cstat, const char *token)
     return new_word;
 }
 
+/**
+ * Is a primitive one that gets an inline property cache?
+ *
+ * @private
+ * @param prim the primitive number
+ * @return boolean true if 'prim' is GETPROP, GETPROPSTR, GETPROPVAL or
+ *         GETPROPFVAL
+ */
+static int
+is_prop_cache_prim(int prim)
+{
+    static int prims[4];
+
+    if (!prims[0]) {
+        prims[0] = get_primitive("GETPROP");
+        prims[1] = get_primitive("GETPROPSTR");
+        prims[2] = get_primitive("GETPROPVAL");
+        prims[3] = get_primitive("GETPROPFVAL");
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (prim == prims[i])
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Free a program's inline property caches
+ *
+ * @private
+ * @param program the program
+ */
+static void
+free_prop_caches(dbref program)
+{
+    struct prop_cache *caches = PROGRAM_PROPCACHES(program);
+
+    for (int i = 0; i < PROGRAM_PROPCACHECOUNT(program); i++)
+        free(caches[i].parts);
+
+    free(caches);
+    PROGRAM_SET_PROPCACHES(program, NULL, 0);
+}
+
+/**
+ * Make inline caches for the property primitives of a program
+ *
+ * Every GETPROP, GETPROPSTR, GETPROPVAL or GETPROPFVAL right after a
+ * constant string gets one, with the string split up at each '/' the way
+ * propdir_get_elem would.  They are made in code order, so they are sorted
+ * by address.
+ *
+ * @private
+ * @param program the program
+ */
+static void
+make_prop_caches(dbref program)
+{
+    struct inst *code = PROGRAM_CODE(program);
+    int siz = PROGRAM_SIZ(program);
+    struct prop_cache *caches = NULL;
+    int count = 0;
+
+    for (int i = 1; i < siz; i++) {
+        const char *path;
+        char *parts, *out;
+
+        if (code[i].type != PROG_PRIMITIVE || code[i - 1].type != PROG_STRING
+            || !code[i - 1].data.string
+            || code[i - 1].data.string->length >= BUFFER_LEN
+            || !is_prop_cache_prim(code[i].data.number))
+            continue;
+
+        path = code[i - 1].data.string->data;
+        out = parts = malloc(strlen(path) + 2);
+
+        while (*path) {
+            if (*path == PROPDIR_DELIMITER) {
+                path++;
+            } else {
+                while (*path && *path != PROPDIR_DELIMITER)
+                    *out++ = *path++;
+
+                *out++ = '\0';
+            }
+        }
+
+        *out = '\0';
+
+        caches = realloc(caches, sizeof(struct prop_cache) * (size_t)(count + 1));
+        caches[count].pc = &code[i];
+        caches[count].path = code[i - 1].data.string;
+        caches[count].parts = parts;
+        caches[count].obj = NOTHING;
+        caches[count].serial = 0;
+        caches[count].prop = NULL;
+        count++;
+    }
+
+    PROGRAM_SET_PROPCACHES(program, caches, count);
+}
+
+/**
+ * Finish setting up a newly compiled program
+ *
+ * This is shared by programs that were compiled and programs that were
+ * loaded from the compiled program cache.
+ *
+ * @private
+ * @param player the player compiling
+ * @param program the program that was compiled
+ */
+static void
+compile_done(dbref player, dbref program)
+{
+    /* Set PROGRAM_INSTANCES to zero (cuz they don't get set elsewhere) */
+    PROGRAM_SET_INSTANCES(program, 0);
+
+    make_prop_caches(program);
+
+    /* restart AUTOSTART program. */
+    if (FLAG_CHECK(program, 'A') && TrueWizard(OWNER(program))) {
+        add_muf_queue_event(-1, OWNER(program), NOTHING, NOTHING,
+                            program, "Startup", "Queued Event.", 0);
+        notify_nolisten(player, "Program autostarted.", 1);
+    }
+}
+
 /**
  * Compile MUF code associated with a given dbref
  *
@@ -2727,11 +3108,16 @@ next_word(COMPSTATE * cstat, const char *token)
  *   player.  Error messages are still displayed anyway if the player
  *   is INTERACTIVE but not READMODE (which I believe means they are in the
  *   @program/@edit editor).
+ * - If force_err_display is false and the program's source hasn't changed
+ *   since it was last compiled, the compiled code is loaded from the
+ *   compiled program cache instead.  @see muf_cache_load
  *
  * @param descr the descriptor of the person compiling
  * @param player_in the player compiling
  * @param program_in the program to compile
- * @param force_err_display boolean - true to always show compile errors
+ * @param force_err_display boolean - true to always show compile errors.
+ *        COMPILE_SHOW_OPTIMIZATIONS may be or'ed in to also list the
+ *        optimizations made.
  */
 void
 do_compile(int descr, dbref player_in, dbref program_in, int force_err_display)
@@ -2755,6 +3141,29 @@ do_compile(int descr, dbref player_in, dbref program_in, int force_err_display)
         return;
     }
 
+    /* free old stuff */
+    (void) dequeue_prog(program_in, 1);
+    free_prog(program_in);
+    cleanpubs(PROGRAM_PUBS(program_in));
+    PROGRAM_SET_PUBS(program_in, NULL);
+    clean_mcpbinds(PROGRAM_MCPBINDS(program_in));
+    PROGRAM_SET_MCPBINDS(program_in, NULL);
+
+    PROGRAM_SET_PROFTIME(program_in, 0, 0);
+    PROGRAM_SET_PROFSTART(program_in, time(NULL));
+    PROGRAM_SET_PROF_USES(program_in, 0);
+
+    /*
+     * If this program was compiled before from the same source, load the
+     * result from the compiled program cache instead.  Compiles that
+     * display errors always compile, so the player sees the usual output.
+     */
+    if (!force_err_display && tp_muf_compile_cache
+        && muf_cache_load(program_in)) {
+        compile_done(player_in, program_in);
+        return;
+    }
+
     /* set all compile state variables */
     cstat.force_err_display = force_err_display;
     cstat.descr = descr;
@@ -2802,6 +3211,11 @@ do_compile(int descr, dbref player_in, dbref program_in, int force_err_display)
     cstat.nextinst = NULL;
     cstat.addrlist = NULL;
     cstat.addroffsets = NULL;
+    cstat.deps = NULL;
+    cstat.depcount = 0;
+    cstat.depmax = 0;
+    cstat.cacheable = 1;
+    memset(cstat.optimizations, 0, sizeof(cstat.optimizations));
     init_defs(&cstat);
 
     cstat.variables[0] = "ME";
@@ -2809,18 +3223,6 @@ do_compile(int descr, dbref player_in, dbref program_in, int force_err_display)
     cstat.variables[2] = "TRIGGER";
     cstat.variables[3] = "COMMAND";
 
-    /* free old stuff */
-    (void) dequeue_prog(cstat.program, 1);
-    free_prog(cstat.program);
-    cleanpubs(PROGRAM_PUBS(cstat.program));
-    PROGRAM_SET_PUBS(cstat.program, NULL);
-    clean_mcpbinds(PROGRAM_MCPBINDS(cstat.program));
-    PROGRAM_SET_MCPBINDS(cstat.program, NULL);
-
-    PROGRAM_SET_PROFTIME(cstat.program, 0, 0);
-    PROGRAM_SET_PROFSTART(cstat.program, time(NULL));
-    PROGRAM_SET_PROF_USES(cstat.program, 0);
-
     if (!cstat.curr_line)
         v_abort_compile(&cstat, "Missing program text.");
 
@@ -2873,11 +3275,19 @@ do_compile(int descr, dbref player_in, dbref program_in, int force_err_display)
             passcount++;
         } while (optcnt > 0 && --maxpasses > 0);
 
-        if (force_err_display && optimcount > 0) {
+        if ((force_err_display & COMPILE_SHOW_OPTIMIZATIONS)
+            || (force_err_display && optimcount > 0)) {
             notifyf_nolisten(cstat.player,
                              "Program optimized by %d instructions in %d passes.", optimcount,
                              passcount);
         }
+
+        if (force_err_display & COMPILE_SHOW_OPTIMIZATIONS) {
+            for (int i = 0; i < OPTIM_KINDS; i++) {
+                notifyf_nolisten(cstat.player, "  %s: %d",
+                                 optim_kind_names[i], cstat.optimizations[i]);
+            }
+        }
     }
 
     /* do copying over */
@@ -2902,21 +3312,16 @@ do_compile(int descr, dbref player_in, dbref program_in, int force_err_display)
         return;
 
     set_start(&cstat);
-    cleanup(&cstat);
 
-    /* Set PROGRAM_INSTANCES to zero (cuz they don't get set elsewhere) */
-    PROGRAM_SET_INSTANCES(cstat.program, 0);
+    if (cstat.cacheable && tp_muf_compile_cache)
+        muf_cache_save(cstat.program, cstat.deps, cstat.depcount);
+
+    cleanup(&cstat);
 
     if (force_err_display)
         notify_nolisten(cstat.player, "Program compiled successfully.", 1);
 
-    /* restart AUTOSTART program. */
-    if (FLAG_CHECK(cstat.program, 'A') && TrueWizard(OWNER(cstat.program))) {
-        add_muf_queue_event(-1, OWNER(cstat.program), NOTHING, NOTHING,
-                            cstat.program, "Startup", "Queued Event.", 0);
-        notify_nolisten(cstat.player, "Program autostarted.", 1);
-    }
-
+    compile_done(cstat.player, cstat.program);
 }
 
 /**
@@ -3521,7 +3926,7 @@ do_directive(COMPSTATE * cstat, char *direct)
     } else if (!strcasecmp(temp, "cleardefs")) {
         char nextToken[BUFFER_LEN];
 
-        kill_hash(cstat->defhash, DEFHASHSIZE, 1); /* Get rid of all defs first. */
+        kill_hash(&cstat->defhash, 1); /* Get rid of all defs first. */
         include_internal_defs(cstat);   /* Always include internal defs. */
         skip_whitespace(&cstat->next_char);
         strcpyn(nextToken, sizeof(nextToken), cstat->next_char);
@@ -3685,6 +4090,14 @@ do_directive(COMPSTATE * cstat, char *direct)
             strcpyn(match_cmdname, sizeof(match_cmdname), tempb);
         }
 
+        /*
+         * The compiled program cache only tracks the included _defs/, so
+         * it can't tell if a registered name or 'me' would now match a
+         * different object.
+         */
+        if (!(*tmpname == NUMBER_TOKEN && number(tmpname + 1)))
+            cstat->cacheable = 0;
+
         free(tmpname);
 
         if (!OkObj(i))
@@ -3829,6 +4242,8 @@ do_directive(COMPSTATE * cstat, char *direct)
     } else if (!strcasecmp(temp, "ifcancall") || !strcasecmp(temp, "ifncancall")) {
         struct match_data md;
 
+        /* The compiled program cache can't tell if this would change. */
+        cstat->cacheable = 0;
         tmpname = (char *) next_token_raw(cstat);
 
         if (!tmpname)
@@ -3929,6 +4344,7 @@ do_directive(COMPSTATE * cstat, char *direct)
         double checkflt = 0;
         int needFree = 0;
 
+        cstat->cacheable = 0;
         tmpname = (char *) next_token_raw(cstat);
 
         if (!tmpname)
@@ -4028,6 +4444,7 @@ do_directive(COMPSTATE * cstat, char *direct)
         struct match_data md;
         char tempa[BUFFER_LEN], tempb[BUFFER_LEN];
 
+        cstat->cacheable = 0;
         tmpname = (char *) next_token_raw(cstat);
 
         if (!tmpname)
@@ -5444,7 +5861,7 @@ get_primitive(const char *token)
 {
     hash_data *hd;
 
-    if ((hd = find_hash(token, primitive_list, COMP_HASH_SIZE)) == NULL)
+    if ((hd = find_hash(token, &primitive_list)) == NULL)
         return 0;
     else {
         return (hd->ival);
@@ -5519,6 +5936,7 @@ free_prog_real(dbref prog, const char *file, const int line)
         free(c);
     }
 
+    free_prop_caches(prog);
     PROGRAM_SET_CODE(prog, 0);
     PROGRAM_SET_SIZ(prog, 0);
     PROGRAM_SET_START(prog, 0);
@@ -5581,7 +5999,7 @@ size_prog(dbref prog)
 void
 clear_primitives(void)
 {
-    kill_hash(primitive_list, COMP_HASH_SIZE, 0);
+    kill_hash(&primitive_list, 0);
 }
 
 /**
@@ -5608,7 +6026,7 @@ init_primitives(void)
         hash_data hd;
         hd.ival = i;
 
-        if (add_hash(base_inst[i - 1], hd, primitive_list, COMP_HASH_SIZE) == NULL)
+        if (add_hash(base_inst[i - 1], hd, &primitive_list) == NULL)
             panic("Out of memory");
     }
 
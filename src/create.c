@@ -102,14 +102,16 @@ do_open(int descr, dbref player, const char *direction, const char *linkto)
         if (!payfor(player, tp_link_cost)) {
             notifyf(player, "You don't have enough %s to link.", tp_pennies);
         } else {
+            dbref *dests;
+
             ndest = link_exit(descr, player, exit, (char *) qname, good_dest);
-            DBFETCH(exit)->sp.exit.ndest = ndest;
-            DBFETCH(exit)->sp.exit.dest = malloc(sizeof(dbref) * (size_t)ndest);
+            dests = malloc(sizeof(dbref) * (size_t)ndest);
 
             for (int i = 0; i < ndest; i++) {
-                (DBFETCH(exit)->sp.exit.dest)[i] = good_dest[i];
+                dests[i] = good_dest[i];
             }
 
+            db_set_exit_dests(exit, ndest, dests);
             DBDIRTY(exit);
         }
     }
@@ -141,6 +143,7 @@ do_link(int descr, dbref player, const char *thing_name, const char *dest_name)
     dbref thing;
     dbref dest;
     dbref good_dest[MAX_LINKS];
+    dbref *dests;
     struct match_data md;
 
     int ndest;
@@ -199,7 +202,7 @@ do_link(int descr, dbref player, const char *thing_name, const char *dest_name)
             }
 
             /* link has been validated and paid for; do it */
-            OWNER(thing) = OWNER(player);
+            db_set_owner(thing, OWNER(player));
             ndest = link_exit(descr, player, thing, (char *) dest_name, good_dest);
 
             if (ndest == 0) {
@@ -210,15 +213,14 @@ do_link(int descr, dbref player, const char *thing_name, const char *dest_name)
                 break;
             }
 
-            DBFETCH(thing)->sp.exit.ndest = ndest;
-
-            free(DBFETCH(thing)->sp.exit.dest);
-            DBFETCH(thing)->sp.exit.dest = malloc(sizeof(dbref) * (size_t)ndest);
+            dests = malloc(sizeof(dbref) * (size_t)ndest);
 
             for (int i = 0; i < ndest; i++) {
-                (DBFETCH(thing)->sp.exit.dest)[i] = good_dest[i];
+                dests[i] = good_dest[i];
             }
 
+            db_set_exit_dests(thing, ndest, dests);
+
             break;
         case TYPE_THING:
         case TYPE_PLAYER:
@@ -272,7 +274,7 @@ do_link(int descr, dbref player, const char *thing_name, const char *dest_name)
                 notify(player,
                     "Permission denied. (you don't control the room, or can't link to the dropto)");
             } else {
-                DBFETCH(thing)->sp.room.dropto = dest;  /* dropto */
+                db_set_dropto(thing, dest);
                 notify(player, "Dropto set.");
             }
 
@@ -1139,6 +1139,7 @@ CrT_alloc_prog_string(const char *s, const char *file, int line)
 
     ss->links = 1;
     ss->length = length;
+    ss->size = length + 1;
     memmove(ss->data, s, ss->length + 1);
     return (ss);
 }
@@ -17,6 +17,8 @@
 #include "db.h"
 #ifdef DISKBASE
 #include "diskprop.h"
+#else
+#include "dbbinary.h"
 #endif
 #include "edit.h"
 #include "fbstrings.h"
@@ -25,6 +27,9 @@
 #include "flags.h"
 #include "game.h"
 #include "interface.h"
+#ifdef DB_JOURNAL
+#include "journal.h"
+#endif
 #include "match.h"
 #include "log.h"
 #include "player.h"
@@ -65,16 +70,471 @@ static int db_load_format = 0;
 #define DB_INITIAL_SIZE 10000
 #endif /* DB_INITIAL_SIZE */
 
+/*
+ * A sorted list of dbrefs, used by the reverse reference indexes
+ */
+struct refindex {
+    dbref *refs;    /* The dbrefs, lowest first; may hold duplicates */
+    int count;      /* Number of dbrefs in the list                  */
+    int size;       /* Allocated size of 'refs'                      */
+};
+
+/*
+ * The reverse references for a single object
+ */
+struct objrefs {
+    struct refindex lists[REFS_KINDS];   /* Referrers, by REFS_* kind      */
+    dbref owner;    /* The owner this object is filed under, or NOTHING  */
+    dbref link;     /* The home or dropto it is filed under, or NOTHING  */
+};
+
+/**
+ * @private
+ * @var the reverse reference indexes, parallel to 'db'
+ *
+ * For every object this keeps the objects that are owned by it and
+ * the objects linked to it (exits with it as a destination, things and
+ * players with it as their home, and rooms with it as their dropto),
+ * so finding them does not need a scan of the whole database.
+ *
+ * Exits and homes and droptos are all 'links' as far as \@entrances and
+ * friends are concerned, so they share one list.  An exit linked to the
+ * same place more than once is listed once per link.
+ */
+static struct objrefs *db_refs = NULL;
+
+/**
+ * @private
+ * @var the number of entries allocated in db_refs
+ */
+static dbref db_refs_top = 0;
+
+/**
+ * Make room in the reverse reference indexes for objects up to 'newtop'
+ *
+ * @private
+ * @param newtop the new DB size
+ */
+static void
+db_refs_grow(dbref newtop)
+{
+    struct objrefs *grown;
+
+    if (newtop <= db_refs_top)
+        return;
+
+    grown = realloc(db_refs, (size_t)newtop * sizeof(struct objrefs));
+
+    if (!grown) {
+        abort();
+    }
+
+    db_refs = grown;
+    memset(db_refs + db_refs_top, 0,
+           (size_t)(newtop - db_refs_top) * sizeof(struct objrefs));
+
+    for (dbref i = db_refs_top; i < newtop; i++) {
+        db_refs[i].owner = NOTHING;
+        db_refs[i].link = NOTHING;
+    }
+
+    db_refs_top = newtop;
+}
+
+/**
+ * Find where 'ref' is, or would go, in a reference list
+ *
+ * @private
+ * @param l the reference list
+ * @param ref the dbref to look for
+ * @return the index of the first entry that is not less than 'ref'
+ */
+static int
+refindex_find(struct refindex *l, dbref ref)
+{
+    int lo = 0;
+    int hi = l->count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (l->refs[mid] < ref) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * Add a referrer to the given kind of reference list of 'target'
+ *
+ * Targets that aren't objects, such as NOTHING or HOME, are ignored.
+ *
+ * @private
+ * @param target the object being referred to
+ * @param kind REFS_OWNED or REFS_LINKED
+ * @param ref the object referring to 'target'
+ */
+static void
+db_refs_add(dbref target, int kind, dbref ref)
+{
+    struct refindex *l;
+    int at;
+
+    if (target < 0 || target >= db_refs_top)
+        return;
+
+    l = &db_refs[target].lists[kind];
+
+    if (l->count == l->size) {
+        l->size = l->size ? l->size * 2 : 4;
+        l->refs = realloc(l->refs, (size_t)l->size * sizeof(dbref));
+
+        if (!l->refs) {
+            panic("db_refs_add(): Out of memory");
+        }
+    }
+
+    /* Objects are mostly indexed in dbref order, so check the end first */
+    if (!l->count || l->refs[l->count - 1] <= ref) {
+        at = l->count;
+    } else {
+        at = refindex_find(l, ref);
+        memmove(l->refs + at + 1, l->refs + at,
+                (size_t)(l->count - at) * sizeof(dbref));
+    }
+
+    l->refs[at] = ref;
+    l->count++;
+}
+
+/**
+ * Remove a referrer from the given kind of reference list of 'target'
+ *
+ * If 'ref' is listed more than once, only one entry is removed.
+ *
+ * @private
+ * @param target the object being referred to
+ * @param kind REFS_OWNED or REFS_LINKED
+ * @param ref the object that no longer refers to 'target'
+ */
+static void
+db_refs_remove(dbref target, int kind, dbref ref)
+{
+    struct refindex *l;
+    int at;
+
+    if (target < 0 || target >= db_refs_top)
+        return;
+
+    l = &db_refs[target].lists[kind];
+    at = refindex_find(l, ref);
+
+    if (at < l->count && l->refs[at] == ref) {
+        l->count--;
+        memmove(l->refs + at, l->refs + at + 1,
+                (size_t)(l->count - at) * sizeof(dbref));
+    }
+}
+
+/**
+ * File an object's owner and links in the reverse reference indexes
+ *
+ * @private
+ * @param obj the object to index
+ */
+static void
+db_refs_index(dbref obj)
+{
+    switch (OBJECT_TYPE(obj)) {
+        case TYPE_GARBAGE:
+            return;
+
+        case TYPE_EXIT:
+            for (int i = 0; i < DBFETCH(obj)->sp.exit.ndest; i++) {
+                db_refs_add(DBFETCH(obj)->sp.exit.dest[i], REFS_LINKED, obj);
+            }
+
+            break;
+
+        case TYPE_ROOM:
+            db_refs[obj].link = DBFETCH(obj)->sp.room.dropto;
+            break;
+
+        case TYPE_THING:
+        case TYPE_PLAYER:
+            db_refs[obj].link = PLAYER_SP(obj) ? PLAYER_HOME(obj) : NOTHING;
+            break;
+    }
+
+    db_refs[obj].owner = OWNER(obj);
+    db_refs_add(db_refs[obj].owner, REFS_OWNED, obj);
+    db_refs_add(db_refs[obj].link, REFS_LINKED, obj);
+}
+
+/**
+ * Rebuild the reverse reference indexes from scratch
+ *
+ * This is done after the database is loaded, and after anything that
+ * edits object fields directly, like \@sanfix.
+ */
+void
+db_reindex(void)
+{
+    for (dbref i = 0; i < db_refs_top; i++) {
+        for (int kind = 0; kind < REFS_KINDS; kind++) {
+            db_refs[i].lists[kind].count = 0;
+        }
+
+        db_refs[i].owner = NOTHING;
+        db_refs[i].link = NOTHING;
+    }
+
+    for (dbref i = 0; i < db_top; i++) {
+        db_refs_index(i);
+    }
+}
+
+/**
+ * Remove an object from the reverse reference indexes
+ *
+ * This drops the object's own owner and links from the indexes; the
+ * lists of objects referring to it are left alone.  It must be called
+ * while the object's exit destinations, if any, are still in place.
+ *
+ * @param obj the object to remove
+ */
+void
+db_unindex_object(dbref obj)
+{
+    if (obj < 0 || obj >= db_refs_top)
+        return;
+
+    if (OBJECT_TYPE(obj) == TYPE_EXIT) {
+        for (int i = 0; i < DBFETCH(obj)->sp.exit.ndest; i++) {
+            db_refs_remove(DBFETCH(obj)->sp.exit.dest[i], REFS_LINKED, obj);
+        }
+    }
+
+    db_refs_remove(db_refs[obj].owner, REFS_OWNED, obj);
+    db_refs_remove(db_refs[obj].link, REFS_LINKED, obj);
+    db_refs[obj].owner = NOTHING;
+    db_refs[obj].link = NOTHING;
+}
+
+/**
+ * Free the reverse reference indexes
+ *
+ * @private
+ */
+static void
+db_refs_free(void)
+{
+    for (dbref i = 0; i < db_refs_top; i++) {
+        for (int kind = 0; kind < REFS_KINDS; kind++) {
+            free(db_refs[i].lists[kind].refs);
+        }
+    }
+
+    free(db_refs);
+    db_refs = NULL;
+    db_refs_top = 0;
+}
+
+/**
+ * Get the objects referring to 'target' in a given way
+ *
+ * The list is sorted by dbref and belongs to the index; it changes as
+ * soon as any owner or link does, so copy it first if you are going to
+ * change the objects in it.
+ *
+ * @param target the object being referred to
+ * @param kind REFS_OWNED for objects it owns, REFS_LINKED for objects
+ *             linked to it
+ * @param[out] count the number of objects in the list
+ * @return the objects, or NULL if there are none
+ */
+const dbref *
+db_referrers(dbref target, int kind, int *count)
+{
+    if (target < 0 || target >= db_refs_top
+        || !db_refs[target].lists[kind].count) {
+        *count = 0;
+        return NULL;
+    }
+
+    *count = db_refs[target].lists[kind].count;
+    return db_refs[target].lists[kind].refs;
+}
+
+/**
+ * Copy the list of objects referring to 'target' in a given way
+ *
+ * Use this instead of db_referrers when the objects are going to be
+ * changed while going through the list.
+ *
+ * @param target the object being referred to
+ * @param kind REFS_OWNED or REFS_LINKED
+ * @param[out] count the number of objects in the list
+ * @return a sorted copy of the list, to be freed by the caller, or NULL
+ *         if there are none
+ */
+dbref *
+db_copy_referrers(dbref target, int kind, int *count)
+{
+    const dbref *refs = db_referrers(target, kind, count);
+    dbref *copy;
+
+    if (!*count)
+        return NULL;
+
+    if (!(copy = malloc(sizeof(dbref) * (size_t)*count))) {
+        panic("db_copy_referrers(): Out of memory");
+    }
+
+    memcpy(copy, refs, sizeof(dbref) * (size_t)*count);
+    return copy;
+}
+
+/**
+ * Find the next object after 'after' that refers to 'target'
+ *
+ * @param target the object being referred to
+ * @param kind REFS_OWNED or REFS_LINKED
+ * @param after the dbref to start after, or NOTHING to start at the top
+ * @return the lowest referring dbref greater than 'after', or NOTHING
+ */
+dbref
+db_next_referrer(dbref target, int kind, dbref after)
+{
+    struct refindex *l;
+    int at;
+
+    if (target < 0 || target >= db_refs_top)
+        return NOTHING;
+
+    l = &db_refs[target].lists[kind];
+    at = refindex_find(l, after + 1);
+
+    return at < l->count ? l->refs[at] : NOTHING;
+}
+
+/**
+ * Set the owner of an object, keeping the ownership index up to date
+ *
+ * This does not set the object dirty.
+ *
+ * @param obj the object to change
+ * @param owner the new owner
+ */
+void
+db_set_owner(dbref obj, dbref owner)
+{
+    OWNER(obj) = owner;
+
+    if (obj < 0 || obj >= db_refs_top)
+        return;
+
+    db_refs_remove(db_refs[obj].owner, REFS_OWNED, obj);
+    db_refs[obj].owner = owner;
+    db_refs_add(owner, REFS_OWNED, obj);
+}
+
+/**
+ * Update the index for an object's home or dropto
+ *
+ * @private
+ * @param obj the object that changed
+ * @param link its new home or dropto
+ */
+static void
+db_refs_relink(dbref obj, dbref link)
+{
+    if (obj < 0 || obj >= db_refs_top)
+        return;
+
+    db_refs_remove(db_refs[obj].link, REFS_LINKED, obj);
+    db_refs[obj].link = link;
+    db_refs_add(link, REFS_LINKED, obj);
+}
+
+/**
+ * Set the home of a thing or player, keeping the link index up to date
+ *
+ * This does not set the object dirty.  It is normally used through
+ * THING_SET_HOME or PLAYER_SET_HOME.
+ *
+ * @param obj the thing or player to change
+ * @param home the new home
+ */
+void
+db_set_home(dbref obj, dbref home)
+{
+    PLAYER_SP(obj)->home = home;
+    db_refs_relink(obj, home);
+}
+
+/**
+ * Set the dropto of a room, keeping the link index up to date
+ *
+ * This does not set the room dirty.
+ *
+ * @param room the room to change
+ * @param dropto the new dropto
+ */
+void
+db_set_dropto(dbref room, dbref dropto)
+{
+    DBFETCH(room)->sp.room.dropto = dropto;
+    db_refs_relink(room, dropto);
+}
+
+/**
+ * Set the destinations of an exit, keeping the link index up to date
+ *
+ * The exit takes over 'dest', which must be allocated with malloc (or
+ * be NULL if 'ndest' is 0).  The old destination array is freed, so
+ * don't edit it in place; the index needs the old destinations.
+ *
+ * This does not set the exit dirty.
+ *
+ * @param exit the exit to change
+ * @param ndest the number of destinations
+ * @param dest the destinations
+ */
+void
+db_set_exit_dests(dbref exit, int ndest, dbref *dest)
+{
+    struct object *o = DBFETCH(exit);
+
+    for (int i = 0; i < o->sp.exit.ndest; i++) {
+        db_refs_remove(o->sp.exit.dest[i], REFS_LINKED, exit);
+    }
+
+    if (o->sp.exit.dest != dest) {
+        free(o->sp.exit.dest);
+    }
+
+    o->sp.exit.ndest = ndest;
+    o->sp.exit.dest = dest;
+
+    for (int i = 0; i < ndest; i++) {
+        db_refs_add(dest[i], REFS_LINKED, exit);
+    }
+}
+
 /**
  * Grow the DB to a new size.
  *
  * 'newtop' will be the number of elements in the DB.  This won't let you
  * shrink the DB, 'newtop' must be greater than db_top
  *
- * @private
  * @param newtop the new DB size
  */
-static void
+void
 db_grow(dbref newtop)
 {
     if (newtop > db_top) {
@@ -91,6 +551,8 @@ db_grow(dbref newtop)
                 abort();
             }
         }
+
+        db_refs_grow(newtop);
     }
 }
 
@@ -127,6 +589,8 @@ db_clear_object(dbref i)
 
 #ifdef DISKBASE
     o->propsfpos = 0;
+    o->propsflen = 0;
+    o->propsbytes = 0;
     o->propstime = 0;
     o->propsmode = PROPS_UNLOADED;
     o->nextold = NOTHING;
@@ -189,9 +653,9 @@ create_object(const char *name, dbref owner, object_flag_type flags)
 {
     dbref newobj = new_object((flags & TYPE_MASK) == TYPE_PLAYER);
 
-    NAME(newobj) = alloc_string(name);
+    NAME(newobj) = alloc_interned(name);
     FLAGS(newobj) = flags;
-    OWNER(newobj) = OWNER(owner);
+    db_set_owner(newobj, OWNER(owner));
 
     return newobj;
 }
@@ -227,9 +691,10 @@ create_action(dbref player, const char *name, dbref source, char *error)
     DBFETCH(newact)->sp.exit.dest = NULL;
 
     if (tp_autolink_actions) {
-        DBFETCH(newact)->sp.exit.ndest = 1;
-        DBFETCH(newact)->sp.exit.dest = malloc(sizeof(dbref));
-        (DBFETCH(newact)->sp.exit.dest)[0] = NIL;
+        dbref *dest = malloc(sizeof(dbref));
+
+        dest[0] = NIL;
+        db_set_exit_dests(newact, 1, dest);
     }
 
     return newact;
@@ -414,6 +879,8 @@ clone_thing(dbref thing, dbref player, int copy_hidden_props, char *error)
     o->properties = copy_prop(thing, copy_hidden_props);
 #ifdef DISKBASE
     o->propsfpos = 0;
+    o->propsflen = 0;
+    o->propsbytes = 0;
     o->propsmode = PROPS_UNLOADED;
     o->propstime = 0;
     o->nextold = NOTHING;
@@ -520,11 +987,10 @@ putproperties(FILE * f, dbref obj)
  *   * PROGRAM:
  *     * owner field as integer string
  *
- * @private
  * @param f the file handle
  * @param i the object dbref to write to the file handle
  */
-static void
+void
 db_write_object(FILE * f, dbref i)
 {
     struct object *o = DBFETCH(i);
@@ -557,6 +1023,7 @@ db_write_object(FILE * f, dbref i)
     tmppos = ftell(f) + 1;
     putprops_copy(f, i);
     o->propsfpos = tmppos;
+    o->propsflen = ftell(f) - tmppos;
     undirtyprops(i);
 #else /* !DISKBASE */
     putproperties(f, i);
@@ -783,6 +1250,9 @@ db_write_header(FILE * f)
  *
  * The dump ends with ***END OF DUMP***
  *
+ * If the dbdump_binary \@tune parameter is set, the binary format is
+ * written instead.  @see db_binary_write
+ *
  * If there is an error writing, this abort()s the program.
  *
  * @param f the file handle to write to
@@ -791,6 +1261,12 @@ db_write_header(FILE * f)
 dbref
 db_write(FILE * f)
 {
+#ifndef DISKBASE
+    if (tp_dbdump_binary) {
+        return db_binary_write(f);
+    }
+#endif
+
     db_write_header(f);
 
     for (dbref i = db_top; i-- > 0;) {
@@ -938,9 +1414,11 @@ db_free_object(dbref i)
         FREE_PROGRAM_SP(i);
     }
 
+    db_unindex_object(i);
+
     o = DBFETCH(i);
 
-    free((void *) NAME(i));
+    free_interned(NAME(i));
 
 #ifdef DISKBASE
     unloadprops_with_prejudice(i);
@@ -981,6 +1459,8 @@ db_free_object(dbref i)
 void
 db_free(void)
 {
+    db_refs_free();
+
     if (db) {
         for (dbref i = 0; i < db_top; i++)
             db_free_object(i);
@@ -1006,16 +1486,16 @@ db_free(void)
  * for all intents and purposes ignored.  If it is 0, we return immediately,
  * but otherwise nothing is done with this number.
  *
- * @private
  * @param f the file handle
  * @param objno the object ref we are loading
  */
-static void
+void
 db_read_object(FILE * f, dbref objno)
 {
     int tmp, c, prop_flag = 0;
     int j = 0;
     const char *password;
+    char *name;
     struct object *o;
 
     db_clear_object(objno);
@@ -1025,7 +1505,9 @@ db_read_object(FILE * f, dbref objno)
      * error checking here.
      */
     FLAGS(objno) = 0;
-    NAME(objno) = getstring(f);
+    name = getstring(f);
+    NAME(objno) = alloc_interned(name);
+    free(name);
 
     o = DBFETCH(objno);
     o->location = getref(f);
@@ -1058,6 +1540,8 @@ db_read_object(FILE * f, dbref objno)
         } else {
             skipproperties(f, objno);
         }
+
+        o->propsflen = ftell(f) - o->propsfpos;
 #else
         getproperties(f, objno, NULL);
 #endif
@@ -1185,6 +1669,9 @@ autostart_progs(void)
  * there is a problem loading the database, chances are it will trigger
  * an abort() as there is no gentle error handling in this process.
  *
+ * Both the text format and the binary format are understood; which one
+ * the file is in is worked out from its first few bytes.
+ *
  * @param f the file handle to load from
  * @return the dbtop value or #-1 if the header is invalid
  */
@@ -1194,6 +1681,22 @@ db_read(FILE * f)
     dbref grow;
     char *special;
 
+#ifdef DISKBASE
+    if (do_peek(f) == 'F') {
+        log_status("LOADING: This looks like a binary dump, which DISKBASE "
+                   "can't use.  Convert it with a server built without it.");
+        return -1;
+    }
+#else
+    if (db_binary_check(f)) {
+        if (db_binary_read(f) < 0) {
+            return -1;
+        }
+
+        goto loaded;
+    }
+#endif
+
     /* Parse the header */
     db_load_format = db_read_header(f, &grow);
 
@@ -1228,6 +1731,13 @@ db_read(FILE * f)
     getref(f);
     tune_load_parms_from_file(f, NOTHING, getref(f));
 
+#ifndef DISKBASE
+loaded:
+#endif
+#ifdef DB_JOURNAL
+    journal_replay();
+#endif
+
     for (dbref j = 0; j < db_top; j++) {
         if (OBJECT_TYPE(j) == TYPE_GARBAGE) {
             NEXTOBJ(j) = recyclable;
@@ -1235,6 +1745,7 @@ db_read(FILE * f)
         }
     }
 
+    db_reindex();
     autostart_progs();
     return db_top;
 }
@@ -2078,7 +2589,7 @@ register_object(dbref player, dbref location, const char *propdir, char *name,
     dbref prevobj = -50;
     char buf[BUFFER_LEN];
     char unparse_buf[BUFFER_LEN], unparse_buf2[BUFFER_LEN];
-    char *strval;
+    const char *strval;
 
     if (!is_valid_propname(name)) {
         notifyf_nolisten(player, "Registry name '%s' is not valid", name);
@@ -2196,14 +2707,21 @@ collect_dbstats(dbref player, dbref ref, int stats[7])
         stats[i] = 0;
     }
 
-    for (dbref i = 0; i < db_top; i++) {
-        if (ref == NOTHING || OWNER(i) == ref) {
-            for (int t = 0, n = ARRAYSIZE(types); t < n; t++) {
-                if (OBJECT_TYPE(i) == types[t]) {
-                    stats[t+1]++;
-                    stats[0]++;
-                    break;
-                }
+    const dbref *owned = NULL;
+    int count = db_top;
+
+    if (ref != NOTHING) {
+        owned = db_referrers(ref, REFS_OWNED, &count);
+    }
+
+    for (int j = 0; j < count; j++) {
+        dbref i = owned ? owned[j] : j;
+
+        for (int t = 0, n = ARRAYSIZE(types); t < n; t++) {
+            if (OBJECT_TYPE(i) == types[t]) {
+                stats[t+1]++;
+                stats[0]++;
+                break;
             }
         }
     }
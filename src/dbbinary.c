@@ -0,0 +1,1424 @@
+/** @file dbbinary.c
+ *
+ * Source for the binary database dump format.
+ *
+ * A binary dump is laid out as follows.  All numbers are little endian,
+ * and every string is a 32 bit length followed by the bytes of the string
+ * and a terminating NUL, so that strings can be used where they lie.
+ *
+ * * The header: the magic string DBBIN_MAGIC, the format version, db_top
+ *   and the number of tune parameters, as 32 bit numbers.
+ * * The tune parameters, as lines of text exactly as in the text format.
+ * * The object sections, each holding DB_BINARY_SECTION_SIZE objects in
+ *   dbref order, except for the last which may hold fewer.
+ * * The property name table: a count followed by the names.  Property
+ *   names are stored once here and referred to by their position.
+ * * The section index: a count followed by, for each section, its file
+ *   offset (64 bits), its length, the first dbref in it and the number
+ *   of objects in it.
+ * * The footer: the file offsets of the name table and the section index
+ *   (64 bits each), followed by the magic string DBBIN_END_MAGIC.
+ *
+ * Each object holds the same fields as in the text format, in the same
+ * order; see db_write_object in db.c.  Properties are stored as a tree:
+ * a directory is an entry count followed by its entries in sorted order,
+ * and each entry is a name number, the property flags, the value (whose
+ * layout depends on the type), and then the directory under it, which is
+ * usually empty.  Because the entries are already sorted, the loader can
+ * fill in each directory's array directly, without any searching.
+ *
+ * Nothing in an object section depends on any other section, so the
+ * loader hands the sections out to DB_LOAD_THREADS threads.  The only
+ * work that has to wait for the main thread is anything that touches
+ * shared state: interning names and string values, parsing locks, and
+ * adding players to the player hash.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#ifndef DISKBASE
+
+#ifndef WIN32
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+/*
+ * The memory profiler keeps its books in unlocked globals, so everything
+ * is decoded on the main thread when it is turned on.
+ */
+#if defined(HAVE_PTHREAD_H) && !defined(WIN32) && !defined(MALLOC_PROFILING)
+# define DB_LOAD_PARALLEL
+# include <pthread.h>
+#endif
+
+#include "boolexp.h"
+#include "db.h"
+#include "dbbinary.h"
+#include "fbmath.h"
+#include "fbstrings.h"
+#include "flags.h"
+#include "game.h"
+#include "log.h"
+#include "player.h"
+#include "props.h"
+#include "tune.h"
+
+#define DBBIN_MAGIC         "FBDBBIN\n" /**< Start of a binary dump    */
+#define DBBIN_END_MAGIC     "FBDBEND\n" /**< End of a binary dump      */
+#define DBBIN_MAGIC_LEN     8           /**< Length of the magic      */
+#define DBBIN_VERSION       1           /**< Current format version   */
+#define DBBIN_HEADER_SIZE   20          /**< Bytes before tune parms  */
+#define DBBIN_FOOTER_SIZE   24          /**< Bytes in the footer      */
+#define DBBIN_INDEX_SIZE    20          /**< Bytes per index entry    */
+
+/*
+ * Where a section of objects lives in the file
+ */
+struct dbbin_section {
+    uint64_t offset;        /* File offset of the section   */
+    uint32_t length;        /* Length of the section        */
+    dbref first;            /* First dbref in the section   */
+    uint32_t count;         /* Number of objects in it      */
+};
+
+/*
+ * The property name table built up while writing a dump
+ */
+struct dbbin_names {
+    const char **names;     /* The names, by number                     */
+    unsigned int count;     /* Number of names                          */
+    unsigned int *slots;    /* Hash slots holding number + 1, 0 if free */
+    unsigned int mask;      /* Number of slots - 1                      */
+};
+
+/*
+ * State for writing a dump
+ */
+struct dbbin_writer {
+    FILE *f;                /* The file being written               */
+    unsigned char *buf;     /* The section being built              */
+    size_t len;             /* Bytes used in 'buf'                  */
+    size_t size;            /* Bytes allocated for 'buf'            */
+    struct dbbin_names names;           /* Property names seen so far  */
+    struct dbbin_section *sections;     /* Sections written so far     */
+    unsigned int nsections;             /* Number of sections written  */
+};
+
+/*
+ * A position in a loaded dump, with the point where reading must stop
+ */
+struct dbbin_reader {
+    const unsigned char *pos;   /* Next byte to read            */
+    const unsigned char *end;   /* End of the readable area     */
+    const char *error;          /* Why reading failed, or NULL  */
+};
+
+/*
+ * A property value waiting for the main thread: a lock to parse, or a
+ * string to intern
+ */
+struct dbbin_pending {
+    PropPtr node;           /* The property to put the value in */
+    const char *text;       /* The value as text                */
+};
+
+/*
+ * A loaded dump, shared by all the loader threads
+ */
+struct dbbin_file {
+    const unsigned char *data;          /* The whole file               */
+    size_t size;                        /* Its length                   */
+    const char **names;                 /* The property name table      */
+    const char **keys;                  /* The same names, interned     */
+    uint32_t namecount;                 /* Number of names              */
+    struct dbbin_section *sections;     /* The section index            */
+    uint32_t nsections;                 /* Number of sections           */
+};
+
+/*
+ * The work of one loader thread
+ */
+struct dbbin_loader {
+    const struct dbbin_file *file;      /* The dump being loaded        */
+    uint32_t first;                     /* First section to decode      */
+    uint32_t stride;                    /* Gap to the next one          */
+    struct dbbin_pending *pending;      /* Values left to set           */
+    size_t npending;                    /* Number of them               */
+    size_t maxpending;                  /* Space for them               */
+    uint32_t *keyuses;                  /* Properties using each key    */
+    const char *error;                  /* Why decoding failed, or NULL */
+    dbref error_obj;                    /* The object it failed on      */
+};
+
+/**
+ * Grow a block of memory, aborting if there is no more to be had
+ *
+ * This may be called from the loader threads, so it can't panic().
+ *
+ * @private
+ * @param ptr the block to grow, or NULL
+ * @param size the new size
+ * @return the grown block
+ */
+static void *
+dbbin_realloc(void *ptr, size_t size)
+{
+    if ((ptr = realloc(ptr, size)) == NULL) {
+        fprintf(stderr, "dbbin_realloc(): Out of Memory!\n");
+        abort();
+    }
+
+    return ptr;
+}
+
+/**
+ * Hash a property name for the name table
+ *
+ * Unlike the property tree, the name table is case sensitive, so that
+ * names are written back exactly as they were set.
+ *
+ * @private
+ * @param name the name to hash
+ * @return the hash value
+ */
+static unsigned int
+dbbin_hash(const char *name)
+{
+    unsigned int h = 2166136261u;
+
+    while (*name) {
+        h = (h ^ (unsigned char) *name++) * 16777619u;
+    }
+
+    return h;
+}
+
+/**
+ * Find the number of a property name, adding it to the table if needed
+ *
+ * The table keeps pointers to the names, which must stay put until the
+ * dump is finished.
+ *
+ * @private
+ * @param t the name table
+ * @param name the name to look up
+ * @return the number of the name
+ */
+static uint32_t
+dbbin_intern(struct dbbin_names *t, const char *name)
+{
+    unsigned int h;
+
+    if ((t->count + 1) * 2 > t->mask) {
+        unsigned int newmask = t->mask ? t->mask * 2 + 1 : 1023;
+        unsigned int *slots = calloc(newmask + 1, sizeof(unsigned int));
+
+        if (!slots) {
+            fprintf(stderr, "dbbin_intern(): Out of Memory!\n");
+            abort();
+        }
+
+        for (unsigned int i = 0; i < t->count; i++) {
+            h = dbbin_hash(t->names[i]) & newmask;
+
+            while (slots[h])
+                h = (h + 1) & newmask;
+
+            slots[h] = i + 1;
+        }
+
+        free(t->slots);
+        t->slots = slots;
+        t->mask = newmask;
+        t->names = dbbin_realloc(t->names,
+                                 (t->mask + 1) / 2 * sizeof(const char *));
+    }
+
+    for (h = dbbin_hash(name) & t->mask; t->slots[h];
+         h = (h + 1) & t->mask) {
+        if (!strcmp(t->names[t->slots[h] - 1], name))
+            return t->slots[h] - 1;
+    }
+
+    t->names[t->count] = name;
+    t->slots[h] = ++t->count;
+    return t->count - 1;
+}
+
+/**
+ * Make room for 'n' more bytes in the writer's buffer
+ *
+ * @private
+ * @param w the writer
+ * @param n the number of bytes needed
+ * @return where the bytes should be written
+ */
+static unsigned char *
+dbbin_reserve(struct dbbin_writer *w, size_t n)
+{
+    unsigned char *p;
+
+    if (w->len + n > w->size) {
+        while (w->len + n > w->size)
+            w->size = w->size ? w->size * 2 : 65536;
+
+        w->buf = dbbin_realloc(w->buf, w->size);
+    }
+
+    p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+/**
+ * Add a 16 bit number to the writer's buffer
+ *
+ * @private
+ * @param w the writer
+ * @param v the number
+ */
+static void
+dbbin_put16(struct dbbin_writer *w, uint16_t v)
+{
+    unsigned char *p = dbbin_reserve(w, 2);
+
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char) (v >> 8);
+}
+
+/**
+ * Add a 32 bit number to the writer's buffer
+ *
+ * @private
+ * @param w the writer
+ * @param v the number
+ */
+static void
+dbbin_put32(struct dbbin_writer *w, uint32_t v)
+{
+    unsigned char *p = dbbin_reserve(w, 4);
+
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char) (v >> 8);
+    p[2] = (unsigned char) (v >> 16);
+    p[3] = (unsigned char) (v >> 24);
+}
+
+/**
+ * Add a 64 bit number to the writer's buffer
+ *
+ * @private
+ * @param w the writer
+ * @param v the number
+ */
+static void
+dbbin_put64(struct dbbin_writer *w, uint64_t v)
+{
+    dbbin_put32(w, (uint32_t) v);
+    dbbin_put32(w, (uint32_t) (v >> 32));
+}
+
+/**
+ * Add a string to the writer's buffer
+ *
+ * NULL is written as an empty string, as the text format does.
+ *
+ * @private
+ * @param w the writer
+ * @param s the string
+ */
+static void
+dbbin_putstr(struct dbbin_writer *w, const char *s)
+{
+    size_t len = s ? strlen(s) : 0;
+
+    dbbin_put32(w, (uint32_t) len);
+    memcpy(dbbin_reserve(w, len + 1), s ? s : "", len + 1);
+}
+
+/**
+ * Write out and empty the writer's buffer
+ *
+ * @private
+ * @param w the writer
+ */
+static void
+dbbin_flush(struct dbbin_writer *w)
+{
+    if (w->len && fwrite(w->buf, 1, w->len, w->f) != w->len) {
+        abort();
+    }
+
+    w->len = 0;
+}
+
+/**
+ * Get the current file offset of the writer, aborting if it is unknown
+ *
+ * @private
+ * @param w the writer
+ * @return the offset the next flush will write to
+ */
+static uint64_t
+dbbin_tell(struct dbbin_writer *w)
+{
+    long pos = ftell(w->f);
+
+    if (pos < 0) {
+        abort();
+    }
+
+    return (uint64_t) pos + w->len;
+}
+
+static uint32_t dbbin_write_propdir(struct dbbin_writer *w, PropDirPtr dir);
+
+/**
+ * Write one property and the directory under it
+ *
+ * Properties are skipped when the text format would skip them: when
+ * they have an empty value and nothing under them.  A property with an
+ * empty value but with properties under it is written as a bare
+ * directory.
+ *
+ * @private
+ * @param w the writer
+ * @param p the property
+ * @return 1 if the property was written, 0 if it was skipped
+ */
+static int
+dbbin_write_prop(struct dbbin_writer *w, PropPtr p)
+{
+    size_t start = w->len;
+    int outflags = PropFlagsRaw(p) & ~(PROP_TOUCHED | PROP_ISUNLOADED
+                                       | PROP_DIRUNLOADED);
+    int empty;
+
+    switch (PropType(p)) {
+        case PROP_INTTYP:
+            empty = !PropDataVal(p);
+            break;
+        case PROP_FLTTYP:
+            empty = PropDataFVal(p) == 0.0;
+            break;
+        case PROP_REFTYP:
+            empty = PropDataRef(p) == NOTHING;
+            break;
+        case PROP_STRTYP:
+            empty = !PropDataStr(p) || !*PropDataStr(p);
+            break;
+        case PROP_LOKTYP:
+            empty = PropDataLok(p) == TRUE_BOOLEXP;
+            break;
+        default:
+            empty = 1;
+            break;
+    }
+
+    if (empty)
+        outflags = PROP_DIRTYP;
+
+    dbbin_put32(w, dbbin_intern(&w->names, PropName(p)));
+    dbbin_put16(w, (uint16_t) outflags);
+
+    switch (outflags & PROP_TYPMASK) {
+        case PROP_INTTYP:
+            dbbin_put32(w, (uint32_t) PropDataVal(p));
+            break;
+        case PROP_FLTTYP: {
+            double fval = PropDataFVal(p);
+            uint64_t bits;
+
+            memcpy(&bits, &fval, sizeof(bits));
+            dbbin_put64(w, bits);
+            break;
+        }
+        case PROP_REFTYP:
+            dbbin_put32(w, (uint32_t) PropDataRef(p));
+            break;
+        case PROP_STRTYP:
+            dbbin_putstr(w, PropDataStr(p));
+            break;
+        case PROP_LOKTYP:
+            dbbin_putstr(w, unparse_boolexp((dbref) 1, PropDataLok(p), 0));
+            break;
+    }
+
+    if (!dbbin_write_propdir(w, PropDir(p)) && empty) {
+        w->len = start;
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Write a property directory: its entry count, then its entries
+ *
+ * @private
+ * @param w the writer
+ * @param dir the directory
+ * @return the number of entries written
+ */
+static uint32_t
+dbbin_write_propdir(struct dbbin_writer *w, PropDirPtr dir)
+{
+    size_t countpos = w->len;
+    uint32_t count = 0;
+
+    dbbin_put32(w, 0);
+
+    if (dir) {
+        for (unsigned int i = 0; i < dir->count; i++)
+            count += (uint32_t) dbbin_write_prop(w, &dir->props[i]);
+    }
+
+    /* Fill in the count now that we know it. */
+    w->buf[countpos] = (unsigned char) count;
+    w->buf[countpos + 1] = (unsigned char) (count >> 8);
+    w->buf[countpos + 2] = (unsigned char) (count >> 16);
+    w->buf[countpos + 3] = (unsigned char) (count >> 24);
+
+    return count;
+}
+
+/**
+ * Write an object to the writer's buffer
+ *
+ * The fields are the same as in the text format, in the same order.
+ *
+ * @private
+ * @param w the writer
+ * @param i the object to write
+ */
+static void
+dbbin_write_object(struct dbbin_writer *w, dbref i)
+{
+    struct object *o = DBFETCH(i);
+
+    dbbin_putstr(w, NAME(i));
+    dbbin_put32(w, (uint32_t) o->location);
+    dbbin_put32(w, (uint32_t) o->contents);
+    dbbin_put32(w, (uint32_t) o->next);
+    dbbin_put32(w, (uint32_t) (FLAGS(i) & ~DUMP_MASK));
+    dbbin_put64(w, (uint64_t) o->ts_created);
+    dbbin_put64(w, (uint64_t) o->ts_lastused);
+    dbbin_put32(w, (uint32_t) o->ts_usecount);
+    dbbin_put64(w, (uint64_t) o->ts_modified);
+
+    dbbin_write_propdir(w, o->properties);
+
+    switch (OBJECT_TYPE(i)) {
+        case TYPE_THING:
+            dbbin_put32(w, (uint32_t) THING_HOME(i));
+            dbbin_put32(w, (uint32_t) o->exits);
+            dbbin_put32(w, (uint32_t) OWNER(i));
+            break;
+
+        case TYPE_ROOM:
+            dbbin_put32(w, (uint32_t) o->sp.room.dropto);
+            dbbin_put32(w, (uint32_t) o->exits);
+            dbbin_put32(w, (uint32_t) OWNER(i));
+            break;
+
+        case TYPE_EXIT:
+            dbbin_put32(w, (uint32_t) o->sp.exit.ndest);
+
+            for (int j = 0; j < o->sp.exit.ndest; j++) {
+                dbbin_put32(w, (uint32_t) (o->sp.exit.dest)[j]);
+            }
+
+            dbbin_put32(w, (uint32_t) OWNER(i));
+            break;
+
+        case TYPE_PLAYER:
+            dbbin_put32(w, (uint32_t) PLAYER_HOME(i));
+            dbbin_put32(w, (uint32_t) o->exits);
+            dbbin_putstr(w, PLAYER_PASSWORD(i));
+            break;
+
+        case TYPE_PROGRAM:
+            dbbin_put32(w, (uint32_t) OWNER(i));
+            break;
+    }
+}
+
+/**
+ * Write the database to the given file handle in the binary format
+ *
+ * Objects are written DB_BINARY_SECTION_SIZE at a time, so only one
+ * section needs to be held in memory.  If there is an error writing,
+ * this abort()s the program, as the text writer does.
+ *
+ * @param f the file handle to write to
+ * @return db_top value
+ */
+dbref
+db_binary_write(FILE * f)
+{
+    struct dbbin_writer w;
+    uint64_t strtab_offset, index_offset;
+
+    memset(&w, 0, sizeof(w));
+    w.f = f;
+
+    memcpy(dbbin_reserve(&w, DBBIN_MAGIC_LEN), DBBIN_MAGIC, DBBIN_MAGIC_LEN);
+    dbbin_put32(&w, DBBIN_VERSION);
+    dbbin_put32(&w, (uint32_t) db_top);
+    dbbin_put32(&w, (uint32_t) tune_count_parms());
+    dbbin_flush(&w);
+
+    tune_save_parms_to_file(f);
+
+    w.sections = dbbin_realloc(NULL, sizeof(struct dbbin_section)
+                   * (size_t) (db_top / DB_BINARY_SECTION_SIZE + 1));
+
+    for (dbref first = 0; first < db_top; first += DB_BINARY_SECTION_SIZE) {
+        struct dbbin_section *s = &w.sections[w.nsections++];
+
+        s->offset = dbbin_tell(&w);
+        s->first = first;
+        s->count = (uint32_t) MIN(db_top - first, DB_BINARY_SECTION_SIZE);
+
+        for (dbref i = first; i < first + (dbref) s->count; i++) {
+            dbbin_write_object(&w, i);
+            FLAGS(i) &= ~OBJECT_CHANGED;    /* clear changed flag */
+        }
+
+        s->length = (uint32_t) w.len;
+        dbbin_flush(&w);
+    }
+
+    strtab_offset = dbbin_tell(&w);
+    dbbin_put32(&w, w.names.count);
+
+    for (unsigned int i = 0; i < w.names.count; i++) {
+        dbbin_putstr(&w, w.names.names[i]);
+    }
+
+    index_offset = dbbin_tell(&w);
+    dbbin_put32(&w, w.nsections);
+
+    for (unsigned int i = 0; i < w.nsections; i++) {
+        dbbin_put64(&w, w.sections[i].offset);
+        dbbin_put32(&w, w.sections[i].length);
+        dbbin_put32(&w, (uint32_t) w.sections[i].first);
+        dbbin_put32(&w, w.sections[i].count);
+    }
+
+    dbbin_put64(&w, strtab_offset);
+    dbbin_put64(&w, index_offset);
+    memcpy(dbbin_reserve(&w, DBBIN_MAGIC_LEN), DBBIN_END_MAGIC,
+           DBBIN_MAGIC_LEN);
+    dbbin_flush(&w);
+
+    fflush(f);
+
+    free(w.buf);
+    free(w.names.names);
+    free(w.names.slots);
+    free(w.sections);
+
+    return db_top;
+}
+
+/**
+ * Fail a read, remembering the first reason given
+ *
+ * Once a read fails, the reader has nothing left to give, so everything
+ * after it reads as zero until the caller notices.
+ *
+ * @private
+ * @param r the reader
+ * @param error why the read failed
+ */
+static void
+dbbin_fail(struct dbbin_reader *r, const char *error)
+{
+    if (!r->error)
+        r->error = error;
+
+    r->pos = r->end;
+}
+
+/**
+ * Take 'n' bytes from a reader
+ *
+ * @private
+ * @param r the reader
+ * @param n the number of bytes
+ * @return the bytes, or NULL if there are not enough left
+ */
+static const unsigned char *
+dbbin_take(struct dbbin_reader *r, size_t n)
+{
+    const unsigned char *p = r->pos;
+
+    if ((size_t) (r->end - r->pos) < n) {
+        dbbin_fail(r, "Unexpected end of data.");
+        return NULL;
+    }
+
+    r->pos += n;
+    return p;
+}
+
+/**
+ * Read a 16 bit number
+ *
+ * @private
+ * @param r the reader
+ * @return the number, or 0 if the read failed
+ */
+static uint16_t
+dbbin_get16(struct dbbin_reader *r)
+{
+    const unsigned char *p = dbbin_take(r, 2);
+
+    return p ? (uint16_t) (p[0] | (p[1] << 8)) : 0;
+}
+
+/**
+ * Read a 32 bit number
+ *
+ * @private
+ * @param r the reader
+ * @return the number, or 0 if the read failed
+ */
+static uint32_t
+dbbin_get32(struct dbbin_reader *r)
+{
+    const unsigned char *p = dbbin_take(r, 4);
+
+    if (!p)
+        return 0;
+
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8)
+           | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * Read a 64 bit number
+ *
+ * @private
+ * @param r the reader
+ * @return the number, or 0 if the read failed
+ */
+static uint64_t
+dbbin_get64(struct dbbin_reader *r)
+{
+    uint64_t low = dbbin_get32(r);
+
+    return low | ((uint64_t) dbbin_get32(r) << 32);
+}
+
+/**
+ * Read a string
+ *
+ * The string is left where it is in the file.
+ *
+ * @private
+ * @param r the reader
+ * @return the string, or "" if the read failed
+ */
+static const char *
+dbbin_getstr(struct dbbin_reader *r)
+{
+    uint32_t len = dbbin_get32(r);
+    const unsigned char *p = dbbin_take(r, (size_t) len + 1);
+
+    if (!p)
+        return "";
+
+    if (p[len] != '\0') {
+        dbbin_fail(r, "Unterminated string.");
+        return "";
+    }
+
+    return (const char *) p;
+}
+
+/**
+ * Queue a property value for the main thread to set
+ *
+ * The text points into the dump, which stays in memory until loading
+ * is over.
+ *
+ * @private
+ * @param l the loader
+ * @param node the property
+ * @param text the value as text
+ */
+static void
+dbbin_defer(struct dbbin_loader *l, PropPtr node, const char *text)
+{
+    if (l->npending == l->maxpending) {
+        l->maxpending = l->maxpending ? l->maxpending * 2 : 256;
+        l->pending = dbbin_realloc(l->pending, l->maxpending
+                                   * sizeof(struct dbbin_pending));
+    }
+
+    l->pending[l->npending].node = node;
+    l->pending[l->npending++].text = text;
+}
+
+static PropDirPtr dbbin_read_propdir(struct dbbin_loader *l,
+                                     struct dbbin_reader *r, dbref obj,
+                                     int depth);
+
+/**
+ * Read one property and the directory under it
+ *
+ * Strings and locks are left unset and queued for the main thread,
+ * because neither the string table nor the lock parser is safe to use
+ * from more than one thread.  For the same reason, the property name is
+ * taken from the keys the main thread interned beforehand, and its use
+ * is only counted here.
+ *
+ * Once the name is known to be good, the node is filled in even if a
+ * later part of the property fails to read, so that it can be freed
+ * like any other.
+ *
+ * @private
+ * @param l the loader
+ * @param r the reader
+ * @param obj the object the property belongs to
+ * @param depth how deeply nested the property is; top level props are 1
+ * @param prev the name of the previous property in the directory
+ * @param node the node to fill in
+ * @return true if the node was filled in, false if not
+ */
+static int
+dbbin_read_prop(struct dbbin_loader *l, struct dbbin_reader *r, dbref obj,
+                int depth, const char **prev, PropPtr node)
+{
+    uint32_t id = dbbin_get32(r);
+    int flags = dbbin_get16(r) & ~(PROP_TOUCHED | PROP_ISUNLOADED
+                                   | PROP_DIRUNLOADED);
+    const char *s;
+
+    if (r->error)
+        return 0;
+
+    if (id >= l->file->namecount) {
+        dbbin_fail(r, "Bad property name number.");
+        return 0;
+    }
+
+    if (*prev && strcasecmp(*prev, l->file->names[id]) >= 0) {
+        dbbin_fail(r, "Properties out of order.");
+        return 0;
+    }
+
+    *prev = l->file->names[id];
+    node->key = l->file->keys[id];
+    l->keyuses[id]++;
+    SetPFlagsRaw(node, flags);
+    SetPDataStr(node, NULL);
+    SetPDir(node, NULL);
+
+    switch (flags & PROP_TYPMASK) {
+        case PROP_DIRTYP:
+            break;
+        case PROP_STRTYP:
+            s = dbbin_getstr(r);
+
+            if (!*s) {
+                dbbin_fail(r, "Empty string property.");
+                break;
+            }
+
+            dbbin_defer(l, node, s);
+            break;
+        case PROP_INTTYP:
+            SetPDataVal(node, (int) dbbin_get32(r));
+            break;
+        case PROP_FLTTYP: {
+            uint64_t bits = dbbin_get64(r);
+            double fval;
+
+            memcpy(&fval, &bits, sizeof(fval));
+            SetPDataFVal(node, fval);
+            break;
+        }
+        case PROP_REFTYP:
+            SetPDataRef(node, (dbref) dbbin_get32(r));
+            break;
+        case PROP_LOKTYP:
+            SetPDataLok(node, TRUE_BOOLEXP);
+            dbbin_defer(l, node, dbbin_getstr(r));
+            break;
+        default:
+            SetPFlagsRaw(node, PROP_DIRTYP);
+            dbbin_fail(r, "Unknown property type.");
+            break;
+    }
+
+    /*
+     * set_property_nofetch marks objects with listen props as listeners,
+     * and the flag isn't saved, so do the same here.
+     */
+    if (depth == 1 && !(FLAGS(obj) & LISTENER)
+        && (string_prefix(PropName(node), LISTEN_PROPQUEUE)
+            || string_prefix(PropName(node), WLISTEN_PROPQUEUE)
+            || string_prefix(PropName(node), WOLISTEN_PROPQUEUE))) {
+        FLAGS(obj) |= LISTENER;
+    }
+
+    if (!r->error)
+        SetPDir(node, dbbin_read_propdir(l, r, obj, depth + 1));
+
+    return 1;
+}
+
+/**
+ * Read a property directory
+ *
+ * The directory is allocated at exactly the size the dump says it has,
+ * and never grows while loading, so the nodes queued for lock parsing
+ * stay where they are.
+ *
+ * @private
+ * @param l the loader
+ * @param r the reader
+ * @param obj the object the properties belong to
+ * @param depth how deeply nested the directory's properties are
+ * @return the directory, or NULL if it is empty
+ */
+static PropDirPtr
+dbbin_read_propdir(struct dbbin_loader *l, struct dbbin_reader *r,
+                   dbref obj, int depth)
+{
+    uint32_t count = dbbin_get32(r);
+    const char *prev = NULL;
+    PropDirPtr dir;
+
+    if (!count || r->error)
+        return NULL;
+
+    /* Every property takes at least 10 bytes. */
+    if (depth > MAX_PROPTREE_DEPTH || count > (r->end - r->pos) / 10) {
+        dbbin_fail(r, "Bad property directory.");
+        return NULL;
+    }
+
+    dir = dbbin_realloc(NULL, offsetof(struct propdir, props)
+                              + count * sizeof(struct plist));
+    dir->size = count;
+    dir->count = 0;
+
+    while (dir->count < count && !r->error) {
+        if (!dbbin_read_prop(l, r, obj, depth, &prev,
+                             &dir->props[dir->count]))
+            break;
+
+        dir->count++;
+    }
+
+    if (!dir->count) {
+        free(dir);
+        return NULL;
+    }
+
+    return dir;
+}
+
+/**
+ * Read an object
+ *
+ * This mirrors db_read_object in db.c, except that players are added to
+ * the player hash later, by the main thread.  Homes are set directly
+ * rather than with THING_SET_HOME, as the reference indexes are shared;
+ * db_read rebuilds them once everything is loaded.
+ *
+ * @private
+ * @param l the loader
+ * @param r the reader
+ * @param objno the object to read
+ */
+static void
+dbbin_read_object(struct dbbin_loader *l, struct dbbin_reader *r,
+                  dbref objno)
+{
+    struct object *o;
+    int tmp;
+
+    db_clear_object(objno);
+
+    /* The main thread interns this later. */
+    FLAGS(objno) = 0;
+    NAME(objno) = dbbin_getstr(r);
+
+    o = DBFETCH(objno);
+    o->location = (dbref) dbbin_get32(r);
+    o->contents = (dbref) dbbin_get32(r);
+    o->next = (dbref) dbbin_get32(r);
+
+    tmp = (int) dbbin_get32(r);    /* flags list */
+    tmp &= ~DUMP_MASK;
+    FLAGS(objno) |= tmp;
+
+    o->ts_created = (time_t) dbbin_get64(r);
+    o->ts_lastused = (time_t) dbbin_get64(r);
+    o->ts_usecount = (int) dbbin_get32(r);
+    o->ts_modified = (time_t) dbbin_get64(r);
+
+    o->properties = dbbin_read_propdir(l, r, objno, 1);
+
+    switch (FLAGS(objno) & TYPE_MASK) {
+        case TYPE_THING:
+            ALLOC_THING_SP(objno);
+            THING_HOME(objno) = (dbref) dbbin_get32(r);
+            o->exits = (dbref) dbbin_get32(r);
+            OWNER(objno) = (dbref) dbbin_get32(r);
+            break;
+
+        case TYPE_ROOM:
+            o->sp.room.dropto = (dbref) dbbin_get32(r);
+            o->exits = (dbref) dbbin_get32(r);
+            OWNER(objno) = (dbref) dbbin_get32(r);
+            break;
+
+        case TYPE_EXIT:
+            o->sp.exit.ndest = (int) dbbin_get32(r);
+
+            if (o->sp.exit.ndest < 0
+                || (size_t) o->sp.exit.ndest > (size_t) (r->end - r->pos) / 4) {
+                o->sp.exit.ndest = 0;
+                dbbin_fail(r, "Bad exit destination count.");
+                break;
+            }
+
+            /* only allocate space for linked exits */
+            if (o->sp.exit.ndest > 0)
+                o->sp.exit.dest = malloc(sizeof(dbref)
+                                         * (size_t) (o->sp.exit.ndest));
+
+            for (int j = 0; j < o->sp.exit.ndest; j++) {
+                (o->sp.exit.dest)[j] = (dbref) dbbin_get32(r);
+            }
+
+            OWNER(objno) = (dbref) dbbin_get32(r);
+            break;
+
+        case TYPE_PLAYER:
+            ALLOC_PLAYER_SP(objno);
+            PLAYER_HOME(objno) = (dbref) dbbin_get32(r);
+            o->exits = (dbref) dbbin_get32(r);
+            set_password_raw(objno, alloc_string(dbbin_getstr(r)));
+            PLAYER_SET_CURR_PROG(objno, NOTHING);
+            PLAYER_SET_IGNORE_LAST(objno, NOTHING);
+            OWNER(objno) = objno;
+            break;
+
+        case TYPE_PROGRAM:
+            ALLOC_PROGRAM_SP(objno);
+            OWNER(objno) = (dbref) dbbin_get32(r);
+            FLAGS(objno) &= ~INTERNAL;
+            break;
+
+        case TYPE_GARBAGE:
+            break;
+    }
+}
+
+/**
+ * Decode the sections given to a loader
+ *
+ * This is the body of each loader thread.  It stops at the first error,
+ * which is left in the loader for the main thread to report.
+ *
+ * @private
+ * @param arg the loader
+ * @return NULL
+ */
+static void *
+dbbin_decode(void *arg)
+{
+    struct dbbin_loader *l = arg;
+    const struct dbbin_file *file = l->file;
+
+    l->keyuses = dbbin_realloc(NULL, sizeof(uint32_t)
+                               * (file->namecount + 1));
+    memset(l->keyuses, 0, sizeof(uint32_t) * (file->namecount + 1));
+
+    for (uint32_t s = l->first; s < file->nsections; s += l->stride) {
+        struct dbbin_section *sec = &file->sections[s];
+        struct dbbin_reader r;
+
+        r.pos = file->data + sec->offset;
+        r.end = r.pos + sec->length;
+        r.error = NULL;
+
+        for (uint32_t i = 0; i < sec->count && !r.error; i++) {
+            l->error_obj = sec->first + (dbref) i;
+            dbbin_read_object(l, &r, l->error_obj);
+        }
+
+        if (!r.error && r.pos != r.end)
+            r.error = "Section has data left over.";
+
+        if (r.error) {
+            l->error = r.error;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Read the name table and section index of a dump
+ *
+ * Everything is checked against the size of the file, and the sections
+ * must cover every object in order, so the loader threads don't need to
+ * check anything but their own sections.
+ *
+ * @private
+ * @param file the dump, with 'data' and 'size' filled in
+ * @param top the db_top given in the header
+ * @return NULL on success, or the reason the dump is bad
+ */
+static const char *
+dbbin_read_tables(struct dbbin_file *file, dbref top)
+{
+    struct dbbin_reader r;
+    uint64_t strtab_offset, index_offset;
+    dbref next = 0;
+
+    r.pos = file->data + file->size - DBBIN_FOOTER_SIZE;
+    r.end = file->data + file->size;
+    r.error = NULL;
+
+    strtab_offset = dbbin_get64(&r);
+    index_offset = dbbin_get64(&r);
+
+    if (strtab_offset > index_offset
+        || index_offset > file->size - DBBIN_FOOTER_SIZE)
+        return "Bad table offsets.";
+
+    /* The name table */
+    r.pos = file->data + strtab_offset;
+    r.end = file->data + index_offset;
+    file->namecount = dbbin_get32(&r);
+
+    if (file->namecount > (size_t) (r.end - r.pos) / 5)
+        return "Bad property name count.";
+
+    file->names = dbbin_realloc(NULL, sizeof(const char *)
+                                * (file->namecount + 1));
+
+    for (uint32_t i = 0; i < file->namecount; i++) {
+        file->names[i] = dbbin_getstr(&r);
+    }
+
+    if (r.error)
+        return r.error;
+
+    /* The section index */
+    r.pos = file->data + index_offset;
+    r.end = file->data + file->size - DBBIN_FOOTER_SIZE;
+    file->nsections = dbbin_get32(&r);
+
+    if (file->nsections > (size_t) (r.end - r.pos) / DBBIN_INDEX_SIZE)
+        return "Bad section count.";
+
+    file->sections = dbbin_realloc(NULL, sizeof(struct dbbin_section)
+                                   * (file->nsections + 1));
+
+    for (uint32_t i = 0; i < file->nsections; i++) {
+        struct dbbin_section *s = &file->sections[i];
+
+        s->offset = dbbin_get64(&r);
+        s->length = dbbin_get32(&r);
+        s->first = (dbref) dbbin_get32(&r);
+        s->count = dbbin_get32(&r);
+
+        if (s->first != next || s->count > (uint32_t) (top - next)
+            || s->offset < DBBIN_HEADER_SIZE || s->offset > strtab_offset
+            || s->length > strtab_offset - s->offset)
+            return "Bad section index.";
+
+        next += (dbref) s->count;
+    }
+
+    if (next != top)
+        return "Sections don't cover the database.";
+
+    return r.error;
+}
+
+/**
+ * Check if a database file is in the binary format
+ *
+ * The file position is not changed.
+ *
+ * @param f the file handle to check
+ * @return boolean true if the file starts like a binary dump
+ */
+int
+db_binary_check(FILE * f)
+{
+    char magic[DBBIN_MAGIC_LEN];
+    long pos = ftell(f);
+    int result;
+
+    result = fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+             && !memcmp(magic, DBBIN_MAGIC, DBBIN_MAGIC_LEN);
+
+    fseek(f, pos, SEEK_SET);
+    return result;
+}
+
+/**
+ * Read a binary database dump from the given file handle
+ *
+ * This loads the objects and the tune parameters; the caller handles
+ * the rest of the start up work, just as with the text format.  The
+ * object sections are decoded by DB_LOAD_THREADS threads where the
+ * platform supports it.
+ *
+ * On failure, the problem is logged and the database may be partly
+ * loaded, so it should not be used.
+ *
+ * @param f the file handle to load from
+ * @return the db_top value or -1 if the file is not a valid dump
+ */
+dbref
+db_binary_read(FILE * f)
+{
+    struct dbbin_file file;
+    struct dbbin_loader loaders[DB_LOAD_THREADS];
+    struct dbbin_reader r;
+    const char *error = NULL;
+    dbref error_obj = NOTHING;
+    int nloaders = 1, mapped = 0;
+    uint32_t tunecount;
+    dbref top;
+
+    memset(&file, 0, sizeof(file));
+    memset(loaders, 0, sizeof(loaders));
+
+    /* Get the whole file into memory, mapping it where we can. */
+#ifndef WIN32
+    {
+        struct stat st;
+
+        if (fstat(fileno(f), &st) == 0 && st.st_size > 0) {
+            void *map = mmap(NULL, (size_t) st.st_size, PROT_READ,
+                             MAP_PRIVATE, fileno(f), 0);
+
+            if (map != MAP_FAILED) {
+                file.data = map;
+                file.size = (size_t) st.st_size;
+                mapped = 1;
+            }
+        }
+    }
+#endif
+
+    if (!mapped) {
+        unsigned char *buf;
+        long size;
+
+        if (fseek(f, 0L, SEEK_END) || (size = ftell(f)) <= 0) {
+            log_status("LOADING: Couldn't find the size of the binary dump.");
+            return -1;
+        }
+
+        buf = dbbin_realloc(NULL, (size_t) size);
+        fseek(f, 0L, SEEK_SET);
+
+        if (fread(buf, 1, (size_t) size, f) != (size_t) size) {
+            log_status("LOADING: Couldn't read the binary dump.");
+            free(buf);
+            return -1;
+        }
+
+        file.data = buf;
+        file.size = (size_t) size;
+    }
+
+    r.pos = file.data;
+    r.end = file.data + file.size;
+    r.error = NULL;
+
+    if (file.size < DBBIN_HEADER_SIZE + DBBIN_FOOTER_SIZE
+        || memcmp(file.data, DBBIN_MAGIC, DBBIN_MAGIC_LEN)
+        || memcmp(file.data + file.size - DBBIN_MAGIC_LEN, DBBIN_END_MAGIC,
+                  DBBIN_MAGIC_LEN)) {
+        error = "Not a complete binary dump.";
+        goto done;
+    }
+
+    dbbin_take(&r, DBBIN_MAGIC_LEN);
+
+    if (dbbin_get32(&r) != DBBIN_VERSION) {
+        error = "Unknown binary dump version.";
+        goto done;
+    }
+
+    top = (dbref) dbbin_get32(&r);
+    tunecount = dbbin_get32(&r);
+
+    if (top < 0 || (error = dbbin_read_tables(&file, top)) != NULL)
+        goto done;
+
+    /*
+     * The property name table isn't safe to share between threads, so
+     * every name is interned up front and the loaders only count uses.
+     */
+    file.keys = dbbin_realloc(NULL, sizeof(const char *)
+                              * (file.namecount + 1));
+
+    for (uint32_t i = 0; i < file.namecount; i++) {
+        file.keys[i] = alloc_interned(file.names[i]);
+    }
+
+    /* This sizes the DB to fit all the objects to load */
+    db_grow(top);
+
+    /* Objects a failed load never reaches must still have a sane name. */
+    for (dbref i = 0; i < top; i++) {
+        NAME(i) = NULL;
+    }
+
+#ifdef DB_LOAD_PARALLEL
+    {
+        pthread_t threads[DB_LOAD_THREADS];
+        int started[DB_LOAD_THREADS];
+
+        nloaders = (int) MIN(DB_LOAD_THREADS, MAX(file.nsections, 1));
+
+        for (int i = 0; i < nloaders; i++) {
+            loaders[i].file = &file;
+            loaders[i].first = (uint32_t) i;
+            loaders[i].stride = (uint32_t) nloaders;
+        }
+
+        for (int i = 1; i < nloaders; i++) {
+            started[i] = !pthread_create(&threads[i], NULL, dbbin_decode,
+                                         &loaders[i]);
+        }
+
+        dbbin_decode(&loaders[0]);
+
+        for (int i = 1; i < nloaders; i++) {
+            if (started[i]) {
+                pthread_join(threads[i], NULL);
+            } else {
+                dbbin_decode(&loaders[i]);
+            }
+        }
+    }
+#else
+    loaders[0].file = &file;
+    loaders[0].first = 0;
+    loaders[0].stride = 1;
+    dbbin_decode(&loaders[0]);
+#endif
+
+    /*
+     * Now the work that can't be shared between threads.  Strings are
+     * interned even if decoding failed, since the dump they point into
+     * is about to go away.
+     */
+    for (dbref i = 0; i < top; i++) {
+        NAME(i) = alloc_interned(NAME(i));
+    }
+
+    for (int i = 0; i < nloaders; i++) {
+        for (size_t j = 0; j < loaders[i].npending; j++) {
+            if (PropType(loaders[i].pending[j].node) == PROP_STRTYP) {
+                SetPDataStr(loaders[i].pending[j].node,
+                            alloc_interned(loaders[i].pending[j].text));
+            }
+        }
+    }
+
+    for (int i = 0; i < nloaders && !error; i++) {
+        error = loaders[i].error;
+        error_obj = loaders[i].error_obj;
+    }
+
+    if (error)
+        goto done;
+
+    for (int i = 0; i < nloaders; i++) {
+        for (size_t j = 0; j < loaders[i].npending; j++) {
+            if (PropType(loaders[i].pending[j].node) == PROP_LOKTYP) {
+                SetPDataLok(loaders[i].pending[j].node,
+                            parse_boolexp(-1, (dbref) 1,
+                                          loaders[i].pending[j].text, 32767));
+            }
+        }
+    }
+
+    /* Add players in the same order as the text loader does. */
+    for (dbref i = db_top; i-- > 0;) {
+        if (OBJECT_TYPE(i) == TYPE_PLAYER)
+            player_hash_add(i);
+    }
+
+    fseek(f, (long) DBBIN_HEADER_SIZE, SEEK_SET);
+    tune_load_parms_from_file(f, NOTHING, (int) tunecount);
+
+done:
+    for (int i = 0; i < nloaders; i++) {
+        free(loaders[i].pending);
+
+        if (!loaders[i].keyuses)
+            continue;
+
+        for (uint32_t j = 0; j < file.namecount; j++) {
+            if (loaders[i].keyuses[j])
+                hold_interned(file.keys[j], loaders[i].keyuses[j]);
+        }
+
+        free(loaders[i].keyuses);
+    }
+
+    if (file.keys) {
+        for (uint32_t i = 0; i < file.namecount; i++) {
+            free_interned(file.keys[i]);
+        }
+
+        free(file.keys);
+    }
+
+    free(file.names);
+    free(file.sections);
+
+#ifndef WIN32
+    if (mapped) {
+        munmap((void *) file.data, file.size);
+    } else
+#endif
+    {
+        free((void *) file.data);
+    }
+
+    if (error) {
+        if (error_obj != NOTHING) {
+            log_status("LOADING: Bad binary dump at object #%d: %s",
+                       error_obj, error);
+        } else {
+            log_status("LOADING: Bad binary dump: %s", error);
+        }
+
+        return -1;
+    }
+
+    return db_top;
+}
+
+#endif /* !DISKBASE */
@@ -685,7 +685,7 @@ push_arg(dbref player, struct frame *fr, const char *arg)
     int sflag = 0;
     double inum;
 
-    if (fr->argument.top >= STACK_SIZE) {
+    if (!grow_argument_stack(fr, fr->argument.top + 1, 0)) {
         notify_nolisten(player, "That would overflow the stack.", 1);
         return;
     }
@@ -1004,7 +1004,7 @@ muf_debugger(int descr, dbref player, dbref program, const char *text, struct fr
             return 0;
         }
 
-        if (fr->system.top >= STACK_SIZE) {
+        if (!grow_system_stack(fr, fr->system.top + 1)) {
             notify_nolisten(player,
                             "That would exceed the system stack size for this program.", 1);
             add_muf_read_event(descr, player, program, fr);
@@ -1053,7 +1053,7 @@ muf_debugger(int descr, dbref player, dbref program, const char *text, struct fr
             return 0;
         }
 
-        if (fr->system.top >= STACK_SIZE) {
+        if (!grow_system_stack(fr, fr->system.top + 1)) {
             notify_nolisten(player,
                             "That would exceed the system stack size for this program.", 1);
             add_muf_read_event(descr, player, program, fr);
@@ -12,9 +12,18 @@
  * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
  */
 
+#include <stdio.h>
+
 #include "config.h"
 
 #ifdef DISKBASE
+
+#ifndef WIN32
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+#include "boolexp.h"
 #include "db.h"
 #include "diskprop.h"
 #include "fbstrings.h"
@@ -59,6 +68,8 @@ static int lastfetchslot = -1;
 struct pload_Q {
     dbref obj;
     long count;
+    size_t bytes;
+    long hits;
     int Qtype;
 };
 
@@ -69,25 +80,37 @@ struct pload_Q {
  * off an LRU (least recently used) list to free memory, etc.
  *
  * They are DB linked lists that use the nextold/prevold db links.
+ *
+ * Unchanged props are cached 2Q style.  Objects loaded from disk start on
+ * the probation queue, and only move to the loaded queue if they are used
+ * again later.  Objects that are looked at once, such as every room a
+ * player walks through, are evicted from probation first, so they can't
+ * push out the objects that are used all the time.
  */
 
 /**
  * @private
  * @var ringqueue for changed props
  */
-static struct pload_Q propchanged_Q = { NOTHING, 0, PROPS_CHANGED };
+static struct pload_Q propchanged_Q = { NOTHING, 0, 0, 0, PROPS_CHANGED };
 
 /**
  * @private
  * @var ringqueue for loaded props
  */
-static struct pload_Q proploaded_Q = { NOTHING, 0, PROPS_LOADED };
+static struct pload_Q proploaded_Q = { NOTHING, 0, 0, 0, PROPS_LOADED };
 
 /**
  * @private
  * @var ringqueue for priority props
  */
-static struct pload_Q proppri_Q = { NOTHING, 0, PROPS_PRIORITY };
+static struct pload_Q proppri_Q = { NOTHING, 0, 0, 0, PROPS_PRIORITY };
+
+/**
+ * @private
+ * @var ringqueue for props loaded but not used again yet
+ */
+static struct pload_Q propprobe_Q = { NOTHING, 0, 0, 0, PROPS_PROBATION };
 
 /**
  * @var the number of cache "hits" (successful use of cache) we get
@@ -100,6 +123,188 @@ long propcache_hits = 0L;
  */
 long propcache_misses = 0L;
 
+/**
+ * @private
+ * @var the number of objects whose props were read ahead by prefetchprops
+ */
+static long propcache_prefetches = 0L;
+
+/**
+ * @private
+ * @var the number of objects moved from probation to the loaded queue
+ */
+static long propcache_promotions = 0L;
+
+/**
+ * @private
+ * @var the number of objects whose props were unloaded to keep the cache
+ *      within its limits
+ */
+static long propcache_evictions = 0L;
+
+/**
+ * @private
+ * @var the database file mapped into memory, or NULL if it isn't
+ */
+static char *propfile_map = NULL;
+
+/**
+ * @private
+ * @var the size of propfile_map
+ */
+static size_t propfile_size = 0;
+
+/**
+ * @private
+ * @var a stream reading propfile_map, or NULL if it isn't mapped
+ */
+static FILE *propfile_view = NULL;
+
+/**
+ * Get the stream to read properties from
+ *
+ * @private
+ * @return the stream on the mapped database file, or input_file
+ */
+static FILE *
+propfile(void)
+{
+    return propfile_view ? propfile_view : input_file;
+}
+
+/**
+ * Map the database file into memory for reading properties from
+ *
+ * Properties are read from input_file until this is called.  Reading
+ * them from memory instead means a fetch costs no system calls unless
+ * the pages have to come off the disk, and lets prefetchprops ask for
+ * those pages ahead of time.
+ *
+ * If the file can't be mapped, properties are read from input_file as
+ * before.
+ *
+ * @param f the database file, which must stay open while it is mapped
+ */
+void
+map_propfile(FILE * f)
+{
+#ifndef WIN32
+    struct stat st;
+    void *map;
+
+    unmap_propfile();
+
+    if (fstat(fileno(f), &st) || st.st_size <= 0)
+        return;
+
+    map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+
+    if (map == MAP_FAILED)
+        return;
+
+    /*
+     * The parsers work on stdio streams, so give them one on the map.
+     * Fetches jump all over the file, so reading ahead of each one only
+     * wastes memory; prefetchprops says what is actually wanted.
+     */
+    if ((propfile_view = fmemopen(map, (size_t) st.st_size, "r")) == NULL) {
+        munmap(map, (size_t) st.st_size);
+        return;
+    }
+
+    madvise(map, (size_t) st.st_size, MADV_RANDOM);
+    propfile_map = map;
+    propfile_size = (size_t) st.st_size;
+#endif
+}
+
+/**
+ * Stop reading properties from the mapped database file
+ *
+ * This must be called before input_file is closed.  It is harmless to
+ * call if the file is not mapped.
+ */
+void
+unmap_propfile(void)
+{
+#ifndef WIN32
+    if (!propfile_map)
+        return;
+
+    fclose(propfile_view);
+    munmap(propfile_map, propfile_size);
+    propfile_view = NULL;
+    propfile_map = NULL;
+    propfile_size = 0;
+#endif
+}
+
+/**
+ * Ask for the properties of an object to be read in, if they aren't
+ *
+ * @private
+ * @param obj the object
+ */
+static void
+prefetch_object(dbref obj)
+{
+#ifndef WIN32
+    static long pagesize = 0;
+    struct object *o = DBFETCH(obj);
+    size_t start, end;
+
+    if (o->propsmode != PROPS_UNLOADED || !o->propsfpos || !o->propsflen)
+        return;
+
+    if (!pagesize)
+        pagesize = sysconf(_SC_PAGESIZE);
+
+    start = (size_t) o->propsfpos & ~((size_t) pagesize - 1);
+    end = (size_t) (o->propsfpos + o->propsflen);
+
+    if (end > propfile_size)
+        return;
+
+    madvise(propfile_map + start, end - start, MADV_WILLNEED);
+    propcache_prefetches++;
+#endif
+}
+
+/**
+ * Start reading an area's properties off the disk ahead of time
+ *
+ * This asks the system to read in the properties of 'loc', its contents
+ * and its exits, if they are not loaded yet, without waiting for them.
+ * It is done when something arrives in a room, so that the disk reads
+ * overlap with each other and with the rest of the move, rather than
+ * happening one at a time as look_room and friends fetch them.
+ *
+ * This does nothing if the database file is not mapped.
+ *
+ * @param loc the location being entered
+ */
+void
+prefetchprops(dbref loc)
+{
+    dbref thing;
+
+    if (!propfile_map || loc < 0 || loc >= db_top)
+        return;
+
+    prefetch_object(loc);
+
+    DOLIST(thing, CONTENTS(loc)) {
+        prefetch_object(thing);
+    }
+
+    if (OBJECT_TYPE(loc) == TYPE_ROOM || OBJECT_TYPE(loc) == TYPE_THING
+        || OBJECT_TYPE(loc) == TYPE_PLAYER) {
+        DOLIST(thing, EXITS(loc)) {
+            prefetch_object(thing);
+        }
+    }
+}
+
 /* See definition for docblock */
 static int fetchprops_priority(dbref obj, int mode, const char *pdir);
 
@@ -117,7 +322,8 @@ static int fetchprops_priority(dbref obj, int mode, const char *pdir);
 int
 fetch_propvals(dbref obj, const char *dir)
 {
-    PropPtr p, pptr;
+    PropPtr p;
+    PropDirPtr pptr;
     int cnt = 0;
     char buf[BUFFER_LEN];
     char name[BUFFER_LEN];
@@ -134,7 +340,7 @@ fetch_propvals(dbref obj, const char *dir)
 
             if (PropFlags(p) & PROP_DIRUNLOADED) {
                 SetPFlags(p, (PropFlags(p) & ~PROP_DIRUNLOADED));
-                getproperties(input_file, obj, buf);
+                getproperties(propfile(), obj, buf);
             }
 
             fetch_propvals(obj, buf);
@@ -196,14 +402,16 @@ putprops_copy(FILE * f, dbref obj)
     putstring(f, "*Props*");
 
     if (DBFETCH(obj)->propsfpos) {
-        fseek(input_file, DBFETCH(obj)->propsfpos, SEEK_SET);
-        ptr = fgets(buf, sizeof(buf), input_file);
+        FILE *in = propfile();
+
+        fseek(in, DBFETCH(obj)->propsfpos, SEEK_SET);
+        ptr = fgets(buf, sizeof(buf), in);
 
         if (!ptr)
             abort();
 
         for (;;) {
-            ptr = fgets(buf, sizeof(buf), input_file);
+            ptr = fgets(buf, sizeof(buf), in);
 
             if (!ptr)
                 abort();
@@ -272,6 +480,34 @@ skipproperties(FILE * f, dbref obj)
     }
 }
 
+/**
+ * Get the ring queue for a PROPS_* mode
+ *
+ * @private
+ * @param mode the PROPS_* mode
+ * @return the ring queue, or NULL for PROPS_UNLOADED
+ */
+static struct pload_Q *
+ringqueue(int mode)
+{
+    switch (mode) {
+        case PROPS_LOADED:
+            return &proploaded_Q;
+
+        case PROPS_PRIORITY:
+            return &proppri_Q;
+
+        case PROPS_CHANGED:
+            return &propchanged_Q;
+
+        case PROPS_PROBATION:
+            return &propprobe_Q;
+
+        default:
+            return NULL;
+    }
+}
+
 /**
  * Remove an object from its ring queue
  *
@@ -284,24 +520,7 @@ skipproperties(FILE * f, dbref obj)
 static void
 removeobj_ringqueue(dbref obj)
 {
-    struct pload_Q *ref = NULL;
-
-    switch (DBFETCH(obj)->propsmode) {
-        case PROPS_UNLOADED:
-            return;
-
-        case PROPS_LOADED:
-            ref = &proploaded_Q;
-            break;
-
-        case PROPS_PRIORITY:
-            ref = &proppri_Q;
-            break;
-
-        case PROPS_CHANGED:
-            ref = &propchanged_Q;
-            break;
-    }
+    struct pload_Q *ref = ringqueue(DBFETCH(obj)->propsmode);
 
     if (DBFETCH(obj)->nextold == NOTHING || DBFETCH(obj)->prevold == NOTHING)
         return;
@@ -323,6 +542,7 @@ removeobj_ringqueue(dbref obj)
     DBFETCH(obj)->prevold = NOTHING;
     DBFETCH(obj)->nextold = NOTHING;
     ref->count--;
+    ref->bytes -= DBFETCH(obj)->propsbytes;
 }
 
 /**
@@ -333,6 +553,7 @@ removeobj_ringqueue(dbref obj)
  *
  * Otherwise, PROPS_LOADED goes to the propsloaded_Q.  PROPS_PRIORITY
  * goes to proppri_Q.  PROPS_CHANGED goes to propchanged_Q.
+ * PROPS_PROBATION goes to propprobe_Q.
  *
  * If the queue is empty, this node will be the only node on the queue.
  * Otherwise, this will be put on the 'end' of the queue.
@@ -344,32 +565,16 @@ removeobj_ringqueue(dbref obj)
 static void
 addobject_ringqueue(dbref obj, int mode)
 {
-    struct pload_Q *ref = NULL;
+    struct pload_Q *ref;
 
     removeobj_ringqueue(obj);
 
     DBFETCH(obj)->propsmode = mode;
 
-    switch (mode) {
-        case PROPS_UNLOADED:
-            DBFETCH(obj)->nextold = NOTHING;
-            DBFETCH(obj)->prevold = NOTHING;
-            return;
-
-        case PROPS_LOADED:
-            ref = &proploaded_Q;
-            break;
-
-        case PROPS_PRIORITY:
-            ref = &proppri_Q;
-            break;
-
-        case PROPS_CHANGED:
-            ref = &propchanged_Q;
-            break;
-
-        default:
-            return;
+    if (!(ref = ringqueue(mode))) {
+        DBFETCH(obj)->nextold = NOTHING;
+        DBFETCH(obj)->prevold = NOTHING;
+        return;
     }
 
     if (ref->obj == NOTHING) {
@@ -384,6 +589,32 @@ addobject_ringqueue(dbref obj, int mode)
     }
 
     ref->count++;
+    ref->bytes += DBFETCH(obj)->propsbytes;
+}
+
+/**
+ * Recount the memory an object's loaded props use
+ *
+ * The count is kept on the object, and added to the bytes of its ring
+ * queue, which is what housecleanprops keeps within max_loaded_kb.
+ * Changes made to props while they are on propchanged_Q are only
+ * counted the next time this is called.
+ *
+ * @private
+ * @param obj the object to recount
+ */
+static void
+charge_props(dbref obj)
+{
+    struct pload_Q *ref = ringqueue(DBFETCH(obj)->propsmode);
+    size_t bytes = size_proplist(DBFETCH(obj)->properties);
+
+    if (ref && DBFETCH(obj)->nextold != NOTHING) {
+        ref->bytes -= DBFETCH(obj)->propsbytes;
+        ref->bytes += bytes;
+    }
+
+    DBFETCH(obj)->propsbytes = bytes;
 }
 
 /**
@@ -558,8 +789,10 @@ report_fetchstats(dbref player)
 /**
  * Display a report based on cache statistics
  *
- * This traverses the loaded prop ringqueue and does some calculations
- * to show cache utilization to the indicated user.
+ * This shows the size of each ring queue and the share of fetches that
+ * were hits on it, then traverses the probation and loaded prop
+ * ringqueues and does some calculations to show cache utilization to the
+ * indicated user.
  *
  * @private
  * @param player the user to display the report to
@@ -567,14 +800,30 @@ report_fetchstats(dbref player)
 static void
 report_cachestats(dbref player)
 {
+    struct pload_Q *queues[] = { &propprobe_Q, &proploaded_Q, &proppri_Q,
+                                 &propchanged_Q };
+    const char *names[] = { "Probation", "Loaded", "Priority", "Changed" };
     dbref obj;
     int count, total, checked, gap, ipct;
     time_t when, now;
-    double pct;
+    double pct, fetches;
+
+    fetches = propcache_hits + propcache_misses;
+
+    notify(player, "Queue       Objs     Bytes     Hits (%fetches)");
+
+    for (unsigned int i = 0; i < ARRAYSIZE(queues); i++) {
+        notifyf(player, "%-9s %6ld %9zu %8ld (%6.2f%%)", names[i],
+                queues[i]->count, queues[i]->bytes, queues[i]->hits,
+                fetches ? 100.0 * queues[i]->hits / fetches : 0.0);
+    }
+
+    notifyf(player, "Budget: %d KB  Promoted: %ld  Evicted: %ld",
+            tp_max_loaded_kb, propcache_promotions, propcache_evictions);
 
     notify(player, "LRU proploaded cache time distribution graph.");
 
-    total = proploaded_Q.count;
+    total = propprobe_Q.count + proploaded_Q.count;
     checked = 0;
     gap = 0;
     when = now = time(NULL);
@@ -583,13 +832,17 @@ report_cachestats(dbref player)
 
     for (; checked < total; when -= 60) {
         count = 0;
-        obj = first_ringqueue_obj(&proploaded_Q);
 
-        while (obj != NOTHING) {
-            if (DBFETCH(obj)->propstime > (when - 60) && DBFETCH(obj)->propstime <= when)
-                count++;
+        for (int i = 0; i < 2; i++) {
+            obj = first_ringqueue_obj(queues[i]);
+
+            while (obj != NOTHING) {
+                if (DBFETCH(obj)->propstime > (when - 60)
+                    && DBFETCH(obj)->propstime <= when)
+                    count++;
 
-            obj = next_ringqueue_obj(&proploaded_Q, obj);
+                obj = next_ringqueue_obj(queues[i], obj);
+            }
         }
 
         checked += count;
@@ -632,13 +885,33 @@ display_propcache(dbref player)
             (100.0 * ph / (ph + pm)), propcache_hits, propcache_misses);
     report_fetchstats(player);
 
-    notifyf(player, "PropLoaded count: %d", proploaded_Q.count);
-    notifyf(player, "PropPriority count: %d", proppri_Q.count);
-    notifyf(player, "PropChanged count: %d", propchanged_Q.count);
+    notifyf(player, "PropProbation count: %ld", propprobe_Q.count);
+    notifyf(player, "PropLoaded count: %ld", proploaded_Q.count);
+    notifyf(player, "PropPriority count: %ld", proppri_Q.count);
+    notifyf(player, "PropChanged count: %ld", propchanged_Q.count);
+    notifyf(player, "Objects prefetched: %ld%s", propcache_prefetches,
+            propfile_map ? "" : " (database file not mapped)");
     report_cachestats(player);
     notify(player, "Done.");
 }
 
+/**
+ * Reset the property cache hit and miss counts
+ *
+ * This is done after each database dump.  Misses start at 1 so the hit
+ * ratio can always be worked out.
+ */
+void
+clear_propcache_stats(void)
+{
+    propcache_hits = 0L;
+    propcache_misses = 1L;
+    propprobe_Q.hits = 0L;
+    proploaded_Q.hits = 0L;
+    proppri_Q.hits = 0L;
+    propchanged_Q.hits = 0L;
+}
+
 /**
  * Clear all in-memory properties off the given object
  *
@@ -650,7 +923,7 @@ display_propcache(dbref player)
 void
 unloadprops_with_prejudice(dbref obj)
 {
-    PropPtr l;
+    PropDirPtr l;
 
     if ((l = DBFETCH(obj)->properties)) {
         /* if it has props, then dispose */
@@ -661,6 +934,7 @@ unloadprops_with_prejudice(dbref obj)
     removeobj_ringqueue(obj);
     DBFETCH(obj)->propsmode = PROPS_UNLOADED;
     DBFETCH(obj)->propstime = 0;
+    DBFETCH(obj)->propsbytes = 0;
 }
 
 /**
@@ -725,13 +999,15 @@ dispose_all_oldprops(void)
 /**
  * Do regular cleanup work
  *
- * If there are less than 100 objects with loaded props, this does nothing.
- * If the loaded count is less than tp_max_loaded_objs percent of
- * the database, then this call does nothing.
+ * Only unchanged, non-priority props are eligible; they are on
+ * propprobe_Q or proploaded_Q.  Props are unloaded while they use more
+ * than tp_max_loaded_kb kilobytes.  After that, if there are at least
+ * 100 eligible objects and they are at least tp_max_loaded_objs percent
+ * of the database, up to 40 more are unloaded.
  *
- * Otherwise, try to clear props for up to 40 eligible objects.  An
- * eligible object is one that has properties loaded and does not have
- * any modifications.
+ * Victims come from the front of propprobe_Q unless it holds less than a
+ * quarter of the eligible bytes, in which case they come from the front
+ * of proploaded_Q.  Both are in least recently used order.
  *
  * This doesn't take into account time.
  *
@@ -740,24 +1016,30 @@ dispose_all_oldprops(void)
 static void
 housecleanprops(void)
 {
-    int limit, max;
-    dbref i, j;
-
-    if ((proploaded_Q.count < 100) ||
-        (proploaded_Q.count < (tp_max_loaded_objs * db_top / 100)))
-        return;
-
-    limit = 40;
-    max = db_top;
-    i = first_ringqueue_obj(&proploaded_Q);
-
-    while (limit > 0 && max-- > 0 && i != NOTHING) {
-        j = next_ringqueue_obj(&proploaded_Q, i);
+    size_t budget = (size_t) tp_max_loaded_kb * 1024;
+    size_t bytes;
+    int limit = 40;
+    long loaded;
+    struct pload_Q *ref;
+
+    while ((loaded = propprobe_Q.count + proploaded_Q.count) > 0) {
+        bytes = propprobe_Q.bytes + proploaded_Q.bytes;
+
+        if (!budget || bytes <= budget) {
+            if (limit-- <= 0 || loaded < 100 ||
+                loaded < (tp_max_loaded_objs * db_top / 100))
+                return;
+        }
 
-        if (disposeprops_notime(i))
-            limit--;
+        if (propprobe_Q.count &&
+            (!proploaded_Q.count || propprobe_Q.bytes * 4 >= bytes)) {
+            ref = &propprobe_Q;
+        } else {
+            ref = &proploaded_Q;
+        }
 
-        i = j;
+        unloadprops_with_prejudice(first_ringqueue_obj(ref));
+        propcache_evictions++;
     }
 }
 
@@ -774,7 +1056,9 @@ housecleanprops(void)
  * (in this case, pdir is ignored).
  *
  * If 'mode' is true, then this is loaded into the PROPS_PRIORITY queue.
- * Otherwise it goes to the regular PROPS_LOADED queue.
+ * Otherwise it goes to the PROPS_PROBATION queue, and moves to the
+ * PROPS_LOADED queue when it is used again in a later second.  Uses in
+ * the same second are usually the same command, so they count as one.
  *
  * @see housecleanprops
  *
@@ -789,14 +1073,21 @@ fetchprops_priority(dbref obj, int mode, const char *pdir)
 {
     const char *s;
     int hitflag = 0;
+    int propsmode = DBFETCH(obj)->propsmode;
+    time_t now = time(NULL);
+
+    if (propsmode == PROPS_PROBATION && DBFETCH(obj)->propstime != now) {
+        propsmode = PROPS_LOADED;
+        propcache_promotions++;
+    }
 
     /* update fetched timestamp */
-    DBFETCH(obj)->propstime = time(NULL);
+    DBFETCH(obj)->propstime = now;
 
     /* if in memory, don't try to reload. */
-    if (DBFETCH(obj)->propsmode != PROPS_UNLOADED) {
+    if (propsmode != PROPS_UNLOADED) {
         /* but do update the queue position */
-        addobject_ringqueue(obj, DBFETCH(obj)->propsmode);
+        addobject_ringqueue(obj, propsmode);
 
         if (!pdir)
             pdir = (char[]){PROPDIR_DELIMITER,0};
@@ -808,13 +1099,15 @@ fetchprops_priority(dbref obj, int mode, const char *pdir)
             if (!mode)
                 update_fetchstats();
 
-            getproperties(input_file, obj, s);
+            getproperties(propfile(), obj, s);
         }
 
         if (hitflag) {
+            charge_props(obj);
             return 1;
         } else {
             propcache_hits++;
+            ringqueue(propsmode)->hits++;
             return 0;
         }
     }
@@ -824,14 +1117,16 @@ fetchprops_priority(dbref obj, int mode, const char *pdir)
     housecleanprops();
 
     /* actually load in root properties */
-    getproperties(input_file, obj, (char[]){PROPDIR_DELIMITER,0});
+    getproperties(propfile(), obj, (char[]){PROPDIR_DELIMITER,0});
 
     /* update fetch statistics */
     if (!mode)
         update_fetchstats();
 
     /* add object to appropriate queue */
-    addobject_ringqueue(obj, ((mode) ? PROPS_PRIORITY : PROPS_LOADED));
+    DBFETCH(obj)->propsbytes = 0;
+    addobject_ringqueue(obj, ((mode) ? PROPS_PRIORITY : PROPS_PROBATION));
+    charge_props(obj);
 
     return 1;
 }
@@ -872,7 +1167,8 @@ dirtyprops(dbref obj)
  * Remove 'dirty' or changed props setting
  *
  * This removes the props from the object as well.  It does nothing if
- * the props are not loaded.
+ * the props are not loaded.  If the props are kept, the cache may be
+ * over its limits again, so other props may be unloaded.
  *
  * @param obj the object to undirty
  */
@@ -888,7 +1184,41 @@ undirtyprops(dbref obj)
     }
 
     addobject_ringqueue(obj, PROPS_LOADED);
+    charge_props(obj);
     disposeprops(obj);
+    housecleanprops();
+}
+
+/**
+ * Count the memory of a property value that was just loaded
+ *
+ * This is cheaper than charge_props, which would have to look at every
+ * property on the object each time a value was read from disk.
+ *
+ * @private
+ * @param obj the object the property belongs to
+ * @param p the property whose value was loaded
+ */
+static void
+charge_propval(dbref obj, PropPtr p)
+{
+    struct pload_Q *ref = ringqueue(DBFETCH(obj)->propsmode);
+    size_t bytes = 0;
+
+    switch (PropType(p)) {
+        case PROP_STRTYP:
+            bytes = PropDataStr(p) ? strlen(PropDataStr(p)) + 1 : 0;
+            break;
+
+        case PROP_LOKTYP:
+            bytes = size_boolexp(PropDataLok(p));
+            break;
+    }
+
+    if (ref && DBFETCH(obj)->nextold != NOTHING)
+        ref->bytes += bytes;
+
+    DBFETCH(obj)->propsbytes += bytes;
 }
 
 /**
@@ -907,7 +1237,8 @@ propfetch(dbref obj, PropPtr p)
     SetPFlags(p, (PropFlags(p) | PROP_TOUCHED));
 
     if (PropFlags(p) & PROP_ISUNLOADED) {
-        db_get_single_prop(input_file, obj, (long) PropDataVal(p), p, NULL);
+        db_get_single_prop(propfile(), obj, (long) PropDataVal(p), p, NULL);
+        charge_propval(obj, p);
         return 1;
     }
 
@@ -1217,7 +1217,9 @@ editor(int descr, dbref player, const char *command)
 
             case COMPILE_COMMAND:
                 /* compile code belongs in compile.c, not in the editor */
-                do_compile(descr, player, program, 1);
+                do_compile(descr, player, program,
+                           (i > 0 && arg[0]) ? 1 | COMPILE_SHOW_OPTIMIZATIONS
+                                             : 1);
                 notify(player, "Compiler done.");
                 break;
 
@@ -18,6 +18,9 @@
 #include "game.h"
 #include "interface.h"
 #include "interp.h"
+#ifdef DB_JOURNAL
+#include "journal.h"
+#endif
 #include "props.h"
 #include "timequeue.h"
 #include "tune.h"
@@ -119,6 +122,61 @@ dump_db_now()
     dump_warned = 0;
 }
 
+#ifdef DB_JOURNAL
+/****************************************************************
+ * Journal the changed objects between dumps.
+ ****************************************************************/
+
+/**
+ * @private
+ * @var last time the changed objects were written to the journal
+ */
+static time_t last_journal_time = 0L;
+
+/**
+ * Calculate the time until the changed objects are next journaled
+ *
+ * This is based off tp_dump_journal_interval.  If that is 0, journaling
+ * is turned off, and this gives the longest time next_muckevent_time
+ * allows.
+ *
+ * @private
+ * @param now the time used as current
+ * @return the time until the journal write or 0 if it should be now.
+ */
+static time_t
+next_journal_time(time_t now)
+{
+    if (!tp_dump_journal_interval)
+        return 1000L;
+
+    if (!last_journal_time)
+        last_journal_time = now;
+
+    if ((last_journal_time + tp_dump_journal_interval) < now)
+        return 0L;
+
+    return (last_journal_time + tp_dump_journal_interval - now);
+}
+
+/**
+ * Checks if it is time to journal the changed objects, and does so
+ *
+ * @see journal_flush
+ *
+ * @private
+ * @param now the time used as current
+ */
+static void
+check_journal_time(time_t now)
+{
+    if (next_journal_time(now) == 0L) {
+        last_journal_time = now;
+        journal_flush();
+    }
+}
+#endif
+
 /*********************
  * Periodic cleanups *
  *********************/
@@ -187,8 +245,8 @@ check_clean_time(time_t now)
 /**
  * Calculate the time until a MUCK event will happen
  *
- * Could be an event, a dump, or a cleanup.  Whichever comes next
- * will determine which time is returned.
+ * Could be an event, a dump, a journal write, or a cleanup.  Whichever
+ * comes next will determine which time is returned.
  *
  * @return the time until the next MUCK event
  */
@@ -197,9 +255,16 @@ next_muckevent_time()
 {
     time_t nexttime = 1000L;
     time_t now = (time_t) time((time_t *) NULL);
+    time_t eventtime = next_event_time(now);
+
+    /* next_event_time gives -1 when there are no events queued. */
+    if (eventtime >= 0L)
+        nexttime = MIN(eventtime, nexttime);
 
-    nexttime = MIN(next_event_time(now), nexttime);
     nexttime = MIN(next_dump_time(now), nexttime);
+#ifdef DB_JOURNAL
+    nexttime = MIN(next_journal_time(now), nexttime);
+#endif
     nexttime = MIN(next_clean_time(now), nexttime);
 
     return nexttime;
@@ -208,10 +273,11 @@ next_muckevent_time()
 /**
  * Runs muckevents
  *
- * This will run timequeue events, dumps, and cleanups.  While it tries
- * each function, the functions will only do something if something is
- * ready to happen.  This is safe to run whenever, but next_muckevent_time
- * will return the time until this will actually do something.
+ * This will run timequeue events, dumps, journal writes, and cleanups.
+ * While it tries each function, the functions will only do something if
+ * something is ready to happen.  This is safe to run whenever, but
+ * next_muckevent_time will return the time until this will actually do
+ * something.
  *
  * @see next_muckevent_time
  */
@@ -222,5 +288,8 @@ next_muckevent()
 
     next_timequeue_event(now);
     check_dump_time(now);
+#ifdef DB_JOURNAL
+    check_journal_time(now);
+#endif
     check_clean_time(now);
 }
@@ -41,9 +41,7 @@ static void sig_reconfigure(int i);
 static void sig_emerg(int i);
 #endif
 
-#ifdef SPAWN_HOST_RESOLVER
 static void sig_reap(int i);
-#endif
 
 #ifdef HAVE_PSELECT
 /**
@@ -100,6 +98,9 @@ set_dumper_signals(void)
 #ifdef SIGVTALRM
     signal(SIGVTALRM, SIG_DFL);
 #endif
+#ifdef SIGPROF
+    signal(SIGPROF, SIG_IGN);   /* Ignore profiler ticks */
+#endif
 }
 
 /* Helper defines for set_sigs_intern */
@@ -125,13 +126,11 @@ set_sigs_intern(int bail)
     /* we don't care about SIGPIPE, we notice it in select() and write() */
     signal(SIGPIPE, SET_IGN);
 
-    /* didn't manage to lose that control tty, did we? Ignore it anyway. */
+    /* SIGHUP reopens the log files and reloads the SSL configuration. */
     signal(SIGHUP, sig_reconfigure);
 
-#ifdef SPAWN_HOST_RESOLVER
-    /* resolver's exited. Better clean up the mess our child leaves */
+    /* a child exited. Better clean up the mess our child leaves */
     signal(SIGCHLD, bail ? SIG_DFL : sig_reap);
-#endif
     /* standard termination signals */
     signal(SIGINT, SET_BAIL);
     signal(SIGTERM, SET_BAIL);
@@ -300,7 +299,10 @@ wall_status(const char *s)
 }
 
 /**
- * Reload SSL configuration based on signal
+ * Reopen log files and reload SSL configuration based on signal
+ *
+ * The log files are reopened so they can be rotated: move them away, then
+ * send SIGHUP, and new lines go to new files.
  *
  * @param i the signal number (ignored)
  */
@@ -309,6 +311,7 @@ sig_reconfigure(int i)
 {
     (void)i;
 
+    log_reopen();
     wall_status("Configuration reload requested remotely.");
 
 #ifdef USE_SSL
@@ -337,9 +340,8 @@ sig_shutdown(int i)
     restart_flag = 0;
 }
 
-#ifdef SPAWN_HOST_RESOLVER
 /*
- * Clean out Zombie Resolver Process.
+ * Clean out Zombie Resolver and Dumper Processes.
  */
 
 void
@@ -365,7 +367,9 @@ sig_reap(int i)
 
     int status = 0;
     int reapedpid = 0;
+#ifdef SPAWN_HOST_RESOLVER
     int need_to_spawn_resolver = 0;
+#endif
 
     /*
      * look for children to reap in a loop in case a resolver and dumper
@@ -374,7 +378,10 @@ sig_reap(int i)
     do {
         reapedpid = waitpid(-1, &status, WNOHANG);
 
-        if (reapedpid == global_resolver_pid) {
+        if (reapedpid == 0) {
+            /* No more children have exited. */
+#ifdef SPAWN_HOST_RESOLVER
+        } else if (reapedpid == global_resolver_pid) {
             log_status("resolver exited with status %d", status);
 
             if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
@@ -384,6 +391,7 @@ sig_reap(int i)
                 /* If the resolver exited due to a signal, respawn it. */
                 need_to_spawn_resolver = 1;
             }
+#endif
 
 #ifndef DISKBASE
         } else if (reapedpid == global_dumper_pid) {
@@ -412,7 +420,8 @@ sig_reap(int i)
                 wall_wizards
                         ("# as soon as possible, and accept the data lost since the previous DB save.");
             }
-            global_dumpdone = 1;
+            global_dumpdone = (WIFEXITED(status) && !WEXITSTATUS(status))
+                              ? 1 : 2;
             global_dumper_pid = 0;
 #endif
         } else if (reapedpid == -1) {
@@ -427,11 +436,12 @@ sig_reap(int i)
      * spawn the resolver after the loop so if it exits immediately,
      * we still manage to exit this signal handler.
      */
+#ifdef SPAWN_HOST_RESOLVER
     if (need_to_spawn_resolver) {
         spawn_resolver();
     }
-}
 #endif
+}
 
 #else /* WIN32 */
 
@@ -7,6 +7,7 @@
  */
 
 #include <ctype.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,6 +15,7 @@
 #include "config.h"
 
 #include "db.h"
+#include "fbmath.h"
 #include "fbstrings.h"
 #include "game.h"
 #include "inst.h"
@@ -590,11 +592,308 @@ alloc_prog_string(const char *s)
 
     ss->links = 1;
     ss->length = length;
+    ss->size = length + 1;
     memmove(ss->data, s, ss->length + 1);
     return (ss);
 }
 #endif
 
+/**
+ * Append to a shared string, reusing it where possible
+ *
+ * This takes over the caller's reference to 'ss' and returns a string
+ * holding both, with one reference for the caller.  If nothing else
+ * refers to 'ss', it is extended in place, so a string built up by
+ * appending to it over and over is only copied when it runs out of room.
+ * New or moved strings get twice the room they need, up to BUFFER_LEN.
+ *
+ * This will abort() if malloc fails.
+ *
+ * @param ss the string to append to, which must not be NULL
+ * @param s the data to append
+ * @param len the length of 's'
+ * @return a shared string with the data of 'ss' followed by 's'
+ */
+struct shared_string *
+append_prog_string(struct shared_string *ss, const char *s, size_t len)
+{
+    struct shared_string *ns;
+    size_t length = ss->length + len;
+    size_t size;
+
+    if (ss->links == 1 && length < ss->size) {
+        memcpy(ss->data + ss->length, s, len);
+        ss->data[length] = '\0';
+        ss->length = length;
+        return ss;
+    }
+
+    size = MAX(MIN((length + 1) * 2, BUFFER_LEN), length + 1);
+
+    if (ss->links == 1) {
+        if ((ns = realloc(ss, sizeof(struct shared_string) + size - 1)) == NULL)
+            abort();
+    } else {
+        if ((ns = malloc(sizeof(struct shared_string) + size - 1)) == NULL)
+            abort();
+
+        ss->links--;
+        ns->links = 1;
+        memcpy(ns->data, ss->data, ss->length);
+        ns->length = ss->length;
+    }
+
+    memcpy(ns->data + ns->length, s, len);
+    ns->data[length] = '\0';
+    ns->length = length;
+    ns->size = size;
+    return ns;
+}
+
+#define INTERNED_TABLE_MIN 1024 /**< Buckets in a new interned string table */
+
+/**
+ * An interned string
+ *
+ * Strings are interned exactly, case and all.
+ */
+struct interned {
+    struct interned *next;  /**< Next string in the same bucket */
+    unsigned int hash;      /**< Hash of the string */
+    unsigned int refs;      /**< Number of users of the string */
+    char data[];            /**< The string */
+};
+
+/**
+ * @private
+ * @var the interned strings, in buckets by hash
+ */
+static struct interned **interned_table = NULL;
+
+/**
+ * @private
+ * @var the number of buckets in interned_table, a power of two
+ */
+static size_t interned_buckets = 0;
+
+/**
+ * @private
+ * @var the number of strings in interned_table
+ */
+static size_t interned_count = 0;
+
+/**
+ * @private
+ * @var the total references to the strings in interned_table
+ */
+static size_t interned_refs = 0;
+
+/**
+ * @private
+ * @var the bytes the strings in interned_table take, one copy each
+ */
+static size_t interned_bytes = 0;
+
+/**
+ * @private
+ * @var the bytes the strings would take with a copy for every reference
+ */
+static size_t interned_refbytes = 0;
+
+/**
+ * Hash a string for the interned string table
+ *
+ * @private
+ * @param s the string
+ * @return the hash
+ */
+static unsigned int
+interned_hash(const char *s)
+{
+    unsigned int h = 2166136261U;
+
+    while (*s) {
+        h ^= (unsigned char) *s++;
+        h *= 16777619U;
+    }
+
+    return h;
+}
+
+/**
+ * Get the table entry for an interned string
+ *
+ * @private
+ * @param s the interned string
+ * @return its entry
+ */
+static struct interned *
+interned_of(const char *s)
+{
+    return (struct interned *) (void *) (s - offsetof(struct interned, data));
+}
+
+/**
+ * Double the number of buckets in the interned string table
+ *
+ * @private
+ */
+static void
+interned_grow(void)
+{
+    size_t nbuckets = interned_buckets ? interned_buckets * 2
+                                       : INTERNED_TABLE_MIN;
+    struct interned **ntable = calloc(nbuckets, sizeof(struct interned *));
+    struct interned *k, *next;
+
+    if (!ntable) {
+        fprintf(stderr, "interned_grow(): Out of Memory!\n");
+        abort();
+    }
+
+    for (size_t i = 0; i < interned_buckets; i++) {
+        for (k = interned_table[i]; k; k = next) {
+            next = k->next;
+            k->next = ntable[k->hash & (nbuckets - 1)];
+            ntable[k->hash & (nbuckets - 1)] = k;
+        }
+    }
+
+    free(interned_table);
+    interned_table = ntable;
+    interned_buckets = nbuckets;
+}
+
+/**
+ * Get the interned copy of a string, adding it if need be.  If the
+ * string is NULL or empty, return NULL.
+ *
+ * This is for strings that live in the database, such as object names,
+ * property names and property values, where the same text turns up
+ * over and over.  Every user of the same string shares one read-only
+ * copy; anything that wants to change it must make its own copy.  Each
+ * call adds a reference, to be dropped with free_interned.
+ *
+ * This will abort() if malloc fails.  It is not safe to call from more
+ * than one thread.
+ *
+ * @param s the string
+ * @return the interned string; it does not move until it is freed
+ */
+const char *
+alloc_interned(const char *s)
+{
+    unsigned int hash;
+    struct interned *k;
+    size_t len;
+
+    if (!s || !*s)
+        return NULL;
+
+    hash = interned_hash(s);
+    len = strlen(s);
+
+    if (interned_buckets) {
+        for (k = interned_table[hash & (interned_buckets - 1)]; k;
+             k = k->next) {
+            if (k->hash == hash && !strcmp(k->data, s)) {
+                k->refs++;
+                interned_refs++;
+                interned_refbytes += len + 1;
+                return k->data;
+            }
+        }
+    }
+
+    if (interned_count >= interned_buckets)
+        interned_grow();
+
+    k = malloc(sizeof(struct interned) + len + 1);
+
+    if (!k) {
+        fprintf(stderr, "alloc_interned(): Out of Memory!\n");
+        abort();
+    }
+
+    memcpy(k->data, s, len + 1);
+    k->hash = hash;
+    k->refs = 1;
+    k->next = interned_table[hash & (interned_buckets - 1)];
+    interned_table[hash & (interned_buckets - 1)] = k;
+    interned_count++;
+    interned_refs++;
+    interned_bytes += len + 1;
+    interned_refbytes += len + 1;
+    return k->data;
+}
+
+/**
+ * Add references to a string from alloc_interned.  This is how a copy
+ * of something holding an interned string shares it.
+ *
+ * @param s the interned string, or NULL to do nothing
+ * @param count the number of references to add
+ */
+void
+hold_interned(const char *s, unsigned int count)
+{
+    if (!s)
+        return;
+
+    interned_of(s)->refs += count;
+    interned_refs += count;
+    interned_refbytes += (strlen(s) + 1) * count;
+}
+
+/**
+ * Release a string from alloc_interned.  When nothing uses the string
+ * any more, it is freed.
+ *
+ * @param s the interned string, or NULL to do nothing
+ */
+void
+free_interned(const char *s)
+{
+    struct interned *k, **kp;
+    size_t len;
+
+    if (!s)
+        return;
+
+    k = interned_of(s);
+    len = strlen(s);
+    interned_refs--;
+    interned_refbytes -= len + 1;
+
+    if (--k->refs)
+        return;
+
+    for (kp = &interned_table[k->hash & (interned_buckets - 1)]; *kp != k;
+         kp = &(*kp)->next) ;
+
+    *kp = k->next;
+    interned_count--;
+    interned_bytes -= len + 1;
+    free(k);
+}
+
+/**
+ * Get statistics on the interned string table
+ *
+ * @param strings the number of distinct strings
+ * @param uses the number of references to them
+ * @param bytes the bytes the strings take, not counting overhead
+ * @param saved the bytes saved by sharing them
+ */
+void
+interned_stats(size_t *strings, size_t *uses, size_t *bytes, size_t *saved)
+{
+    *strings = interned_count;
+    *uses = interned_refs;
+    *bytes = interned_bytes;
+    *saved = interned_refbytes - interned_bytes;
+}
+
 /**
  * Converts an integer to a string.
  *
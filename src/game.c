@@ -32,6 +32,9 @@
 #include "flags.h"
 #include "game.h"
 #include "interface.h"
+#ifdef DB_JOURNAL
+#include "journal.h"
+#endif
 #include "log.h"
 #include "mpi.h"
 #include "predicates.h"
@@ -65,12 +68,18 @@ int force_level = 0;
  *      @see MOD_DEFINED
  */
 const char *compile_options =
+#ifndef DISKBASE
+    "BINARYDB "
+#endif
 #ifdef DEBUG
     "DEBUG "
 #endif
 #ifdef DISKBASE
     "DISKBASE "
 #endif
+#ifdef DB_JOURNAL
+    "JOURNAL "
+#endif
 #ifdef GOD_PRIV
     "GODPRIV "
 #endif
@@ -86,9 +95,15 @@ const char *compile_options =
 #ifdef MCPGUI_SUPPORT
     "MCPGUI "
 #endif
+#ifdef MUF_THREADED_DISPATCH
+    "THREADEDMUF "
+#endif
 #ifdef SPAWN_HOST_RESOLVER
     "RESOLVER "
 #endif
+#ifdef ASYNC_HOST_RESOLVER
+    "ASYNCRESOLVER "
+#endif
 #ifdef HAVE_LIBSSL
     "SSL "
 #endif
@@ -256,12 +271,14 @@ do_restart(dbref player)
  * file (MACRO_FILE)
  *
  * @private
+ * @return boolean true if the database was saved to 'dumpfile'
  */
-static void
+static bool
 dump_database_internal(void)
 {
     char tmpfile[2048];
     FILE *f;
+    bool saved = false;
 
     snprintf(tmpfile, sizeof(tmpfile), "%s.#%d#", dumpfile, epoch - 1);
     (void) unlink(tmpfile); /* nuke our predecessor */
@@ -273,6 +290,7 @@ dump_database_internal(void)
         fclose(f);
 
 #ifdef DISKBASE
+        unmap_propfile();
         fclose(input_file);
 #endif
 
@@ -282,6 +300,8 @@ dump_database_internal(void)
 
         if (rename(tmpfile, dumpfile) < 0)
             perror(tmpfile);
+        else
+            saved = true;
 
 #ifdef DISKBASE
             free(in_filename);
@@ -289,6 +309,8 @@ dump_database_internal(void)
 
             if ((input_file = fopen(in_filename, "rb")) == NULL)
                 perror(dumpfile);
+            else
+                map_propfile(input_file);
 #endif
     } else {
         perror(tmpfile);
@@ -341,9 +363,10 @@ dump_database_internal(void)
         global_dumper_player = -1;
     }
 
-    propcache_hits = 0L;
-    propcache_misses = 1L;
+    clear_propcache_stats();
 #endif
+
+    return saved;
 }
 
 /**
@@ -358,7 +381,15 @@ dump_database(void)
     epoch++;
 
     log_status("DUMPING: %s.#%d#", dumpfile, epoch);
+
+#ifdef DB_JOURNAL
+    /* Everything is in the dump now, so the journal isn't needed. */
+    if (dump_database_internal())
+        journal_discard();
+#else
     dump_database_internal();
+#endif
+
     log_status("DUMPING: %s.#%d# (done)", dumpfile, epoch);
 }
 
@@ -369,7 +400,9 @@ dump_database(void)
  * forked and the database is dumped "inline".
  *
  * Otherwise, a process is forked, its nice level is set to NICELEVEL
- * if defined, and the database is dumped to disk.
+ * if defined, and the database is dumped to disk.  With DB_JOURNAL,
+ * the changed objects are journaled and a new journal is started just
+ * before the fork.  @see journal_rotate
  *
  * You probably don't want to call this function.  You likely should
  * call dump_db_now instead as it does additional book-keeping.
@@ -402,6 +435,15 @@ fork_and_dump(void)
     dump_database_internal();
 
 #else
+#  ifdef DB_JOURNAL
+    /*
+     * Journal everything up to the fork, then start a new journal.  The
+     * old one is kept until the dump is done, in case it doesn't finish.
+     */
+    journal_flush();
+    journal_rotate();
+#  endif /* DB_JOURNAL */
+
     if ((global_dumper_pid = fork()) == 0) {
         /* We are the child. */
         forked_dump_process_flag = 1;
@@ -418,8 +460,7 @@ fork_and_dump(void)
 #  endif /* NICEVAL */
 
         set_dumper_signals();
-        dump_database_internal();
-        _exit(0);
+        _exit(dump_database_internal() ? 0 : 1);
     }
 
     if (global_dumper_pid < 0) {
@@ -441,7 +482,7 @@ fork_and_dump(void)
  * - Initalize MUF primitives
  * - Initialize MPI
  * - Initialize random number generator
- * - Load DB
+ * - Load DB, and replay any journals for 'outfile' (with DB_JOURNAL)
  * - Set the book-keeping ~sys properties on #0
  *
  * @param infile the path to the input database file
@@ -471,6 +512,10 @@ init_game(const char *infile, const char *outfile)
     mesg_init(); /* init mpi interpreter */
     SRANDOM((unsigned int)getpid()); /* init random number generator */
 
+    /* set up dumper; this is also where the journals are found */
+    free((void *) dumpfile);
+    dumpfile = alloc_string(outfile);
+
     /* ok, read the db in */
     log_status("LOADING: %s", infile);
     fprintf(stderr, "LOADING: %s\n", infile);
@@ -478,13 +523,13 @@ init_game(const char *infile, const char *outfile)
     if (db_read(input_file) < 0)
         return -1;
 
+#ifdef DISKBASE
+    map_propfile(input_file);
+#endif
+
     log_status("LOADING: %s (done)", infile);
     fprintf(stderr, "LOADING: %s (done)\n", infile);
 
-    /* set up dumper */
-    free((void *) dumpfile);
-    dumpfile = alloc_string(outfile);
-
     if (!db_conversion_flag) {
         add_property((dbref) 0, SYS_STARTUPTIME_PROP, NULL, (int) time((time_t *) NULL));
         add_property((dbref) 0, SYS_MAXPENNIES_PROP, NULL, tp_max_pennies);
@@ -1236,8 +1281,8 @@ process_command(int descr, dbref player, const char *command)
                     case 'p':
                     case 'P':
                         /*
-                         * @password, @pcreate, @pecho, @program, @propset,
-                         * @ps
+                         * @password, @pcreate, @pecho, @profile, @program,
+                         * @propset, @ps
                          */
                         switch (command[2]) {
                             case 'a':
@@ -1275,6 +1320,11 @@ process_command(int descr, dbref player, const char *command)
                                     MUCKERONLY("@program", player);
                                     do_program(descr, player, arg1, arg2);
                                     break;
+                                } else if (string_prefix("@profile", command)) {
+                                    Matched("@profile");
+                                    WIZARDONLY("@profile", player);
+                                    do_profile(player, arg1);
+                                    break;
                                 } else {
                                     Matched("@propset");
                                     NOGUEST("@propset", player);
@@ -5,6 +5,7 @@
  * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
  */
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,13 +15,35 @@
 #include "fbstrings.h"
 #include "hashtab.h"
 
+/**
+ * Compute the full hash value of a string (case-insensitive)
+ *
+ * This is FNV-1a over the lower cased characters, so strings that
+ * strcasecmp considers equal hash the same.  Unlike a hash reduced to
+ * a table size, this is kept in each entry so that a table can grow
+ * without hashing its names again.
+ *
+ * @private
+ * @param s the string to hash
+ * @return the hash value
+ */
+static unsigned int
+hash_full(const char *s)
+{
+    unsigned int hashval = 2166136261u;
+
+    for (; *s != '\0'; s++) {
+        hashval ^= (unsigned int) tolower((unsigned char) *s);
+        hashval *= 16777619u;
+    }
+
+    return hashval;
+}
+
 /**
  * Compute hash value for a string (case-insensitive)
  *
- * This particular hash function is fairly simple.  Note that it
- * throws away the information from the 0x20 bit in the character.
- * This means that upper and lower case letters will hash to the
- * same value.
+ * Upper and lower case letters hash to the same value.
  *
  * Hash size is the page size of the hash.  The resulting number
  * returned will be between 0 and hash_size-1
@@ -32,13 +55,63 @@
 unsigned int
 hash(const char *s, unsigned int hash_size)
 {
-    unsigned int hashval;
+    return hash_full(s) % hash_size;
+}
+
+/**
+ * Find the link that points to a name's entry in a hash table
+ *
+ * @private
+ * @param s the name to look for
+ * @param hashval the full hash of 's'
+ * @param table the table to look in, which must have buckets
+ * @return the link pointing to the entry, or to NULL at the end of the
+ *         chain the entry would be in if it is not there
+ */
+static hash_entry **
+hash_link(const char *s, unsigned int hashval, hash_tab * table)
+{
+    hash_entry **lp = &table->buckets[hashval & (table->size - 1)];
 
-    for (hashval = 0; *s != '\0'; s++) {
-        hashval = ((unsigned int)*s | 0x20) + 31 * hashval;
+    for (; *lp != NULL; lp = &(*lp)->next) {
+        if ((*lp)->hashval == hashval && strcasecmp(s, (*lp)->name) == 0)
+            break;
     }
 
-    return hashval % hash_size;
+    return lp;
+}
+
+/**
+ * Change the number of buckets in a hash table
+ *
+ * Entries are moved to their new buckets using the hash values kept in
+ * them.
+ *
+ * @private
+ * @param table the table to resize
+ * @param size the new number of buckets, a power of two
+ */
+static void
+hash_resize(hash_tab * table, unsigned int size)
+{
+    hash_entry **buckets, *hp, *np;
+
+    if ((buckets = calloc(size, sizeof(hash_entry *))) == NULL) {
+        perror("hash_resize: out of memory!");
+        abort(); /* can't allocate new table -- die */
+    }
+
+    for (unsigned int i = 0; i < table->size; i++) {
+        for (hp = table->buckets[i]; hp != NULL; hp = np) {
+            np = hp->next;
+            hp->next = buckets[hp->hashval & (size - 1)];
+            buckets[hp->hashval & (size - 1)] = hp;
+        }
+    }
+
+    free(table->buckets);
+    table->buckets = buckets;
+    table->size = size;
 }
 
 /**
@@ -49,20 +122,18 @@ hash(const char *s, unsigned int hash_size)
  *
  * @param s the string to look up
  * @param table the table to look the string up in
- * @param size the hash page size
  * @return NULL if not found, otherwise a pointer to the data union
  */
 hash_data *
-find_hash(const char *s, hash_tab * table, unsigned int size)
+find_hash(const char *s, hash_tab * table)
 {
-    for (hash_entry *hp = table[hash(s, size)]; hp != NULL;
-         hp = hp->next) {
-        if (strcasecmp(s, hp->name) == 0) {
-            return &(hp->dat); /* found */
-        }
-    }
+    hash_entry *hp;
+
+    if (!table->count)
+        return NULL; /* not found */
 
-    return NULL; /* not found */
+    hp = *hash_link(s, hash_full(s), table);
+    return hp ? &(hp->dat) : NULL;
 }
 
 /**
@@ -71,31 +142,26 @@ find_hash(const char *s, hash_tab * table, unsigned int size)
  * Will supercede old values in the table, returns pointer to
  * the hash entry, or NULL on failure.
  *
- * The name is copied when a new entry is added.
+ * The name is copied when a new entry is added.  The table doubles in
+ * size whenever it has more than HASH_MAX_LOAD entries per bucket.
  *
  * @param name the name of the entry to add
  * @param data the data to store
  * @param table the hash stable to store it in
- * @param size the page size of the hash table
  */
 hash_entry *
-add_hash(const char *name, hash_data data, hash_tab * table,
-         unsigned int size)
+add_hash(const char *name, hash_data data, hash_tab * table)
 {
-    hash_entry *hp;
-    unsigned int hashval;
+    hash_entry **lp, *hp;
+    unsigned int hashval = hash_full(name);
 
-    hashval = hash(name, size);
+    if (!table->buckets)
+        hash_resize(table, HASH_MIN_SIZE);
 
-    /* an inline find_hash */
-    for (hp = table[hashval]; hp != NULL; hp = hp->next) {
-        if (strcasecmp(name, hp->name) == 0) {
-            break;
-        }
-    }
+    lp = hash_link(name, hashval, table);
 
     /* If not found, set up a new entry */
-    if (hp == NULL) {
+    if ((hp = *lp) == NULL) {
         hp = malloc(sizeof(hash_entry));
 
         if (hp == NULL) {
@@ -103,8 +169,9 @@ add_hash(const char *name, hash_data data, hash_tab * table,
             abort(); /* can't allocate new entry -- die */
         }
 
-        hp->next = table[hashval];
-        table[hashval] = hp;
+        hp->next = NULL;
+        hp->hashval = hashval;
+        *lp = hp;
 
         /*
          * @TODO The comment was WRONG and implied the hash name isn't
@@ -118,6 +185,9 @@ add_hash(const char *name, hash_data data, hash_tab * table,
             perror("add_hash: out of memory!");
             abort(); /* can't allocate new entry -- die */
         }
+
+        if (++table->count > table->size * HASH_MAX_LOAD)
+            hash_resize(table, table->size * 2);
     }
 
     /* One way or another, the pointer is now valid */
@@ -140,46 +210,44 @@ add_hash(const char *name, hash_data data, hash_tab * table,
  *
  * @param name the name of the hash entry to free
  * @param table the table to delete from
- * @param size the page size
  * @return 0 on success, -1 if 'name' was not found.
  */
 int
-free_hash(const char *name, hash_tab * table, unsigned int size)
+free_hash(const char *name, hash_tab * table)
 {
-    hash_entry **lp;
+    hash_entry **lp, *hp;
 
-    lp = &table[hash(name, size)];
+    if (!table->count)
+        return -1; /* not found */
 
-    for (hash_entry *hp = *lp;
-         hp != NULL; lp = &(hp->next), hp = hp->next) {
-        if (strcasecmp(name, hp->name) == 0) {
-            *lp = hp->next; /* got it.  fix the pointers */
-            free((void *) hp->name);
-            free(hp);
-            return 0;
-        }
-    }
+    lp = hash_link(name, hash_full(name), table);
+
+    if ((hp = *lp) == NULL)
+        return -1; /* not found */
 
-    return -1; /* not found */
+    *lp = hp->next; /* got it.  fix the pointers */
+    table->count--;
+    free((void *) hp->name);
+    free(hp);
+    return 0;
 }
 
 /**
  * Kill an entire hash table, by freeing every entry
  *
  * This will optionally also delete the data pointers if freeptrs is
- * true.
+ * true.  The table is left empty, and can be used again.
  *
  * @param table the hash table to operate on
- * @param size the page size
  * @param freeptrs boolean if true, free the data union value.
  */
 void
-kill_hash(hash_tab * table, unsigned int size, int freeptrs)
+kill_hash(hash_tab * table, int freeptrs)
 {
     hash_entry *np;
 
-    for (unsigned int i = 0; i < size; i++) {
-        for (hash_entry *hp = table[i]; hp != NULL; hp = np) {
+    for (unsigned int i = 0; i < table->size; i++) {
+        for (hash_entry *hp = table->buckets[i]; hp != NULL; hp = np) {
             np = hp->next; /* Don't dereference the pointer after */
             free((void *) hp->name);
 
@@ -189,7 +257,10 @@ kill_hash(hash_tab * table, unsigned int size, int freeptrs)
 
             free(hp);
         }
-
-        table[i] = NULL;
     }
+
+    free(table->buckets);
+    table->buckets = NULL;
+    table->size = 0;
+    table->count = 0;
 }
@@ -344,6 +344,30 @@ do_helpfile(dbref player, const char *dir, const char *file, const char *topic,
     }
 }
 
+/**
+ * Append a line to the MOTD file
+ *
+ * This writes the file directly instead of going through the logger, so
+ * the line is there as soon as this returns and the logger never holds
+ * the file open.
+ *
+ * @private
+ * @param line the line to append, without a newline
+ */
+static void
+add_motd_line(const char *line)
+{
+    FILE *f;
+
+    if ((f = fopen(tp_file_motd, "ab")) == NULL) {
+        fprintf(stderr, "Unable to open %s!\n", tp_file_motd);
+        return;
+    }
+
+    fprintf(f, "%s\n", line);
+    fclose(f);
+}
+
 /**
  * Write MOTD text to the MOTD file
  *
@@ -370,7 +394,7 @@ add_motd_text_fmt(const char *text)
             buf[count++] = *p++;
 
         buf[count] = '\0';
-        log2file(tp_file_motd, "%s", buf);
+        add_motd_line(buf);
         skip_whitespace(&p);
         count = 0;
     }
@@ -405,20 +429,18 @@ do_motd(dbref player, char *text)
 
     if (!strcasecmp(text, "clear")) {
         unlink(tp_file_motd);
-        log2file(tp_file_motd, "%s %s",
-                 "- - - - - - - - - - - - - - - - - - -",
-                 "- - - - - - - - - - - - - - - - - - -");
+        add_motd_line("- - - - - - - - - - - - - - - - - - - "
+                      "- - - - - - - - - - - - - - - - - - -");
         notify(player, "MOTD cleared.");
         return;
     }
 
     lt = time(NULL);
     strftime(buf, sizeof(buf), "%a %b %d %T %Z %Y", localtime(&lt));
-    log2file(tp_file_motd, "%s", buf);
+    add_motd_line(buf);
     add_motd_text_fmt(text);
-    log2file(tp_file_motd, "%s %s",
-             "- - - - - - - - - - - - - - - - - - -",
-             "- - - - - - - - - - - - - - - - - - -");
+    add_motd_line("- - - - - - - - - - - - - - - - - - - "
+                  "- - - - - - - - - - - - - - - - - - -");
     notify(player, "MOTD updated.");
 }
 
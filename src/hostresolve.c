@@ -0,0 +1,675 @@
+/** @file hostresolve.c
+ *
+ * Source for looking up the host and user names of new connections from
+ * inside the server.
+ *
+ * This takes the place of the fb-resolver process.  Reverse DNS lookups
+ * block, so they are run by a pool of RESOLVER_THREADS threads.  The
+ * threads only ever see the host_entry they were handed, and give it back
+ * to the main loop through a queue and a wakeup pipe, so everything else
+ * here belongs to the main thread and needs no locking.
+ *
+ * Host names are cached for RESOLVER_CACHE_TTL seconds, and addresses
+ * without one for RESOLVER_RETRY_TIME seconds.  A burst of connections
+ * from one address, such as everyone reconnecting after a restart, shares
+ * a single lookup.
+ *
+ * Ident (RFC 1413) queries don't need a thread: they are made over
+ * non-blocking sockets watched by the network event loop, and given up on
+ * after RESOLVER_IDENT_TIMEOUT seconds.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include "config.h"
+
+#ifdef ASYNC_HOST_RESOLVER
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fbstrings.h"
+#include "hashtab.h"
+#include "hostresolve.h"
+#include "interface.h"
+#include "log.h"
+#include "netloop.h"
+
+/*
+ * A cached host name.  While 'pending' is set, a lookup thread owns
+ * 'name' and 'found'.
+ */
+struct host_entry {
+    struct host_entry *next;        /* Next entry, less recently used     */
+    struct host_entry *prev;        /* Previous entry, more recently used */
+    struct host_entry *next_job;    /* Next entry in a thread queue       */
+    struct sockaddr_storage addr;   /* The address to look up             */
+    socklen_t addrlen;              /* Length of addr                     */
+    char ip[INET6_ADDRSTRLEN];      /* The address as text, the cache key */
+    char name[SMALL_BUFFER_LEN];    /* The host name, or the address      */
+    time_t expires;                 /* When to look the address up again  */
+    int pending;                    /* Boolean: being looked up           */
+    int found;                      /* Boolean: a host name was found     */
+};
+
+/*
+ * The lookups for one connection.
+ */
+struct host_lookup {
+    struct host_lookup *next;       /* Next lookup in progress            */
+    int descr;                      /* The connection's descriptor        */
+    char ip[INET6_ADDRSTRLEN];      /* Its host name when it was accepted */
+    char port[MINI_BUFFER_LEN];     /* Its user name when it was accepted */
+    struct host_entry *entry;       /* Host name waited for, or NULL      */
+    char name[SMALL_BUFFER_LEN];    /* The host name, once known          */
+    int ident_fd;                   /* Ident socket, or -1 when done      */
+    int ident_sent;                 /* Boolean: the query has been sent   */
+    time_t ident_deadline;          /* When to give up on ident           */
+    char ident_buf[MEDIUM_BUFFER_LEN]; /* The query, then the reply       */
+    size_t ident_len;               /* Bytes of reply in ident_buf        */
+    char user[SMALL_BUFFER_LEN];    /* The ident user name, if any        */
+};
+
+/**
+ * @private
+ * @var the host name cache, keyed by address
+ */
+static hash_tab host_table;
+
+/**
+ * @private
+ * @var the cached entries, most recently used first
+ */
+static struct host_entry *host_lru = NULL;
+
+/**
+ * @private
+ * @var the least recently used cached entry
+ */
+static struct host_entry *host_lru_tail = NULL;
+
+/**
+ * @private
+ * @var the number of cached entries
+ */
+static int host_count = 0;
+
+/**
+ * @private
+ * @var the number of entries handed to the lookup threads and not back yet
+ */
+static int host_pending = 0;
+
+/**
+ * @private
+ * @var the lookups in progress
+ */
+static struct host_lookup *host_lookups = NULL;
+
+/**
+ * @private
+ * @var the number of lookups in progress
+ */
+static int host_lookup_count = 0;
+
+/**
+ * @private
+ * @var protects host_waiting, host_waiting_tail and host_done
+ */
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @private
+ * @var signalled when an entry is added to host_waiting
+ */
+static pthread_cond_t host_wake = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @private
+ * @var entries waiting for a lookup thread, oldest first
+ */
+static struct host_entry *host_waiting = NULL;
+
+/**
+ * @private
+ * @var the last entry in host_waiting
+ */
+static struct host_entry *host_waiting_tail = NULL;
+
+/**
+ * @private
+ * @var entries the lookup threads are done with
+ */
+static struct host_entry *host_done = NULL;
+
+/**
+ * @private
+ * @var the lookup threads write to [1] to wake up the main loop on [0]
+ */
+static int host_pipe[2] = { -1, -1 };
+
+/**
+ * Look up host names handed over through host_waiting
+ *
+ * This is the body of each lookup thread.  It never returns; the threads
+ * go away with the process.
+ *
+ * @private
+ * @param arg unused
+ * @return never returns
+ */
+static void *
+host_thread(void *arg)
+{
+    struct host_entry *e;
+
+    (void) arg;
+
+    pthread_mutex_lock(&host_lock);
+
+    for (;;) {
+        while (!host_waiting)
+            pthread_cond_wait(&host_wake, &host_lock);
+
+        e = host_waiting;
+        host_waiting = e->next_job;
+
+        if (!host_waiting)
+            host_waiting_tail = NULL;
+
+        pthread_mutex_unlock(&host_lock);
+
+        e->found = !getnameinfo((struct sockaddr *) &e->addr, e->addrlen,
+                                e->name, sizeof(e->name), NULL, 0,
+                                NI_NAMEREQD);
+
+        pthread_mutex_lock(&host_lock);
+        e->next_job = host_done;
+        host_done = e;
+
+        /* One byte is enough to wake the main loop for the whole list. */
+        if (!e->next_job && write(host_pipe[1], "", 1) == -1) {
+            /* ignore */
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Set up the wakeup pipe and start the lookup threads
+ *
+ * This is done on the first lookup, by which time the server has gone
+ * into the background; threads would not survive that fork().
+ *
+ * @private
+ * @return boolean true if the threads are running
+ */
+static int
+host_start(void)
+{
+    static int started = 0;
+    pthread_attr_t attr;
+    pthread_t thread;
+    sigset_t all, old;
+
+    if (started)
+        return started > 0;
+
+    started = -1;
+
+    if (pipe(host_pipe)) {
+        log_status("RESOLVER: Unable to create pipe: %s", strerror(errno));
+        return 0;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        fcntl(host_pipe[i], F_SETFL, fcntl(host_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(host_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    netloop_set(host_pipe[0], NETLOOP_READ);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    /* Signals are for the main thread, which the handlers expect. */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+
+    for (int i = 0; i < RESOLVER_THREADS; i++) {
+        if (!pthread_create(&thread, &attr, host_thread, NULL))
+            started = 1;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    pthread_attr_destroy(&attr);
+
+    if (started < 0)
+        log_status("RESOLVER: Unable to start lookup threads.");
+
+    return started > 0;
+}
+
+/**
+ * Unlink a cache entry from the most recently used list
+ *
+ * @private
+ * @param e the entry to unlink
+ */
+static void
+host_lru_remove(struct host_entry *e)
+{
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        host_lru = e->next;
+
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        host_lru_tail = e->prev;
+}
+
+/**
+ * Link a cache entry in as the most recently used
+ *
+ * @private
+ * @param e the entry to link
+ */
+static void
+host_lru_add(struct host_entry *e)
+{
+    e->prev = NULL;
+    e->next = host_lru;
+
+    if (host_lru)
+        host_lru->prev = e;
+    else
+        host_lru_tail = e;
+
+    host_lru = e;
+}
+
+/**
+ * Drop least recently used cache entries until there is room for one more
+ *
+ * Entries being looked up are skipped, as a thread is using them.
+ *
+ * @private
+ */
+static void
+host_prune(void)
+{
+    struct host_entry *e = host_lru_tail, *prev;
+
+    while (e && host_count >= RESOLVER_CACHE_SIZE) {
+        prev = e->prev;
+
+        if (!e->pending) {
+            host_lru_remove(e);
+            free_hash(e->ip, &host_table);
+            free(e);
+            host_count--;
+        }
+
+        e = prev;
+    }
+}
+
+/**
+ * Find the cache entry for an address, starting a lookup if needed
+ *
+ * @private
+ * @param ip the address as text
+ * @param addr the address
+ * @param addrlen the length of 'addr'
+ * @return the entry, which may still be pending, or NULL if there are too
+ *         many lookups waiting already
+ */
+static struct host_entry *
+host_fetch(const char *ip, const struct sockaddr *addr, socklen_t addrlen)
+{
+    hash_data *hd;
+    hash_data hdat;
+    struct host_entry *e;
+
+    if ((hd = find_hash(ip, &host_table))) {
+        e = hd->pval;
+        host_lru_remove(e);
+        host_lru_add(e);
+
+        if (e->pending || e->expires > time(NULL))
+            return e;
+    } else {
+        host_prune();
+
+        if (!(e = calloc(1, sizeof(struct host_entry))))
+            return NULL;
+
+        strcpyn(e->ip, sizeof(e->ip), ip);
+        hdat.pval = e;
+        add_hash(e->ip, hdat, &host_table);
+        host_lru_add(e);
+        host_count++;
+    }
+
+    /* Keep whatever name we had until a fresh one comes in. */
+    if (host_pending >= RESOLVER_QUEUE_MAX || !host_start()) {
+        if (!*e->name)
+            strcpyn(e->name, sizeof(e->name), ip);
+
+        return e;
+    }
+
+    memcpy(&e->addr, addr, addrlen);
+    e->addrlen = addrlen;
+    e->pending = 1;
+    host_pending++;
+
+    pthread_mutex_lock(&host_lock);
+    e->next_job = NULL;
+
+    if (host_waiting_tail)
+        host_waiting_tail->next_job = e;
+    else
+        host_waiting = e;
+
+    host_waiting_tail = e;
+    pthread_cond_signal(&host_wake);
+    pthread_mutex_unlock(&host_lock);
+
+    return e;
+}
+
+/**
+ * Send an ident query for a connection
+ *
+ * @private
+ * @param l the lookup to query for
+ * @param addr the client's address
+ * @param addrlen the length of 'addr'
+ * @param lport the server port the client connected to, in host order
+ */
+static void
+ident_start(struct host_lookup *l, const struct sockaddr *addr,
+            socklen_t addrlen, in_port_t lport)
+{
+    struct sockaddr_storage ident;
+    in_port_t rport;
+    int fd;
+
+    memcpy(&ident, addr, addrlen);
+
+    if (addr->sa_family == AF_INET6) {
+        rport = ((struct sockaddr_in6 *) &ident)->sin6_port;
+        ((struct sockaddr_in6 *) &ident)->sin6_port = htons(113);
+    } else {
+        rport = ((struct sockaddr_in *) &ident)->sin_port;
+        ((struct sockaddr_in *) &ident)->sin_port = htons(113);
+    }
+
+    snprintf(l->ident_buf, sizeof(l->ident_buf), "%" PRIu16 ",%" PRIu16 "\n",
+             ntohs(rport), lport);
+
+    if ((fd = socket(addr->sa_family, SOCK_STREAM, 0)) < 0)
+        return;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (connect(fd, (struct sockaddr *) &ident, addrlen) < 0
+        && errno != EINPROGRESS) {
+        close(fd);
+        return;
+    }
+
+    l->ident_fd = fd;
+    l->ident_deadline = time(NULL) + RESOLVER_IDENT_TIMEOUT;
+    netloop_set(fd, NETLOOP_WRITE);
+}
+
+/**
+ * Stop talking to an ident server
+ *
+ * @private
+ * @param l the lookup to stop the ident query for
+ */
+static void
+ident_finish(struct host_lookup *l)
+{
+    netloop_forget(l->ident_fd);
+    close(l->ident_fd);
+    l->ident_fd = -1;
+}
+
+/**
+ * Pick the user name out of an ident reply
+ *
+ * A reply looks like "port , port : USERID : opsys : user".  Anything else,
+ * such as an ERROR reply, leaves the user name empty.
+ *
+ * @private
+ * @param l the lookup holding the reply in ident_buf
+ */
+static void
+ident_parse(struct host_lookup *l)
+{
+    char *ptr, *end;
+
+    l->ident_buf[l->ident_len] = '\0';
+
+    if (!(ptr = strchr(l->ident_buf, ':')))
+        return;
+
+    for (ptr++; *ptr == ' '; ptr++) ;
+
+    if (strncmp(ptr, "USERID", 6))
+        return;
+
+    if (!(ptr = strchr(ptr, ':')) || !(ptr = strchr(ptr + 1, ':')))
+        return;
+
+    for (ptr++; *ptr == ' '; ptr++) ;
+
+    /* Stop at the end of the line, or anything that would confuse WHO */
+    for (end = ptr; *end && *end > ' ' && *end != '(' && *end != ')'; end++) ;
+
+    *end = '\0';
+    strcpyn(l->user, sizeof(l->user), ptr);
+}
+
+/**
+ * Move an ident query along
+ *
+ * @private
+ * @param l the lookup with the query
+ * @param now the current time
+ */
+static void
+ident_process(struct host_lookup *l, time_t now)
+{
+    int ready = netloop_ready(l->ident_fd);
+    ssize_t got;
+
+    if (!l->ident_sent && (ready & NETLOOP_WRITE)) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+
+        if (getsockopt(l->ident_fd, SOL_SOCKET, SO_ERROR, &err, &len) || err
+            || write(l->ident_fd, l->ident_buf, strlen(l->ident_buf)) < 0) {
+            ident_finish(l);
+            return;
+        }
+
+        /* The query is short enough to go in one write. */
+        l->ident_sent = 1;
+        l->ident_len = 0;
+        netloop_set(l->ident_fd, NETLOOP_READ);
+    } else if (l->ident_sent && (ready & NETLOOP_READ)) {
+        got = read(l->ident_fd, l->ident_buf + l->ident_len,
+                   sizeof(l->ident_buf) - 1 - l->ident_len);
+
+        if (got > 0)
+            l->ident_len += (size_t) got;
+
+        if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR)
+            || memchr(l->ident_buf, '\n', l->ident_len)
+            || l->ident_len == sizeof(l->ident_buf) - 1) {
+            ident_parse(l);
+            ident_finish(l);
+            return;
+        }
+    }
+
+    if (now >= l->ident_deadline)
+        ident_finish(l);
+}
+
+/**
+ * Give a connection the names its lookups found
+ *
+ * Nothing is changed if the descriptor has gone away, or been reused, or
+ * had its names set some other way since the lookups started.
+ *
+ * @private
+ * @param l the finished lookup
+ */
+static void
+host_lookup_apply(struct host_lookup *l)
+{
+    struct descriptor_data *d = descrdata_by_descr(l->descr);
+
+    if (!d || strcmp(d->hostname, l->ip) || strcmp(d->username, l->port))
+        return;
+
+    if (strcmp(l->name, l->ip)) {
+        free((void *) d->hostname);
+        d->hostname = strdup(l->name);
+    }
+
+    if (*l->user) {
+        free((void *) d->username);
+        d->username = strdup(l->user);
+    }
+}
+
+/**
+ * Start looking up the host and user names of a new connection
+ *
+ * 'd' must still have the host name and user name it was given when it
+ * was accepted: the address as text, and the client's port number.  They
+ * are replaced when the lookups finish, unless something else has changed
+ * them in the meantime.
+ *
+ * If too many lookups are already in progress, this does nothing and the
+ * connection keeps its address.
+ *
+ * @param d the new connection
+ * @param addr the client's address
+ * @param addrlen the length of 'addr'
+ * @param lport the server port the client connected to
+ */
+void
+host_resolve_add(struct descriptor_data *d, const struct sockaddr *addr,
+                 socklen_t addrlen, in_port_t lport)
+{
+    struct host_lookup *l;
+
+    if (host_lookup_count >= RESOLVER_QUEUE_MAX)
+        return;
+
+    if (!(l = calloc(1, sizeof(struct host_lookup))))
+        return;
+
+    l->descr = d->descriptor;
+    l->ident_fd = -1;
+    strcpyn(l->ip, sizeof(l->ip), d->hostname);
+    strcpyn(l->port, sizeof(l->port), d->username);
+
+    if (!(l->entry = host_fetch(l->ip, addr, addrlen))) {
+        strcpyn(l->name, sizeof(l->name), l->ip);
+    } else if (!l->entry->pending) {
+        strcpyn(l->name, sizeof(l->name), l->entry->name);
+        l->entry = NULL;
+    }
+
+    ident_start(l, addr, addrlen, lport);
+
+    l->next = host_lookups;
+    host_lookups = l;
+    host_lookup_count++;
+}
+
+/**
+ * Move host and user name lookups along
+ *
+ * This is called from the main loop after the network event loop has
+ * waited.  It collects host names from the lookup threads, talks to ident
+ * servers, and updates connections whose lookups are done.
+ */
+void
+host_resolve_process(void)
+{
+    struct host_entry *done, *e;
+    struct host_lookup **prev, *l;
+    time_t now;
+    char buf[MINI_BUFFER_LEN];
+
+    if (!host_lookups && !host_pending)
+        return;
+
+    now = time(NULL);
+
+    if (netloop_ready(host_pipe[0]) & NETLOOP_READ) {
+        while (read(host_pipe[0], buf, sizeof(buf)) > 0) ;
+
+        pthread_mutex_lock(&host_lock);
+        done = host_done;
+        host_done = NULL;
+        pthread_mutex_unlock(&host_lock);
+
+        for (e = done; e; e = e->next_job) {
+            if (e->found) {
+                e->expires = now + RESOLVER_CACHE_TTL;
+            } else {
+                strcpyn(e->name, sizeof(e->name), e->ip);
+                e->expires = now + RESOLVER_RETRY_TIME;
+            }
+
+            e->pending = 0;
+            host_pending--;
+
+            for (l = host_lookups; l; l = l->next) {
+                if (l->entry == e) {
+                    strcpyn(l->name, sizeof(l->name), e->name);
+                    l->entry = NULL;
+                }
+            }
+        }
+    }
+
+    for (prev = &host_lookups; (l = *prev);) {
+        if (l->ident_fd >= 0)
+            ident_process(l, now);
+
+        if (l->entry || l->ident_fd >= 0) {
+            prev = &l->next;
+            continue;
+        }
+
+        host_lookup_apply(l);
+        *prev = l->next;
+        host_lookup_count--;
+        free(l);
+    }
+}
+
+#endif /* ASYNC_HOST_RESOLVER */
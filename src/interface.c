@@ -13,6 +13,7 @@
 #include <inttypes.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,6 +26,9 @@
 #include "commands.h"
 #include "db.h"
 #include "defines.h"
+#ifdef DISKBASE
+#include "diskprop.h"
+#endif
 #include "edit.h"
 #include "events.h"
 #include "fbsignal.h"
@@ -32,8 +36,14 @@
 #include "fbtime.h"
 #include "flags.h"
 #include "game.h"
+#ifdef ASYNC_HOST_RESOLVER
+#include "hostresolve.h"
+#endif
 #include "interface.h"
 #include "interp.h"
+#ifdef DB_JOURNAL
+#include "journal.h"
+#endif
 #include "log.h"
 #include "look.h"
 #include "match.h"
@@ -43,9 +53,12 @@
 #endif
 #include "mpi.h"
 #include "mufevent.h"
+#include "netloop.h"
 #include "player.h"
 #include "predicates.h"
+#include "profile.h"
 #include "props.h"
+#include "smtpqueue.h"
 #include "timequeue.h"
 #include "tune.h"
 
@@ -57,6 +70,9 @@
 #  include <ssl.h>
 # endif
 #include <sys/stat.h>
+#ifndef WIN32
+# include <sys/uio.h>
+#endif
 #endif
 
 #ifdef WIN32
@@ -79,12 +95,14 @@ static const char *flushed_message = "<Output Flushed>\r\n";
  */
 static const char *shutdown_message = "\r\nGoing down - Bye\r\n";
 
+#ifdef SPAWN_HOST_RESOLVER
 /**
  * @private
  * @var Resolver socket pair for working with the resolver process.
  *      Resolver uses [0] and parent uses [1].
  */
 static int resolver_sock[2];
+#endif
 
 /**
  * @var The list of descriptors being managed.
@@ -140,12 +158,6 @@ static size_t numports = 0;
  */
 static int numsocks = 0;
 
-/**
- * @private
- * @var the highest descriptor number - this is needed for select()/pselect()
- */
-static int max_descriptor = 0;
-
 /**
  * @private
  * @var the array of NON SSL listening port numbers.  This defaults to
@@ -237,23 +249,40 @@ static int ndescriptors = 0;
  * @private
  * @var a mapping of descriptor numbers to descriptor data objects
  *
- * @TODO This is actually a pretty fragile way to do it.  First off,
- *       we should consider moving to poll.  There's a nice example
- *       of converting select to poll here:
- *
- * https://stackoverflow.com/questions/7976388/increasing-limit-of-fd-setsize-and-select
- *
- *       (I think its the third answer)
+ * This is an open addressing hash table keyed by descriptor number, using
+ * linear probing.  It starts at FD_SETSIZE entries and doubles whenever it
+ * becomes half full, so lookups stay O(1) no matter how many connections
+ * there are.  On UNIX descriptor numbers are small and dense so there are
+ * very few collisions; on Windows socket handles are not, which is why this
+ * is a hash rather than a plain array.
+ */
+static struct descriptor_data **descr_lookup_table = NULL;
+
+/**
+ * @private
+ * @var the number of slots in descr_lookup_table; always a power of two
+ */
+static int descr_lookup_size = 0;
+
+/**
+ * @private
+ * @var the number of descriptors in descr_lookup_table
+ */
+static int descr_lookup_count = 0;
+
+/**
+ * @var The list of connected (logged in) descriptors.
  *
- *       This should be either a dynamically resized table or a hash.
- *       I think a dynamically resized table is probably more appropriate,
- *       and it can start with a default size of FD_SETSIZE (which is 1024)
- *       and grow if needed.  It is unlikely (though possible) for a MUCK
- *       to have more than 1024 descriptors + sockets, so this is unlikely
- *       to increase memory usage but would allow it to expand if needed.
- *       (tanabi)
+ * This is kept in the same order as descriptor_list, but skips the
+ * descriptors that are still sitting at the login screen.  It is linked
+ * through the con_next and con_prev fields.
+ */
+struct descriptor_data *connected_list = NULL;
+
+/**
+ * @var Tail of the list of connected descriptors for reverse iteration.
  */
-static struct descriptor_data *descr_lookup_table[FD_SETSIZE];
+struct descriptor_data *connected_list_tail = NULL;
 
 /**
  * Is 'q' a valid input character?
@@ -304,7 +333,8 @@ static char resolver_program[BUFFER_LEN];
 short db_conversion_flag = 0;
 
 /**
- * @var Boolean, true if has the forked dump process has completed.
+ * @var Non-zero if the forked dump process has completed: 1 if it saved
+ *      the database, 2 if it failed.
  */
 short global_dumpdone = 0;
 
@@ -420,6 +450,9 @@ show_program_usage(char *prog)
 "        -gamedir PATH    changes directory to PATH before starting up.\n"
 "        -parmfile PATH   replace the system parameters with those in PATH.\n"
 "        -convert         load the db, then save and quit.\n"
+#ifndef DISKBASE
+"        -dbformat FORMAT save the db in FORMAT, either 'text' or 'binary'.\n"
+#endif
 "        -nosanity        don't do db sanity checks at startup time.\n"
 "        -insanity        load db, then enter the interactive sanity editor.\n"
 "        -sanfix          attempt to auto-fix a corrupt db after loading.\n"
@@ -446,23 +479,6 @@ show_program_usage(char *prog)
     exit(1);
 }
 
-/**
- * Update max descriptor count
- *
- * This is actually done in a number of places so it makes sense to
- * centralize this logic.
- *
- * @private
- * @param descr the newly added descriptor to consider as the new maximum
- */
-static inline void
-update_max_descriptor(int descr)
-{
-    if (descr >= max_descriptor) {
-        max_descriptor = descr + 1;
-    }
-}
-
 /**
  * Update the command burst "quotas"
  *
@@ -555,31 +571,33 @@ free_text_block(struct text_block *t)
  * Allocate a new text block for 'n' bytes coming from 's'
  *
  * Note that no \0 provision is made here.  Exactly 'n' bytes is
- * allocated, and exactly 'n' bytes is copied, so if null termination
- * is required it is up to the caller.  Consumers be aware that string
- * functions cannot rely on a null terminator for text_block strings.
+ * copied, so if null termination is required it is up to the caller.
+ * Consumers be aware that string functions cannot rely on a null
+ * terminator for text_block strings.
  *
  * Text blocks could technically be arbitrary bytes, such as telnet
  * control characters, so this situation does make sense.
  *
  * @private
  * @param s the source bytes
- * @param n the number of bytes to allocate, then copy from s
+ * @param n the number of bytes to copy from s
+ * @param size the number of bytes to allocate, which must be at least n
  * @return a new struct text_block
  */
 static struct text_block *
-make_text_block(const char *s, size_t n)
+make_text_block(const char *s, size_t n, size_t size)
 {
     struct text_block *p;
 
     if (!(p = malloc(sizeof(struct text_block))))
         panic("make_text_block: Out of memory");
 
-    if (!(p->buf = malloc(n * sizeof(char))))
+    if (!(p->buf = malloc(size * sizeof(char))))
         panic("make_text_block: Out of memory");
 
     memmove(p->buf, s, n);
     p->nchars = n;
+    p->size = size;
     p->start = p->buf;
     p->nxt = 0;
     return p;
@@ -588,6 +606,9 @@ make_text_block(const char *s, size_t n)
 /**
  * Add a new message to the given queue
  *
+ * The message gets a block of its own.  This is what the input queue
+ * needs, since each block there is a command.
+ *
  * @private
  * @param q the queue to add the message to
  * @param b the message
@@ -598,13 +619,53 @@ add_to_queue(struct text_queue *q, const char *b, size_t n)
 {
     struct text_block *p;
 
-    p = make_text_block(b, n);
+    p = make_text_block(b, n, n);
     p->nxt = 0;
     *q->tail = p;
     q->tail = &p->nxt;
     q->lines++;
 }
 
+/**
+ * Add output to the given queue, packing it in with what is there
+ *
+ * If the last block in the queue has room after its text, the output is
+ * copied there.  Otherwise a new block of at least OUTPUT_BLOCK_SIZE
+ * bytes is started.  A burst of messages to one connection then costs a
+ * few allocations and writes rather than one of each per message.
+ *
+ * A block that SSL_write has to be retried with is moved off the queue to
+ * pending_ssl_write, so it is never added to.
+ *
+ * @private
+ * @param q the queue to add the output to
+ * @param b the output
+ * @param n the number of bytes of output
+ */
+static void
+append_to_queue(struct text_queue *q, const char *b, size_t n)
+{
+    struct text_block *last;
+
+    if (q->tail != &q->head) {
+        /* The tail points at the last block's nxt. */
+        last = (struct text_block *)
+                   ((char *) q->tail - offsetof(struct text_block, nxt));
+
+        if ((size_t) (last->buf + last->size - (last->start + last->nchars))
+            >= n) {
+            memcpy(last->start + last->nchars, b, n);
+            last->nchars += n;
+            return;
+        }
+    }
+
+    last = make_text_block(b, n, n > OUTPUT_BLOCK_SIZE ? n : OUTPUT_BLOCK_SIZE);
+    *q->tail = last;
+    q->tail = &last->nxt;
+    q->lines++;
+}
+
 /**
  * For a given descriptor 'd' flush all output above size_limit
  *
@@ -634,7 +695,8 @@ flush_output_queue(struct descriptor_data *d, int size_limit)
             free_text_block(p);
         }
 
-        p = make_text_block(flushed_message, strlen(flushed_message));
+        p = make_text_block(flushed_message, strlen(flushed_message),
+                            strlen(flushed_message));
         p->nxt = q->head;
         q->head = p;
         q->lines++;
@@ -672,11 +734,30 @@ queue_write_max(struct descriptor_data *d, const char *b, size_t n, size_t max)
         flush_output_queue(d, max);
     }
 
-    add_to_queue(&d->output, b, n);
+    append_to_queue(&d->output, b, n);
     d->output_size += n;
 }
 
 
+/**
+ * Find out if a descriptor is sent ANSI codes
+ *
+ * Connected players get them if they are set CHOWN_OK.  Connections that
+ * haven't logged in yet get them if the welcome screen is parsed for MPI.
+ *
+ * @private
+ * @param d the descriptor_data to check
+ * @return boolean true if "good" ANSI is kept, false if all ANSI is stripped
+ */
+static int
+wants_ansi(struct descriptor_data *d)
+{
+    if (d->connected)
+        return FLAG_CHECK(d->player, 'C');
+
+    return tp_do_mpi_parsing && tp_do_welcome_parsing;
+}
+
 /**
  * Queue ANSI-enabled (color, etc.) text to the given descriptor
  *
@@ -703,13 +784,7 @@ queue_ansi(struct descriptor_data *d, const char *msg)
 {
     char buf[BUFFER_LEN + 8];
 
-    if (d->connected) {
-        if (FLAG_CHECK(d->player, 'C')) {
-            strip_bad_ansi(buf, msg);
-        } else {
-            strip_ansi(buf, msg);
-        }
-    } else if (tp_do_mpi_parsing && tp_do_welcome_parsing) {
+    if (wants_ansi(d)) {
         strip_bad_ansi(buf, msg);
     } else {
         strip_ansi(buf, msg);
@@ -819,12 +894,11 @@ dump_users(struct descriptor_data *e, char *user)
         );
     }
 
-    d = descriptor_list;
+    d = connected_list;
     players = 0;
 
     while (d) {
-        if (d->connected &&
-            (!tp_who_hides_dark ||
+        if ((!tp_who_hides_dark ||
              (wizard || !Dark(d->player))) &&
              ++players && (!user || string_prefix(NAME(d->player), user))
         ) {
@@ -907,7 +981,7 @@ dump_users(struct descriptor_data *e, char *user)
             queue_ansi(e, buf);
         }
 
-        d = d->next;
+        d = d->con_next;
     }
 
     /*
@@ -999,33 +1073,32 @@ announce_puppets(dbref player, const char *msg, const char *prop)
     dbref where;
     const char *ptr, *msg2;
     char buf[BUFFER_LEN];
+    int count;
 
-    /*
-     * @TODO This is brutal.  Scan the entire DB every time someone
-     *       logs in or disconnects?  Yuck.  This is a great reason
-     *       to use a relational database because there really isn't
-     *       a better way to do this, short of maintaining a linked
-     *       list of owned items for each player which would be nasty
-     *       in other ways.
-     */
-    for (dbref what = 0; what < db_top; what++) {
-        if (OBJECT_TYPE(what) == TYPE_THING && FLAG_CHECK(what, 'Z')) {
-            if (OWNER(what) == player) {
-                where = LOCATION(what);
+    /* Copied, since the notifications can run programs */
+    dbref *owned = db_copy_referrers(player, REFS_OWNED, &count);
 
-                if ((!Dark(where)) && (!Dark(player)) && (!Dark(what))) {
-                    msg2 = msg;
+    for (int i = 0; i < count; i++) {
+        dbref what = owned[i];
 
-                    if ((ptr = (char *) get_property_class(what, prop)) && *ptr)
-                        msg2 = ptr;
+        if (OBJECT_TYPE(what) == TYPE_THING && FLAG_CHECK(what, 'Z')
+            && OWNER(what) == player) {
+            where = LOCATION(what);
 
-                    snprintf(buf, sizeof(buf), "%.512s %.3000s",
-                             NAME(what), msg2);
-                    notify_except(CONTENTS(where), what, buf, what);
-                }
+            if ((!Dark(where)) && (!Dark(player)) && (!Dark(what))) {
+                msg2 = msg;
+
+                if ((ptr = (char *) get_property_class(what, prop)) && *ptr)
+                    msg2 = ptr;
+
+                snprintf(buf, sizeof(buf), "%.512s %.3000s",
+                         NAME(what), msg2);
+                notify_except(CONTENTS(where), what, buf, what);
             }
         }
     }
+
+    free(owned);
 }
 
 /**
@@ -1356,79 +1429,56 @@ forget_player_descr(dbref player, int descr)
     PLAYER_SET_DESCRS(player, arr);
 }
 
-#ifdef WIN32
 /**
- * @var Windows doesn't handle descriptors the same way that UNIX does,
- *      and so the descriptors have to be handled differently.
- *
- *      It isn't really a hash; it is a flat array that is iterated over
- *      to find the descriptor number.
+ * Find the slot for a descriptor number in the descriptor lookup table
  *
- * @TODO This system will need to change to make this 'hash' table dynamically
- *       sized if we make this support poll.
- */
-int descr_hash_table[FD_SETSIZE];
-
-/**
- * Add a descriptor to the hash table
+ * The returned slot either holds the descriptor_data for 'descr', or is
+ * the empty slot where it would be inserted.
  *
  * @private
- * @param d the descriptor to add to the table
- * @return the index into the hash table, or -1 if the table is full
+ * @param descr the descriptor number
+ * @return the index of the slot in descr_lookup_table
  */
 static int
-sethash_descr(int d)
+descr_lookup_slot(int descr)
 {
-    for (int i = 0; i < FD_SETSIZE; i++) {
-        if (descr_hash_table[i] == -1) {
-            descr_hash_table[i] = d;
-            return i;
-        }
+    unsigned int mask = (unsigned int)descr_lookup_size - 1;
+    unsigned int slot = ((unsigned int)descr * 2654435761U) & mask;
+
+    while (descr_lookup_table[slot]
+           && descr_lookup_table[slot]->descriptor != descr) {
+        slot = (slot + 1) & mask;
     }
 
-    fprintf(stderr, "descr hash table full !");
-    return -1;
+    return (int)slot;
 }
 
 /**
- * Resolve a descriptor hash index into a descriptor
+ * Resize the descriptor lookup table, rehashing everything in it.
  *
  * @private
- * @param d the has index
- * @return the descriptor corresponding to 'd' or -1 if not found
+ * @param newsize the new number of slots; must be a power of two
  */
-static int
-gethash_descr(int d)
+static void
+resize_descriptor_lookup(int newsize)
 {
-    for (int i = 0; i < FD_SETSIZE; i++) {
-        if (descr_hash_table[i] == d)
-            return i;
-    }
+    struct descriptor_data **oldtable = descr_lookup_table;
+    int oldsize = descr_lookup_size;
 
-    fprintf(stderr, "descr hash value missing !"); /* Should NEVER happen */
-    return -1;
+    if (!(descr_lookup_table = calloc((size_t)newsize, sizeof(struct descriptor_data *))))
+        panic("resize_descriptor_lookup: Out of memory");
 
-}
+    descr_lookup_size = newsize;
 
-/**
- * Remove a descriptor from the descriptor "hash" table.
- *
- * @private
- * @param d the descriptor to remove from the "hash" table
- */
-static void
-unsethash_descr(int d)
-{
-    for (int i = 0; i < FD_SETSIZE; i++) {
-        if (descr_hash_table[i] == d) {
-            descr_hash_table[i] = -1;
-            return;
+    for (int i = 0; i < oldsize; i++) {
+        if (oldtable[i]) {
+            descr_lookup_table[descr_lookup_slot(oldtable[i]->descriptor)] =
+                oldtable[i];
         }
     }
 
-    fprintf(stderr, "descr hash value missing !");
+    free(oldtable);
 }
-#endif
 
 /**
  * Initialize the descriptor lookup table
@@ -1438,47 +1488,33 @@ unsethash_descr(int d)
 static void
 init_descriptor_lookup()
 {
-#ifdef WIN32
-    for (int i = 0; i < FD_SETSIZE; i++) {
-        descr_hash_table[i] = -1;
-    }
-#endif
-    for (int i = 0; i < FD_SETSIZE; i++) {
-        descr_lookup_table[i] = NULL;
-    }
+    resize_descriptor_lookup(FD_SETSIZE);
 }
 
 /**
- * Fetch a descriptor number from an index in the descriptor table.
+ * Validate a descriptor number.
  *
- * Note that for UNIX, 'index' is always going to be the same as the
- * returned descriptor.  This is more for the benefit of Windows,
- * which has sort of a complicated descriptor abstraction going on
- * (or at least that's how it seems to work).
+ * This is used to check that a descriptor number taken from a player's
+ * descriptor list still refers to a live connection.
  *
- * @param index the index in the descriptor table to fetch
- * @return the descriptor associated with that index
+ * @param index the descriptor number to check
+ * @return the descriptor if it is a live connection, -1 otherwise
  */
 int
 index_descr(int index)
 {
-    if ((index < 0) || (index >= FD_SETSIZE))
-        return -1;
+    struct descriptor_data *d = descrdata_by_descr(index);
 
-    if (descr_lookup_table[index] == NULL)
+    if (d == NULL)
         return -1;
 
-    return descr_lookup_table[index]->descriptor;
+    return d->descriptor;
 }
 
 /**
  * Add a descriptor_data entry to the descriptor lookup table
  *
- * For windows, this uses the abstraction of the hash table,
- * and the index into remember_descriptor will be the return
- * value of sethash_descr
- *
- * @see sethash_descr
+ * The table is grown if this would make it more than half full.
  *
  * @private
  * @param d the descriptor_data to add to the descr_lookup_table
@@ -1487,19 +1523,21 @@ static void
 remember_descriptor(struct descriptor_data *d)
 {
     if (d) {
-#ifdef WIN32
-        descr_lookup_table[sethash_descr(d->descriptor)] = d;
-#else
-        descr_lookup_table[d->descriptor] = d;
-#endif
+        if ((descr_lookup_count + 1) * 2 > descr_lookup_size) {
+            resize_descriptor_lookup(descr_lookup_size * 2);
+        }
+
+        descr_lookup_table[descr_lookup_slot(d->descriptor)] = d;
+        descr_lookup_count++;
     }
 }
 
 /**
  * Remove a descriptor_data structure from the descriptor lookup table
  *
- * Note that this does not free memory, but it does set the slot in the
- * table NULL.
+ * Note that this does not free memory.  Entries that follow the removed
+ * one in its probe sequence are shifted back so that lookups never need
+ * to skip over deleted slots.
  *
  * @private
  * @param d the descriptor_data structure to remove
@@ -1507,58 +1545,108 @@ remember_descriptor(struct descriptor_data *d)
 static void
 forget_descriptor(struct descriptor_data *d)
 {
-    if (d) {
-#ifdef WIN32
-        unsethash_descr(d->descriptor);
+    unsigned int mask = (unsigned int)descr_lookup_size - 1;
+    unsigned int hole, next, home;
+
+    if (!d)
+        return;
+
+    hole = (unsigned int)descr_lookup_slot(d->descriptor);
+
+    if (descr_lookup_table[hole] != d)
+        return;
+
+    descr_lookup_table[hole] = NULL;
+    descr_lookup_count--;
+
+    for (next = (hole + 1) & mask; descr_lookup_table[next];
+         next = (next + 1) & mask) {
+        home = ((unsigned int)descr_lookup_table[next]->descriptor
+                * 2654435761U) & mask;
 
         /*
-         * @TODO Bug: if win32, don't we need to remove the HASHED
-         *       d->descriptor rather than d->descriptor?  This seems
-         *       like it will just set some poor random soul NULL in
-         *       the descr_lookup_table :)  Could be that Windows
-         *       descriptors such high numbers vs. the hashed numbers
-         *       that we've been lucky and never over-written active
-         *       entries with NULL :P
-         *
-         *       Why do we do this stupid hash thing anyway?  What does
-         *       it matter if descriptors are sequential and relatively
-         *       low numbered?  This system just seems weird and flawed
-         *       to me, but it could be my lack of understanding of
-         *       WinSock. (tanabi)
+         * Move the entry into the hole unless its home slot lies
+         * cyclically between the hole and where it currently is.
          */
-#else
-        descr_lookup_table[d->descriptor] = NULL;
-#endif
+        if ((next > hole && (home <= hole || home > next)) ||
+            (next < hole && (home <= hole && home > next))) {
+            descr_lookup_table[hole] = descr_lookup_table[next];
+            descr_lookup_table[next] = NULL;
+            hole = next;
+        }
     }
 }
 
 /**
  * Get the descriptor_data associated with a given descriptor number
  *
- * For UNIX, 'c' is the descriptor and is just an index in the table.
- * For Windows, 'c' gets hashed with gethash_descr then that index's
- * value is returned.
- *
- * @see gethash_descr
- *
  * @param c the descriptor to lookup
  * @return the descriptor_data corresponding to c or NULL if not found
  */
 struct descriptor_data *
 descrdata_by_descr(int c)
 {
-#ifdef WIN32
-    if (c < 0)
+    if (c < 0 || !descr_lookup_table)
         return NULL;
 
-    return descr_lookup_table[gethash_descr(c)];
-#else
-    if (c >= FD_SETSIZE || c < 0) {
-        return NULL;
+    return descr_lookup_table[descr_lookup_slot(c)];
+}
+
+/**
+ * Add a descriptor to the list of connected descriptors
+ *
+ * The connected list is kept in the same order as descriptor_list, so
+ * the descriptor is linked in just ahead of the nearest older descriptor
+ * that is also connected.
+ *
+ * @private
+ * @param d the descriptor that has just become connected
+ */
+static void
+link_connected_descr(struct descriptor_data *d)
+{
+    struct descriptor_data *older = d->next;
+
+    while (older && !older->connected)
+        older = older->next;
+
+    d->con_next = older;
+
+    if (older) {
+        d->con_prev = older->con_prev;
+        older->con_prev = d;
+    } else {
+        d->con_prev = connected_list_tail;
+        connected_list_tail = d;
     }
 
-    return descr_lookup_table[c];
-#endif
+    if (d->con_prev)
+        d->con_prev->con_next = d;
+    else
+        connected_list = d;
+}
+
+/**
+ * Remove a descriptor from the list of connected descriptors
+ *
+ * @private
+ * @param d the descriptor that is no longer connected
+ */
+static void
+unlink_connected_descr(struct descriptor_data *d)
+{
+    if (d->con_prev)
+        d->con_prev->con_next = d->con_next;
+    else
+        connected_list = d->con_next;
+
+    if (d->con_next)
+        d->con_next->con_prev = d->con_prev;
+    else
+        connected_list_tail = d->con_prev;
+
+    d->con_next = NULL;
+    d->con_prev = NULL;
 }
 
 /**
@@ -1749,6 +1837,7 @@ process_welcome_input(struct descriptor_data *d, const char *msg)
     d->connected = 1;
     d->connected_at = time(NULL);
     d->player = player;
+    link_connected_descr(d);
     remember_player_descr(player, d->descriptor);
     PLAYER_SET_BLOCK(d->player, 0);
 
@@ -2155,7 +2244,7 @@ queue_immediate_raw(struct descriptor_data *d, const char *msg)
      *        everywhere queue_immediate_raw is used instead?
      *        Or not if I'm just being stupid nitpicky. -tanabi
      */
-    add_to_queue(&d->priority_output, msg, strlen(msg));
+    append_to_queue(&d->priority_output, msg, strlen(msg));
 }
 
 /**
@@ -2343,6 +2432,7 @@ announce_disconnect(struct descriptor_data *d)
 
     d->connected = 0;
     d->player = NOTHING;
+    unlink_connected_descr(d);
 
     forget_player_descr(player, d->descriptor);
 
@@ -2398,6 +2488,8 @@ shutdownsock(struct descriptor_data *d)
                    d->descriptor, d->hostname, d->username);
     }
 
+    netloop_forget(d->descriptor);
+
     if (!d->is_console) {
         shutdown(d->descriptor, 2);
         close(d->descriptor);
@@ -2603,9 +2695,7 @@ initializesock(int s, int output_s, const char *hostname, int is_ssl, int is_con
  */
 static void
 connect_console() {
-    struct descriptor_data *d;
-    d = initializesock(STDIN_FILENO, STDOUT_FILENO, "console(console)", 0, 1);
-    update_max_descriptor(d->descriptor);
+    initializesock(STDIN_FILENO, STDOUT_FILENO, "console(console)", 0, 1);
 }
 #endif
 
@@ -2701,8 +2791,8 @@ make_socket(int port, sa_family_t family, void *bind_addr, socklen_t addr_len)
  * This resolves the IPv6 address 'a' to either an IP string or a hostname
  * based on if we can resolve it, and how we're resolving it.
  *
- * If the resolver is spawned, we will temporarily use the IPv6 address
- * until the resolver responds.
+ * If the resolver is spawned or runs in the server, we will temporarily use
+ * the IPv6 address until the resolver responds.
  *
  * Uses a static buffer, so be careful with it; copy the string out if
  * needed.
@@ -2724,7 +2814,7 @@ addrout_v6(in_port_t lport, struct in6_addr *a, in_port_t prt)
 
     prt = ntohs(prt);
 
-#ifndef SPAWN_HOST_RESOLVER
+#if !defined(SPAWN_HOST_RESOLVER) && !defined(ASYNC_HOST_RESOLVER)
     if (tp_use_hostnames) {
         /*
          * One day the nameserver Qwest uses decided to start
@@ -2757,7 +2847,7 @@ addrout_v6(in_port_t lport, struct in6_addr *a, in_port_t prt)
             }
         }
     }
-#endif /* !SPAWN_HOST_RESOLVER */
+#endif /* !SPAWN_HOST_RESOLVER && !ASYNC_HOST_RESOLVER */
 
     inet_ntop(AF_INET6, a, ip6addr, sizeof(ip6addr));
 
@@ -2782,8 +2872,8 @@ addrout_v6(in_port_t lport, struct in6_addr *a, in_port_t prt)
  * This resolves the IPv4 address 'a' to either an IP string or a hostname
  * based on if we can resolve it, and how we're resolving it.
  *
- * If the resolver is spawned, we will temporarily use the IPv4 address
- * until the resolver responds.
+ * If the resolver is spawned or runs in the server, we will temporarily use
+ * the IPv4 address until the resolver responds.
  *
  * Uses a static buffer, so be careful with it; copy the string out if
  * needed.
@@ -2805,7 +2895,7 @@ addrout(in_port_t lport, in_addr_t a, in_port_t prt)
 
     prt = ntohs(prt);
 
-#ifndef SPAWN_HOST_RESOLVER
+#if !defined(SPAWN_HOST_RESOLVER) && !defined(ASYNC_HOST_RESOLVER)
     if (tp_use_hostnames) {
         /*
          * One day the nameserver Qwest uses decided to start
@@ -2838,7 +2928,7 @@ addrout(in_port_t lport, in_addr_t a, in_port_t prt)
             }
         }
     }
-#endif /* !SPAWN_HOST_RESOLVER */
+#endif /* !SPAWN_HOST_RESOLVER && !ASYNC_HOST_RESOLVER */
 
     a = ntohl(a);
 
@@ -2927,7 +3017,20 @@ new_connection(in_port_t port, int sock_, bool is_ssl, sa_family_t family)
         log_status("ACCEPT: %s on descriptor %d", hostname, newsock);
         log_status("CONCOUNT: There are now %d open connections.", ++ndescriptors);
 
+#ifdef ASYNC_HOST_RESOLVER
+        {
+            struct descriptor_data *d;
+
+            d = initializesock(newsock, newsock, hostname, is_ssl, 0);
+
+            if (tp_use_hostnames)
+                host_resolve_add(d, (struct sockaddr *) &addr, addr_len, port);
+
+            return d;
+        }
+#else
         return initializesock(newsock, newsock, hostname, is_ssl, 0);
+#endif
     }
 }
 
@@ -3869,6 +3972,7 @@ kill_resolver(void)
         /* ignore */
     }
 
+    netloop_forget(resolver_sock[1]);
     shutdown(resolver_sock[1], 2);
 
     /*
@@ -3903,6 +4007,15 @@ spawn_resolver(void)
         return;
     }
 
+    /*
+     * If we are respawning a resolver that died, stop watching the old
+     * socket and close it so the descriptor isn't leaked.
+     */
+    if (resolver_spawn_time) {
+        netloop_forget(resolver_sock[1]);
+        close(resolver_sock[1]);
+    }
+
     resolver_spawn_time = time(NULL);
 
     socketpair(AF_UNIX, SOCK_STREAM, 0, resolver_sock);
@@ -4092,20 +4205,22 @@ resolve_hostnames()
 static void
 shovechars()
 {
-    fd_set input_set, output_set;
     time_t now;
     long tmptq;
     struct timeval last_slice, current_time;
     struct timeval next_slice;
     struct timeval timeout, slice_timeout;
-#ifdef HAVE_PSELECT
-    struct timespec timeout_for_pselect;
-#endif
     int cnt;
     struct descriptor_data *dnext;
+#ifdef USE_SSL
     struct descriptor_data *newd;
+#endif
     struct timeval sel_in, sel_out;
     int avail_descriptors;
+    int listen_events;
+
+    netloop_init();
+    log_status("INIT: Using %s network event loop.", netloop_backend_name());
 
     listen_bound_sockets();
 
@@ -4113,6 +4228,9 @@ shovechars()
 
     avail_descriptors = max_open_files() - 5;
 
+    if (avail_descriptors > netloop_max_descriptors() - 5)
+        avail_descriptors = netloop_max_descriptors() - 5;
+
     (void) time(&now);
 
 #ifndef WIN32
@@ -4126,6 +4244,10 @@ shovechars()
         gettimeofday(&current_time, NULL);
         last_slice = update_quotas(last_slice, current_time);
 
+        /* A profiler tick that neither MUF nor MPI took */
+        if (profile_sample_due)
+            profile_sample_server();
+
         /* Process timed events, commands, and MUF stuff. */
         next_muckevent();
         process_commands();
@@ -4185,6 +4307,11 @@ shovechars()
                 global_dumper_player = -1;
             }
 
+#ifdef DB_JOURNAL
+            if (global_dumpdone == 1)
+                journal_dump_done();
+#endif
+
             global_dumpdone = 0;
         }
 
@@ -4194,46 +4321,50 @@ shovechars()
         if (shutdown_flag)
             break;
 
-        /* Set up FDSET's for select/pselect */
+        /* Work out the timeout and what we want to hear about */
         timeout.tv_sec = 10;
         timeout.tv_usec = 0;
         next_slice = msec_add(last_slice, tp_command_time_msec);
         slice_timeout = timeval_sub(next_slice, current_time);
 
-        FD_ZERO(&input_set);
-        FD_ZERO(&output_set);
+        /*
+         * Interest is persistent in the event loop, and setting the
+         * same interest again costs nothing, so we simply state what we
+         * want for every descriptor on every pass.
+         */
+        listen_events = (ndescriptors < avail_descriptors) ? NETLOOP_READ : 0;
 
-        /* Add all the descriptors to the FDSETs */
-        if (ndescriptors < avail_descriptors) {
-            for (int i = 0; i < numsocks; i++) {
-                FD_SET(sock[i], &input_set);
-            }
+        for (int i = 0; i < numsocks; i++) {
+            netloop_set(sock[i], listen_events);
+        }
 
-            for (int i = 0; i < numsocks_v6; i++) {
-                FD_SET(sock_v6[i], &input_set);
-            }
+        for (int i = 0; i < numsocks_v6; i++) {
+            netloop_set(sock_v6[i], listen_events);
+        }
 
 #ifdef USE_SSL
-            for (int i = 0; i < ssl_numsocks; i++) {
-                FD_SET(ssl_sock[i], &input_set);
-            }
+        for (int i = 0; i < ssl_numsocks; i++) {
+            netloop_set(ssl_sock[i], listen_events);
+        }
 
-            for (int i = 0; i < ssl_numsocks_v6; i++) {
-                FD_SET(ssl_sock_v6[i], &input_set);
-            }
-#endif
+        for (int i = 0; i < ssl_numsocks_v6; i++) {
+            netloop_set(ssl_sock_v6[i], listen_events);
         }
+#endif
 
-        /* Iterate over the descriptors and add to input_set */
+        /* Iterate over the descriptors and work out their interest */
         for (struct descriptor_data *d = descriptor_list; d; d = d->next) {
+            int events = 0;
+
             if (d->input.lines > 0)
                 timeout = slice_timeout;
 
             if (d->input.lines < 100)
-                FD_SET(d->descriptor, &input_set);
+                events |= NETLOOP_READ;
 
-#ifdef USE_SSL
+            /* Write interest is only armed when there is output waiting */
             if (has_output(d)) {
+#ifdef USE_SSL
                 /*
                  * If SSL isn't already in place, give TELNET STARTTLS
                  * handshaking a couple seconds to respond, to start it.
@@ -4242,15 +4373,18 @@ shovechars()
                 time_t timeon = now - d->connected_at;
 
                 if (d->ssl_session || !tp_starttls_allow) {
-                    FD_SET(d->descriptor, &output_set);
+                    events |= NETLOOP_WRITE;
                 } else if (timeon >= welcome_pause) {
-                    FD_SET(d->descriptor, &output_set);
+                    events |= NETLOOP_WRITE;
                 } else {
                     if (timeout.tv_sec > welcome_pause - timeon) {
                         timeout.tv_sec = (long)(welcome_pause - timeon);
                         timeout.tv_usec = 10; /* 10 msecs min.  Arbitrary. */
                     }
                 }
+#else
+                events |= NETLOOP_WRITE;
+#endif
                 if (d->is_console && !isatty(d->descriptor)) {
                   if (timeout.tv_sec > 0) {
                     timeout.tv_sec = 0L;
@@ -4261,73 +4395,58 @@ shovechars()
                 }
             }
 
+#ifdef USE_SSL
             if (d->ssl_session) {
                 /* SSL may want to write even if the output queue is empty */
                 if (!SSL_is_init_finished(d->ssl_session)) {
                     /* log_status("SSL : Init not finished.\n", "version"); */
-                    FD_CLR(d->descriptor, &output_set);
-                    FD_SET(d->descriptor, &input_set);
+                    events &= ~NETLOOP_WRITE;
+                    events |= NETLOOP_READ;
                 }
 
                 if (SSL_want_write(d->ssl_session)) {
                     /* log_status("SSL : Need write.\n", "version"); */
-                    FD_SET(d->descriptor, &output_set);
-                }
-            }
-#else
-            if (has_output(d)) {
-                FD_SET(d->descriptor, &output_set);
-                if (d->is_console && !isatty(d->descriptor)) {
-                  if (timeout.tv_sec > 0) {
-                    timeout.tv_sec = 0L;
-                    if (!timeout.tv_usec || timeout.tv_usec > 500) {
-                      timeout.tv_usec = 500;
-                    }
-                  }
+                    events |= NETLOOP_WRITE;
                 }
             }
 #endif
 
+            netloop_set(d->descriptor, events);
         }
 
 #ifdef SPAWN_HOST_RESOLVER
         /* Add the host resolver socket if we're using spawned resolver. */
-        FD_SET(resolver_sock[1], &input_set);
+        netloop_set(resolver_sock[1], NETLOOP_READ);
 #endif
 
-        /* Set up timer for select */
+        /* Set up timer for the wait */
         tmptq = (long)next_muckevent_time();
 
-        if ((tmptq >= 0L) && (timeout.tv_sec > tmptq)) {
-            timeout.tv_sec = tmptq + (tp_pause_min / 1000);
-            timeout.tv_usec = (tp_pause_min % 1000) * 1000L;
-        }
+        if (tmptq >= 0L) {
+            struct timeval tq_timeout;
 
-        gettimeofday(&sel_in, NULL);
+            tq_timeout.tv_sec = tmptq + (tp_pause_min / 1000);
+            tq_timeout.tv_usec = (tp_pause_min % 1000) * 1000L;
 
-        /* Use the right select call for our system */
-#ifdef HAVE_PSELECT
-        timeout_for_pselect.tv_sec = timeout.tv_sec;
-        timeout_for_pselect.tv_nsec = timeout.tv_usec * 1000L;
+            /*
+             * Compare the microseconds too, or an event that is due now
+             * waits out the rest of a command slice.
+             */
+            if (timeval_sub(timeout, tq_timeout).tv_sec >= 0)
+                timeout = tq_timeout;
+        }
 
-        if (pselect(max_descriptor, &input_set, &output_set, (fd_set *) 0,
-                    &timeout_for_pselect, &pselect_signal_mask) < 0) {
-            if (errno != EINTR) {
-                perror("select");
-                return;
-            }
+        gettimeofday(&sel_in, NULL);
 
-#elif !defined(WIN32)
-        if (select(max_descriptor, &input_set, &output_set, (fd_set *) 0, &timeout) < 0) {
+        if (netloop_wait(&timeout) < 0) {
+#ifndef WIN32
             if (errno != EINTR) {
-                perror("select");
+                perror("netloop_wait");
                 return;
             }
 #else
-        if (select(max_descriptor, &input_set, &output_set, (fd_set *) 0, &timeout) ==
-            SOCKET_ERROR) {
             if (WSAGetLastError() != WSAEINTR) {
-                perror("select");
+                perror("netloop_wait");
                 return;
             }
 #endif
@@ -4355,8 +4474,8 @@ shovechars()
 
             /* Iterate over sockets and handle new connections */
             for (int i = 0; i < numsocks; i++) {
-                if (FD_ISSET(sock[i], &input_set)) {
-                    if (!(newd = new_connection(listener_port[i], sock[i], false, AF_INET))) {
+                if (netloop_ready(sock[i]) & NETLOOP_READ) {
+                    if (!new_connection(listener_port[i], sock[i], false, AF_INET)) {
 #ifndef WIN32
                         if (errno && errno != EINTR && errno != EMFILE && errno != ENFILE) {
                             perror("new_connection");
@@ -4368,16 +4487,14 @@ shovechars()
                             /* return; */
                         }
 #endif /* WIN32 */
-                    } else {
-                        update_max_descriptor(newd->descriptor);
                     }
                 }
             }
 
             /* Iterate over sockets and handle new connections */
             for (int i = 0; i < numsocks_v6; i++) {
-                if (FD_ISSET(sock_v6[i], &input_set)) {
-                    if (!(newd = new_connection(listener_port[i], sock_v6[i], false, AF_INET6))) {
+                if (netloop_ready(sock_v6[i]) & NETLOOP_READ) {
+                    if (!new_connection(listener_port[i], sock_v6[i], false, AF_INET6)) {
 #ifndef WIN32
                         if (errno && errno != EINTR && errno != EMFILE && errno != ENFILE) {
                             perror("new_connection");
@@ -4389,8 +4506,6 @@ shovechars()
                             /* return; */
                         }
 #endif
-                    } else {
-                        update_max_descriptor(newd->descriptor);
                     }
                 }
             }
@@ -4398,7 +4513,7 @@ shovechars()
 #ifdef USE_SSL
             /* Iterate over sockets and handle new connections */
             for (int i = 0; i < ssl_numsocks; i++) {
-                if (FD_ISSET(ssl_sock[i], &input_set)) {
+                if (netloop_ready(ssl_sock[i]) & NETLOOP_READ) {
                     if (!(newd = new_connection(ssl_listener_port[i], ssl_sock[i], true, AF_INET))) {
 # ifndef WIN32
                         if (errno && errno != EINTR && errno != EMFILE && errno != ENFILE) {
@@ -4412,8 +4527,6 @@ shovechars()
                         }
 # endif
                     } else {
-                        update_max_descriptor(newd->descriptor);
-
                         if (tp_ssl_auto_reload_certs)
                             update_server_certificates();
 
@@ -4437,7 +4550,7 @@ shovechars()
 
             /* Iterate over sockets and handle new connections */
             for (int i = 0; i < ssl_numsocks_v6; i++) {
-                if (FD_ISSET(ssl_sock_v6[i], &input_set)) {
+                if (netloop_ready(ssl_sock_v6[i]) & NETLOOP_READ) {
                     if (!(newd = new_connection(ssl_listener_port[i], ssl_sock_v6[i], true, AF_INET6))) {
 # ifndef WIN32
                         if (errno && errno != EINTR && errno != EMFILE && errno != ENFILE) {
@@ -4449,8 +4562,6 @@ shovechars()
                         }
 # endif
                     } else {
-                        update_max_descriptor(newd->descriptor);
-
                         if (tp_ssl_auto_reload_certs)
                             update_server_certificates();
 
@@ -4473,28 +4584,39 @@ shovechars()
             }
 #endif
 #ifdef SPAWN_HOST_RESOLVER
-            if (FD_ISSET(resolver_sock[1], &input_set)) {
+            if (netloop_ready(resolver_sock[1]) & NETLOOP_READ) {
                 resolve_hostnames();
             }
 #endif
+
+            /* Deliver completion events for finished SMTP_SEND mails */
+            smtp_queue_process();
+
+#ifdef ASYNC_HOST_RESOLVER
+            /* Fill in host and user names of connections as they come in */
+            host_resolve_process();
+#endif
+
             cnt = 0;
 
             /* Iterate over descriptors and handle I/O */
             for (struct descriptor_data *d = descriptor_list; d; d = dnext) {
                 dnext = d->next;
 
+                int ready = netloop_ready(d->descriptor);
+
 #ifdef USE_SSL
-                if (FD_ISSET(d->descriptor, &input_set)
+                if ((ready & NETLOOP_READ)
                     || (d->ssl_session && SSL_pending(d->ssl_session))) {
 #else
-                if (FD_ISSET(d->descriptor, &input_set)) {
+                if (ready & NETLOOP_READ) {
 #endif
                     if (!process_input(d)) {
                         d->booted = 1;
                     }
                 }
 
-                if (FD_ISSET(d->descriptor, &output_set) ||
+                if ((ready & NETLOOP_WRITE) ||
                     (d->is_console && !isatty(d->descriptor) &&
                      has_output(d))) {
                     process_output(d);
@@ -4703,6 +4825,129 @@ notify_nolisten(dbref player, const char *msg, int isprivate)
     return retval;
 }
 
+/**
+ * Render a broadcast message for players that do or don't take ANSI
+ *
+ * @private
+ * @param bc the broadcast to render
+ * @param ansi boolean true to keep good ANSI codes, false to strip them all
+ * @return the rendering as described under struct broadcast
+ */
+static const char *
+broadcast_lines(struct broadcast *bc, int ansi)
+{
+    char buf[BUFFER_LEN + 2];
+    char out[BUFFER_LEN + 8];
+    const char *ptr2 = bc->msg;
+    size_t used = 0, size = 0;
+    char *ptr1;
+
+    if (bc->lines[ansi])
+        return bc->lines[ansi];
+
+    /* Split the same way as notify_nolisten */
+    while (*ptr2) {
+        size_t len;
+
+        ptr1 = buf;
+
+        while (*ptr2 && *ptr2 != '\r' && ptr1 < buf + BUFFER_LEN - 1)
+            *(ptr1++) = *(ptr2++);
+
+        while (*ptr2 && *ptr2 != '\r')
+            ptr2++;
+
+        *(ptr1++) = '\r';
+        *(ptr1++) = '\n';
+        *(ptr1++) = '\0';
+
+        if (*ptr2 == '\r')
+            ptr2++;
+
+        if (ansi) {
+            strip_bad_ansi(out, buf);
+        } else {
+            strip_ansi(out, buf);
+        }
+
+        len = strlen(out) + 1;
+
+        /* Leave room for the empty string at the end */
+        if (used + len + 1 > size) {
+            size = (used + len + 1) * 2;
+            bc->lines[ansi] = realloc(bc->lines[ansi], size);
+        }
+
+        memcpy(bc->lines[ansi] + used, out, len);
+        used += len;
+    }
+
+    if (!bc->lines[ansi])
+        bc->lines[ansi] = malloc(1);
+
+    bc->lines[ansi][used] = '\0';
+    return bc->lines[ansi];
+}
+
+/**
+ * Queue a broadcast message to each of a player's connections
+ *
+ * This does for a player what notify_nolisten does, using the renderings
+ * shared by everyone else who hears the message.
+ *
+ * @private
+ * @param bc the broadcast to send
+ * @param player the player to send it to
+ */
+static void
+broadcast_to_player(struct broadcast *bc, dbref player)
+{
+    int *darr;
+    int dcount;
+
+    darr = get_player_descrs(player, &dcount);
+
+    for (int di = 0; di < dcount; di++) {
+        struct descriptor_data *d = descrdata_by_descr(darr[di]);
+
+        for (const char *line = broadcast_lines(bc, wants_ansi(d) ? 1 : 0);
+             *line; line += strlen(line) + 1) {
+            mcp_frame_output_inband(&d->mcpframe, line);
+        }
+    }
+}
+
+/**
+ * Start a broadcast of a message
+ *
+ * Nothing is rendered until a player needs it.  The message must stay
+ * valid until broadcast_free is called.
+ *
+ * @param bc the broadcast to set up
+ * @param msg the message to send
+ */
+void
+broadcast_init(struct broadcast *bc, const char *msg)
+{
+    bc->msg = msg;
+    bc->lines[0] = NULL;
+    bc->lines[1] = NULL;
+}
+
+/**
+ * Free the renderings of a broadcast message
+ *
+ * @param bc the broadcast to clean up
+ */
+void
+broadcast_free(struct broadcast *bc)
+{
+    free(bc->lines[0]);
+    free(bc->lines[1]);
+    bc->lines[0] = NULL;
+    bc->lines[1] = NULL;
+}
+
 /**
  * Filter the message through player's ignore list, and filter NULL messages.
  *
@@ -4801,32 +5046,27 @@ notifyf_nolisten(dbref player, const char *format, ...)
 }
 
 /**
- * This is used by MUF programs to send notifications that process listeners
+ * notify_listeners for one of the recipients of a room broadcast
  *
- * Most (all?) MUF notifications use this call.  However, it is not typically
- * used for non-MUF notifications.
+ * If 'bc' is given, players get its shared renderings of the message
+ * rather than having it split and stripped of ANSI just for them.
+ * Listeners and everything other than players are handled exactly as
+ * notify_listeners does.
  *
- * isprivate only impacts zombies.  If true, then the zombie will get the
- * message regardless of the location of the zombie's owner.  If false, the
- * message will not be sent to the zombie if the owner is in the same room
- * as the zombie.
- *
- * Return value is from notify_filtered if obj is a player/thing, otherwise
- * it is 0.
- *
- * @see notify_filtered
+ * @see notify_listeners
  *
  * @param who the person sending the message
  * @param xprog the program that originated the message
  * @param obj the target of the message
  * @param room the room that the message is sourced in
  * @param msg the message to send
- * @param isprivate boolean, usually false.  See explanation above
+ * @param isprivate boolean, usually false.  See notify_listeners
+ * @param bc the broadcast of 'msg', or NULL to render it just for 'obj'
  * @return boolean result from notify filtered or 0 if obj is not player/thing
  */
 int
-notify_listeners(dbref who, dbref xprog, dbref obj, dbref room,
-                 const char *msg, int isprivate)
+notify_listeners_shared(dbref who, dbref xprog, dbref obj, dbref room,
+                        const char *msg, int isprivate, struct broadcast *bc)
 {
     char buf[BUFFER_LEN];
     dbref ref;
@@ -4885,12 +5125,52 @@ notify_listeners(dbref who, dbref xprog, dbref obj, dbref room,
         }
     }
 
+    if (bc && msg && OBJECT_TYPE(obj) == TYPE_PLAYER) {
+        if (ignore_is_ignoring(obj, who))
+            return 0;
+
+        broadcast_to_player(bc, obj);
+        return 1;
+    }
+
     if (OBJECT_TYPE(obj) == TYPE_PLAYER || OBJECT_TYPE(obj) == TYPE_THING)
         return notify_filtered(who, obj, msg, isprivate);
 
     return 0;
 }
 
+/**
+ * This is used by MUF programs to send notifications that process listeners
+ *
+ * Most (all?) MUF notifications use this call.  However, it is not typically
+ * used for non-MUF notifications.
+ *
+ * isprivate only impacts zombies.  If true, then the zombie will get the
+ * message regardless of the location of the zombie's owner.  If false, the
+ * message will not be sent to the zombie if the owner is in the same room
+ * as the zombie.
+ *
+ * Return value is from notify_filtered if obj is a player/thing, otherwise
+ * it is 0.
+ *
+ * @see notify_filtered
+ *
+ * @param who the person sending the message
+ * @param xprog the program that originated the message
+ * @param obj the target of the message
+ * @param room the room that the message is sourced in
+ * @param msg the message to send
+ * @param isprivate boolean, usually false.  See explanation above
+ * @return boolean result from notify filtered or 0 if obj is not player/thing
+ */
+int
+notify_listeners(dbref who, dbref xprog, dbref obj, dbref room,
+                 const char *msg, int isprivate)
+{
+    return notify_listeners_shared(who, xprog, obj, room, msg, isprivate,
+                                   NULL);
+}
+
 /**
  * Send notification to a DB list starting with 'first' except for 'exception'
  *
@@ -4906,10 +5186,12 @@ void
 notify_except(dbref first, dbref exception, const char *msg, dbref who)
 {
     dbref room, srch;
+    struct broadcast bc;
 
     if (first == NOTHING)
         return;
 
+    broadcast_init(&bc, msg);
     srch = room = LOCATION(first);
 
     if (tp_allow_listeners) {
@@ -4927,9 +5209,12 @@ notify_except(dbref first, dbref exception, const char *msg, dbref who)
     DOLIST(first, first) {
         if ((OBJECT_TYPE(first) != TYPE_ROOM) && (first != exception)) {
             /* don't want excepted player or child rooms to hear */
-            notify_listeners(who, NOTHING, first, LOCATION(who), msg, 0);
+            notify_listeners_shared(who, NOTHING, first, LOCATION(who), msg,
+                                    0, &bc);
         }
     }
+
+    broadcast_free(&bc);
 }
 
 /*
@@ -5051,10 +5336,10 @@ wall_wizards(const char *msg)
     strcpyn(buf, sizeof(buf), msg);
     strcatn(buf, sizeof(buf), "\r\n");
 
-    for (struct descriptor_data *d = descriptor_list; d; d = dnext) {
-        dnext = d->next;
+    for (struct descriptor_data *d = connected_list; d; d = dnext) {
+        dnext = d->con_next;
 
-        if (d->connected && Wizard(d->player)) {
+        if (Wizard(d->player)) {
             queue_ansi(d, buf);
             process_output(d);
         }
@@ -5132,6 +5417,63 @@ write_text_block(struct descriptor_data *d, struct text_block **qp)
     return 1;
 }
 
+#ifndef WIN32
+/**
+ * Write text blocks from a queue with writev(), up to OUTPUT_IOV_MAX at once
+ *
+ * This is for connections without SSL, which can write any number of
+ * blocks with one system call.  Blocks that are written are freed, and
+ * the first block not completely written is advanced past what was.
+ *
+ * Returns 1 if something incomplete written, 0 if write was successful,
+ * and -1 if I/O error
+ *
+ * @private
+ * @param d the descriptor to send the text to
+ * @param queue the queue to process
+ * @return integer, 0 for success, 1 for incomplete write, and -1 on error
+ */
+static int
+writev_text_blocks(struct descriptor_data *d, struct text_queue *queue)
+{
+    struct iovec iov[OUTPUT_IOV_MAX];
+    struct text_block *cur;
+    ssize_t count;
+    int n;
+
+    while (queue->head) {
+        n = 0;
+
+        for (cur = queue->head; cur && n < OUTPUT_IOV_MAX; cur = cur->nxt) {
+            iov[n].iov_base = cur->start;
+            iov[n++].iov_len = cur->nchars;
+        }
+
+        d->last_pinged_at = time(NULL);
+
+        if ((count = writev(d->output_descriptor, iov, n)) < 0)
+            return errno == EWOULDBLOCK ? 1 : -1;
+
+        d->output_size -= count;
+
+        while ((cur = queue->head) && (size_t)count >= cur->nchars) {
+            count -= cur->nchars;
+            queue->head = cur->nxt;
+            queue->lines--;
+            free_text_block(cur);
+        }
+
+        if (count) {
+            cur->nchars -= (size_t)count;
+            cur->start += count;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 /**
  * Write all messages in queue
  *
@@ -5149,6 +5491,13 @@ write_queue(struct descriptor_data * d, struct text_queue *queue)
     int result = 0;
     struct text_block **qp = &queue->head;
 
+#ifndef WIN32
+# ifdef USE_SSL
+    if (!d->ssl_session)
+# endif
+        result = writev_text_blocks(d, queue);
+#endif
+
     /* Iterate over the text queue and write each block */
     while (*qp && result == 0) {
         result = write_text_block(d, qp);
@@ -5372,6 +5721,13 @@ close_sockets(const char *msg)
     }
 
     descriptor_list = descriptor_list_tail = NULL;
+    connected_list = connected_list_tail = NULL;
+
+    if (descr_lookup_table) {
+        memset(descr_lookup_table, 0,
+               sizeof(struct descriptor_data *) * (size_t)descr_lookup_size);
+        descr_lookup_count = 0;
+    }
 
     for (int i = 0; i < numsocks; i++) {
         close(sock[i]);
@@ -5469,6 +5825,8 @@ panic(const char *message)
     char panicfile[2048];
     FILE *f;
 
+    /* Write what is waiting, and the rest as it comes. */
+    log_stop();
     log_status("PANIC: %s", message);
     fprintf(stderr, "PANIC: %s\n", message);
 
@@ -5497,6 +5855,15 @@ panic(const char *message)
         fclose(f);
         log_status("DUMPING: %s (done)", panicfile);
         fprintf(stderr, "DUMPING: %s (done)\n", panicfile);
+
+#ifdef DB_JOURNAL
+        /*
+         * The panic dump has every change, and will be used in place of
+         * the output database, so the journal must not be replayed.
+         */
+        if (!forked_dump_process_flag)
+            journal_discard();
+#endif
     } else {
         perror("CANNOT OPEN PANIC FILE, YOU LOSE");
     }
@@ -5872,12 +6239,8 @@ pdescrnotify(int c, char *outstr)
 int
 pfirstdescr(void)
 {
-    struct descriptor_data* d;
-
-    for (d = descriptor_list_tail; d; d = d->prev) {
-        if (d->connected) {
-            return d->descriptor;
-        }
+    if (connected_list_tail) {
+        return connected_list_tail->descriptor;
     }
 
     return 0;
@@ -5891,12 +6254,8 @@ pfirstdescr(void)
 int
 plastdescr(void)
 {
-    struct descriptor_data* d;
-
-    for (d = descriptor_list; d; d = d->next) {
-        if (d->connected) {
-            return d->descriptor;
-        }
+    if (connected_list) {
+        return connected_list->descriptor;
     }
 
     return 0;
@@ -5915,17 +6274,19 @@ pnextdescr(int c)
 
     d = descrdata_by_descr(c);
 
-    if (d) {
-        d = d->prev;
+    if (d && d->connected) {
+        d = d->con_prev;
+    } else if (d) {
+        /*
+         * Descriptors may be sitting on the welcome screen -- we want to
+         * skip those.  Connected descriptors can go straight to the next
+         * one in the connected list.
+         */
+        do {
+            d = d->prev;
+        } while (d && !d->connected);
     }
 
-    /*
-     * Descriptors may be sitting on the welcome screen -- we want to skip
-     * those.
-     */
-    while (d && (!d->connected))
-        d = d->prev;
-
     if (d) {
         return (d->descriptor);
     }
@@ -5978,6 +6339,7 @@ pset_user(int c, dbref who)
         if (who != NOTHING) {
             d->player = who;
             d->connected = 1;
+            link_connected_descr(d);
             remember_player_descr(who, d->descriptor);
             announce_connect(d->descriptor, who);
         }
@@ -6124,10 +6486,9 @@ partial_pmatch(const char *name)
     if (!name || !*name)
         return AMBIGUOUS;
 
-    d = descriptor_list;
+    d = connected_list;
     while (d) {
-        if (d->connected && (last != d->player)
-            && string_prefix(NAME(d->player), name)) {
+        if ((last != d->player) && string_prefix(NAME(d->player), name)) {
             if (last != NOTHING) {
                 last = AMBIGUOUS;
                 break;
@@ -6136,7 +6497,7 @@ partial_pmatch(const char *name)
             last = d->player;
         }
 
-        d = d->next;
+        d = d->con_next;
     }
 
     return (last);
@@ -6604,6 +6965,9 @@ main(int argc, char **argv)
     char *infile_name;
     char *outfile_name;
     char *num_one_new_passwd = NULL;
+#ifndef DISKBASE
+    int binary_dumps = -1;
+#endif
     char pidstr[SMALL_BUFFER_LEN];
     int nomore_options;
     int sanity_skip;
@@ -6703,6 +7067,22 @@ main(int argc, char **argv)
                 }
 
                 db_conversion_flag = 1;
+#ifndef DISKBASE
+            } else if (!strcmp(argv[i], "-dbformat")) {
+                if (i + 1 >= argc) {
+                    show_program_usage(*argv);
+                }
+
+                i++;
+
+                if (!strcmp(argv[i], "binary")) {
+                    binary_dumps = 1;
+                } else if (!strcmp(argv[i], "text")) {
+                    binary_dumps = 0;
+                } else {
+                    show_program_usage(*argv);
+                }
+#endif
             } else if (!strcmp(argv[i], "-port")) {
                 if (i + 1 >= argc) {
                     show_program_usage(*argv);
@@ -6932,14 +7312,12 @@ main(int argc, char **argv)
     for (unsigned int i = 0; i < numports; i++) {
         sock[i] = make_socket(listener_port[i], AF_INET, &bind_ipv4_address,
                 sizeof(struct sockaddr_in));
-        update_max_descriptor(sock[i]);
         numsocks++;
     }
 
     for (unsigned int i = 0; i < numports; i++) {
         sock_v6[i] = make_socket(listener_port[i], AF_INET6, &bind_ipv6_address,
                 sizeof(struct sockaddr_in6));
-        update_max_descriptor(sock_v6[i]);
         numsocks_v6++;
     }
 
@@ -6947,14 +7325,12 @@ main(int argc, char **argv)
     for (unsigned int i = 0; i < ssl_numports; i++) {
         ssl_sock[i] = make_socket(ssl_listener_port[i], AF_INET, &bind_ipv4_address,
                 sizeof(struct sockaddr_in));
-        update_max_descriptor(ssl_sock[i]);
         ssl_numsocks++;
     }
 
     for (unsigned int i = 0; i < ssl_numports; i++) {
         ssl_sock_v6[i] = make_socket(ssl_listener_port[i], AF_INET6, &bind_ipv6_address,
                                  sizeof(struct sockaddr_in6));
-        update_max_descriptor(ssl_sock_v6[i]);
         ssl_numsocks_v6++;
     }
 #endif
@@ -7001,6 +7377,14 @@ main(int argc, char **argv)
         tune_load_parms_from_file(parmfile, NOTHING, -1);
     }
 
+#ifndef DISKBASE
+    /* This has to come after the DB's own parameters are loaded. */
+    if (binary_dumps >= 0) {
+        tune_setparm(GOD, "dbdump_binary", binary_dumps ? "yes" : "no",
+                     MLEV_GOD);
+    }
+#endif
+
 #ifdef USE_SSL
     /*
      * This should be done after loading parms (from extra file or DB)
@@ -7046,6 +7430,8 @@ main(int argc, char **argv)
         spawn_resolver();
 #endif
 
+        log_start();
+
         /* go do it */
         shovechars();
 
@@ -7091,6 +7477,7 @@ main(int argc, char **argv)
 #endif
 
 #ifdef DISKBASE
+        unmap_propfile();
         fclose(input_file);
 #endif
 
@@ -7098,6 +7485,8 @@ main(int argc, char **argv)
         CrT_summarize_to_file(tp_file_log_malloc, "Shutdown");
 #endif
 
+        log_stop();
+
         if (restart_flag) {
 #ifndef WIN32
             char **argslist;
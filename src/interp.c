@@ -33,6 +33,7 @@
 #endif
 #include "mufevent.h"
 #include "predicates.h"
+#include "profile.h"
 #include "props.h"
 #include "timequeue.h"
 #include "tune.h"
@@ -519,6 +520,24 @@ int prim_count = 0;
  */
 static struct frame *free_frames_list = NULL;
 
+/**
+ * @private
+ * @var the number of frames on free_frames_list
+ */
+static int frames_pooled = 0;
+
+/**
+ * @private
+ * @var the number of frames handed out by alloc_frame and not yet cleaned
+ */
+static int frames_in_use = 0;
+
+/**
+ * @private
+ * @var the memory used by all frames and their stacks, in bytes
+ */
+static size_t frames_bytes = 0;
+
 /**
  * @private
  * @var pool of reusable forvars structures, again for performance reasons.
@@ -543,6 +562,23 @@ static struct tryvars *try_pool = NULL;
  */
 static struct tryvars **last_try = &try_pool;
 
+/**
+ * Free a frame and everything its stacks hold on to
+ *
+ * @private
+ * @param fr the frame to free
+ */
+static void
+free_frame(struct frame *fr)
+{
+    release_retired_stacks(fr);
+    frames_bytes -= frame_memory(fr);
+    free(fr->argument.st);
+    free(fr->system.st);
+    free(fr->caller.st);
+    free(fr);
+}
+
 /**
  * Clean up extra free frames
  *
@@ -565,7 +601,8 @@ purge_free_frames(void)
     while (ptr && ptr->next) {
         ptr2 = ptr->next;
         ptr->next = ptr->next->next;
-        free(ptr2);
+        free_frame(ptr2);
+        frames_pooled--;
     }
 }
 
@@ -584,7 +621,8 @@ purge_all_free_frames(void)
     while (free_frames_list) {
         ptr = free_frames_list;
         free_frames_list = ptr->next;
-        free(ptr);
+        free_frame(ptr);
+        frames_pooled--;
     }
 }
 #endif
@@ -635,6 +673,251 @@ purge_try_pool(void)
     }
 }
 
+/**
+ * Work out the new size of a stack that needs 'count' items
+ *
+ * @private
+ * @param size the current size of the stack
+ * @param count the number of items needed
+ * @return the new size, or 0 if 'count' is over STACK_SIZE
+ */
+static int
+stack_new_size(int size, int count)
+{
+    if (count > STACK_SIZE)
+        return 0;
+
+    if (size < STACK_INITIAL)
+        size = STACK_INITIAL;
+
+    while (size < count)
+        size *= 2;
+
+    return MIN(size, STACK_SIZE);
+}
+
+/**
+ * Make room for at least 'count' items on a frame's argument stack
+ *
+ * The stack is doubled in size until it is big enough.  If 'retire' is
+ * true, the old array is kept until release_retired_stacks() is called
+ * instead of being freed, so that pointers into it stay usable.  This is
+ * what CHECKOFLOW does, as primitives often hold pointers to the items
+ * they popped.
+ *
+ * @param fr the frame
+ * @param count the number of items needed
+ * @param retire boolean if true keep the old array around
+ * @return boolean true if there is room, false if 'count' is over STACK_SIZE
+ */
+int
+grow_argument_stack(struct frame *fr, int count, int retire)
+{
+    struct inst *st;
+    int size;
+
+    if (count <= fr->argument.size)
+        return 1;
+
+    if (!(size = stack_new_size(fr->argument.size, count)))
+        return 0;
+
+    /*
+     * Copy every slot rather than just the top ones, since a primitive's
+     * idea of the top is ahead of fr->argument.top.
+     */
+    st = malloc(sizeof(struct inst) * (size_t)size);
+
+    if (fr->argument.st) {
+        memcpy(st, fr->argument.st,
+               sizeof(struct inst) * (size_t)fr->argument.size);
+    }
+
+    if (retire && fr->argument.st) {
+        struct retired_stack *old = malloc(sizeof(struct retired_stack));
+
+        old->st = fr->argument.st;
+        old->next = fr->argument.retired;
+        fr->argument.retired = old;
+    } else {
+        free(fr->argument.st);
+    }
+
+    frames_bytes += sizeof(struct inst) * (size_t)(size - fr->argument.size);
+    fr->argument.st = st;
+    fr->argument.size = size;
+    return 1;
+}
+
+/**
+ * Free argument stack arrays kept by grow_argument_stack()
+ *
+ * @param fr the frame
+ */
+void
+release_retired_stacks(struct frame *fr)
+{
+    while (fr->argument.retired) {
+        struct retired_stack *old = fr->argument.retired;
+
+        fr->argument.retired = old->next;
+        free(old->st);
+        free(old);
+    }
+}
+
+/**
+ * Make room for at least 'count' items on a frame's system stack
+ *
+ * @param fr the frame
+ * @param count the number of items needed
+ * @return boolean true if there is room, false if 'count' is over STACK_SIZE
+ */
+int
+grow_system_stack(struct frame *fr, int count)
+{
+    int size;
+
+    if (count <= fr->system.size)
+        return 1;
+
+    if (!(size = stack_new_size(fr->system.size, count)))
+        return 0;
+
+    fr->system.st = realloc(fr->system.st,
+                            sizeof(struct stack_addr) * (size_t)size);
+    frames_bytes += sizeof(struct stack_addr) * (size_t)(size - fr->system.size);
+    fr->system.size = size;
+    return 1;
+}
+
+/**
+ * Make room for at least 'count' items on a frame's caller stack
+ *
+ * @param fr the frame
+ * @param count the number of items needed
+ * @return boolean true if there is room, false if 'count' is over STACK_SIZE
+ */
+int
+grow_caller_stack(struct frame *fr, int count)
+{
+    int size;
+
+    if (count <= fr->caller.size)
+        return 1;
+
+    if (!(size = stack_new_size(fr->caller.size, count)))
+        return 0;
+
+    fr->caller.st = realloc(fr->caller.st, sizeof(dbref) * (size_t)size);
+    frames_bytes += sizeof(dbref) * (size_t)(size - fr->caller.size);
+    fr->caller.size = size;
+    return 1;
+}
+
+/**
+ * Get the memory used by a frame and its stacks, in bytes
+ *
+ * @param fr the frame
+ * @return the number of bytes used by 'fr'
+ */
+size_t
+frame_memory(struct frame *fr)
+{
+    return sizeof(struct frame)
+           + sizeof(struct inst) * (size_t)fr->argument.size
+           + sizeof(struct stack_addr) * (size_t)fr->system.size
+           + sizeof(dbref) * (size_t)fr->caller.size;
+}
+
+/**
+ * Get statistics about MUF frames
+ *
+ * 'bytes' covers every frame, including the free frames list, and their
+ * stacks.
+ *
+ * @param inuse set to the number of frames in use
+ * @param pooled set to the number of frames on the free frames list
+ * @param bytes set to the memory used by all frames, in bytes
+ */
+void
+frame_stats(int *inuse, int *pooled, size_t *bytes)
+{
+    *inuse = frames_in_use;
+    *pooled = frames_pooled;
+    *bytes = frames_bytes;
+}
+
+/**
+ * Shrink one of a pooled frame's stacks back to its initial size
+ *
+ * @private
+ * @param st the stack array
+ * @param size the stack size, which is updated
+ * @param itemsize the size of one item
+ * @return the new stack array
+ */
+static void *
+shrink_stack(void *st, int *size, size_t itemsize)
+{
+    if (*size <= STACK_INITIAL)
+        return st;
+
+    frames_bytes -= itemsize * (size_t)(*size - STACK_INITIAL);
+    *size = STACK_INITIAL;
+    return realloc(st, itemsize * STACK_INITIAL);
+}
+
+/**
+ * Get a cleared frame, from the free frames list if there is one
+ *
+ * The frame's stacks are allocated at their initial size and are empty.
+ *
+ * @return the new frame
+ */
+struct frame *
+alloc_frame(void)
+{
+    struct frame *fr;
+    struct stack argument = { 0, 0, NULL, NULL };
+    struct sysstack system = { 0, 0, NULL };
+    struct callstack caller = { 0, 0, NULL };
+
+    if (free_frames_list) {
+        /*
+         * Pooled frames keep their stacks, but give back whatever a
+         * deep program grew them to.
+         */
+        fr = free_frames_list;
+        free_frames_list = fr->next;
+        frames_pooled--;
+
+        release_retired_stacks(fr);
+        argument.st = shrink_stack(fr->argument.st, &fr->argument.size,
+                                   sizeof(struct inst));
+        argument.size = fr->argument.size;
+        system.st = shrink_stack(fr->system.st, &fr->system.size,
+                                 sizeof(struct stack_addr));
+        system.size = fr->system.size;
+        caller.st = shrink_stack(fr->caller.st, &fr->caller.size,
+                                 sizeof(dbref));
+        caller.size = fr->caller.size;
+    } else {
+        fr = malloc(sizeof(struct frame));
+        frames_bytes += sizeof(struct frame);
+    }
+
+    memset(fr, 0, sizeof(struct frame));
+    fr->argument = argument;
+    fr->system = system;
+    fr->caller = caller;
+    grow_argument_stack(fr, STACK_INITIAL, 0);
+    grow_system_stack(fr, STACK_INITIAL);
+    grow_caller_stack(fr, STACK_INITIAL);
+    frames_in_use++;
+    return fr;
+}
+
 /**
  * Set up a frame for MUF program interpretation
  *
@@ -671,14 +954,7 @@ interp(int descr, dbref player, dbref location, dbref program,
     }
 
     /* Grab a pre-allocated frame if we've got one, or allocate a fresh one */
-    if (free_frames_list) {
-        fr = free_frames_list;
-        free_frames_list = fr->next;
-    } else {
-        fr = malloc(sizeof(struct frame));
-    }
-
-    memset(fr, 0, sizeof(struct frame));
+    fr = alloc_frame();
     fr->pid = forced_pid ? forced_pid : top_pid++;
     fr->descr = descr;
     fr->supplicant = NOTHING;
@@ -1170,6 +1446,8 @@ prog_clean(struct frame *fr)
     array_free_all_on_list(&fr->array_active_list);
     fr->next = free_frames_list;
     free_frames_list = fr;
+    frames_in_use--;
+    frames_pooled++;
     err = 0;
 }
 
@@ -1607,6 +1885,51 @@ do_abort_loop(dbref player, dbref program, const char *msg,
     return 0; \
 }
 
+#ifdef MUF_THREADED_DISPATCH
+/**
+ * Jump to the handler for the instruction at pc
+ *
+ * Instruction types without a handler of their own go through the switch.
+ *
+ * @private
+ */
+# define DISPATCH() \
+    goto *((unsigned short) pc->type < ARRAYSIZE(dispatch_table) \
+           ? dispatch_table[pc->type] : &&dispatch_switch)
+
+/**
+ * Label an instruction handler for DISPATCH
+ *
+ * @private
+ * @param name the name of the handler
+ */
+# define DISPATCH_LABEL(name) op_##name:
+#else
+# define DISPATCH() goto dispatch_switch
+# define DISPATCH_LABEL(name)
+#endif
+
+/**
+ * Finish an instruction and go on to the next one
+ *
+ * Until a safepoint is due, this counts the next instruction and goes
+ * straight to it, skipping the checks at the top of the interpreter loop.
+ * Otherwise it leaves the switch, so the loop does those checks.  A
+ * profiler sample also goes through the top of the loop.
+ *
+ * @private
+ */
+#define NEXT_INSTRUCTION \
+{ \
+    if (fast_left > 0 && !profile_sample_due) { \
+        fast_left--; \
+        fr->instcnt++; \
+        instr_count++; \
+        DISPATCH(); \
+    } \
+    break; \
+}
+
 /**
  * The MUF interpreter loop - run a program until it completes or yields
  *
@@ -1624,6 +1947,13 @@ do_abort_loop(dbref player, dbref program, const char *msg,
  *
  * This will parse the instructions using a godawful switch statement.
  *
+ * Checking all of the above before every instruction is slow, so it is
+ * only done at safepoints.  A safepoint works out how many instructions
+ * can run before any limit could be reached, and until then each
+ * instruction goes straight to the next (@see NEXT_INSTRUCTION).  Calls,
+ * returns, and primitives that change what the checks depend on end the
+ * run early.  Debugging turns the shortcut off.
+ *
  * @param player the player running the program
  * @param program the program being run
  * @param fr the frame for the current running program
@@ -1646,6 +1976,41 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
     static struct inst retval;
     char dbuf[BUFFER_LEN];
     int instno_debug_line = get_primitive("debug_line");
+    int fast_left = 0, safe_multitask = 0, safe_nested = 0, limit;
+    object_flag_type watch_flags, safe_flags = 0;
+
+#ifdef MUF_THREADED_DISPATCH
+    static void *const dispatch_table[] = {
+        [PROG_CLEARED] = &&dispatch_switch,
+        [PROG_PRIMITIVE] = &&op_primitive,
+        [PROG_INTEGER] = &&op_push,
+        [PROG_FLOAT] = &&op_push,
+        [PROG_OBJECT] = &&op_push,
+        [PROG_VAR] = &&op_push,
+        [PROG_LVAR] = &&op_push,
+        [PROG_SVAR] = &&op_push,
+        [8] = &&dispatch_switch,     /* not used */
+        [PROG_STRING] = &&op_push,
+        [PROG_FUNCTION] = &&op_function,
+        [PROG_LOCK] = &&op_push,
+        [PROG_ADD] = &&op_push,
+        [PROG_IF] = &&op_if,
+        [PROG_EXEC] = &&op_exec,
+        [PROG_JMP] = &&op_jmp,
+        [PROG_ARRAY] = &&op_push,
+        [PROG_MARK] = &&op_push,
+        [PROG_SVAR_AT] = &&op_svar_at,
+        [PROG_SVAR_AT_CLEAR] = &&op_svar_at,
+        [PROG_SVAR_BANG] = &&op_svar_bang,
+        [PROG_TRY] = &&op_try,
+        [PROG_LVAR_AT] = &&op_lvar_at,
+        [PROG_LVAR_AT_CLEAR] = &&op_lvar_at,
+        [PROG_LVAR_BANG] = &&op_lvar_bang,
+    };
+#endif
+
+    /* Changes to these flags on the program need a safepoint. */
+    watch_flags = FLAG_VALUE('B') | FLAG_VALUE('D') | FLAG_VALUE('Z');
 
     /* Keep track of the depth */
     if (interp_depth == 0) {
@@ -1722,6 +2087,9 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
         fr->instcnt++;
         instr_count++;
 
+        if (profile_sample_due)
+            profile_sample_muf(program, pc, sys, stop);
+
         /*
          * If it is pre-empt, check instruction count, nested loop count,
          * and all.
@@ -1880,7 +2248,44 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                                 NULL, NULL);
         }
 
+        /*
+         * Work out how many more instructions can skip the checks above.
+         * The count stops one short of the first instruction that could
+         * hit a limit, so that instruction comes through here.
+         */
+        safe_flags = FLAGS(program) & watch_flags;
+        safe_multitask = fr->multitask;
+        safe_nested = nested_interp_loop_count;
+
+        if ((safe_flags & (FLAG_VALUE('D') | FLAG_VALUE('Z')))
+            || fr->brkpt.force_debugging) {
+            fast_left = 0;
+        } else {
+            fast_left = MUF_SAFEPOINT_INTERVAL;
+
+            if ((fr->multitask == PREEMPT) || FLAG_CHECK(program, 'B')) {
+                if (mlev == 4)
+                    limit = tp_max_ml4_preempt_count
+                            ? tp_max_ml4_preempt_count - instr_count - 1
+                            : fast_left;
+                else
+                    limit = tp_max_instr_count - instr_count - 1;
+            } else {
+                limit = tp_instr_slice * 4 - fr->instcnt;
+                limit = MAX(limit, tp_instr_slice - instr_count - 1);
+            }
+
+            fast_left = MIN(fast_left, limit);
+
+            if (mlev < 3) {
+                limit = tp_max_instr_count * ((mlev == 2) ? 4 : 1)
+                        - fr->instcnt;
+                fast_left = MIN(fast_left, limit);
+            }
+        }
+
         /* The giant switch to handle instruction types */
+      dispatch_switch:
         switch (pc->type) {
             case PROG_INTEGER: /* These all push something onto the stack */
             case PROG_FLOAT:
@@ -1893,22 +2298,32 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
             case PROG_LOCK:
             case PROG_MARK:
             case PROG_ARRAY:
-                if (atop >= STACK_SIZE)
-                    abort_loop("Stack overflow.", NULL, NULL);
+                DISPATCH_LABEL(push)
+                if (atop >= fr->argument.size) {
+                    if (!grow_argument_stack(fr, atop + 1, 0))
+                        abort_loop("Stack overflow.", NULL, NULL);
+
+                    arg = fr->argument.st;
+                }
 
                 copyinst(pc, arg + atop);
                 pc++;
                 atop++;
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_LVAR_AT: /* Push local variable content onto stack */
             case PROG_LVAR_AT_CLEAR:
+                DISPATCH_LABEL(lvar_at)
                 {
                     struct inst *tmpvar;
                     struct localvars *lv;
 
-                    if (atop >= STACK_SIZE)
-                        abort_loop("Stack overflow.", NULL, NULL);
+                    if (atop >= fr->argument.size) {
+                        if (!grow_argument_stack(fr, atop + 1, 0))
+                            abort_loop("Stack overflow.", NULL, NULL);
+
+                        arg = fr->argument.st;
+                    }
 
                     if (pc->data.number >= MAX_VAR || pc->data.number < 0)
                         abort_loop("Scoped variable number out of range.", NULL,
@@ -1929,9 +2344,10 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                     atop++;
                 }
 
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_LVAR_BANG: /* Implementation ! for local variables */
+                DISPATCH_LABEL(lvar_bang)
                 {
                     struct inst *the_var;
                     struct localvars *lv;
@@ -1955,15 +2371,20 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                     pc++;
                 }
 
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_SVAR_AT: /* Push scoped var onto the stack */
             case PROG_SVAR_AT_CLEAR:
+                DISPATCH_LABEL(svar_at)
                 {
                     struct inst *tmpvar;
 
-                    if (atop >= STACK_SIZE)
-                        abort_loop("Stack overflow.", NULL, NULL);
+                    if (atop >= fr->argument.size) {
+                        if (!grow_argument_stack(fr, atop + 1, 0))
+                            abort_loop("Stack overflow.", NULL, NULL);
+
+                        arg = fr->argument.st;
+                    }
 
                     tmpvar = scopedvar_get(fr, 0, pc->data.number);
 
@@ -1984,9 +2405,10 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                     atop++;
                 }
 
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_SVAR_BANG: /* ! for scoped variables */
+                DISPATCH_LABEL(svar_bang)
                 {
                     struct inst *the_var;
 
@@ -2008,9 +2430,10 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                     pc++;
                 }
 
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_FUNCTION: /* Call a function */
+                DISPATCH_LABEL(function)
                 {
                     int mufargs = pc->data.mufproc->args;
 
@@ -2043,9 +2466,10 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                     pc++;
                 }
 
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_IF: /* Handle if */
+                DISPATCH_LABEL(if)
                 if (atop < 1)
                     abort_loop("Stack Underflow.", NULL, NULL);
 
@@ -2060,25 +2484,32 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                     pc++;
 
                 CLEAR(temp1);
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_EXEC: /* Call another program */
-                if (stop >= STACK_SIZE)
-                    abort_loop("System Stack Overflow", NULL, NULL);
+                DISPATCH_LABEL(exec)
+                if (stop >= fr->system.size) {
+                    if (!grow_system_stack(fr, stop + 1))
+                        abort_loop("System Stack Overflow", NULL, NULL);
+
+                    sys = fr->system.st;
+                }
 
                 sys[stop].progref = program;
                 sys[stop++].offset = pc + 1;
                 pc = pc->data.call;
                 fr->skip_declare = 0; /* Make sure we DON'T skip var decls */
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_JMP: /* JMP implementation */
+                DISPATCH_LABEL(jmp)
                 /* Don't need to worry about skipping scoped var decls here. */
                 /* JMP to a function header can only happen in IN_JMP */
                 pc = pc->data.call;
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_TRY: /* Start of a try block */
+                DISPATCH_LABEL(try)
                 if (atop < 1)
                     abort_loop("Stack Underflow.", NULL, NULL);
 
@@ -2107,12 +2538,13 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
 
                 pc++;
                 CLEAR(temp1);
-                break;
+                NEXT_INSTRUCTION;
 
             case PROG_PRIMITIVE: /*
                                   * It's a primitive -- call the associated
                                   * primitive function.
                                   */
+                DISPATCH_LABEL(primitive)
                 /*
                  * All pc modifiers and stuff like that should stay here,
                  * everything else call with an independent dispatcher.
@@ -2169,7 +2601,16 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                             abort_loop_hard("Internal error.  Invalid address.",
                                             temp1, NULL);
 
-                        if (stop >= STACK_SIZE)
+                        if (stop >= fr->system.size) {
+                            if (!grow_system_stack(fr, stop + 1))
+                                abort_loop("System Stack Overflow", temp1, NULL);
+
+                            sys = fr->system.st;
+                        }
+
+                        if (program != temp1->data.addr->progref &&
+                            fr->caller.top + 1 >= fr->caller.size &&
+                            !grow_caller_stack(fr, fr->caller.top + 2))
                             abort_loop("System Stack Overflow", temp1, NULL);
 
                         sys[stop].progref = program;
@@ -2253,7 +2694,16 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                             && !Linkable(temp1->data.objref))
                             abort_loop("Permission denied", temp1, temp2);
 
-                        if (stop >= STACK_SIZE)
+                        if (stop >= fr->system.size) {
+                            if (!grow_system_stack(fr, stop + 1))
+                                abort_loop("System Stack Overflow", temp1, temp2);
+
+                            sys = fr->system.st;
+                        }
+
+                        if (temp1->data.objref != program &&
+                            fr->caller.top + 1 >= fr->caller.size &&
+                            !grow_caller_stack(fr, fr->caller.top + 2))
                             abort_loop("System Stack Overflow", temp1, temp2);
 
                         sys[stop].progref = program;
@@ -2541,6 +2991,12 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
                         prim_func[pc->data.number - 1] (player, program, mlev,
                                                         pc, arg, &tmp, fr);
                         PROGRAM_DEC_INSTANCES_IN_PRIMITIVE(program);
+
+                        /* CHECKOFLOW may have moved the stack */
+                        arg = fr->argument.st;
+
+                        if (fr->argument.retired)
+                            release_retired_stacks(fr);
 #ifdef DEBUG
                         assert(fr->expect_pop == fr->actual_pop || err);
                         assert(fr->expect_push_to == -1 ||
@@ -2549,7 +3005,15 @@ interp_loop(dbref player, dbref program, struct frame *fr, int rettyp)
 #endif
                         atop = tmp;
                         pc++;
-                        break;
+
+                        /* Did the primitive change anything checked above? */
+                        if (err || !OkObj(player) || fr->brkpt.force_debugging
+                            || (FLAGS(program) & watch_flags) != safe_flags
+                            || fr->multitask != safe_multitask
+                            || nested_interp_loop_count != safe_nested)
+                            break;
+
+                        NEXT_INSTRUCTION;
                 } /* switch */
 
                 break;
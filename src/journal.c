@@ -0,0 +1,439 @@
+/** @file journal.c
+ *
+ * Source for the database change journal.  @see journal.h
+ *
+ * A journal file is a series of batches, each written as:
+ *
+ *     *Batch* <length of the body, as ten digits>
+ *     <db_top>
+ *     #<dbref>
+ *     <the object, just as in a text dump>
+ *     ... more objects ...
+ *     *Commit*
+ *
+ * The body is everything between the "*Batch*" line and the "*Commit*"
+ * line.  Its length is filled in only after the rest of the batch is
+ * written, so a batch cut short by a crash never looks complete.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include "config.h"
+
+#ifdef DB_JOURNAL
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "db.h"
+#include "fbstrings.h"
+#include "flags.h"
+#include "game.h"
+#include "interface.h"
+#include "journal.h"
+#include "log.h"
+#include "player.h"
+#include "tune.h"
+
+#define JOURNAL_BATCH   "*Batch* "      /**< Starts each batch */
+#define JOURNAL_COMMIT  "*Commit*\n"    /**< Ends each batch */
+
+/**
+ * @private
+ * @var boolean true once the journals have been replayed at startup;
+ *      until then, and always when converting, the journal is left alone
+ */
+static bool journal_active = false;
+
+/**
+ * @private
+ * @var the open current journal, or NULL if it isn't open
+ */
+static FILE *journal_file = NULL;
+
+/**
+ * Get the path of one of the journals
+ *
+ * @private
+ * @param buf the buffer to put the path in
+ * @param buflen the size of buf
+ * @param old boolean true for the old journal, false for the current one
+ */
+static void
+journal_path(char *buf, size_t buflen, bool old)
+{
+    snprintf(buf, buflen, "%s.journal%s", dumpfile, old ? ".old" : "");
+}
+
+/**
+ * Close the current journal if it is open
+ *
+ * @private
+ */
+static void
+journal_close(void)
+{
+    if (journal_file) {
+        fclose(journal_file);
+        journal_file = NULL;
+    }
+}
+
+/**
+ * Open the current journal, creating it if need be
+ *
+ * @private
+ * @return the file handle, or NULL if it couldn't be opened
+ */
+static FILE *
+journal_open(void)
+{
+    char path[2048];
+
+    if (journal_file)
+        return journal_file;
+
+    journal_path(path, sizeof(path), false);
+
+    /* Not append mode: the length of each batch is written afterwards. */
+    if ((journal_file = fopen(path, "r+b")) == NULL && errno == ENOENT)
+        journal_file = fopen(path, "w+b");
+
+    if (!journal_file)
+        log_status("JOURNAL: Cannot open %s: %s", path, strerror(errno));
+
+    return journal_file;
+}
+
+/**
+ * Append the changed objects to the journal
+ *
+ * The OBJECT_CHANGED flag is cleared on every object that is written.
+ * Nothing is written if no object has changed.  If the journal cannot be
+ * written, the error is logged and the flags are left alone, so the
+ * objects are tried again next time.
+ */
+void
+journal_flush(void)
+{
+    FILE *f;
+    long start, body, end;
+    int count = 0;
+
+    if (!journal_active || !tp_dump_journal_interval)
+        return;
+
+    for (dbref i = 0; i < db_top; i++) {
+        if (FLAGS(i) & OBJECT_CHANGED)
+            count++;
+    }
+
+    if (!count || (f = journal_open()) == NULL)
+        return;
+
+    fseek(f, 0L, SEEK_END);
+    start = ftell(f);
+
+    fprintf(f, JOURNAL_BATCH "%010ld\n", 0L);
+    body = ftell(f);
+    putref(f, db_top);
+
+    for (dbref i = 0; i < db_top; i++) {
+        if (FLAGS(i) & OBJECT_CHANGED) {
+            fprintf(f, "#%d\n", i);
+            db_write_object(f, i);
+        }
+    }
+
+    end = ftell(f);
+    fputs(JOURNAL_COMMIT, f);
+
+    if (fflush(f) || fseek(f, start, SEEK_SET) < 0
+        || fprintf(f, JOURNAL_BATCH "%010ld\n", end - body) < 0
+        || fflush(f) || fsync(fileno(f))) {
+        log_status("JOURNAL: Cannot write to the journal: %s",
+                   strerror(errno));
+
+        /* Drop the partial batch; the objects are still marked changed. */
+        if (ftruncate(fileno(f), (off_t) start) < 0)
+            log_status("JOURNAL: Cannot truncate the journal: %s",
+                       strerror(errno));
+
+        journal_close();
+        return;
+    }
+
+    for (dbref i = 0; i < db_top; i++) {
+        FLAGS(i) &= ~OBJECT_CHANGED;
+    }
+}
+
+/**
+ * Make sure the database is at least a given size for replaying a batch
+ *
+ * New objects start out as garbage, in case a batch doesn't cover them.
+ *
+ * @private
+ * @param top the db_top the batch was written with
+ */
+static void
+journal_grow(dbref top)
+{
+    dbref oldtop = db_top;
+
+    if (top <= db_top)
+        return;
+
+    db_grow(top);
+
+    for (dbref i = oldtop; i < top; i++) {
+        db_clear_object(i);
+        NAME(i) = alloc_interned("<garbage>");
+        FLAGS(i) = TYPE_GARBAGE;
+    }
+}
+
+/**
+ * Replay the complete batches in a journal file
+ *
+ * Anything after the last complete batch is logged and cut off, so that
+ * batches written later are not stuck behind it.
+ *
+ * @private
+ * @param path the journal file
+ */
+static void
+journal_replay_file(const char *path)
+{
+    FILE *f;
+    char line[SMALL_BUFFER_LEN];
+    long size, good = 0;
+    int batches = 0, objects = 0;
+    const size_t batchlen = strlen(JOURNAL_BATCH);
+    const long commitlen = (long) strlen(JOURNAL_COMMIT);
+
+    if ((f = fopen(path, "rb")) == NULL)
+        return;
+
+    fseek(f, 0L, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+
+    while (fgets(line, sizeof(line), f)
+           && !strncmp(line, JOURNAL_BATCH, batchlen)) {
+        long len = atol(line + batchlen);
+        long body = ftell(f);
+
+        if (len <= 0 || body + len + commitlen > size)
+            break;
+
+        fseek(f, body + len, SEEK_SET);
+
+        if (!fgets(line, sizeof(line), f) || strcmp(line, JOURNAL_COMMIT))
+            break;
+
+        fseek(f, body, SEEK_SET);
+        journal_grow(getref(f));
+
+        while (ftell(f) < body + len) {
+            dbref obj;
+
+            if (getc(f) != NUMBER_TOKEN)
+                break;
+
+            obj = getref(f);
+
+            if (obj < 0 || obj >= db_top)
+                break;
+
+            if (OBJECT_TYPE(obj) == TYPE_PLAYER)
+                player_hash_delete(obj);
+
+            db_free_object(obj);
+            db_read_object(f, obj);
+            objects++;
+        }
+
+        if (ftell(f) != body + len) {
+            log_status("JOURNAL: Bad object in batch %d of %s.",
+                       batches + 1, path);
+            break;
+        }
+
+        good = body + len + commitlen;
+        batches++;
+        fseek(f, good, SEEK_SET);
+    }
+
+    fclose(f);
+
+    log_status("JOURNAL: Replayed %d object(s) in %d batch(es) from %s",
+               objects, batches, path);
+
+    if (good < size) {
+        log_status("JOURNAL: Dropping %ld byte(s) after the last complete "
+                   "batch in %s", size - good, path);
+
+        if (truncate(path, (off_t) good) < 0)
+            log_status("JOURNAL: Cannot truncate %s: %s", path,
+                       strerror(errno));
+    }
+}
+
+/**
+ * Replay the journals for the output database
+ *
+ * This is called by db_read, after the objects are loaded but before the
+ * indexes are built, and replays the old journal and then the current
+ * one.  Only complete batches of changes are replayed.
+ *
+ * Nothing is done when converting a database with -convert, and the
+ * other journal calls do nothing either.
+ */
+void
+journal_replay(void)
+{
+    char path[2048];
+
+    if (db_conversion_flag || !dumpfile)
+        return;
+
+    journal_active = true;
+
+    journal_path(path, sizeof(path), true);
+    journal_replay_file(path);
+
+    journal_path(path, sizeof(path), false);
+    journal_replay_file(path);
+
+    /*
+     * What was just loaded is all on disk already, so only later changes
+     * need to go into the journal.
+     */
+    for (dbref i = 0; i < db_top; i++) {
+        FLAGS(i) &= ~OBJECT_CHANGED;
+    }
+}
+
+/**
+ * Start a new journal for a dump that is about to begin
+ *
+ * The current journal becomes the old journal, which is kept until
+ * the dump finishes.  If the old journal is still there because the last
+ * dump never finished, the current journal is added to the end of it.
+ */
+void
+journal_rotate(void)
+{
+    char path[2048];
+    char oldpath[2048];
+    char buf[BUFFER_LEN];
+    FILE *from, *to;
+    long oldsize;
+    size_t n;
+    int failed = 0;
+
+    if (!journal_active)
+        return;
+
+    journal_close();
+
+    journal_path(path, sizeof(path), false);
+    journal_path(oldpath, sizeof(oldpath), true);
+
+    if (access(path, F_OK))
+        return;
+
+    if (access(oldpath, F_OK)) {
+        if (rename(path, oldpath) < 0)
+            log_status("JOURNAL: Cannot rename %s: %s", path,
+                       strerror(errno));
+
+        return;
+    }
+
+    /* The last dump didn't finish, so the old journal is still needed. */
+    if ((from = fopen(path, "rb")) == NULL) {
+        log_status("JOURNAL: Cannot open %s: %s", path, strerror(errno));
+        return;
+    }
+
+    if ((to = fopen(oldpath, "ab")) == NULL) {
+        log_status("JOURNAL: Cannot open %s: %s", oldpath, strerror(errno));
+        fclose(from);
+        return;
+    }
+
+    fseek(to, 0L, SEEK_END);
+    oldsize = ftell(to);
+
+    while ((n = fread(buf, 1, sizeof(buf), from)) > 0) {
+        if (fwrite(buf, 1, n, to) != n) {
+            failed = 1;
+            break;
+        }
+    }
+
+    failed |= ferror(from);
+    fclose(from);
+    failed |= fclose(to);
+
+    if (failed) {
+        log_status("JOURNAL: Cannot add %s to %s", path, oldpath);
+
+        /* Leave the old journal as it was; the current one still works. */
+        if (truncate(oldpath, (off_t) oldsize) < 0)
+            log_status("JOURNAL: Cannot truncate %s: %s", oldpath,
+                       strerror(errno));
+
+        return;
+    }
+
+    unlink(path);
+}
+
+/**
+ * Note that a forked dump has finished saving the database
+ *
+ * The changes in the old journal are all in the new dump, so the old
+ * journal is removed.
+ */
+void
+journal_dump_done(void)
+{
+    char path[2048];
+
+    if (!journal_active)
+        return;
+
+    journal_path(path, sizeof(path), true);
+    unlink(path);
+}
+
+/**
+ * Remove both journal files
+ *
+ * This is used after the whole database has been saved by the main
+ * process, such as at shutdown or by panic(), when nothing in the journal
+ * is needed any more.
+ */
+void
+journal_discard(void)
+{
+    char path[2048];
+
+    if (!journal_active)
+        return;
+
+    journal_close();
+
+    journal_path(path, sizeof(path), false);
+    unlink(path);
+
+    journal_path(path, sizeof(path), true);
+    unlink(path);
+}
+
+#endif /* DB_JOURNAL */
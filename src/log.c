@@ -6,6 +6,7 @@
  */
 
 #include <ctype.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -13,6 +14,16 @@
 
 #include "config.h"
 
+/*
+ * Log lines are handed to a background thread to write where threads are
+ * available.  The memory profiler keeps its books in unlocked globals, so
+ * everything is written on the main thread when it is turned on.
+ */
+#if defined(HAVE_PTHREAD_H) && !defined(WIN32) && !defined(MALLOC_PROFILING)
+# define LOG_ASYNC
+# include <pthread.h>
+#endif
+
 #include "db.h"
 #include "fbtime.h"
 #include "fbstrings.h"
@@ -21,11 +32,535 @@
 #include "log.h"
 #include "tune.h"
 
+/**
+ * @private
+ * @var an open log file
+ */
+struct log_handle {
+    char *name;     /* The file name, as given by the caller */
+    FILE *fp;       /* The file, opened for appending        */
+};
+
+/**
+ * @private
+ * @var log files kept open between writes, by whichever thread writes them
+ */
+static struct log_handle log_handles[LOG_MAX_FILES];
+
+/**
+ * @private
+ * @var set by log_reopen to make the writer close and reopen its files
+ */
+static volatile sig_atomic_t log_reopen_flag = 0;
+
+/**
+ * @private
+ * @var set while the main thread is in log_line, to catch signal handlers
+ *      that log while it is busy
+ */
+static volatile sig_atomic_t log_busy = 0;
+
+/**
+ * Write a log line the slow way, opening and closing the file around it
+ *
+ * This is the fallback for a line that can't go through the open files,
+ * such as one logged from a signal handler while the main thread was in
+ * the middle of logging.
+ *
+ * Prints to standard error if the file cannot be opened.
+ *
+ * @private
+ * @param filename the file to write to
+ * @param text the line, without a newline
+ */
+static void
+log_append(const char *filename, const char *text)
+{
+    FILE *fp;
+
+    if ((fp = fopen(filename, "ab")) == NULL) {
+        fprintf(stderr, "Unable to open %s!\n", filename);
+        fprintf(stderr, "%s\n", text);
+    } else {
+        fprintf(fp, "%s\n", text);
+        fclose(fp);
+    }
+}
+
+/**
+ * Close all the open log files
+ *
+ * @private
+ */
+static void
+log_close_all(void)
+{
+    for (int i = 0; i < LOG_MAX_FILES; i++) {
+        if (log_handles[i].fp)
+            fclose(log_handles[i].fp);
+
+        free(log_handles[i].name);
+        log_handles[i].name = NULL;
+        log_handles[i].fp = NULL;
+    }
+}
+
+/**
+ * Get an open log file, opening it if need be
+ *
+ * If all the slots are taken, the oldest file is closed to make room.
+ *
+ * @private
+ * @param filename the file to get
+ * @return the file, or NULL if it couldn't be opened
+ */
+static FILE *
+log_open(const char *filename)
+{
+    static int next_slot = 0;
+    struct log_handle *h;
+
+    if (log_reopen_flag) {
+        log_reopen_flag = 0;
+        log_close_all();
+    }
+
+    for (int i = 0; i < LOG_MAX_FILES; i++) {
+        if (log_handles[i].name && !strcmp(log_handles[i].name, filename))
+            return log_handles[i].fp;
+    }
+
+    h = &log_handles[next_slot];
+    next_slot = (next_slot + 1) % LOG_MAX_FILES;
+
+    if (h->fp)
+        fclose(h->fp);
+
+    free(h->name);
+    h->name = NULL;
+
+    if ((h->fp = fopen(filename, "ab")) == NULL) {
+        fprintf(stderr, "Unable to open %s!\n", filename);
+        return NULL;
+    }
+
+    h->name = strdup(filename);
+    return h->fp;
+}
+
+/**
+ * Write a log line through the open log files
+ *
+ * @private
+ * @param filename the file to write to
+ * @param text the line, without a newline
+ * @param len the length of text
+ * @return the file written to, or NULL if it couldn't be opened
+ */
+static FILE *
+log_write(const char *filename, const char *text, size_t len)
+{
+    FILE *fp;
+
+    if ((fp = log_open(filename)) == NULL) {
+        fprintf(stderr, "%.*s\n", (int) len, text);
+        return NULL;
+    }
+
+    fwrite(text, 1, len, fp);
+    fputc('\n', fp);
+    return fp;
+}
+
+#ifdef LOG_ASYNC
+/*
+ * The header of a log line waiting in a buffer.  It is followed by the
+ * file name, with its terminating NUL, and then the text.
+ */
+struct log_record {
+    unsigned int namelen;   /* Length of the name, with the NUL  */
+    unsigned int len;       /* Length of the text                */
+};
+
+/**
+ * @private
+ * @var guards everything below, except log_io_lock
+ */
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @private
+ * @var held by the writer while it writes, so fork() can wait for a
+ *      moment when no file has unflushed data in it
+ */
+static pthread_mutex_t log_io_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @private
+ * @var signalled when there is something for the writer to do
+ */
+static pthread_cond_t log_wake = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @private
+ * @var signalled when the writer has taken the lines waiting
+ */
+static pthread_cond_t log_drained = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @private
+ * @var the writer thread
+ */
+static pthread_t log_thread;
+
+/**
+ * @private
+ * @var true if the writer thread is running
+ */
+static int log_running = 0;
+
+/**
+ * @private
+ * @var true if the writer thread has been asked to finish
+ */
+static int log_stopping = 0;
+
+/**
+ * @private
+ * @var the buffer new lines are added to
+ */
+static char *log_fill = NULL;
+
+/**
+ * @private
+ * @var the number of bytes used in log_fill
+ */
+static size_t log_used = 0;
+
+/**
+ * @private
+ * @var the other buffer, or NULL while the writer is writing it out
+ */
+static char *log_spare = NULL;
+
+/**
+ * @private
+ * @var tp_log_flush_msec, as of the last line added
+ */
+static int log_flush_msec = 0;
+
+/**
+ * Write out a buffer of log lines
+ *
+ * Each file written to is flushed at the end.
+ *
+ * @private
+ * @param buf the buffer
+ * @param used the number of bytes used in buf
+ */
+static void
+log_write_buffer(const char *buf, size_t used)
+{
+    struct log_record rec;
+    const char *p = buf;
+
+    while (p < buf + used) {
+        memcpy(&rec, p, sizeof(rec));
+        p += sizeof(rec);
+        log_write(p, p + rec.namelen, rec.len);
+        p += rec.namelen + rec.len;
+    }
+
+    for (int i = 0; i < LOG_MAX_FILES; i++) {
+        if (log_handles[i].fp)
+            fflush(log_handles[i].fp);
+    }
+}
+
+/**
+ * The body of the writer thread
+ *
+ * It waits for lines to be added, then gives more lines up to
+ * log_flush_msec to arrive before it takes the whole buffer, hands the
+ * other one back, and writes out what it took.  It stops once it has been
+ * asked to and nothing is left.
+ *
+ * @private
+ * @param arg unused
+ * @return NULL
+ */
+static void *
+log_writer(void *arg)
+{
+    struct timespec deadline;
+    char *buf;
+    size_t used;
+
+    (void) arg;
+
+    pthread_mutex_lock(&log_lock);
+
+    for (;;) {
+        while (!log_used && !log_stopping)
+            pthread_cond_wait(&log_wake, &log_lock);
+
+        if (!log_used && log_stopping)
+            break;
+
+        if (log_flush_msec > 0 && !log_stopping) {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += log_flush_msec / 1000;
+            deadline.tv_nsec += (log_flush_msec % 1000) * 1000000L;
+
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            while (log_used < LOG_BUFFER_SIZE / 2 && !log_stopping) {
+                if (pthread_cond_timedwait(&log_wake, &log_lock, &deadline))
+                    break;
+            }
+        }
+
+        buf = log_fill;
+        used = log_used;
+        log_fill = log_spare;
+        log_spare = NULL;
+        log_used = 0;
+        pthread_cond_broadcast(&log_drained);
+        pthread_mutex_unlock(&log_lock);
+
+        pthread_mutex_lock(&log_io_lock);
+
+        if (log_reopen_flag) {
+            log_reopen_flag = 0;
+            log_close_all();
+        }
+
+        log_write_buffer(buf, used);
+        pthread_mutex_unlock(&log_io_lock);
+
+        pthread_mutex_lock(&log_lock);
+        log_spare = buf;
+    }
+
+    pthread_mutex_unlock(&log_lock);
+    return NULL;
+}
+
+/**
+ * Get ready to fork()
+ *
+ * This waits until the writer is between buffers, so no file has data
+ * sitting in it that the child would write out a second time.
+ *
+ * @private
+ */
+static void
+log_prepare_fork(void)
+{
+    pthread_mutex_lock(&log_io_lock);
+    pthread_mutex_lock(&log_lock);
+}
+
+/**
+ * Carry on in the parent after fork()
+ *
+ * @private
+ */
+static void
+log_parent_fork(void)
+{
+    pthread_mutex_unlock(&log_lock);
+    pthread_mutex_unlock(&log_io_lock);
+}
+
+/**
+ * Carry on in the child after fork()
+ *
+ * The writer thread doesn't exist in the child, so the child writes its
+ * lines itself.  Lines waiting in the buffer are the parent's to write.
+ *
+ * @private
+ */
+static void
+log_child_fork(void)
+{
+    log_running = 0;
+    log_used = 0;
+    pthread_mutex_unlock(&log_lock);
+    pthread_mutex_unlock(&log_io_lock);
+}
+
+/**
+ * Add a log line to the buffer for the writer thread
+ *
+ * If the buffer is full, this waits for the writer to take it.
+ *
+ * @private
+ * @param filename the file to write to
+ * @param text the line, without a newline
+ * @param len the length of text
+ */
+static void
+log_queue(const char *filename, const char *text, size_t len)
+{
+    struct log_record rec;
+    size_t size;
+
+    rec.namelen = strlen(filename) + 1;
+
+    if (len > LOG_BUFFER_SIZE - sizeof(rec) - rec.namelen)
+        len = LOG_BUFFER_SIZE - sizeof(rec) - rec.namelen;
+
+    rec.len = len;
+    size = sizeof(rec) + rec.namelen + rec.len;
+
+    pthread_mutex_lock(&log_lock);
+
+    while (log_used + size > LOG_BUFFER_SIZE) {
+        pthread_cond_signal(&log_wake);
+        pthread_cond_wait(&log_drained, &log_lock);
+    }
+
+    memcpy(log_fill + log_used, &rec, sizeof(rec));
+    memcpy(log_fill + log_used + sizeof(rec), filename, rec.namelen);
+    memcpy(log_fill + log_used + sizeof(rec) + rec.namelen, text, rec.len);
+    log_used += size;
+    log_flush_msec = tp_log_flush_msec;
+
+    /* The writer only needs waking for the first line or to hurry up. */
+    if (log_used == size || log_flush_msec <= 0
+        || log_used >= LOG_BUFFER_SIZE / 2)
+        pthread_cond_signal(&log_wake);
+
+    pthread_mutex_unlock(&log_lock);
+}
+#endif /* LOG_ASYNC */
+
+/**
+ * Start writing log lines from a background thread
+ *
+ * Until this is called, and in any process fork()ed after it, log lines
+ * are written to the open files as they are logged.  Afterwards they are
+ * collected in a buffer, and a writer thread writes them out at least
+ * every tp_log_flush_msec milliseconds.
+ *
+ * This should be called after the server has gone into the background,
+ * as the thread would not survive the fork().
+ */
+void
+log_start(void)
+{
+#ifdef LOG_ASYNC
+    static int registered = 0;
+    sigset_t all, old;
+
+    if (log_running)
+        return;
+
+    if (!log_fill) {
+        log_fill = malloc(LOG_BUFFER_SIZE);
+        log_spare = malloc(LOG_BUFFER_SIZE);
+    }
+
+    if (!registered) {
+        pthread_atfork(log_prepare_fork, log_parent_fork, log_child_fork);
+        atexit(log_stop);
+        registered = 1;
+    }
+
+    /* Signals are for the main thread, which the handlers expect. */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    log_stopping = 0;
+    log_running = !pthread_create(&log_thread, NULL, log_writer, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+#endif
+}
+
+/**
+ * Stop the background log writer
+ *
+ * This waits for every line logged so far to be written.  Later lines are
+ * written as they are logged.  It does nothing if the writer isn't
+ * running.
+ */
+void
+log_stop(void)
+{
+#ifdef LOG_ASYNC
+    /* A signal handler that interrupted logging can't wait for the lock. */
+    if (!log_running || log_busy)
+        return;
+
+    pthread_mutex_lock(&log_lock);
+    log_stopping = 1;
+    pthread_cond_signal(&log_wake);
+    pthread_mutex_unlock(&log_lock);
+
+    pthread_join(log_thread, NULL);
+    log_running = 0;
+#endif
+}
+
+/**
+ * Close and reopen the log files
+ *
+ * This is for log rotation: once the old files have been moved away,
+ * this makes the next lines go to new files under the configured names.
+ * It is safe to call from a signal handler.
+ */
+void
+log_reopen(void)
+{
+    log_reopen_flag = 1;
+}
+
+/**
+ * Log a finished line to a file
+ *
+ * The line goes to the writer thread if it is running, or is written
+ * and flushed right away if not.
+ *
+ * @private
+ * @param filename the file to write to
+ * @param text the line, without a newline
+ * @param len the length of text
+ */
+static void
+log_line(const char *filename, const char *text, size_t len)
+{
+    FILE *fp;
+
+    if (log_busy) {
+        log_append(filename, text);
+        return;
+    }
+
+    log_busy = 1;
+
+#ifdef LOG_ASYNC
+    if (log_running) {
+        log_queue(filename, text, len);
+        log_busy = 0;
+        return;
+    }
+#endif
+
+    if ((fp = log_write(filename, text, len)))
+        fflush(fp);
+
+    log_busy = 0;
+}
+
 /**
  * sprintf-style variable argument function for logging to a given file name
  *
- * Used as the underpinning of other log calls.  The file written to will be
- * opened in binary/append mode, then closed after the write.
+ * Used as the underpinning of other log calls.  The file written to is
+ * kept open for the next line, and the line may be written later by the
+ * background writer.
  *
  * Prints to standard error if the file cannot be opened.
  *
@@ -38,31 +573,49 @@
 static void
 vlog2file(int prepend_time, const char *filename, const char *format, va_list args)
 {
-    FILE *fp;
+    static time_t stamp_time = 0;
+    static char stamp[40];
+    char buf[BUFFER_LEN * 2];
+    char *line = buf;
+    size_t start = 0;
+    va_list copy;
     time_t lt;
-    char buf[40];
-    lt = time(NULL);
-    *buf = '\0';
+    int len;
 
-    if ((fp = fopen(filename, "ab")) == NULL) {
-        fprintf(stderr, "Unable to open %s!\n", filename);
+    if (prepend_time) {
+        /* localtime() is slow enough to be worth doing once a second. */
+        if ((lt = time(NULL)) != stamp_time) {
+            stamp_time = lt;
+            strftime(stamp, 32, "%Y-%m-%dT%H:%M:%S", localtime(&lt));
+        }
 
-        if (prepend_time)
-            strftime(buf, 32, "%Y-%m-%dT%H:%M:%S", localtime(&lt));
+        start = (size_t) snprintf(buf, sizeof(buf), "%.32s: ", stamp);
+    }
 
-        fprintf(stderr, "%.32s: ", buf);
-        vfprintf(stderr, format, args);
-    } else {
-        if (prepend_time) {
-            strftime(buf, 32, "%Y-%m-%dT%H:%M:%S", localtime(&lt));
-            fprintf(fp, "%.32s: ", buf);
-        }
+    va_copy(copy, args);
+    len = vsnprintf(buf + start, sizeof(buf) - start, format, args);
 
-        vfprintf(fp, format, args);
-        fprintf(fp, "\n");
+    if (len < 0) {
+        va_end(copy);
+        return;
+    }
 
-        fclose(fp);
+    if ((size_t) len >= sizeof(buf) - start) {
+        if ((line = malloc(start + (size_t) len + 1))) {
+            memcpy(line, buf, start);
+            vsnprintf(line + start, (size_t) len + 1, format, copy);
+        } else {
+            line = buf;
+            len = (int) (sizeof(buf) - start - 1);
+        }
     }
+
+    va_end(copy);
+
+    log_line(filename, line, start + (size_t) len);
+
+    if (line != buf)
+        free(line);
 }
 
 /**
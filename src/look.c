@@ -374,7 +374,8 @@ do_look_at(int descr, dbref player, const char *name, const char *detail)
              */
             int ambig_flag = 0;
             char propname[BUFFER_LEN];
-            PropPtr propadr, pptr, lastmatch = NULL;
+            PropPtr propadr, lastmatch = NULL;
+            PropDirPtr pptr;
 
             /* @TODO This does something that is kind of ... technially
              *       wrong maybe?  Let's say you have a looktrap called
@@ -468,7 +469,8 @@ listprops_wildcard(dbref player, dbref thing, const char *dir, const char *wild,
     char buf[BUFFER_LEN+128];
     char buf2[BUFFER_LEN+256];
     char *ptr, *wldcrd;
-    PropPtr propadr, pptr;
+    PropPtr propadr;
+    PropDirPtr pptr;
     int i, cnt = 0;
     int recurse = 0;
 
@@ -1457,8 +1459,8 @@ do_find(dbref player, const char *name, const char *flags)
  * Like do_find, this is underpinned by the checkflags system.
  * For details of how the flags work, see init_checkflags
  *
- * This does do permission checks.  Like \@find, it iterates over the
- * entire database and supports a lookup cost.
+ * This does do permission checks.  Like \@find, it supports a lookup
+ * cost, but it only has to look at the objects the player owns.
  *
  * @see init_checkflags
  * @see do_find
@@ -1471,7 +1473,9 @@ void
 do_owned(dbref player, const char *name, const char *flags)
 {
     dbref victim;
+    dbref *owned;
     struct flgchkdat check;
+    int count;
     int total = 0;
     int output_type = init_checkflags(player, flags, &check);
 
@@ -1488,13 +1492,17 @@ do_owned(dbref player, const char *name, const char *flags)
     } else
         victim = player;
 
-    for (dbref i = 0; i < db_top; i++) {
-        if ((OWNER(i) == OWNER(victim)) && checkflags(i, check)) {
-            display_objinfo(player, i, output_type);
+    owned = db_copy_referrers(OWNER(victim), REFS_OWNED, &count);
+
+    for (int i = 0; i < count; i++) {
+        if (checkflags(owned[i], check)) {
+            display_objinfo(player, owned[i], output_type);
             total++;
         }
     }
 
+    free(owned);
+
     notify(player, "***End of List***");
     notifyf(player, "%d objects found.", total);
 }
@@ -1564,8 +1572,10 @@ void
 do_entrances(int descr, dbref player, const char *name, const char *flags)
 {
     dbref thing;
+    dbref *linked;
     struct match_data md;
     struct flgchkdat check;
+    int count;
     int total = 0;
     int output_type = init_checkflags(player, flags, &check);
 
@@ -1588,46 +1598,21 @@ do_entrances(int descr, dbref player, const char *name, const char *flags)
 
     init_checkflags(player, flags, &check);
 
-    for (dbref i = 0; i < db_top; i++) {
-        if (checkflags(i, check)) {
-            switch (OBJECT_TYPE(i)) {
-                case TYPE_EXIT:
-                    for (int j = DBFETCH(i)->sp.exit.ndest; j--;) {
-                        if (DBFETCH(i)->sp.exit.dest[j] == thing) {
-                            display_objinfo(player, i, output_type);
-                            total++;
-                        }
-                    }
-
-                    break;
-                case TYPE_PLAYER:
-                    if (PLAYER_HOME(i) == thing) {
-                        display_objinfo(player, i, output_type);
-                        total++;
-                    }
-
-                    break;
-                case TYPE_THING:
-                    if (THING_HOME(i) == thing) {
-                        display_objinfo(player, i, output_type);
-                        total++;
-                    }
-
-                    break;
-                case TYPE_ROOM:
-                    if (DBFETCH(i)->sp.room.dropto == thing) {
-                        display_objinfo(player, i, output_type);
-                        total++;
-                    }
+    /*
+     * Exits linked to 'thing' more than once are listed once for each
+     * link.
+     */
+    linked = db_copy_referrers(thing, REFS_LINKED, &count);
 
-                    break;
-                case TYPE_PROGRAM:
-                case TYPE_GARBAGE:
-                    break;
-            }
+    for (int i = 0; i < count; i++) {
+        if (checkflags(linked[i], check)) {
+            display_objinfo(player, linked[i], output_type);
+            total++;
         }
     }
 
+    free(linked);
+
     notify(player, "***End of List***");
     notifyf(player, "%d objects found.", total);
 }
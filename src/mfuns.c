@@ -1761,18 +1761,14 @@ mfn_online(MFUNARGS)
     int list_limit = MAX_MFUN_LIST_LEN;
     int count = pdescrcount();
     char buf2[BUFFER_LEN];
-    struct descriptor_data* d = descriptor_list_tail;
+    struct descriptor_data* d = connected_list_tail;
 
     if (!(mesgtyp & MPI_ISBLESSED))
         ABORT_MPI("ONLINE", "Permission denied.");
 
     *buf = '\0';
 
-    for ( ; list_limit && d; d = d->prev) {
-        if (!d->connected) {
-            continue;
-        }
-
+    for ( ; list_limit && d; d = d->con_prev) {
         if (*buf)
             strcatn(buf, BUFFER_LEN, "\r");
 
@@ -14,6 +14,9 @@
 #include "boolexp.h"
 #include "commands.h"
 #include "db.h"
+#ifdef DISKBASE
+#include "diskprop.h"
+#endif
 #include "edit.h"
 #include "fbstrings.h"
 #include "fbtime.h"
@@ -24,6 +27,7 @@
 #include "log.h"
 #include "match.h"
 #include "move.h"
+#include "mufcache.h"
 #include "predicates.h"
 #include "props.h"
 #include "timequeue.h"
@@ -172,6 +176,11 @@ enter_room(int descr, dbref player, dbref loc, dbref exit)
         /* go there */
         moveto(player, loc);
 
+#ifdef DISKBASE
+        /* Get the disk reading what look and the propqueues will want. */
+        prefetchprops(loc);
+#endif
+
         if (old != NOTHING) {
             propqueue(descr, player, old, exit, player, NOTHING,
                       DEPART_PROPQUEUE, "Depart", 1, 1);
@@ -1086,8 +1095,11 @@ recycle(int descr, dbref player, dbref thing)
     static int depth = 0;
     dbref first;
     dbref rest;
+    dbref loc;
+    dbref *refs;
     char buf[2048];
     int looplimit;
+    int count;
 
     depth++;
 
@@ -1148,24 +1160,33 @@ recycle(int descr, dbref player, dbref thing)
         case TYPE_PROGRAM:
             snprintf(buf, sizeof(buf), "muf/%d.m", (int) thing);
             unlink(buf);
+            muf_cache_remove(thing);
             break;
     }
 
-    for (rest = 0; rest < db_top; rest++) {
+    /* Take it out of the contents or exits list it is in */
+    if ((loc = LOCATION(thing)) >= 0 && loc < db_top) {
+        if (OBJECT_TYPE(thing) == TYPE_EXIT) {
+            DBSTORE(loc, exits, remove_first(EXITS(loc), thing));
+        } else {
+            DBSTORE(loc, contents, remove_first(CONTENTS(loc), thing));
+        }
+    }
+
+    /* Relink everything that is linked to it */
+    refs = db_copy_referrers(thing, REFS_LINKED, &count);
+
+    for (int i = 0; i < count; i++) {
+        rest = refs[i];
+
+        /* Exits linked to it more than once are listed more than once */
+        if (i > 0 && rest == refs[i - 1])
+            continue;
+
         switch (OBJECT_TYPE(rest)) {
             case TYPE_ROOM:
                 if (DBFETCH(rest)->sp.room.dropto == thing) {
-                    DBFETCH(rest)->sp.room.dropto = NOTHING;
-                    DBDIRTY(rest);
-                }
-
-                if (EXITS(rest) == thing) {
-                    EXITS(rest) = NEXTOBJ(thing);
-                    DBDIRTY(rest);
-                }
-
-                if (OWNER(rest) == thing) {
-                    OWNER(rest) = GOD;
+                    db_set_dropto(rest, NOTHING);
                     DBDIRTY(rest);
                 }
 
@@ -1173,8 +1194,6 @@ recycle(int descr, dbref player, dbref thing)
 
             case TYPE_THING:
                 if (THING_HOME(rest) == thing) {
-                    dbref loc;
-
                     if (PLAYER_HOME(OWNER(rest)) == thing)
                         PLAYER_SET_HOME(OWNER(rest), tp_player_start);
 
@@ -1192,96 +1211,87 @@ recycle(int descr, dbref player, dbref thing)
                     DBDIRTY(rest);
                 }
 
-                if (EXITS(rest) == thing) {
-                    EXITS(rest) = NEXTOBJ(thing);
-                    DBDIRTY(rest);
-                }
-
-                if (OWNER(rest) == thing) {
-                    OWNER(rest) = GOD;
-                    DBDIRTY(rest);
-                }
-
                 break;
 
             case TYPE_EXIT:
                 {
-                    int j;
+                    int ndest = DBFETCH(rest)->sp.exit.ndest;
+                    dbref *dest = malloc(sizeof(dbref) * (size_t)ndest);
+                    int j = 0;
 
-                    for (int i = j = 0; i < DBFETCH(rest)->sp.exit.ndest; i++) {
-                        if ((DBFETCH(rest)->sp.exit.dest)[i] != thing)
-                            (DBFETCH(rest)->sp.exit.dest)[j++]
-                                         = (DBFETCH(rest)->sp.exit.dest)[i];
+                    for (int k = 0; k < ndest; k++) {
+                        if ((DBFETCH(rest)->sp.exit.dest)[k] != thing)
+                            dest[j++] = (DBFETCH(rest)->sp.exit.dest)[k];
                     }
 
-                    if (j < DBFETCH(rest)->sp.exit.ndest) {
+                    if (j < ndest) {
                         SETVALUE(OWNER(rest),
                                  GETVALUE(OWNER(rest)) + tp_link_cost);
                         DBDIRTY(OWNER(rest));
-                        DBFETCH(rest)->sp.exit.ndest = j;
+                        db_set_exit_dests(rest, j, dest);
                         DBDIRTY(rest);
+                    } else {
+                        free(dest);
                     }
                 }
 
-                if (OWNER(rest) == thing) {
-                    OWNER(rest) = GOD;
-                    DBDIRTY(rest);
-                }
-
                 break;
 
             case TYPE_PLAYER:
-                if (OBJECT_TYPE(thing) == TYPE_PROGRAM
-                    && (FLAGS(rest) & INTERACTIVE)
-                    && (PLAYER_CURR_PROG(rest) == thing)) {
-                    if (FLAGS(rest) & READMODE) {
-                        notify(rest,
-                               "The program you were running has been "
-                               "recycled.  Aborting program.");
-                    } else {
-                        free_prog_text(PROGRAM_FIRST(thing));
-                        PROGRAM_SET_FIRST(thing, NULL);
-                        PLAYER_SET_INSERT_MODE(rest, 0);
-                        FLAGS(thing) &= ~INTERNAL;
-                        FLAGS(rest) &= ~INTERACTIVE;
-                        PLAYER_SET_CURR_PROG(rest, NOTHING);
-                        notify(rest,
-                               "The program you were editing has been "
-                               "recycled.  Exiting Editor.");
-                    }
-                }
-
                 if (PLAYER_HOME(rest) == thing) {
                     PLAYER_SET_HOME(rest, tp_player_start);
                     DBDIRTY(rest);
                 }
 
-                if (EXITS(rest) == thing) {
-                    EXITS(rest) = NEXTOBJ(thing);
-                    DBDIRTY(rest);
-                }
+                break;
+        }
+    }
 
-                if (PLAYER_CURR_PROG(rest) == thing)
-                    PLAYER_SET_CURR_PROG(rest, 0);
+    free(refs);
 
-                break;
+    /* Anything it owned, other than players, now belongs to GOD */
+    refs = db_copy_referrers(thing, REFS_OWNED, &count);
 
-            case TYPE_PROGRAM:
-                if (OWNER(rest) == thing) {
-                    OWNER(rest) = GOD;
-                    DBDIRTY(rest);
-                }
+    for (int i = 0; i < count; i++) {
+        if (OBJECT_TYPE(refs[i]) != TYPE_PLAYER) {
+            db_set_owner(refs[i], GOD);
+            DBDIRTY(refs[i]);
         }
+    }
+
+    free(refs);
+
+    /*
+     * Nothing keeps track of who is editing or running a program, so
+     * that still takes a look at every player.
+     */
+    if (OBJECT_TYPE(thing) == TYPE_PROGRAM) {
+        for (rest = 0; rest < db_top; rest++) {
+            if (OBJECT_TYPE(rest) != TYPE_PLAYER)
+                continue;
 
-        /*
-         * if (LOCATION(rest) == thing)
-         *    DBSTORE(rest, location, NOTHING);
-         */
-        if (CONTENTS(rest) == thing)
-            DBSTORE(rest, contents, NEXTOBJ(thing));
+            if ((FLAGS(rest) & INTERACTIVE)
+                && (PLAYER_CURR_PROG(rest) == thing)) {
+                if (FLAGS(rest) & READMODE) {
+                    notify(rest,
+                           "The program you were running has been "
+                           "recycled.  Aborting program.");
+                } else {
+                    free_prog_text(PROGRAM_FIRST(thing));
+                    PROGRAM_SET_FIRST(thing, NULL);
+                    PLAYER_SET_INSERT_MODE(rest, 0);
+                    FLAGS(thing) &= ~INTERNAL;
+                    FLAGS(rest) &= ~INTERACTIVE;
+                    PLAYER_SET_CURR_PROG(rest, NOTHING);
+                    notify(rest,
+                           "The program you were editing has been "
+                           "recycled.  Exiting Editor.");
+                }
+            }
 
-        if (NEXTOBJ(rest) == thing)
-            DBSTORE(rest, next, NEXTOBJ(thing));
+            if (PLAYER_CURR_PROG(rest) == thing)
+                PLAYER_SET_CURR_PROG(rest, 0);
+        }
     }
 
     looplimit = db_top;
@@ -1311,7 +1321,7 @@ recycle(int descr, dbref player, dbref thing)
 
     db_free_object(thing);
     db_clear_object(thing);
-    NAME(thing) = strdup("<garbage>");
+    NAME(thing) = alloc_interned("<garbage>");
     SETDESC(thing, "<recyclable>");
     FLAGS(thing) = TYPE_GARBAGE;
 
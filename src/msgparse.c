@@ -22,6 +22,7 @@
 #include "match.h"
 #include "mfun.h"
 #include "mpi.h"
+#include "profile.h"
 #include "props.h"
 #include "tune.h"
 
@@ -1151,10 +1152,6 @@ msg_unparse_macro(dbref player, dbref what, dbref perms, char *name, int argc,
     rest[p] = '\0';
 }
 
-#ifndef MSGHASHSIZE
-#define MSGHASHSIZE 256
-#endif
-
 /**
  * @private
  * @var hashtable for mapping function names to their index in the mfun_list
@@ -1163,7 +1160,7 @@ msg_unparse_macro(dbref player, dbref what, dbref perms, char *name, int argc,
  *
  * Note: this probably IS threadsafe because this is just for MPI built-ins.
  */
-static hash_tab msghash[MSGHASHSIZE];
+static hash_tab msghash;
 
 /**
  * Get the index of mfun_list for a given function name
@@ -1178,7 +1175,7 @@ static hash_tab msghash[MSGHASHSIZE];
 static int
 find_mfn(const char *name)
 {
-    hash_data *exp = find_hash(name, msghash, MSGHASHSIZE);
+    hash_data *exp = find_hash(name, &msghash);
 
     if (exp)
         return (exp->ival);
@@ -1202,13 +1199,15 @@ insert_mfn(const char *name, int i)
 {
     hash_data hd;
 
-    (void) free_hash(name, msghash, MSGHASHSIZE);
+    (void) free_hash(name, &msghash);
     hd.ival = i;
-    (void) add_hash(name, hd, msghash, MSGHASHSIZE);
+    (void) add_hash(name, hd, &msghash);
 }
 
+static void mpi_cache_purge(void);
+
 /**
- * Purge all the hash entries for MPI functions.
+ * Purge all the hash entries for MPI functions, and the compiled MPI cache.
  *
  * This is used to clean up MPI memory.  It should only be used on server
  * shutdown.
@@ -1216,7 +1215,8 @@ insert_mfn(const char *name, int i)
 void
 purge_mfns(void)
 {
-    kill_hash(msghash, MSGHASHSIZE, 0);
+    kill_hash(&msghash, 0);
+    mpi_cache_purge();
 }
 
 /**
@@ -1328,6 +1328,438 @@ mesg_args(char *wbuf, size_t maxlen, char **argv, char ulv, char sep, char dlv,
     return argc;
 }
 
+#ifndef MPI_CACHE_SIZE
+#define MPI_CACHE_SIZE 512  /* Number of entries; must be a multiple of 2 */
+#endif
+
+#define MPI_CACHE_WAYS 2    /* Entries per hash bucket, most recent first */
+
+#define MPI_SEG_TEXT 0  /* Literal text to copy to the output */
+#define MPI_SEG_CALL 1  /* A function call                    */
+
+#define MPI_CACHE_SEEN     1 /* Looked up once, not compiled yet */
+#define MPI_CACHE_COMPILED 2 /* Compiled, or failed to compile   */
+
+/*
+ * An argument of a compiled MPI function call
+ */
+struct mpi_compiled_arg {
+    char *raw;                  /* The argument text the function gets  */
+    struct mpi_compiled *prog;  /* 'raw' compiled, if the function wants
+                                 * its arguments parsed and 'raw' could be
+                                 * compiled.  May be NULL.
+                                 */
+};
+
+/*
+ * One piece of a compiled MPI string
+ */
+struct mpi_segment {
+    int type;                   /* MPI_SEG_TEXT or MPI_SEG_CALL           */
+    char *text;                 /* The literal text, or the function name
+                                 * as written for calls
+                                 */
+    int len;                    /* Length of the literal text             */
+    int fn;                     /* Index into mfun_list for calls         */
+    int varflag;                /* True if this is a {&var} reference     */
+    int argc;                   /* Number of arguments, not counting var  */
+    struct mpi_compiled_arg *args;  /* The arguments                      */
+};
+
+/*
+ * A compiled MPI string
+ *
+ * This is the result of doing all of mesg_parse's scanning up front:
+ * escapes and literal quoting are resolved, function names are looked up
+ * in mfun_list, and arguments are split.  Arguments that mesg_parse would
+ * parse before calling the function are compiled too.
+ */
+struct mpi_compiled {
+    int refcnt;                 /* References from the cache and from
+                                 * evaluations in progress
+                                 */
+    int srclen;                 /* Length of the source string */
+    int segc;                   /* Number of segments          */
+    struct mpi_segment *segs;   /* The segments, in order      */
+};
+
+/*
+ * An entry in the compiled MPI cache
+ */
+struct mpi_cache_entry {
+    unsigned int hash;          /* Hash of 'src'                          */
+    int state;                  /* MPI_CACHE_SEEN or MPI_CACHE_COMPILED   */
+    char *src;                  /* The MPI source string, or NULL if empty */
+    struct mpi_compiled *prog;  /* The compiled source, or NULL           */
+};
+
+/**
+ * @private
+ * @var cache of compiled MPI strings, indexed by a hash of the source
+ *
+ * The cache is split into buckets of MPI_CACHE_WAYS entries, so two busy
+ * strings that hash alike don't keep evicting each other.  Entries are
+ * keyed by the full MPI text, so changing a property simply stops its old
+ * text from being looked up; the stale entry ages out of its bucket.
+ *
+ * This is NOT threadsafe.
+ */
+static struct mpi_cache_entry mpi_cache[MPI_CACHE_SIZE];
+
+/**
+ * Release a reference to compiled MPI, freeing it if it was the last one
+ *
+ * @private
+ * @param prog the compiled MPI, may be NULL
+ */
+static void
+mpi_compiled_release(struct mpi_compiled *prog)
+{
+    if (!prog || --prog->refcnt > 0)
+        return;
+
+    for (int i = 0; i < prog->segc; i++) {
+        struct mpi_segment *seg = &prog->segs[i];
+
+        for (int j = 0; j < seg->argc; j++) {
+            free(seg->args[j].raw);
+            mpi_compiled_release(seg->args[j].prog);
+        }
+
+        free(seg->args);
+        free(seg->text);
+    }
+
+    free(prog->segs);
+    free(prog);
+}
+
+/**
+ * Add a new, zeroed segment to compiled MPI
+ *
+ * @private
+ * @param prog the compiled MPI to add to
+ * @param segsize pointer to the allocated number of segments
+ * @return the new segment
+ */
+static struct mpi_segment *
+mpi_compiled_add_segment(struct mpi_compiled *prog, int *segsize)
+{
+    if (prog->segc >= *segsize) {
+        *segsize = *segsize ? *segsize * 2 : 4;
+        prog->segs = realloc(prog->segs,
+                             sizeof(struct mpi_segment) * (size_t)*segsize);
+
+        if (!prog->segs) {
+            panic("mpi_compiled_add_segment(): Out of memory");
+        }
+    }
+
+    memset(&prog->segs[prog->segc], 0, sizeof(struct mpi_segment));
+    return &prog->segs[prog->segc++];
+}
+
+/**
+ * Add pending literal text to compiled MPI as a text segment
+ *
+ * @private
+ * @param prog the compiled MPI to add to
+ * @param segsize pointer to the allocated number of segments
+ * @param text the literal text
+ * @param len pointer to the length of the text, which is reset to 0
+ */
+static void
+mpi_compiled_add_text(struct mpi_compiled *prog, int *segsize,
+                      const char *text, int *len)
+{
+    struct mpi_segment *seg;
+
+    if (!*len)
+        return;
+
+    seg = mpi_compiled_add_segment(prog, segsize);
+    seg->type = MPI_SEG_TEXT;
+    seg->len = *len;
+    seg->text = malloc((size_t)*len + 1);
+
+    if (!seg->text) {
+        panic("mpi_compiled_add_text(): Out of memory");
+    }
+
+    memcpy(seg->text, text, (size_t)*len);
+    seg->text[*len] = '\0';
+    *len = 0;
+}
+
+/**
+ * Compile an MPI string
+ *
+ * This scans the string exactly the way mesg_parse does, but records what
+ * it finds instead of running it.  Anything whose meaning can only be
+ * known at run time makes the compile fail, so that mesg_parse will fall
+ * back to interpreting the string.  That is the case for macros and
+ * unknown function names, unterminated function calls, a trailing lone
+ * backslash, and strings too long to be parsed in full.
+ *
+ * @private
+ * @param inbuf the MPI string to compile
+ * @param depth how deeply nested this argument is, 0 for the top level
+ * @return the compiled MPI with a reference count of 1, or NULL
+ */
+static struct mpi_compiled *
+mpi_compile(const char *inbuf, int depth)
+{
+    char wbuf[BUFFER_LEN];
+    char cmdbuf[MAX_MFUN_NAME_LEN + 2];
+    char *argv[10] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                       NULL };
+    struct mpi_compiled *prog;
+    char *text;
+    const char *ptr;
+    int srclen = (int)strlen(inbuf);
+    int textlen = 0;
+    int segsize = 0;
+    int literalflag = 0;
+    int failed = 0;
+    int s;
+
+    if (srclen >= BUFFER_LEN - 1 || depth > MPI_RECURSION_LIMIT)
+        return NULL;
+
+    strcpyn(wbuf, sizeof(wbuf), inbuf);
+    text = malloc((size_t)srclen + 1);
+    prog = calloc(1, sizeof(struct mpi_compiled));
+
+    if (!text || !prog) {
+        panic("mpi_compile(): Out of memory");
+    }
+
+    prog->refcnt = 1;
+    prog->srclen = srclen;
+
+    for (int p = 0; wbuf[p] && !failed; p++) {
+        if (wbuf[p] == '\\') {  /* Escape character */
+            p++;
+
+            if (wbuf[p] == 'r') {
+                text[textlen++] = '\r';
+            } else if (wbuf[p] == '[') {
+                text[textlen++] = ESCAPE_CHAR;
+            } else if (wbuf[p]) {
+                text[textlen++] = wbuf[p];
+            } else {
+                failed = 1;
+            }
+        } else if (wbuf[p] == MFUN_LITCHAR) { /* Toggle literalness */
+            literalflag = (!literalflag);
+        } else if (!literalflag && wbuf[p] == MFUN_LEADCHAR) {
+            if (wbuf[p + 1] == MFUN_LEADCHAR) {
+                /* This is an escaped entry brace */
+                text[textlen++] = wbuf[p++];
+                continue;
+            }
+
+            /* Figure out what function and arguments */
+            ptr = wbuf + (++p);
+            s = 0;
+
+            while (wbuf[p] && wbuf[p] != MFUN_LEADCHAR &&
+                   !isspace(wbuf[p]) && wbuf[p] != MFUN_ARGSTART &&
+                   wbuf[p] != MFUN_ARGEND && s <= MAX_MFUN_NAME_LEN) {
+                p++;
+                s++;
+            }
+
+            if ( ( s <= MAX_MFUN_NAME_LEN ||
+                  ( s <= MAX_MFUN_NAME_LEN + 1 && *ptr == '&' ) ) &&
+                (wbuf[p] == MFUN_ARGSTART || wbuf[p] == MFUN_ARGEND)) {
+                struct mpi_segment *seg;
+                int varflag = 0;
+                int argc = 0;
+
+                strncpy(cmdbuf, ptr, (size_t)s);
+                cmdbuf[s] = '\0';
+
+                if (*cmdbuf == '&') {
+                    s = find_mfn("sublist");
+                    varflag = 1;
+                } else if (*cmdbuf) {
+                    s = find_mfn(cmdbuf);
+                } else {
+                    s = 0;
+                }
+
+                /* Macros and unknown functions are resolved at run time */
+                if (!s) {
+                    failed = 1;
+                    break;
+                }
+
+                s--;
+
+                if (wbuf[p] != MFUN_ARGEND) {
+                    argc = mesg_args((wbuf + p + 1),
+                                     ((sizeof(wbuf) - (size_t)p) - 1),
+                                     &argv[(varflag ? 1 : 0)],
+                                     MFUN_LEADCHAR, MFUN_ARGSEP,
+                                     MFUN_ARGEND, MFUN_LITCHAR,
+                                     (mfun_list[s].maxargs < 0) ?
+                                     (-mfun_list[s].maxargs) +
+                                     (varflag ? 1 : 0) :
+                                     (varflag ? 8 : 9));
+
+                    /*
+                     * mesg_args frees what it found on an error, but
+                     * doesn't clear argv.
+                     */
+                    if (argc == -1) {
+                        for (int i = 0; i < 10; i++) {
+                            argv[i] = NULL;
+                        }
+
+                        failed = 1;
+                        break;
+                    }
+                }
+
+                mpi_compiled_add_text(prog, &segsize, text, &textlen);
+                seg = mpi_compiled_add_segment(prog, &segsize);
+                seg->type = MPI_SEG_CALL;
+                seg->text = strdup(cmdbuf);
+                seg->fn = s;
+                seg->varflag = varflag;
+                seg->argc = argc;
+
+                if (argc) {
+                    seg->args = calloc((size_t)argc,
+                                       sizeof(struct mpi_compiled_arg));
+
+                    if (!seg->args) {
+                        panic("mpi_compile(): Out of memory");
+                    }
+                }
+
+                for (int i = 0; i < argc; i++) {
+                    char *raw = argv[i + varflag];
+
+                    argv[i + varflag] = NULL;
+
+                    if (mfun_list[s].stripp) {
+                        seg->args[i].raw = strdup(stripspaces(raw));
+                        free(raw);
+                    } else {
+                        seg->args[i].raw = raw;
+                    }
+
+                    if (mfun_list[s].parsep) {
+                        seg->args[i].prog = mpi_compile(seg->args[i].raw,
+                                                        depth + 1);
+                    }
+                }
+            } else {
+                /* Not a function call; the text is copied as is */
+                ptr--;
+
+                for (int i = s + 1; *ptr && i--; ) {
+                    text[textlen++] = *(ptr++);
+                }
+
+                p = (int) (ptr - wbuf) - 1;
+            }
+        } else {
+            text[textlen++] = wbuf[p];
+        }
+    }
+
+    if (failed) {
+        free(text);
+        mpi_compiled_release(prog);
+        return NULL;
+    }
+
+    mpi_compiled_add_text(prog, &segsize, text, &textlen);
+    free(text);
+    return prog;
+}
+
+/**
+ * Find the compiled form of an MPI string in the cache
+ *
+ * Strings are only compiled the second time they are looked up, so that
+ * one-off strings such as the results of other MPI functions don't pay
+ * for a compile they will never use.  If a string cannot be compiled,
+ * that is remembered as well.
+ *
+ * The returned pointer is owned by the cache; take a reference if it
+ * needs to outlive further cache lookups.
+ *
+ * @private
+ * @param src the MPI string
+ * @return the compiled MPI or NULL if it is not (or cannot be) compiled
+ */
+static struct mpi_compiled *
+mpi_cache_lookup(const char *src)
+{
+    struct mpi_cache_entry *bucket;
+    unsigned int hash = 2166136261U;
+    size_t len = 0;
+
+    for (const char *s = src; *s; s++, len++) {
+        hash = (hash ^ (unsigned char)*s) * 16777619U;
+    }
+
+    if (len >= BUFFER_LEN - 1)
+        return NULL;
+
+    bucket = &mpi_cache[(hash % (MPI_CACHE_SIZE / MPI_CACHE_WAYS))
+                        * MPI_CACHE_WAYS];
+
+    for (int i = 0; i < MPI_CACHE_WAYS; i++) {
+        if (bucket[i].src && bucket[i].hash == hash
+            && !strcmp(bucket[i].src, src)) {
+            struct mpi_cache_entry hit = bucket[i];
+
+            /* Move it to the front of its bucket */
+            memmove(bucket + 1, bucket, (size_t)i * sizeof(struct mpi_cache_entry));
+
+            if (hit.state == MPI_CACHE_SEEN) {
+                hit.prog = mpi_compile(src, 0);
+                hit.state = MPI_CACHE_COMPILED;
+            }
+
+            bucket[0] = hit;
+            return hit.prog;
+        }
+    }
+
+    /* Replace the least recently used entry */
+    free(bucket[MPI_CACHE_WAYS - 1].src);
+    mpi_compiled_release(bucket[MPI_CACHE_WAYS - 1].prog);
+    memmove(bucket + 1, bucket,
+            (MPI_CACHE_WAYS - 1) * sizeof(struct mpi_cache_entry));
+    bucket[0].hash = hash;
+    bucket[0].state = MPI_CACHE_SEEN;
+    bucket[0].src = strdup(src);
+    bucket[0].prog = NULL;
+    return NULL;
+}
+
+/**
+ * Empty the compiled MPI cache
+ *
+ * @private
+ */
+static void
+mpi_cache_purge(void)
+{
+    for (int i = 0; i < MPI_CACHE_SIZE; i++) {
+        free(mpi_cache[i].src);
+        mpi_compiled_release(mpi_cache[i].prog);
+        mpi_cache[i].src = NULL;
+        mpi_cache[i].prog = NULL;
+    }
+}
+
 /**
  * @private
  * @var keep track of MPI recursion level.  This is NOT threadsafe
@@ -1340,6 +1772,10 @@ static int mesg_rec_cnt = 0;
  */
 static int mesg_instr_cnt = 0;
 
+static char *mesg_parse_compiled(int descr, dbref player, dbref what,
+                                 dbref perms, struct mpi_compiled *prog,
+                                 char *outbuf, int maxchars, int mesgtyp);
+
 /**
  * Parse an MPI message
  *
@@ -1376,6 +1812,16 @@ mesg_parse(int descr, dbref player, dbref what, dbref perms, const char *inbuf,
     int showtextflag = 0;
     int literalflag = 0;
 
+    /* Run the compiled form if we have one, unless we are debugging */
+    if (tp_mpi_compile_cache && !(mesgtyp & MPI_ISDEBUG)) {
+        struct mpi_compiled *prog = mpi_cache_lookup(inbuf);
+
+        if (prog && prog->srclen < maxchars - 1) {
+            return mesg_parse_compiled(descr, player, what, perms, prog,
+                                       outbuf, maxchars, mesgtyp);
+        }
+    }
+
     mesg_rec_cnt++;
 
     if (mesg_rec_cnt > MPI_RECURSION_LIMIT) {
@@ -1724,9 +2170,12 @@ mesg_parse(int descr, dbref player, dbref what, dbref perms, const char *inbuf,
                             return NULL;
                         } else {
                             /* Good to go! */
+                            profile_mpi_enter(what, (varflag ? cmdbuf :
+                                                     mfun_list[s].name));
                             ptr = mfun_list[s].mfn(descr, player, what, perms,
                                                    argc, argv, buf, sizeof(buf),
                                                    mesgtyp);
+                            profile_mpi_leave();
 
                             if (!ptr) {
                                 outbuf[q] = '\0';
@@ -1884,6 +2333,212 @@ mesg_parse(int descr, dbref player, dbref what, dbref perms, const char *inbuf,
     return (outbuf);
 }
 
+/**
+ * Run compiled MPI
+ *
+ * This does what mesg_parse does for the string 'prog' was compiled from,
+ * with the same checks, error messages, and output truncation, but
+ * without scanning the string again.  MPI debugging is not supported
+ * here; mesg_parse always interprets the string when it is on.
+ *
+ * @private
+ * @param descr the descriptor of the user running the parser
+ * @param player the player running the parser
+ * @param what the triggering object
+ * @param perms the object that dictates the permission
+ * @param prog the compiled MPI to run
+ * @param outbuf the output buffer
+ * @param maxchars the maximum size of the output buffer
+ * @param mesgtyp permission bitvector
+ * @return NULL on failure, outbuf on success
+ */
+static char *
+mesg_parse_compiled(int descr, dbref player, dbref what, dbref perms,
+                    struct mpi_compiled *prog, char *outbuf, int maxchars,
+                    int mesgtyp)
+{
+    char buf[BUFFER_LEN];
+    char *argv[10];
+    const char *ptr;
+    char *dptr;
+    char *result = outbuf;
+    int argc = 0;
+    int q = 0;
+
+    mesg_rec_cnt++;
+
+    if (mesg_rec_cnt > MPI_RECURSION_LIMIT) {
+        char *zptr = get_mvar("how");
+        notifyf_nolisten(player, "%s Recursion limit exceeded.", zptr);
+        mesg_rec_cnt--;
+        outbuf[0] = '\0';
+        return NULL;
+    }
+
+    /* Sanity check player */
+    if (OBJECT_TYPE(player) == TYPE_GARBAGE) {
+        mesg_rec_cnt--;
+        outbuf[0] = '\0';
+        return NULL;
+    }
+
+    /* Sanity check trigger */
+    if (OBJECT_TYPE(what) == TYPE_GARBAGE) {
+        notify_nolisten(player, "MPI Error: Garbage trigger.", 1);
+        mesg_rec_cnt--;
+        outbuf[0] = '\0';
+        return NULL;
+    }
+
+    /* Functions we call may replace it in the cache */
+    prog->refcnt++;
+
+    for (int n = 0; n < prog->segc && result && q < (maxchars - 1); n++) {
+        struct mpi_segment *seg = &prog->segs[n];
+        struct mfun_dat *mfn;
+        const char *fname;
+
+        if (seg->type == MPI_SEG_TEXT) {
+            int len = seg->len;
+
+            if (len > maxchars - 1 - q)
+                len = maxchars - 1 - q;
+
+            memcpy(outbuf + q, seg->text, (size_t)len);
+            q += len;
+            continue;
+        }
+
+        mfn = &mfun_list[seg->fn];
+        fname = seg->varflag ? seg->text : mfn->name;
+
+        /* Have we run out of instructions? */
+        if (++mesg_instr_cnt > tp_mpi_max_commands) {
+            notifyf_nolisten(player, "%s %c%s%c: Instruction limit exceeded.",
+                             get_mvar("how"), MFUN_LEADCHAR, fname,
+                             MFUN_ARGEND);
+            result = NULL;
+            break;
+        }
+
+        /* Fresh copies, since functions may modify their arguments */
+        argc = 0;
+
+        if (seg->varflag) {
+            char *zptr = get_mvar(seg->text + 1);
+
+            if (!zptr) {
+                notifyf_nolisten(player, "%s %c%s%c: Unrecognized variable.",
+                                 get_mvar("how"), MFUN_LEADCHAR, seg->text,
+                                 MFUN_ARGEND);
+                result = NULL;
+                break;
+            }
+
+            argv[argc++] = strdup(zptr);
+        }
+
+        for (int i = 0; i < seg->argc; i++) {
+            argv[argc++] = strdup(seg->args[i].raw);
+        }
+
+        /* Parse the arguments if we are asked to do so by the function. */
+        if (mfn->parsep) {
+            for (int i = 0; i < seg->argc && result; i++) {
+                int ai = i + seg->varflag;
+
+                if (seg->args[i].prog) {
+                    ptr = mesg_parse_compiled(descr, player, what, perms,
+                                              seg->args[i].prog, buf,
+                                              sizeof(buf), mesgtyp);
+                } else {
+                    ptr = MesgParse(argv[ai], buf, sizeof(buf));
+                }
+
+                if (!ptr) {
+                    notifyf_nolisten(player, "%s %c%s%c (arg %d)",
+                                     get_mvar("how"), MFUN_LEADCHAR, fname,
+                                     MFUN_ARGEND, ai + 1);
+                    result = NULL;
+                    break;
+                }
+
+                argv[ai] = realloc(argv[ai], strlen(buf) + 1);
+                strcpyn(argv[ai], strlen(buf) + 1, buf);
+            }
+
+            if (!result)
+                break;
+        }
+
+        if (argc < mfn->minargs) {
+            notifyf_nolisten(player, "%s %c%s%c: Too few arguments.",
+                             get_mvar("how"), MFUN_LEADCHAR, fname,
+                             MFUN_ARGEND);
+            result = NULL;
+            break;
+        } else if (mfn->maxargs > 0 && argc > mfn->maxargs) {
+            notifyf_nolisten(player, "%s %c%s%c: Too many arguments.",
+                             get_mvar("how"), MFUN_LEADCHAR, fname,
+                             MFUN_ARGEND);
+            result = NULL;
+            break;
+        }
+
+        profile_mpi_enter(what, fname);
+        ptr = mfn->mfn(descr, player, what, perms, argc, argv, buf,
+                       sizeof(buf), mesgtyp);
+        profile_mpi_leave();
+
+        if (!ptr) {
+            result = NULL;
+            break;
+        }
+
+        /* Parse the output, if requested by function */
+        if (mfn->postp) {
+            dptr = MesgParse(ptr, buf, sizeof(buf));
+
+            if (!dptr) {
+                notifyf_nolisten(player, "%s %c%s%c (returned string)",
+                                 get_mvar("how"), MFUN_LEADCHAR, fname,
+                                 MFUN_ARGEND);
+                result = NULL;
+                break;
+            }
+
+            ptr = dptr;
+        }
+
+        while (*ptr && q < (maxchars - 1)) {
+            outbuf[q++] = *(ptr++);
+        }
+
+        for (int i = 0; i < argc; i++) {
+            free(argv[i]);
+        }
+
+        argc = 0;
+    }
+
+    /* Anything left over if we bailed out of a function call */
+    for (int i = 0; i < argc; i++) {
+        free(argv[i]);
+    }
+
+    mpi_compiled_release(prog);
+    mesg_rec_cnt--;
+
+    if (!result) {
+        outbuf[0] = '\0';
+        return NULL;
+    }
+
+    outbuf[q] = '\0';
+    outbuf[maxchars - 1] = '\0';
+    return outbuf;
+}
+
 /**
  * The guts of do_parse_mesg, which does not include stat accounting items
  *
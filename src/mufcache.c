@@ -0,0 +1,779 @@
+/** @file mufcache.c
+ *
+ * Source for the on-disk cache of compiled MUF programs.
+ *
+ * Compiling a large library can take a noticeable amount of time, and it
+ * has to be done again after every restart and \@uncompile.  To avoid
+ * that, successfully compiled programs are written to muf/<dbref>.mc, and
+ * do_compile loads that file instead of compiling when it can.
+ *
+ * A cache file records everything the compiled code depends on:
+ *
+ * - the server build, through VERSION and the list of primitive names,
+ *   since compiled code refers to primitives by number;
+ * - the @tune settings that change how code is compiled;
+ * - a hash of the source text and the program's owner;
+ * - a hash of the _defs/ of every object whose definitions were included.
+ *
+ * If any of them differ, the file is ignored and the program is compiled
+ * as normal, which writes a new file.  Programs using $ifcancall, $iflib or
+ * $ifver are never cached, as those look at other programs in ways the
+ * cache can't check.
+ *
+ * The file format is native byte order; a file from a different kind of
+ * machine is simply ignored.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+# include <unistd.h>
+#endif
+
+#include "config.h"
+
+#include "db.h"
+#include "fbstrings.h"
+#include "game.h"
+#include "inst.h"
+#include "interp.h"
+#include "log.h"
+#include "mufcache.h"
+#include "props.h"
+#include "tune.h"
+
+#define MUF_CACHE_MAGIC     "FBMUFC1"   /**< Start of every cache file */
+#define MUF_CACHE_BYTEORDER 0x01020304  /**< Detects foreign byte order */
+#define MUF_CACHE_MAXSTR    (BUFFER_LEN * 4)    /**< Longest string read */
+
+/**
+ * @private
+ * @var signature of this server build; 0 until first computed
+ */
+static uint64_t muf_cache_build = 0;
+
+/**
+ * Add a string to a 64-bit FNV-1a hash
+ *
+ * @private
+ * @param hash the hash so far
+ * @param s the string to add; NULL is treated as an empty string
+ * @return the new hash
+ */
+static uint64_t
+muf_cache_hash(uint64_t hash, const char *s)
+{
+    if (s) {
+        while (*s) {
+            hash = (hash ^ (unsigned char) *s++) * 1099511628211ULL;
+        }
+    }
+
+    /* Terminate each string so "ab" "c" and "a" "bc" hash differently. */
+    return (hash ^ 0xff) * 1099511628211ULL;
+}
+
+/**
+ * The starting value for muf_cache_hash
+ */
+#define MUF_CACHE_HASH_INIT 14695981039346656037ULL
+
+/**
+ * Get the signature of this server build
+ *
+ * This covers the version and the primitive table, which compiled code
+ * indexes into.
+ *
+ * @private
+ * @return the build signature
+ */
+static uint64_t
+muf_cache_build_signature(void)
+{
+    if (!muf_cache_build) {
+        uint64_t hash = muf_cache_hash(MUF_CACHE_HASH_INIT, VERSION);
+
+        for (int i = 0; i < prim_count; i++) {
+            hash = muf_cache_hash(hash, base_inst[i]);
+        }
+
+        muf_cache_build = hash ? hash : 1;
+    }
+
+    return muf_cache_build;
+}
+
+/**
+ * Get a hash of the @tune settings that change how programs compile
+ *
+ * @private
+ * @return the settings hash
+ */
+static uint64_t
+muf_cache_settings(void)
+{
+    uint64_t hash = MUF_CACHE_HASH_INIT;
+
+    hash = muf_cache_hash(hash, tp_optimize_muf ? "1" : "0");
+    hash = muf_cache_hash(hash, tp_muf_comments_strict ? "1" : "0");
+    return muf_cache_hash(hash, tp_muckname);
+}
+
+/**
+ * Get a hash of a program's source text
+ *
+ * @private
+ * @param program the program, with its source loaded in PROGRAM_FIRST
+ * @return the source hash
+ */
+static uint64_t
+muf_cache_source(dbref program)
+{
+    uint64_t hash = MUF_CACHE_HASH_INIT;
+
+    for (struct line *l = PROGRAM_FIRST(program); l; l = l->next) {
+        hash = muf_cache_hash(hash, l->this_line);
+    }
+
+    return hash;
+}
+
+/**
+ * Get a hash of the _defs/ propdir of an object
+ *
+ * This mirrors how the compiler includes definitions, so only string
+ * properties are looked at.
+ *
+ * @private
+ * @param obj the object
+ * @return the hash of its definitions
+ */
+static uint64_t
+muf_cache_defs(dbref obj)
+{
+    char name[BUFFER_LEN];
+    char dirname[sizeof(name) + sizeof(DEFINES_PROPDIR) + 2];
+    uint64_t hash = MUF_CACHE_HASH_INIT;
+    PropPtr p;
+    PropDirPtr pptr;
+
+    if (!ObjExists(obj))
+        return 0;
+
+    snprintf(dirname, sizeof(dirname), "/%s/", DEFINES_PROPDIR);
+    p = first_prop(obj, dirname, &pptr, name, sizeof(name));
+
+    while (p) {
+        const char *value;
+
+        snprintf(dirname, sizeof(dirname), "/%s/%s", DEFINES_PROPDIR, name);
+        value = get_property_class(obj, dirname);
+
+        if (value && *value) {
+            hash = muf_cache_hash(hash, name);
+            hash = muf_cache_hash(hash, value);
+        }
+
+        p = next_prop(pptr, p, name, sizeof(name));
+    }
+
+    return hash;
+}
+
+/**
+ * Get the name of a program's cache file
+ *
+ * @private
+ * @param program the program
+ * @param buf the buffer to put the name in
+ * @param buflen the size of 'buf'
+ */
+static void
+muf_cache_filename(dbref program, char *buf, size_t buflen)
+{
+    snprintf(buf, buflen, "muf/%d.mc", (int) program);
+}
+
+/*
+ * Writing.  Errors are sticky in the FILE, so they are checked once at
+ * the end with ferror().
+ */
+
+/**
+ * Write a 32 bit integer to a cache file
+ *
+ * @private
+ * @param f the file
+ * @param val the value
+ */
+static void
+muf_cache_put_int(FILE * f, int32_t val)
+{
+    (void) fwrite(&val, sizeof(val), 1, f);
+}
+
+/**
+ * Write a 64 bit unsigned integer to a cache file
+ *
+ * @private
+ * @param f the file
+ * @param val the value
+ */
+static void
+muf_cache_put_u64(FILE * f, uint64_t val)
+{
+    (void) fwrite(&val, sizeof(val), 1, f);
+}
+
+/**
+ * Write a string to a cache file
+ *
+ * @private
+ * @param f the file
+ * @param s the string, which may be NULL
+ */
+static void
+muf_cache_put_str(FILE * f, const char *s)
+{
+    if (!s) {
+        muf_cache_put_int(f, -1);
+        return;
+    }
+
+    muf_cache_put_int(f, (int32_t) strlen(s));
+    (void) fwrite(s, 1, strlen(s), f);
+}
+
+/**
+ * Write a program's code and publics to a cache file
+ *
+ * @private
+ * @param f the file
+ * @param program the program
+ */
+static void
+muf_cache_put_code(FILE * f, dbref program)
+{
+    struct inst *code = PROGRAM_CODE(program);
+    int siz = PROGRAM_SIZ(program);
+    int32_t count = 0;
+
+    muf_cache_put_int(f, siz);
+    muf_cache_put_int(f, (int32_t) (PROGRAM_START(program) - code));
+
+    for (int i = 0; i < siz; i++) {
+        struct inst *in = code + i;
+
+        muf_cache_put_int(f, in->type);
+        muf_cache_put_int(f, in->line);
+
+        switch (in->type) {
+            case PROG_FLOAT:
+                (void) fwrite(&in->data.fnumber, sizeof(double), 1, f);
+                break;
+            case PROG_STRING:
+                muf_cache_put_str(f, in->data.string ?
+                                  in->data.string->data : NULL);
+                break;
+            case PROG_FUNCTION:
+                muf_cache_put_str(f, in->data.mufproc->procname);
+                muf_cache_put_int(f, in->data.mufproc->vars);
+                muf_cache_put_int(f, in->data.mufproc->args);
+                muf_cache_put_int(f, in->data.mufproc->varnames != NULL);
+
+                if (in->data.mufproc->varnames) {
+                    for (int j = 0; j < in->data.mufproc->vars; j++) {
+                        muf_cache_put_str(f, in->data.mufproc->varnames[j]);
+                    }
+                }
+
+                break;
+            case PROG_OBJECT:
+                muf_cache_put_int(f, in->data.objref);
+                break;
+            case PROG_ADD:
+                muf_cache_put_int(f, (int32_t) (in->data.addr->data - code));
+                break;
+            case PROG_IF:
+            case PROG_JMP:
+            case PROG_EXEC:
+            case PROG_TRY:
+                muf_cache_put_int(f, (int32_t) (in->data.call - code));
+                break;
+            default:
+                muf_cache_put_int(f, in->data.number);
+                break;
+        }
+    }
+
+    for (struct publics *pub = PROGRAM_PUBS(program); pub; pub = pub->next)
+        count++;
+
+    muf_cache_put_int(f, count);
+
+    for (struct publics *pub = PROGRAM_PUBS(program); pub; pub = pub->next) {
+        muf_cache_put_str(f, pub->subname);
+        muf_cache_put_int(f, pub->mlev);
+        muf_cache_put_int(f, (int32_t) (pub->addr.ptr - code));
+    }
+}
+
+/**
+ * Write a freshly compiled program to its cache file
+ *
+ * 'deps' lists the objects whose _defs/ were included by the compile.
+ * Their current _defs/ are recorded in the cache file, and the file is
+ * only used again while they stay the same.
+ *
+ * Failures are logged, but are otherwise harmless; the program will just
+ * be compiled the next time it is needed.
+ *
+ * @param program the program that was just compiled
+ * @param deps the objects whose _defs/ were used by the compile
+ * @param depcount the number of entries in 'deps'
+ */
+void
+muf_cache_save(dbref program, const dbref *deps, int depcount)
+{
+    char fname[BUFFER_LEN];
+    char tmpname[sizeof(fname) + 4];
+    FILE *f;
+    int failed;
+
+    if (!PROGRAM_CODE(program) || !PROGRAM_FIRST(program))
+        return;
+
+    muf_cache_filename(program, fname, sizeof(fname));
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp", fname);
+
+    if ((f = fopen(tmpname, "wb")) == NULL) {
+        log_status("Couldn't open file %s!", tmpname);
+        return;
+    }
+
+    (void) fwrite(MUF_CACHE_MAGIC, 1, sizeof(MUF_CACHE_MAGIC), f);
+    muf_cache_put_int(f, MUF_CACHE_BYTEORDER);
+    muf_cache_put_int(f, (int32_t) sizeof(double));
+    muf_cache_put_u64(f, muf_cache_build_signature());
+    muf_cache_put_u64(f, muf_cache_settings());
+    muf_cache_put_u64(f, muf_cache_source(program));
+    muf_cache_put_int(f, OWNER(program));
+
+    muf_cache_put_int(f, depcount);
+
+    for (int i = 0; i < depcount; i++) {
+        muf_cache_put_int(f, deps[i]);
+        muf_cache_put_u64(f, muf_cache_defs(deps[i]));
+    }
+
+    muf_cache_put_code(f, program);
+
+    failed = ferror(f);
+
+    if (fclose(f) || failed) {
+        log_status("Couldn't write compiled program cache %s", tmpname);
+        unlink(tmpname);
+        return;
+    }
+
+#ifdef WIN32
+    unlink(fname);
+#endif
+
+    if (rename(tmpname, fname)) {
+        log_status("Couldn't rename %s to %s", tmpname, fname);
+        unlink(tmpname);
+    }
+}
+
+/*
+ * Reading.  Any short read or bad value marks the whole file as unusable.
+ */
+
+/**
+ * Read a 32 bit integer from a cache file
+ *
+ * @private
+ * @param f the file
+ * @param ok set to false on failure
+ * @return the value read, or 0 on failure
+ */
+static int32_t
+muf_cache_get_int(FILE * f, int *ok)
+{
+    int32_t val = 0;
+
+    if (fread(&val, sizeof(val), 1, f) != 1)
+        *ok = 0;
+
+    return val;
+}
+
+/**
+ * Read a 64 bit unsigned integer from a cache file
+ *
+ * @private
+ * @param f the file
+ * @param ok set to false on failure
+ * @return the value read, or 0 on failure
+ */
+static uint64_t
+muf_cache_get_u64(FILE * f, int *ok)
+{
+    uint64_t val = 0;
+
+    if (fread(&val, sizeof(val), 1, f) != 1)
+        *ok = 0;
+
+    return val;
+}
+
+/**
+ * Read a string from a cache file
+ *
+ * @private
+ * @param f the file
+ * @param ok set to false on failure
+ * @param isnull set to true if the string written was NULL
+ * @return a newly allocated string, or NULL if it was NULL or on failure
+ */
+static char *
+muf_cache_get_str(FILE * f, int *ok, int *isnull)
+{
+    int32_t len = muf_cache_get_int(f, ok);
+    char *s;
+
+    *isnull = 0;
+
+    if (!*ok)
+        return NULL;
+
+    if (len == -1) {
+        *isnull = 1;
+        return NULL;
+    }
+
+    if (len < 0 || len > MUF_CACHE_MAXSTR) {
+        *ok = 0;
+        return NULL;
+    }
+
+    if ((s = malloc((size_t) len + 1)) == NULL) {
+        panic("muf_cache_get_str(): Out of memory");
+    }
+
+    if (fread(s, 1, (size_t) len, f) != (size_t) len) {
+        free(s);
+        *ok = 0;
+        return NULL;
+    }
+
+    s[len] = '\0';
+    return s;
+}
+
+/**
+ * Free code loaded from a cache file that turned out to be unusable
+ *
+ * @private
+ * @param code the code array
+ * @param count how many instructions of 'code' were filled in
+ */
+static void
+muf_cache_free_code(struct inst *code, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (code[i].type == PROG_ADD) {
+            free(code[i].data.addr);
+        } else {
+            CLEAR(code + i);
+        }
+    }
+
+    free(code);
+}
+
+/**
+ * Free publics loaded from a cache file that turned out to be unusable
+ *
+ * @private
+ * @param pubs the list of publics
+ */
+static void
+muf_cache_free_pubs(struct publics *pubs)
+{
+    struct publics *next;
+
+    for (; pubs; pubs = next) {
+        next = pubs->next;
+        free(pubs->subname);
+        free(pubs);
+    }
+}
+
+/**
+ * Read one instruction from a cache file
+ *
+ * @private
+ * @param f the file
+ * @param program the program the code belongs to
+ * @param code the code array being loaded
+ * @param siz the number of instructions in 'code'
+ * @param in the instruction to fill in
+ * @return true on success, false if the file is unusable
+ */
+static int
+muf_cache_get_inst(FILE * f, dbref program, struct inst *code, int siz,
+                   struct inst *in)
+{
+    int ok = 1;
+    int isnull;
+    int32_t val;
+    char *s;
+
+    in->type = (short) muf_cache_get_int(f, &ok);
+    in->line = muf_cache_get_int(f, &ok);
+
+    if (!ok) {
+        in->type = PROG_INTEGER;
+        return 0;
+    }
+
+    switch (in->type) {
+        case PROG_PRIMITIVE:
+        case PROG_INTEGER:
+        case PROG_SVAR:
+        case PROG_SVAR_AT:
+        case PROG_SVAR_AT_CLEAR:
+        case PROG_SVAR_BANG:
+        case PROG_LVAR:
+        case PROG_LVAR_AT:
+        case PROG_LVAR_AT_CLEAR:
+        case PROG_LVAR_BANG:
+        case PROG_VAR:
+            in->data.number = muf_cache_get_int(f, &ok);
+            break;
+        case PROG_FLOAT:
+            if (fread(&in->data.fnumber, sizeof(double), 1, f) != 1)
+                ok = 0;
+
+            break;
+        case PROG_STRING:
+            s = muf_cache_get_str(f, &ok, &isnull);
+            in->data.string = s ? alloc_prog_string(s) : NULL;
+            free(s);
+            break;
+        case PROG_FUNCTION:
+            if ((in->data.mufproc = malloc(sizeof(struct muf_proc_data))) == NULL) {
+                panic("muf_cache_get_inst(): Out of memory");
+            }
+
+            in->data.mufproc->varnames = NULL;
+            in->data.mufproc->vars = 0;
+            in->data.mufproc->procname = muf_cache_get_str(f, &ok, &isnull);
+
+            if (!in->data.mufproc->procname) {
+                in->data.mufproc->procname = strdup("");
+                ok = 0;
+            }
+
+            val = muf_cache_get_int(f, &ok);
+            in->data.mufproc->args = muf_cache_get_int(f, &ok);
+
+            if (!ok || val < 0 || val > MAX_VAR) {
+                return 0;
+            }
+
+            if (muf_cache_get_int(f, &ok) && ok && val) {
+                in->data.mufproc->varnames = calloc((size_t) val,
+                                                    sizeof(char *));
+
+                if (!in->data.mufproc->varnames) {
+                    panic("muf_cache_get_inst(): Out of memory");
+                }
+
+                /* Count them as we go, so a failure frees just these. */
+                for (int j = 0; j < val && ok; j++) {
+                    s = muf_cache_get_str(f, &ok, &isnull);
+                    in->data.mufproc->varnames[j] = s ? s : strdup("");
+                    in->data.mufproc->vars++;
+                }
+            } else {
+                in->data.mufproc->vars = val;
+            }
+
+            break;
+        case PROG_OBJECT:
+            in->data.objref = muf_cache_get_int(f, &ok);
+            break;
+        case PROG_ADD:
+            val = muf_cache_get_int(f, &ok);
+
+            if (!ok || val < 0 || val > siz) {
+                /* Not yet an address, so it mustn't be freed as one. */
+                in->type = PROG_INTEGER;
+                return 0;
+            }
+
+            if ((in->data.addr = malloc(sizeof(struct prog_addr))) == NULL) {
+                panic("muf_cache_get_inst(): Out of memory");
+            }
+
+            in->data.addr->links = 1;
+            in->data.addr->progref = program;
+            in->data.addr->data = code + val;
+            break;
+        case PROG_IF:
+        case PROG_JMP:
+        case PROG_EXEC:
+        case PROG_TRY:
+            val = muf_cache_get_int(f, &ok);
+
+            if (!ok || val < 0 || val > siz)
+                return 0;
+
+            in->data.call = code + val;
+            break;
+        default:
+            /* Make it safe to free, and give up. */
+            in->type = PROG_INTEGER;
+            return 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Load a program's compiled code from its cache file
+ *
+ * The program's source must be loaded into PROGRAM_FIRST, as it is when
+ * do_compile is called, so that it can be checked against the cache.
+ *
+ * On success, the code, size, start address and publics of the program
+ * are set.  Any code the program already had must have been freed first.
+ * On failure, the program is not touched.
+ *
+ * @param program the program to load
+ * @return true if the program was loaded, false if it must be compiled
+ */
+int
+muf_cache_load(dbref program)
+{
+    char fname[BUFFER_LEN];
+    char magic[sizeof(MUF_CACHE_MAGIC)];
+    struct inst *code = NULL;
+    struct publics *pubs = NULL, **pubtail = &pubs;
+    int ok = 1;
+    int isnull;
+    int32_t siz, start, count;
+    int loaded = 0;
+    FILE *f;
+
+    if (!PROGRAM_FIRST(program))
+        return 0;
+
+    muf_cache_filename(program, fname, sizeof(fname));
+
+    if ((f = fopen(fname, "rb")) == NULL)
+        return 0;
+
+    /* Check everything the compiled code depends on. */
+    if (fread(magic, 1, sizeof(magic), f) != sizeof(magic)
+            || memcmp(magic, MUF_CACHE_MAGIC, sizeof(magic))
+            || muf_cache_get_int(f, &ok) != MUF_CACHE_BYTEORDER
+            || muf_cache_get_int(f, &ok) != (int32_t) sizeof(double)
+            || muf_cache_get_u64(f, &ok) != muf_cache_build_signature()
+            || muf_cache_get_u64(f, &ok) != muf_cache_settings()
+            || muf_cache_get_u64(f, &ok) != muf_cache_source(program)
+            || muf_cache_get_int(f, &ok) != OWNER(program)
+            || !ok) {
+        fclose(f);
+        return 0;
+    }
+
+    count = muf_cache_get_int(f, &ok);
+
+    for (int i = 0; ok && i < count; i++) {
+        dbref obj = muf_cache_get_int(f, &ok);
+
+        if (muf_cache_get_u64(f, &ok) != muf_cache_defs(obj))
+            ok = 0;
+    }
+
+    siz = muf_cache_get_int(f, &ok);
+    start = muf_cache_get_int(f, &ok);
+
+    if (!ok || siz <= 0 || start < 0 || start >= siz) {
+        fclose(f);
+        return 0;
+    }
+
+    /* Like the compiler, allocate one spare instruction at the end. */
+    if ((code = calloc((size_t) siz + 1, sizeof(struct inst))) == NULL) {
+        panic("muf_cache_load(): Out of memory");
+    }
+
+    for (int i = 0; i < siz; i++) {
+        if (!muf_cache_get_inst(f, program, code, siz, code + i)) {
+            muf_cache_free_code(code, i + 1);
+            fclose(f);
+            return 0;
+        }
+    }
+
+    count = muf_cache_get_int(f, &ok);
+
+    for (int i = 0; ok && i < count; i++) {
+        struct publics *pub;
+        int32_t addr;
+
+        if ((pub = malloc(sizeof(struct publics))) == NULL) {
+            panic("muf_cache_load(): Out of memory");
+        }
+
+        pub->next = NULL;
+        pub->subname = muf_cache_get_str(f, &ok, &isnull);
+        pub->mlev = muf_cache_get_int(f, &ok);
+        addr = muf_cache_get_int(f, &ok);
+        pub->addr.ptr = code + addr;
+        *pubtail = pub;
+        pubtail = &pub->next;
+
+        if (!pub->subname || addr < 0 || addr >= siz)
+            ok = 0;
+    }
+
+    /* Anything left over means the file isn't what we think it is. */
+    if (ok && fgetc(f) == EOF) {
+        PROGRAM_SET_CODE(program, code);
+        PROGRAM_SET_SIZ(program, siz);
+        PROGRAM_SET_START(program, code + start);
+        PROGRAM_SET_PUBS(program, pubs);
+        loaded = 1;
+    } else {
+        muf_cache_free_code(code, siz);
+        muf_cache_free_pubs(pubs);
+    }
+
+    fclose(f);
+    return loaded;
+}
+
+/**
+ * Remove a program's cache file, if it has one
+ *
+ * @param program the program whose cache file should be removed
+ */
+void
+muf_cache_remove(dbref program)
+{
+    char fname[BUFFER_LEN];
+
+    muf_cache_filename(program, fname, sizeof(fname));
+    unlink(fname);
+}
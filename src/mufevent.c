@@ -516,7 +516,7 @@ muf_event_controls(dbref player, int pid)
  *
  * 'pat' is intended to be something akin to this:
  *
- * **%10s %4s %4s %6s %4s %7s %-10.10s %-12s %.512s
+ * **%10s %4s %4s %6s %4s %4s %7s %-10.10s %-12s %.512s
  *
  * That's the format used in the only place this is called.
  *
@@ -534,6 +534,7 @@ muf_event_list(dbref player, const char *pat)
     char pidstr[BUFFER_LEN];
     char inststr[BUFFER_LEN];
     char cpustr[BUFFER_LEN];
+    char memstr[BUFFER_LEN];
     char progstr[BUFFER_LEN];
     char prognamestr[BUFFER_LEN];
     int count = 0;
@@ -596,10 +597,13 @@ muf_event_list(dbref player, const char *pat)
                          NAME(proc->prog));
             }
 
+            snprintf(memstr, sizeof(memstr), "%lu",
+                     (unsigned long) ((frame_memory(proc->fr) + 1023) / 1024));
+
             snprintf(buf, sizeof(buf), pat, pidstr, "--",
                      time_format_2((time_t) (rtime - proc->fr->started)),
-                     inststr, cpustr, progstr, prognamestr, NAME(proc->player),
-                     "EVENT_WAITFOR");
+                     inststr, cpustr, memstr, progstr, prognamestr,
+                     NAME(proc->player), "EVENT_WAITFOR");
 
             /*
              * @TODO: Why are we doing all this formatting, and then checking
@@ -1148,7 +1152,8 @@ muf_event_process(void)
             if (ev) {
                 --limit; /* Deduct from our processing limit */
 
-                if (proc->fr->argument.top + 1 >= STACK_SIZE) {
+                if (!grow_argument_stack(proc->fr, proc->fr->argument.top + 2,
+                                         0)) {
                     /*
                      * Uh oh! That MUF program's stack is full!
                      * Print an error, free the frame, and exit.
@@ -0,0 +1,587 @@
+/** @file netloop.c
+ *
+ * Source for the network event loop backends used by the main player
+ * interaction loop.  There are two backends:
+ *
+ * - epoll, used on Linux.  Each descriptor is registered with the kernel
+ *   once and only re-registered when the events we are interested in
+ *   change, so the cost of a wakeup depends on how many descriptors are
+ *   actually active rather than how many are connected.  It is not limited
+ *   by FD_SETSIZE.
+ *
+ * - select, used everywhere else.  The interest sets are kept between
+ *   calls and copied for each wait.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#include "fbsignal.h"
+#include "interface.h"
+#include "netloop.h"
+
+#ifdef USE_EPOLL
+# include <sys/epoll.h>
+
+/**
+ * @private
+ * @var the maximum number of events collected by a single netloop_wait.
+ *      Any further ready descriptors are picked up on the next pass.
+ */
+# define NETLOOP_MAX_EVENTS 1024
+
+/**
+ * Book-keeping for a single descriptor in the epoll backend
+ */
+struct netloop_fd {
+    unsigned char interest;     /**< NETLOOP_* events we are watching for */
+    unsigned char ready;        /**< NETLOOP_* events from the last wait  */
+    unsigned char unpollable;   /**< epoll refused it (i.e. a plain file)  */
+};
+
+/**
+ * @private
+ * @var the epoll instance descriptor
+ */
+static int epoll_fd = -1;
+
+/**
+ * @private
+ * @var per-descriptor state, indexed by descriptor number
+ */
+static struct netloop_fd *fd_state = NULL;
+
+/**
+ * @private
+ * @var number of entries allocated in fd_state
+ */
+static int fd_state_size = 0;
+
+/**
+ * @private
+ * @var the events returned by the last wait
+ */
+static struct epoll_event ready_events[NETLOOP_MAX_EVENTS];
+
+/**
+ * @private
+ * @var the number of entries in ready_events that are valid
+ */
+static int nready_events = 0;
+
+/**
+ * @private
+ * @var the number of unpollable descriptors with a non-zero interest.
+ *      These are always considered ready, so the wait must not block.
+ */
+static int unpollable_count = 0;
+
+/**
+ * Get the state entry for a descriptor, growing the table if needed
+ *
+ * @private
+ * @param fd the descriptor
+ * @return the state entry for fd
+ */
+static struct netloop_fd *
+netloop_fd_state(int fd)
+{
+    if (fd >= fd_state_size) {
+        int newsize = fd_state_size ? fd_state_size : 256;
+
+        while (newsize <= fd) {
+            newsize *= 2;
+        }
+
+        if (!(fd_state = realloc(fd_state, sizeof(struct netloop_fd) * newsize)))
+            panic("netloop_fd_state: Out of memory");
+
+        memset(fd_state + fd_state_size, 0,
+               sizeof(struct netloop_fd) * (newsize - fd_state_size));
+        fd_state_size = newsize;
+    }
+
+    return &fd_state[fd];
+}
+
+/**
+ * Convert NETLOOP_* events to epoll events
+ *
+ * @private
+ * @param events a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ * @return the equivalent epoll event mask
+ */
+static uint32_t
+netloop_to_epoll(int events)
+{
+    uint32_t result = 0;
+
+    if (events & NETLOOP_READ)
+        result |= EPOLLIN;
+
+    if (events & NETLOOP_WRITE)
+        result |= EPOLLOUT;
+
+    return result;
+}
+
+/**
+ * Initialize the network event loop backend.
+ *
+ * This must be called once before any other netloop call.  If the backend
+ * cannot be initialized, this will panic.
+ */
+void
+netloop_init(void)
+{
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        panic("netloop_init: Unable to create epoll instance");
+}
+
+/**
+ * Get the name of the compiled in event loop backend
+ *
+ * @return a constant string such as "epoll" or "select"
+ */
+const char *
+netloop_backend_name(void)
+{
+    return "epoll";
+}
+
+/**
+ * Get the number of descriptors the event loop backend can watch
+ *
+ * For select() this is FD_SETSIZE; for other backends it is effectively
+ * unlimited.
+ *
+ * @return the maximum number of descriptors that can be watched
+ */
+long
+netloop_max_descriptors(void)
+{
+    return LONG_MAX;
+}
+
+/**
+ * Set the events we are interested in for a given descriptor
+ *
+ * Interest is persistent; it remains in effect for every following call
+ * to netloop_wait until it is changed or the descriptor is forgotten.
+ * Setting the same interest again is cheap and does not result in a
+ * system call, so callers may simply set the interest they want on every
+ * pass of the main loop.
+ *
+ * Setting an interest of 0 stops watching the descriptor entirely.  This
+ * removes it from the epoll set rather than leaving it registered with
+ * no events, because epoll always reports hangups and we do not want a
+ * throttled connection that has hung up to wake us on every pass.
+ *
+ * @see netloop_forget
+ *
+ * @param fd the descriptor
+ * @param events a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ * @return 0 on success, -1 if the descriptor cannot be watched
+ */
+int
+netloop_set(int fd, int events)
+{
+    struct netloop_fd *state;
+    struct epoll_event ev;
+    int op;
+
+    if (fd < 0)
+        return -1;
+
+    state = netloop_fd_state(fd);
+
+    if (state->interest == events)
+        return 0;
+
+    if (state->unpollable) {
+        if (!state->interest)
+            unpollable_count++;
+        else if (!events)
+            unpollable_count--;
+
+        state->interest = (unsigned char)events;
+        return 0;
+    }
+
+    if (!events)
+        op = EPOLL_CTL_DEL;
+    else if (!state->interest)
+        op = EPOLL_CTL_ADD;
+    else
+        op = EPOLL_CTL_MOD;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = netloop_to_epoll(events);
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, op, fd, &ev) < 0) {
+        /*
+         * Regular files (such as a console redirected from a file) can't
+         * be watched by epoll.  select() considers them always ready, so
+         * we do the same.
+         */
+        if (op == EPOLL_CTL_ADD && errno == EPERM) {
+            state->unpollable = 1;
+            state->interest = (unsigned char)events;
+            unpollable_count++;
+            return 0;
+        }
+
+        if (op != EPOLL_CTL_DEL)
+            return -1;
+    }
+
+    state->interest = (unsigned char)events;
+    return 0;
+}
+
+/**
+ * Forget about a descriptor
+ *
+ * This must be called before a watched descriptor is closed so that the
+ * descriptor number can be safely reused.
+ *
+ * @param fd the descriptor to forget about
+ */
+void
+netloop_forget(int fd)
+{
+    struct netloop_fd *state;
+
+    if (fd < 0 || fd >= fd_state_size)
+        return;
+
+    state = &fd_state[fd];
+
+    if (state->interest) {
+        if (state->unpollable) {
+            unpollable_count--;
+        } else {
+            struct epoll_event ev;
+
+            memset(&ev, 0, sizeof(ev));
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+        }
+    }
+
+    memset(state, 0, sizeof(struct netloop_fd));
+}
+
+/**
+ * Wait for activity on the watched descriptors
+ *
+ * Signals that are blocked during normal operation are unblocked for the
+ * duration of the wait if pselect support is available.
+ *
+ * @param timeout how long to wait at most
+ * @return the number of ready descriptors, 0 on timeout, or -1 on error
+ *         with errno set.
+ */
+int
+netloop_wait(struct timeval *timeout)
+{
+    int msecs;
+    int count;
+
+    /* Clear out the results of the previous wait. */
+    for (int i = 0; i < nready_events; i++) {
+        int fd = ready_events[i].data.fd;
+
+        if (fd < fd_state_size)
+            fd_state[fd].ready = 0;
+    }
+
+    nready_events = 0;
+
+    if (unpollable_count > 0) {
+        msecs = 0;
+    } else if (timeout) {
+        /* Round up, so that short timeouts don't become busy loops. */
+        msecs = (int)(timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000);
+
+        /* A deadline that has already passed must not wait forever. */
+        if (msecs < 0)
+            msecs = 0;
+    } else {
+        msecs = -1;
+    }
+
+#ifdef HAVE_PSELECT
+    count = epoll_pwait(epoll_fd, ready_events, NETLOOP_MAX_EVENTS, msecs,
+                        &pselect_signal_mask);
+#else
+    count = epoll_wait(epoll_fd, ready_events, NETLOOP_MAX_EVENTS, msecs);
+#endif
+
+    if (count < 0)
+        return -1;
+
+    nready_events = count;
+
+    for (int i = 0; i < count; i++) {
+        int fd = ready_events[i].data.fd;
+        uint32_t ev = ready_events[i].events;
+        struct netloop_fd *state;
+
+        if (fd >= fd_state_size)
+            continue;
+
+        state = &fd_state[fd];
+
+        if (ev & EPOLLIN)
+            state->ready |= NETLOOP_READ;
+
+        if (ev & EPOLLOUT)
+            state->ready |= NETLOOP_WRITE;
+
+        if (ev & (EPOLLERR | EPOLLHUP))
+            state->ready |= state->interest;
+    }
+
+    return count;
+}
+
+/**
+ * Which events are ready on a given descriptor after netloop_wait?
+ *
+ * Errors and hangups are reported as whichever events the descriptor
+ * was being watched for, so that the normal read or write path notices
+ * the problem.
+ *
+ * @param fd the descriptor to check
+ * @return a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ */
+int
+netloop_ready(int fd)
+{
+    if (fd < 0 || fd >= fd_state_size)
+        return 0;
+
+    if (fd_state[fd].unpollable)
+        return fd_state[fd].interest;
+
+    return fd_state[fd].ready;
+}
+
+#else /* !USE_EPOLL */
+
+/**
+ * @private
+ * @var descriptors we are watching for reading
+ */
+static fd_set interest_read;
+
+/**
+ * @private
+ * @var descriptors we are watching for writing
+ */
+static fd_set interest_write;
+
+/**
+ * @private
+ * @var descriptors that were ready for reading after the last wait
+ */
+static fd_set ready_read;
+
+/**
+ * @private
+ * @var descriptors that were ready for writing after the last wait
+ */
+static fd_set ready_write;
+
+/**
+ * @private
+ * @var the highest descriptor number we have watched
+ */
+static int max_fd = -1;
+
+/**
+ * Initialize the network event loop backend.
+ *
+ * This must be called once before any other netloop call.  If the backend
+ * cannot be initialized, this will panic.
+ */
+void
+netloop_init(void)
+{
+    FD_ZERO(&interest_read);
+    FD_ZERO(&interest_write);
+    FD_ZERO(&ready_read);
+    FD_ZERO(&ready_write);
+}
+
+/**
+ * Get the name of the compiled in event loop backend
+ *
+ * @return a constant string such as "epoll" or "select"
+ */
+const char *
+netloop_backend_name(void)
+{
+    return "select";
+}
+
+/**
+ * Get the number of descriptors the event loop backend can watch
+ *
+ * For select() this is FD_SETSIZE; for other backends it is effectively
+ * unlimited.
+ *
+ * @return the maximum number of descriptors that can be watched
+ */
+long
+netloop_max_descriptors(void)
+{
+    return FD_SETSIZE;
+}
+
+/**
+ * Set the events we are interested in for a given descriptor
+ *
+ * Interest is persistent; it remains in effect for every following call
+ * to netloop_wait until it is changed or the descriptor is forgotten.
+ * Setting the same interest again is cheap and does not result in a
+ * system call, so callers may simply set the interest they want on every
+ * pass of the main loop.
+ *
+ * Setting an interest of 0 stops watching the descriptor entirely.
+ *
+ * @see netloop_forget
+ *
+ * @param fd the descriptor
+ * @param events a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ * @return 0 on success, -1 if the descriptor cannot be watched
+ */
+int
+netloop_set(int fd, int events)
+{
+#ifndef WIN32
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return -1;
+#endif
+
+    if (events & NETLOOP_READ)
+        FD_SET(fd, &interest_read);
+    else
+        FD_CLR(fd, &interest_read);
+
+    if (events & NETLOOP_WRITE)
+        FD_SET(fd, &interest_write);
+    else
+        FD_CLR(fd, &interest_write);
+
+    if (events && fd > max_fd)
+        max_fd = fd;
+
+    return 0;
+}
+
+/**
+ * Forget about a descriptor
+ *
+ * This must be called before a watched descriptor is closed so that the
+ * descriptor number can be safely reused.
+ *
+ * @param fd the descriptor to forget about
+ */
+void
+netloop_forget(int fd)
+{
+#ifndef WIN32
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return;
+#endif
+
+    FD_CLR(fd, &interest_read);
+    FD_CLR(fd, &interest_write);
+    FD_CLR(fd, &ready_read);
+    FD_CLR(fd, &ready_write);
+}
+
+/**
+ * Wait for activity on the watched descriptors
+ *
+ * Signals that are blocked during normal operation are unblocked for the
+ * duration of the wait if pselect support is available.
+ *
+ * @param timeout how long to wait at most
+ * @return the number of ready descriptors, 0 on timeout, or -1 on error
+ *         with errno set.
+ */
+int
+netloop_wait(struct timeval *timeout)
+{
+    int count;
+
+    ready_read = interest_read;
+    ready_write = interest_write;
+
+#ifdef HAVE_PSELECT
+    {
+        struct timespec timeout_for_pselect;
+
+        timeout_for_pselect.tv_sec = timeout->tv_sec;
+        timeout_for_pselect.tv_nsec = timeout->tv_usec * 1000L;
+
+        count = pselect(max_fd + 1, &ready_read, &ready_write, NULL,
+                        &timeout_for_pselect, &pselect_signal_mask);
+    }
+#else
+    count = select(max_fd + 1, &ready_read, &ready_write, NULL, timeout);
+#endif
+
+#ifdef WIN32
+    if (count == SOCKET_ERROR)
+        count = -1;
+#endif
+
+    if (count < 0) {
+        FD_ZERO(&ready_read);
+        FD_ZERO(&ready_write);
+    }
+
+    return count;
+}
+
+/**
+ * Which events are ready on a given descriptor after netloop_wait?
+ *
+ * Errors and hangups are reported as whichever events the descriptor
+ * was being watched for, so that the normal read or write path notices
+ * the problem.
+ *
+ * @param fd the descriptor to check
+ * @return a bitmask of NETLOOP_READ and NETLOOP_WRITE
+ */
+int
+netloop_ready(int fd)
+{
+    int result = 0;
+
+#ifndef WIN32
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return 0;
+#endif
+
+    if (FD_ISSET(fd, &ready_read))
+        result |= NETLOOP_READ;
+
+    if (FD_ISSET(fd, &ready_write))
+        result |= NETLOOP_WRITE;
+
+    return result;
+}
+
+#endif /* USE_EPOLL */
@@ -1655,7 +1655,8 @@ prim_array_get_propdirs(PRIM_PROTOTYPE)
     stk_array *nu;
     char propname[BUFFER_LEN*2];
     char dir[BUFFER_LEN*2];
-    PropPtr propadr, pptr;
+    PropPtr propadr;
+    PropDirPtr pptr;
     PropPtr prptr;
     int count = 0;
     int len;
@@ -1767,7 +1768,8 @@ prim_array_get_propvals(PRIM_PROTOTYPE)
     stk_array *nu;
     char propname[BUFFER_LEN];
     char dir[BUFFER_LEN];
-    PropPtr propadr, pptr;
+    PropPtr propadr;
+    PropDirPtr pptr;
     PropPtr prptr;
     int count = 0;
 
@@ -91,7 +91,7 @@ prim_awakep(PRIM_PROTOTYPE)
 void
 prim_online(PRIM_PROTOTYPE)
 {
-    struct descriptor_data* d = descriptor_list;
+    struct descriptor_data* d = connected_list;
     stk_array *duparr;
 
     CHECKOP(0);
@@ -118,14 +118,12 @@ prim_online(PRIM_PROTOTYPE)
 
     result = 0;
 
-    for ( ; d; d = d->next) {
-        if (d->connected) {
-            temp1.data.number = d->player;
+    for ( ; d; d = d->con_next) {
+        temp1.data.number = d->player;
 
-            if (!array_getitem(duparr, &temp1)) {
-                array_setitem(&duparr, &temp1, &temp1);
-                result++;
-            }
+        if (!array_getitem(duparr, &temp1)) {
+            array_setitem(&duparr, &temp1, &temp1);
+            result++;
         }
     }
 
@@ -165,7 +163,7 @@ void
 prim_online_array(PRIM_PROTOTYPE)
 {
     stk_array *duparr, *nu;
-    struct descriptor_data* d = descriptor_list;
+    struct descriptor_data* d = connected_list;
 
     CHECKOP(0);
 
@@ -184,14 +182,12 @@ prim_online_array(PRIM_PROTOTYPE)
 
     result = 0;
 
-    for ( ; d; d = d->next) {
-        if (d->connected) {
-            temp1.data.number = d->player;
+    for ( ; d; d = d->con_next) {
+        temp1.data.number = d->player;
 
-            if (!array_getitem(duparr, &temp1)) {
-                array_setitem(&duparr, &temp1, &temp1);
-                result++;
-            }
+        if (!array_getitem(duparr, &temp1)) {
+            array_setitem(&duparr, &temp1, &temp1);
+            result++;
         }
     }
 
@@ -722,16 +718,14 @@ prim_descriptors(PRIM_PROTOTYPE)
     CLEAR(oper1);
 
     if (ref == NOTHING) {
-        d = descriptor_list_tail;
+        d = connected_list_tail;
         result = pdescrcount();
 
         CHECKOFLOW(result + 1);
 
-        for ( ; d; d = d->prev) {
-            if (d->connected) {
-                PushInt(d->descriptor);
-                mycount++;
-            }
+        for ( ; d; d = d->con_prev) {
+            PushInt(d->descriptor);
+            mycount++;
         }
     } else {
         darr = get_player_descrs(ref, &dcount);
@@ -793,23 +787,20 @@ prim_descr_array(PRIM_PROTOTYPE)
     if (ref == NOTHING) {
         result = 0;
 
-        for (d = descriptor_list; d; d = d->next) {
-            if (d->connected)
-                result++;
+        for (d = connected_list; d; d = d->con_next) {
+            result++;
         }
 
         newarr = new_array_packed(result, fr->pinning);
 
-        d = descriptor_list;
+        d = connected_list;
 
-        for (int i = 0; d; d = d->next) {
-            if (d->connected) {
-                temp1.data.number = i;
-                temp2.data.number = d->descriptor;
+        for (int i = 0; d; d = d->con_next) {
+            temp1.data.number = i;
+            temp2.data.number = d->descriptor;
 
-                array_setitem(&newarr, &temp1, &temp2);
-                i++;
-            }
+            array_setitem(&newarr, &temp1, &temp2);
+            i++;
         }
     } else {
         darr = get_player_descrs(ref, &dcount);
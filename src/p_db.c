@@ -583,17 +583,14 @@ prim_nextowned(PRIM_PROTOTYPE)
     ownr = OWNER(ref);
 
     if (OBJECT_TYPE(ref) == TYPE_PLAYER) {
-        ref = 0;
-    } else {
-        ref++;
+        ref = NOTHING;
     }
 
-    while (ref < db_top && (OWNER(ref) != ownr || ref == ownr)) {
-        ref++;
-    }
+    ref = db_next_referrer(ownr, REFS_OWNED, ref);
 
-    if (ref >= db_top) {
-        ref = NOTHING;
+    /* Players own themselves, but that's not what we're looking for */
+    if (ref == ownr) {
+        ref = db_next_referrer(ownr, REFS_OWNED, ref);
     }
 
     CLEAR(oper1);
@@ -727,8 +724,8 @@ prim_setname(PRIM_PROTOTYPE)
             abort_interp("Invalid name.");
         }
 
-        free((void *) NAME(ref));
-        NAME(ref) = alloc_string(b);
+        free_interned(NAME(ref));
+        NAME(ref) = alloc_interned(b);
         ts_modifyobject(ref);
     }
 
@@ -1802,6 +1799,7 @@ void
 prim_setlink(PRIM_PROTOTYPE)
 {
     dbref ref;
+    dbref *dest;
 
     CHECKOP(2);
     oper1 = POP();              /* dbref: destination */
@@ -1835,15 +1833,15 @@ prim_setlink(PRIM_PROTOTYPE)
         }
 
         if (OBJECT_TYPE(ref) == TYPE_EXIT) {
-            DBSTORE(ref, sp.exit.ndest, 0);
-            free(DBFETCH(ref)->sp.exit.dest);
-            DBSTORE(ref, sp.exit.dest, NULL);
+            db_set_exit_dests(ref, 0, NULL);
+            DBDIRTY(ref);
 
             if (OBJECT_MLEVEL(ref)) {
                 SetMLevel(ref, 0);
             }
         } else {
-            DBSTORE(ref, sp.room.dropto, NOTHING);
+            db_set_dropto(ref, NOTHING);
+            DBDIRTY(ref);
         }
     } else {
         if (!prog_can_link_to(mlev, ProgUID, OBJECT_TYPE(ref), oper1->data.objref)) {
@@ -1864,9 +1862,9 @@ prim_setlink(PRIM_PROTOTYPE)
                     abort_interp("Link would cause a loop.");
                 }
 
-                DBFETCH(ref)->sp.exit.ndest = 1;
-                DBFETCH(ref)->sp.exit.dest = malloc(sizeof(dbref));
-                (DBFETCH(ref)->sp.exit.dest)[0] = oper1->data.objref;
+                dest = malloc(sizeof(dbref));
+                dest[0] = oper1->data.objref;
+                db_set_exit_dests(ref, 1, dest);
                 DBDIRTY(ref);
                 break;
 
@@ -1893,7 +1891,7 @@ prim_setlink(PRIM_PROTOTYPE)
                 break;
 
             case TYPE_ROOM:
-                DBFETCH(ref)->sp.room.dropto = oper1->data.objref;
+                db_set_dropto(ref, oper1->data.objref);
                 DBDIRTY(ref);
                 break;
         }
@@ -1964,7 +1962,7 @@ prim_setown(PRIM_PROTOTYPE)
         }
     }
 
-    OWNER(ref) = OWNER(oper1->data.objref);
+    db_set_owner(ref, OWNER(oper1->data.objref));
     DBDIRTY(ref);
 
     CLEAR(oper1);
@@ -2622,13 +2620,24 @@ prim_findnext(PRIM_PROTOTYPE)
 
     init_checkflags(player, DoNullInd(oper4->data.string), &check);
 
-    for (dbref i = item; i < db_top; i++) {
-        if ((who == NOTHING || OWNER(i) == who) &&
-            checkflags(i, check) && NAME(i) && OBJECT_TYPE(i) != TYPE_GARBAGE &&
-            (!*name || equalstr(buf, (char *) NAME(i)))) {
-            ref = i;
+    /* When looking for someone's stuff, only look at what they own */
+    if (who != NOTHING) {
+        item = db_next_referrer(who, REFS_OWNED, item - 1);
+    }
+
+    while (item != NOTHING && item < db_top) {
+        if (checkflags(item, check) && NAME(item)
+            && OBJECT_TYPE(item) != TYPE_GARBAGE
+            && (!*name || equalstr(buf, (char *) NAME(item)))) {
+            ref = item;
             break;
         }
+
+        if (who == NOTHING) {
+            item++;
+        } else {
+            item = db_next_referrer(who, REFS_OWNED, item);
+        }
     }
 
     CLEAR(oper1);
@@ -2658,8 +2667,6 @@ void
 prim_nextentrance(PRIM_PROTOTYPE)
 {
     dbref linkref, ref;
-    int foundref = 0;
-    int count;
 
     if (mlev < 3) {
         abort_interp("Permission denied.  Requires Mucker Level 3.");
@@ -2684,55 +2691,20 @@ prim_nextentrance(PRIM_PROTOTYPE)
         linkref = PLAYER_HOME(player);
     }
 
-    (void) ref++;
-
-    for (; ref < db_top; ref++) {
-        oper2->data.objref = ref;
-
-        if (valid_object(oper2)) {
-            switch (OBJECT_TYPE(ref)) {
-                case TYPE_PLAYER:
-                    if (PLAYER_HOME(ref) == linkref) {
-                        foundref = 1;
-                    }
-
-                    break;
-
-                case TYPE_ROOM:
-                    if (DBFETCH(ref)->sp.room.dropto == linkref) {
-                        foundref = 1;
-                    }
-
-                    break;
-
-                case TYPE_THING:
-                    if (THING_HOME(ref) == linkref) {
-                        foundref = 1;
-                    }
-
-                    break;
-
-                case TYPE_EXIT:
-                    count = DBFETCH(ref)->sp.exit.ndest;
-
-                    for (int i = 0; i < count; i++) {
-                        if (DBFETCH(ref)->sp.exit.dest[i] == linkref) {
-                            foundref = 1;
-                            break;
-                        }
-                    }
-
-                    break;
-            }
-
-            if (foundref) {
+    if (linkref == NOTHING) {
+        /* Rooms without a dropto are linked to NOTHING, but not indexed */
+        for (ref++; ref < db_top; ref++) {
+            if (OBJECT_TYPE(ref) == TYPE_ROOM
+                && DBFETCH(ref)->sp.room.dropto == NOTHING) {
                 break;
             }
         }
-    }
 
-    if (!foundref) {
-        ref = NOTHING;
+        if (ref >= db_top) {
+            ref = NOTHING;
+        }
+    } else {
+        ref = db_next_referrer(linkref, REFS_LINKED, ref);
     }
 
     CLEAR(oper1);
@@ -3617,8 +3589,9 @@ void
 prim_entrances_array(PRIM_PROTOTYPE)
 {
     dbref ref;
+    const dbref *linked;
     stk_array *nw;
-    int count = 0;
+    int count;
 
     CHECKOP(1);
     oper1 = POP();
@@ -3634,38 +3607,10 @@ prim_entrances_array(PRIM_PROTOTYPE)
     ref = oper1->data.objref;
     nw = new_array_packed(0, fr->pinning);
 
-    for (dbref i = 0; i < db_top; i++) {
-        switch (OBJECT_TYPE(i)) {
-            case TYPE_EXIT:
-                for (dbref j = DBFETCH(i)->sp.exit.ndest; j--;) {
-                    if (DBFETCH(i)->sp.exit.dest[j] == ref) {
-                        array_set_intkey_refval(&nw, count++, i);
-                    }
-                }
-
-                break;
-
-            case TYPE_PLAYER:
-                if (PLAYER_HOME(i) == ref) {
-                    array_set_intkey_refval(&nw, count++, i);
-                }
-
-                break;
-
-            case TYPE_THING:
-                if (THING_HOME(i) == ref) {
-                    array_set_intkey_refval(&nw, count++, i);
-                }
-
-                break;
-
-            case TYPE_ROOM:
-                if (DBFETCH(i)->sp.room.dropto == ref) {
-                    array_set_intkey_refval(&nw, count++, i);
-                }
+    linked = db_referrers(ref, REFS_LINKED, &count);
 
-                break;
-        }
+    for (int i = 0; i < count; i++) {
+        array_set_intkey_refval(&nw, i, linked[i]);
     }
 
     CLEAR(oper1);
@@ -4040,19 +3985,16 @@ prim_setlinks_array(PRIM_PROTOTYPE)
         if (OBJECT_MLEVEL(what)) {
             SetMLevel(what, 0);
         }
-
-        free(DBFETCH(what)->sp.exit.dest);
     }
 
     if (dest_count == 0) {
         switch (OBJECT_TYPE(what)) {
             case TYPE_EXIT:
-                DBSTORE(what, sp.exit.ndest, 0);
-                DBSTORE(what, sp.exit.dest, NULL);
+                db_set_exit_dests(what, 0, NULL);
                 break;
 
             case TYPE_ROOM:
-                DBSTORE(what, sp.room.dropto, NOTHING);
+                db_set_dropto(what, NOTHING);
                 break;
 
             default:
@@ -4064,8 +4006,8 @@ prim_setlinks_array(PRIM_PROTOTYPE)
                 dbref *dests = malloc(sizeof(dbref) * dest_count);
 
                 if (dests == NULL) {
-                    DBSTORE(what, sp.exit.ndest, 0);
-                    DBSTORE(what, sp.exit.dest, NULL);
+                    db_set_exit_dests(what, 0, NULL);
+                    DBDIRTY(what);
                     abort_interp("Out of memory.");
                 }
 
@@ -4079,14 +4021,13 @@ prim_setlinks_array(PRIM_PROTOTYPE)
                     }  while (array_next(arr, &idx));
                 }
 
-                DBSTORE(what, sp.exit.ndest, dest_count);
-                DBSTORE(what, sp.exit.dest, dests);
+                db_set_exit_dests(what, (int)dest_count, dests);
             }
             break;
 
             case TYPE_ROOM:
                 if (array_first(arr, &idx)) {
-                    DBSTORE(what, sp.room.dropto, array_getitem(arr, &idx)->data.objref);
+                    db_set_dropto(what, array_getitem(arr, &idx)->data.objref);
                     CLEAR(&idx);
                 }
                 break;
@@ -4163,7 +4104,8 @@ prim_pname_history(PRIM_PROTOTYPE)
     dbref ref;
     stk_array *nu;
     struct inst temp1, temp2;
-    PropPtr propadr, pptr;
+    PropPtr propadr;
+    PropDirPtr pptr;
 
     CHECKOP(1);
     oper1 = POP();
@@ -28,7 +28,7 @@
 #include "log.h"
 #include "mufevent.h"
 #include "player.h"
-#include "smtp.h"
+#include "smtpqueue.h"
 #include "timequeue.h"
 #include "tune.h"
 
@@ -704,22 +704,24 @@ prim_fork(PRIM_PROTOTYPE)
 
     fr->pc = pc;
 
-    tmpfr = calloc(1, sizeof(struct frame));
-    tmpfr->next = NULL;
+    tmpfr = alloc_frame();
 
     array_init_active_list(&tmpfr->array_active_list);
     stk_array_active_list = &tmpfr->array_active_list;
 
+    grow_system_stack(tmpfr, fr->system.top);
     tmpfr->system.top = fr->system.top;
     for (int i = 0; i < fr->system.top; i++) {
         tmpfr->system.st[i] = fr->system.st[i];
     }
 
+    grow_argument_stack(tmpfr, fr->argument.top + 1, 0);
     tmpfr->argument.top = fr->argument.top;
     for (int i = 0; i < fr->argument.top; i++) {
         deep_copyinst(&fr->argument.st[i], &tmpfr->argument.st[i], -1);
     }
 
+    grow_caller_stack(tmpfr, fr->caller.top + 1);
     tmpfr->caller.top = fr->caller.top;
     for (int i = 0; i <= fr->caller.top; i++) {
         tmpfr->caller.st[i] = fr->caller.st[i];
@@ -2147,8 +2149,10 @@ prim_debug_line(PRIM_PROTOTYPE)
  * Sends an email via the SMTP library if email is configured.
  *
  * Consumes 3 strings and an array/list of strings.  To, to name, subject,
- * and then the email body.  Returns an integer -- 0 on success, -1 if
- * SMTP is not configured, -2 on failure.
+ * and then the email body.  The mail is queued and sent in the background;
+ * see smtp_queue_add.  Returns an integer -- the positive job ID that will
+ * be used for the "SMTP.<id>" completion event, -1 if SMTP is not
+ * configured, or -2 if the mail could not be queued.
  *
  * Requires WIZARD perms.
  *
@@ -2164,9 +2168,7 @@ void
 prim_smtp_send(PRIM_PROTOTYPE)
 {
     int result;
-    char           body[BUFFER_LEN];
-    struct smtp    *smtp = NULL;
-    int            rc;
+    char body[BUFFER_LEN];
 
     if (mlev < 4) {
         abort_interp("Permission Denied.");
@@ -2244,87 +2246,15 @@ prim_smtp_send(PRIM_PROTOTYPE)
         abort_interp("Operation would result in overflow(4)");
     }
 
-    /*
-     * Set up to make our email.
-     *
-     * TODO: Put this in its own function rather than burried in a MUF
-     * prim.  Also this can support cert files, not sure what that is for
-     * or if we need it.  That's the NULL parameter here.
-     */
-    rc = smtp_open(tp_smtp_server, tp_smtp_port, tp_smtp_ssl_type,
-                   tp_smtp_no_verify_cert ? SMTP_NO_CERT_VERIFY : 0,
-                   NULL, &smtp);
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    rc = smtp_auth(smtp, tp_smtp_auth_type, tp_smtp_user, tp_smtp_password);
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    rc = smtp_address_add(smtp,
-                          SMTP_ADDRESS_FROM,
-                          tp_smtp_from_email,
-                          tp_smtp_from_name);
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    rc = smtp_address_add(smtp,
-                          SMTP_ADDRESS_TO,
-                          oper1->data.string->data,
-                          (oper2->data.string && oper2->data.string->length) ?
-                          oper2->data.string->data : "");
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    rc = smtp_header_add(smtp,
-                         "Subject",
-                         oper3->data.string->data);
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    rc = smtp_mail(smtp, body);
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    rc = smtp_close(smtp);
-
-    if (rc != SMTP_STATUS_OK) {
-        goto smtp_cleanup_error;
-    }
-
-    CLEAR(oper1);
-    CLEAR(oper2);
-    CLEAR(oper3);
-    CLEAR(oper4);
-
-    result = 0;
-    PushInt(result);
-    return;
-
-smtp_cleanup_error:
-    log_status("ERROR: email send failed: %s", smtp_status_code_errstr(rc));
-
-    if (smtp) {
-        smtp_close(smtp);
-    }
+    result = smtp_queue_add(fr, oper1->data.string->data,
+                            (oper2->data.string && oper2->data.string->length) ?
+                            oper2->data.string->data : "",
+                            oper3->data.string->data, body);
 
     CLEAR(oper1);
     CLEAR(oper2);
     CLEAR(oper3);
     CLEAR(oper4);
 
-    result = -2;
     PushInt(result);
 }
@@ -62,6 +62,61 @@ static dbref ref;
  */
 static char buf[BUFFER_LEN];
 
+/**
+ * Get a property, using the calling instruction's inline cache if it has one
+ *
+ * This finds the same property get_property would.  If the compiler made
+ * a cache for 'pc' and 'path' is the string it was made for, the path does
+ * not have to be split up again, and the lookup is skipped entirely when
+ * 'obj' is the object last looked up and no property has been added or
+ * removed since.
+ *
+ * @private
+ * @param program the program being run
+ * @param pc the primitive instruction being run
+ * @param path the path string the program passed in
+ * @param obj the object to get the property from
+ * @param pname the property name, with trailing slashes removed
+ * @return the property or NULL if not found
+ */
+static PropPtr
+cached_get_property(dbref program, struct inst *pc,
+                    struct shared_string *path, dbref obj, const char *pname)
+{
+    struct prop_cache *caches = PROGRAM_PROPCACHES(program);
+    struct prop_cache *pcache = NULL;
+    int lo = 0, hi = PROGRAM_PROPCACHECOUNT(program) - 1;
+
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+
+        if (caches[mid].pc == pc) {
+            pcache = &caches[mid];
+            break;
+        } else if (caches[mid].pc < pc) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if (!pcache || pcache->path != path)
+        return get_property(obj, pname);
+
+#ifdef DISKBASE
+    fetchprops(obj, propdir_name(pname));
+#endif
+
+    if (pcache->obj != obj || pcache->serial != props_serial) {
+        pcache->prop = propdir_get_parts(DBFETCH(obj)->properties,
+                                         pcache->parts);
+        pcache->obj = obj;
+        pcache->serial = props_serial;
+    }
+
+    return pcache->prop;
+}
+
 /**
  * Checks prop reading permissions
  *
@@ -204,7 +259,18 @@ prim_getpropval(PRIM_PROTOTYPE)
             type[len] = '\0';
         }
 
-        result = get_property_value(oper2->data.objref, type);
+        PropPtr ptr = cached_get_property(program, pc, oper1->data.string,
+                                          oper2->data.objref, type);
+
+        result = 0;
+
+        if (ptr) {
+#ifdef DISKBASE
+            propfetch(oper2->data.objref, ptr);
+#endif
+            if (PropType(ptr) == PROP_INTTYP)
+                result = PropDataVal(ptr);
+        }
     }
 
     CLEAR(oper1);
@@ -257,7 +323,18 @@ prim_getpropfval(PRIM_PROTOTYPE)
             type[len] = '\0';
         }
 
-        fresult = get_property_fvalue(oper2->data.objref, type);
+        PropPtr ptr = cached_get_property(program, pc, oper1->data.string,
+                                          oper2->data.objref, type);
+
+        fresult = 0.0;
+
+        if (ptr) {
+#ifdef DISKBASE
+            propfetch(oper2->data.objref, ptr);
+#endif
+            if (PropType(ptr) == PROP_FLTTYP)
+                fresult = PropDataFVal(ptr);
+        }
     }
 
     CLEAR(oper1);
@@ -314,7 +391,8 @@ prim_getprop(PRIM_PROTOTYPE)
         }
 
         obj2 = oper2->data.objref;
-        prptr = get_property(obj2, type);
+        prptr = cached_get_property(program, pc, oper1->data.string, obj2,
+                                    type);
 
         CLEAR(oper1);
         CLEAR(oper2);
@@ -415,7 +493,8 @@ prim_getpropstr(PRIM_PROTOTYPE)
             type[len] = '\0';
         }
 
-        ptr = get_property(oper2->data.objref, type);
+        ptr = cached_get_property(program, pc, oper1->data.string,
+                                  oper2->data.objref, type);
 
         if (!ptr) {
             temp = "";
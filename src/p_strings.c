@@ -2160,10 +2160,11 @@ prim_strcat(PRIM_PROTOTYPE)
                > (BUFFER_LEN) - 1) {
         abort_interp("Operation would result in overflow.");
     } else {
-        memmove(buf, oper2->data.string->data, oper2->data.string->length);
-        memmove(buf + oper2->data.string->length, oper1->data.string->data,
-                oper1->data.string->length + 1);
-        string = alloc_prog_string(buf);
+        /* The result takes over oper2's reference to its string. */
+        string = append_prog_string(oper2->data.string,
+                                    oper1->data.string->data,
+                                    oper1->data.string->length);
+        oper2->data.string = NULL;
     }
 
     CLEAR(oper1);
@@ -2432,6 +2433,10 @@ prim_notify_exclude(PRIM_PROTOTYPE)
         CLEAR(oper1);
 
         if (*buf) {
+            struct broadcast bc;
+
+            broadcast_init(&bc, buf);
+
             while (what != NOTHING) {
                 if (OBJECT_TYPE(what) != TYPE_ROOM) {
                     for (tmp = 0, i = count; i-- > 0;) {
@@ -2443,10 +2448,13 @@ prim_notify_exclude(PRIM_PROTOTYPE)
                 }
 
                 if (!tmp)
-                    notify_listeners(player, program, what, where, buf, 0);
+                    notify_listeners_shared(player, program, what, where, buf,
+                                            0, &bc);
 
                 what = NEXTOBJ(what);
             }
+
+            broadcast_free(&bc);
         }
 
         if (tp_allow_listeners) {
@@ -2505,11 +2513,18 @@ prim_otell(PRIM_PROTOTYPE)
     what = CONTENTS(where);
 
     if (*buf) {
+        struct broadcast bc;
+
+        broadcast_init(&bc, buf);
+
         for (; what != NOTHING; what = NEXTOBJ(what)) {
             if (OBJECT_TYPE(what) != TYPE_ROOM && what != player) {
-                notify_listeners(player, program, what, where, buf, 0);
+                notify_listeners_shared(player, program, what, where, buf, 0,
+                                        &bc);
             }
         }
+
+        broadcast_free(&bc);
     }
 
     if (tp_allow_listeners) {
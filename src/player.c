@@ -39,7 +39,7 @@
  *
  * This is not threadsafe but could easily be so with a mutex.
  */
-static hash_tab player_list[PLAYER_HASH_SIZE];
+static hash_tab player_list;
 
 /**
  * Look up a player by name
@@ -58,7 +58,7 @@ lookup_player(const char *name)
 {
     hash_data *hd;
 
-    if ((hd = find_hash(name, player_list, PLAYER_HASH_SIZE)) == NULL) {
+    if ((hd = find_hash(name, &player_list)) == NULL) {
         return NOTHING;
     } else {
         return (hd->dbval);
@@ -225,11 +225,11 @@ create_player(const char *name, const char *password, char *error)
     player = new_object(true);
 
     /* initialize everything */
-    NAME(player) = alloc_string(name);
+    NAME(player) = alloc_interned(name);
     add_property(player, PLAYER_CREATED_AS_PROP, name, 0);
     LOCATION(player) = tp_player_start;
     FLAGS(player) = TYPE_PLAYER;
-    OWNER(player) = player;
+    db_set_owner(player, player);
     ALLOC_PLAYER_SP(player);
     PLAYER_SET_HOME(player, tp_player_start);
     EXITS(player) = NOTHING;
@@ -273,35 +273,48 @@ void
 toad_player(int descr, dbref player, dbref victim, dbref recipient)
 {
     char buf[BUFFER_LEN];
+    dbref *refs;
+    int count;
 
     send_contents(descr, victim, HOME);
     dequeue_prog(victim, 0);
 
-    for (dbref stuff = 0; stuff < db_top; stuff++) {
-        if (OWNER(stuff) == victim) {
-            switch (OBJECT_TYPE(stuff)) {
-                case TYPE_PROGRAM:
-                    dequeue_prog(stuff, 0);
-                    if (TrueWizard(recipient)) {
-                        FLAGS(stuff) &= ~(ABODE | WIZARD);
-                        SetMLevel(stuff, 1);
-                    }
-                    /* fall through */
-
-                case TYPE_ROOM:
-                case TYPE_THING:
-                case TYPE_EXIT:
-                    OWNER(stuff) = recipient;
-                    DBDIRTY(stuff);
-                    break;
-            }
+    refs = db_copy_referrers(victim, REFS_OWNED, &count);
+
+    for (int i = 0; i < count; i++) {
+        dbref stuff = refs[i];
+
+        switch (OBJECT_TYPE(stuff)) {
+            case TYPE_PROGRAM:
+                dequeue_prog(stuff, 0);
+                if (TrueWizard(recipient)) {
+                    FLAGS(stuff) &= ~(ABODE | WIZARD);
+                    SetMLevel(stuff, 1);
+                }
+                /* fall through */
+
+            case TYPE_ROOM:
+            case TYPE_THING:
+            case TYPE_EXIT:
+                db_set_owner(stuff, recipient);
+                DBDIRTY(stuff);
+                break;
         }
+    }
+
+    free(refs);
+    refs = db_copy_referrers(victim, REFS_LINKED, &count);
+
+    for (int i = 0; i < count; i++) {
+        dbref stuff = refs[i];
 
         if (OBJECT_TYPE(stuff) == TYPE_THING && THING_HOME(stuff) == victim) {
             THING_SET_HOME(stuff, tp_lost_and_found);
         }
     }
 
+    free(refs);
+
     chown_macros(macrotop, victim, recipient);
 
     free((void *) PLAYER_PASSWORD(victim));
@@ -309,8 +322,8 @@ toad_player(int descr, dbref player, dbref victim, dbref recipient)
 
     player_hash_delete(victim);
     snprintf(buf, sizeof(buf), "A slimy toad named %s", NAME(victim));
-    free((void *) NAME(victim));
-    NAME(victim) = alloc_string(buf);
+    free_interned(NAME(victim));
+    NAME(victim) = alloc_interned(buf);
     DBDIRTY(victim);
 
     boot_player_off(victim);
@@ -327,7 +340,7 @@ toad_player(int descr, dbref player, dbref victim, dbref recipient)
     THING_SET_HOME(victim, PLAYER_HOME(player));
 
     FLAGS(victim) = TYPE_THING;
-    OWNER(victim) = player;
+    db_set_owner(victim, player);
 
     if (tp_toad_recycle) {
         recycle(descr, player, victim);
@@ -373,7 +386,7 @@ do_password(dbref player, const char *old, const char *newobj)
 void
 clear_players(void)
 {
-    kill_hash(player_list, PLAYER_HASH_SIZE, 0);
+    kill_hash(&player_list, 0);
     return;
 }
 
@@ -391,7 +404,7 @@ player_hash_add(dbref who)
 
     hd.dbval = who;
 
-    if (add_hash(NAME(who), hd, player_list, PLAYER_HASH_SIZE) == NULL) {
+    if (add_hash(NAME(who), hd, &player_list) == NULL) {
         panic("Out of memory");
     } else {
         return;
@@ -425,7 +438,7 @@ player_hash_delete(dbref who)
     dbref found, ren;
     int j;
 
-    result = free_hash(NAME(who), player_list, PLAYER_HASH_SIZE);
+    result = free_hash(NAME(who), &player_list);
 
     if (result) {
         wall_wizards(
@@ -470,7 +483,7 @@ player_hash_delete(dbref who)
                                NAME(ren), ren, namebuf);
 
                     if (ren == found) {
-                        free_hash(NAME(ren), player_list, PLAYER_HASH_SIZE);
+                        free_hash(NAME(ren), &player_list);
                     }
 
                     change_player_name(ren, namebuf);
@@ -481,7 +494,7 @@ player_hash_delete(dbref who)
             }
         }
 
-        result = free_hash(NAME(who), player_list, PLAYER_HASH_SIZE);
+        result = free_hash(NAME(who), &player_list);
 
         if (result) {
             wall_wizards(
@@ -568,7 +581,8 @@ void
 change_player_name(dbref player, const char *name)
 {
     char buf[BUFFER_LEN];
-    PropPtr propadr, pptr;
+    PropPtr propadr;
+    PropDirPtr pptr;
     char propname[BUFFER_LEN];
     time_t t, now = time(NULL), cutoff = now - tp_pname_history_threshold;
 
@@ -582,16 +596,19 @@ change_player_name(dbref player, const char *name)
                 break;
 
             snprintf(buf, sizeof(buf), "%s/%d", PNAME_HISTORY_PROPDIR, (int)t);
-            propadr = next_prop(pptr, propadr, propname, sizeof(propname));
             remove_property(player, buf);
+
+            /* Removing a prop changes the directory, so start again. */
+            propadr = first_prop(player, PNAME_HISTORY_PROPDIR, &pptr, propname,
+                                 sizeof(propname));
         }
     }
 
     snprintf(buf, sizeof(buf), "%s/%d", PNAME_HISTORY_PROPDIR, (int)now);
     add_property(player, buf, name, 0);
 
-    free((void *) NAME(player));
+    free_interned(NAME(player));
 
-    NAME(player) = alloc_string(name);
+    NAME(player) = alloc_interned(name);
     ts_modifyobject(player);
 }
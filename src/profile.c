@@ -0,0 +1,472 @@
+/** @file profile.c
+ *
+ * Source for the sampling profiler for MUF and MPI.
+ *
+ * A SIGPROF interval timer sets profile_sample_due.  Nothing else happens
+ * in the signal handler: whoever is running checks the flag at their next
+ * step and takes the sample, which clears it.  The interpreter checks it
+ * at the top of its loop, and doesn't skip that while a sample is due
+ * (@see NEXT_INSTRUCTION), so samples land on the instruction that was
+ * running.  MPI checks it before each function call, and the main loop
+ * picks up ticks that arrived while neither was running.
+ *
+ * A tick that arrives while the server is doing other work just before it
+ * runs MUF or MPI is counted against that code instead.  The timer counts
+ * the CPU time of the whole process, so time spent by helper threads is
+ * counted against whatever the main thread is doing.
+ *
+ * Each sample is turned into its collapsed stack text right away, and the
+ * stacks are counted in a hash table.  At most PROFILE_MAX_STACKS
+ * different stacks are kept; samples of any others are counted as
+ * "(dropped)".
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WIN32
+# include <sys/time.h>
+#endif
+
+#include "config.h"
+
+#include "db.h"
+#include "hashtab.h"
+#include "inst.h"
+#include "interp.h"
+#include "profile.h"
+#include "tune.h"
+
+/**
+ * @var set by the timer when a sample is due, and cleared by taking one
+ */
+volatile sig_atomic_t profile_sample_due = 0;
+
+/**
+ * @private
+ * @var true while the timer is running
+ */
+static int profile_running = 0;
+
+/**
+ * @private
+ * @var the number of samples taken, for each collapsed stack
+ */
+static hash_tab profile_stacks;
+
+/**
+ * @private
+ * @var the number of samples taken since the last clear
+ */
+static long profile_samples = 0;
+
+/**
+ * @private
+ * @var when the samples since the last clear started, or 0 if none have
+ */
+static time_t profile_started = 0;
+
+/**
+ * An MPI function being run
+ */
+struct profile_mpi_frame {
+    dbref what;                 /**< The object the MPI is running on */
+    const char *name;           /**< The name of the function */
+};
+
+/**
+ * @private
+ * @var the MPI functions being run, outermost first
+ */
+static struct profile_mpi_frame profile_mpi_stack[PROFILE_MAX_FRAMES];
+
+/**
+ * @private
+ * @var the number of MPI functions being run, which may be more than fit
+ *      in profile_mpi_stack
+ */
+static int profile_mpi_depth = 0;
+
+#ifndef WIN32
+/**
+ * Handle a profiler timer tick
+ *
+ * @private
+ * @param sig the signal number (ignored)
+ */
+static void
+profile_tick(int sig)
+{
+    (void) sig;
+    profile_sample_due = 1;
+}
+#endif
+
+/**
+ * Start the profiler
+ *
+ * Samples are added to any that have been taken before.  Starting a
+ * running profiler picks up a new profile_sample_msec.
+ *
+ * @return true if the profiler is running, false if it is not supported
+ */
+int
+profile_start(void)
+{
+#ifdef WIN32
+    return 0;
+#else
+    struct sigaction act;
+    struct itimerval timer;
+    int msec = tp_profile_sample_msec > 0 ? tp_profile_sample_msec : 1;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = profile_tick;
+    act.sa_flags = SA_RESTART;
+    sigemptyset(&act.sa_mask);
+
+    if (sigaction(SIGPROF, &act, NULL))
+        return 0;
+
+    timer.it_interval.tv_sec = msec / 1000;
+    timer.it_interval.tv_usec = (msec % 1000) * 1000;
+    timer.it_value = timer.it_interval;
+
+    if (setitimer(ITIMER_PROF, &timer, NULL))
+        return 0;
+
+    if (!profile_started)
+        profile_started = time(NULL);
+
+    profile_running = 1;
+    return 1;
+#endif
+}
+
+/**
+ * Stop the profiler
+ *
+ * The samples taken so far are kept until they are cleared.
+ */
+void
+profile_stop(void)
+{
+#ifndef WIN32
+    struct itimerval timer;
+
+    if (profile_running) {
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, NULL);
+        signal(SIGPROF, SIG_IGN);
+    }
+#endif
+
+    profile_running = 0;
+    profile_sample_due = 0;
+}
+
+/**
+ * Throw away all the samples taken so far
+ */
+void
+profile_clear(void)
+{
+    kill_hash(&profile_stacks, 0);
+    profile_samples = 0;
+    profile_started = profile_running ? time(NULL) : 0;
+}
+
+/**
+ * Get the state of the profiler
+ *
+ * Any of the pointers may be NULL.
+ *
+ * @param running set to true if the profiler is running
+ * @param samples set to the number of samples taken
+ * @param stacks set to the number of different stacks seen
+ * @return when the samples were started, or 0 if none have been
+ */
+time_t
+profile_status(int *running, long *samples, int *stacks)
+{
+    if (running)
+        *running = profile_running;
+
+    if (samples)
+        *samples = profile_samples;
+
+    if (stacks)
+        *stacks = (int) profile_stacks.count;
+
+    return profile_started;
+}
+
+/**
+ * Write the samples taken so far to a file in collapsed stack format
+ *
+ * @param filename the file to write, which is replaced
+ * @return the number of stacks written, or -1 if the file can't be written
+ */
+int
+profile_write(const char *filename)
+{
+    FILE *f;
+    int written = 0;
+
+    if ((f = fopen(filename, "wb")) == NULL)
+        return -1;
+
+    for (unsigned int i = 0; i < profile_stacks.size; i++) {
+        for (hash_entry *hp = profile_stacks.buckets[i]; hp; hp = hp->next) {
+            fprintf(f, "%s %d\n", hp->name, hp->dat.ival);
+            written++;
+        }
+    }
+
+    if (fclose(f))
+        return -1;
+
+    return written;
+}
+
+/**
+ * Add a frame to the end of a collapsed stack
+ *
+ * ';' separates frames, so any in the frame's text are changed to ':'.
+ * If the stack is full, the frame is cut short.
+ *
+ * @private
+ * @param buf the stack
+ * @param size the size of buf
+ * @param len the length of the stack, which is updated
+ * @param format printf style format for the frame's text
+ * @param ... arguments for the format
+ */
+static void
+profile_add_frame(char *buf, size_t size, size_t *len, const char *format,
+                  ...)
+{
+    char frame[BUFFER_LEN];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(frame, sizeof(frame), format, args);
+    va_end(args);
+
+    if (*len > 0 && *len < size - 1)
+        buf[(*len)++] = ';';
+
+    for (const char *p = frame; *p && *len < size - 1; p++)
+        buf[(*len)++] = (*p == ';') ? ':' : *p;
+
+    buf[*len] = '\0';
+}
+
+/**
+ * Add the frame for a MUF word to a collapsed stack
+ *
+ * @private
+ * @param buf the stack
+ * @param size the size of buf
+ * @param len the length of the stack, which is updated
+ * @param program the program the word is in
+ * @param pc an instruction in the word
+ */
+static void
+profile_add_muf_frame(char *buf, size_t size, size_t *len, dbref program,
+                      struct inst *pc)
+{
+    struct inst *code = PROGRAM_CODE(program);
+    const char *word = "???";
+
+    if (code && pc >= code) {
+        while (pc > code && pc->type != PROG_FUNCTION)
+            pc--;
+
+        if (pc->type == PROG_FUNCTION)
+            word = pc->data.mufproc->procname;
+    }
+
+    profile_add_frame(buf, size, len, "%s(#%d):%s", NAME(program), program,
+                      word);
+}
+
+/**
+ * Add the frames for the running MPI functions to a collapsed stack
+ *
+ * Each function gets a frame, after a frame for the object it runs on
+ * whenever that changes.
+ *
+ * @private
+ * @param buf the stack
+ * @param size the size of buf
+ * @param len the length of the stack, which is updated
+ */
+static void
+profile_add_mpi_frames(char *buf, size_t size, size_t *len)
+{
+    dbref what = NOTHING;
+    int depth = profile_mpi_depth;
+
+    if (depth > PROFILE_MAX_FRAMES)
+        depth = PROFILE_MAX_FRAMES;
+
+    for (int i = 0; i < depth; i++) {
+        struct profile_mpi_frame *frame = &profile_mpi_stack[i];
+
+        if (frame->what != what) {
+            what = frame->what;
+            profile_add_frame(buf, size, len, "%s(#%d)",
+                              ObjExists(what) ? NAME(what) : "?", what);
+        }
+
+        profile_add_frame(buf, size, len, "{%s}", frame->name);
+    }
+}
+
+/**
+ * Count a sample
+ *
+ * @private
+ * @param stack the sample's collapsed stack
+ */
+static void
+profile_count(const char *stack)
+{
+    hash_data *count;
+    hash_data zero;
+    hash_entry *entry;
+
+    profile_sample_due = 0;
+    profile_samples++;
+
+    if (!(count = find_hash(stack, &profile_stacks))) {
+        if (profile_stacks.count >= PROFILE_MAX_STACKS) {
+            stack = "(dropped)";
+            count = find_hash(stack, &profile_stacks);
+        }
+
+        if (!count) {
+            zero.ival = 0;
+
+            if (!(entry = add_hash(stack, zero, &profile_stacks)))
+                return;
+
+            count = &entry->dat;
+        }
+    }
+
+    count->ival++;
+}
+
+/**
+ * Take a sample of a running MUF program
+ *
+ * This is called by the interpreter when profile_sample_due is set, with
+ * its own copies of the program counter and system stack.
+ *
+ * @param program the program being run
+ * @param pc the instruction about to be run
+ * @param sys the system stack, holding the return addresses of callers
+ * @param stop the top of the system stack
+ */
+void
+profile_sample_muf(dbref program, struct inst *pc, struct stack_addr *sys,
+                   int stop)
+{
+    char stack[BUFFER_LEN];
+    size_t len = 0;
+    int first = 1;
+
+    if (!profile_running) {
+        profile_sample_due = 0;
+        return;
+    }
+
+    stack[0] = '\0';
+    profile_add_mpi_frames(stack, sizeof(stack), &len);
+
+    /*
+     * sys[1] up to sys[stop - 1] are the return addresses of the callers,
+     * outermost first.  Each points just past its call.
+     */
+    if (stop - first > PROFILE_MAX_FRAMES) {
+        first = stop - PROFILE_MAX_FRAMES;
+        profile_add_frame(stack, sizeof(stack), &len, "...");
+    }
+
+    for (int i = first; i < stop; i++) {
+        profile_add_muf_frame(stack, sizeof(stack), &len, sys[i].progref,
+                              sys[i].offset - 1);
+    }
+
+    profile_add_muf_frame(stack, sizeof(stack), &len, program, pc);
+    profile_add_frame(stack, sizeof(stack), &len, "line %d", pc->line);
+    profile_count(stack);
+}
+
+/**
+ * Note that an MPI function is about to be run
+ *
+ * This keeps the stack of running MPI functions, and takes a sample if
+ * one is due.  Each call must be matched by a call to profile_mpi_leave.
+ * 'name' must stay valid until then.
+ *
+ * @param what the object the MPI is running on
+ * @param name the name of the function
+ */
+void
+profile_mpi_enter(dbref what, const char *name)
+{
+    char stack[BUFFER_LEN];
+    size_t len = 0;
+
+    if (profile_mpi_depth < PROFILE_MAX_FRAMES) {
+        profile_mpi_stack[profile_mpi_depth].what = what;
+        profile_mpi_stack[profile_mpi_depth].name = name;
+    }
+
+    profile_mpi_depth++;
+
+    if (!profile_sample_due)
+        return;
+
+    if (!profile_running) {
+        profile_sample_due = 0;
+        return;
+    }
+
+    stack[0] = '\0';
+    profile_add_mpi_frames(stack, sizeof(stack), &len);
+    profile_count(stack);
+}
+
+/**
+ * Note that the last MPI function passed to profile_mpi_enter has finished
+ */
+void
+profile_mpi_leave(void)
+{
+    profile_mpi_depth--;
+}
+
+/**
+ * Take a sample outside of MUF and MPI
+ *
+ * This is called by the main loop when profile_sample_due is set.
+ */
+void
+profile_sample_server(void)
+{
+    if (!profile_running) {
+        profile_sample_due = 0;
+        return;
+    }
+
+    profile_count("(server)");
+}
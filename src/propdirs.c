@@ -41,7 +41,7 @@
  *         or NULL on error
  */
 PropPtr
-propdir_new_elem(PropPtr * root, char *path)
+propdir_new_elem(PropDirPtr * root, char *path)
 {
     PropPtr p;
     char *n;
@@ -83,15 +83,15 @@ propdir_new_elem(PropPtr * root, char *path)
  *
  * @see delete_prop
  *
- * @param root The root property node to start your search
+ * @param root The root property directory to start your search
  * @param path the path you are searching for to delete.
  *
- * @return the updated root node with the property removed.  Because this
+ * @return the updated root directory with the property removed.  Because this
  *         mutates the passed structure, this is equivalent to the 'root'
  *         parameter.
  */
-PropPtr
-propdir_delete_elem(PropPtr root, char *path)
+PropDirPtr
+propdir_delete_elem(PropDirPtr root, char *path)
 {
     PropPtr p;
     char *n;
@@ -163,7 +163,7 @@ propdir_delete_elem(PropPtr root, char *path)
  * @return the found property or NULL if not found.
  */
 PropPtr
-propdir_get_elem(PropPtr root, char *path)
+propdir_get_elem(PropDirPtr root, char *path)
 {
     PropPtr p;
     char *n;
@@ -207,6 +207,41 @@ propdir_get_elem(PropPtr root, char *path)
     }
 }
 
+/**
+ * Fetches a given property from the property path structure 'root',
+ * with the path already split up.
+ *
+ * This is for callers that look up the same path over and over, and
+ * finds the same property propdir_get_elem would.
+ *
+ * @see propdir_get_elem
+ *
+ * @param root The root of the property directory tree
+ * @param parts the names in the path, each followed by a '\0', with an
+ *              empty name after the last one
+ *
+ * @return the found property or NULL if not found.
+ */
+PropPtr
+propdir_get_parts(PropDirPtr root, const char *parts)
+{
+    PropPtr p;
+
+    if (!*parts)
+        return NULL;
+
+    while ((p = locate_prop(root, parts))) {
+        parts += strlen(parts) + 1;
+
+        if (!*parts)
+            return p;
+
+        root = PropDir(p);
+    }
+
+    return NULL;
+}
+
 /**
  * This gets the first element of a propdir given a certain path.
  * As this is something of a low level call, you may prefer to use
@@ -221,7 +256,7 @@ propdir_get_elem(PropPtr root, char *path)
  * @return the first element of the given path or NULL if not found.
  */
 PropPtr
-propdir_first_elem(PropPtr root, char *path)
+propdir_first_elem(PropDirPtr root, char *path)
 {
     PropPtr p;
 
@@ -256,7 +291,7 @@ propdir_first_elem(PropPtr root, char *path)
  * @return the next property in the propdir or NULL if no more.
  */
 PropPtr
-propdir_next_elem(PropPtr root, char *path)
+propdir_next_elem(PropDirPtr root, char *path)
 {
     PropPtr p;
     char *n;
@@ -334,13 +369,13 @@ propdir_name(const char *name)
  * Returns the path of the first unloaded propdir in a given path,
  * or NULL if all the propdirs to the path are loaded.
  *
- * @param root The root propdir node
+ * @param root The root property directory
  * @param path The path to operate on.
  *
  * @return path name as described above, or NULL.
  */
 const char *
-propdir_unloaded(PropPtr root, const char *path)
+propdir_unloaded(PropDirPtr root, const char *path)
 {
     PropPtr p;
     const char *n;
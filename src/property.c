@@ -171,7 +171,7 @@ set_property_nofetch(dbref player, const char *pname, PData * dat)
                     remove_property_nofetch(player, pname);
                 }
             } else {
-                SetPDataStr(p, alloc_string(dat->data.str));
+                SetPDataStr(p, alloc_interned(dat->data.str));
             }
 
             break;
@@ -399,23 +399,20 @@ remove_proplist_item(dbref player, PropPtr p, int allp)
 void
 remove_property_list(dbref player, int all)
 {
-    PropPtr l;
     PropPtr p;
-    PropPtr n;
+    char name[BUFFER_LEN];
 
 #ifdef DISKBASE
     fetchprops(player, NULL);
 #endif
 
-    if ((l = DBFETCH(player)->properties) != NULL) {
-        p = first_node(l);
+    p = first_node(DBFETCH(player)->properties);
 
-        while (p) {
-            n = next_node(l, PropName(p));
-            remove_proplist_item(player, p, all);
-            l = DBFETCH(player)->properties;
-            p = n;
-        }
+    while (p) {
+        /* Removing a prop moves the others, so go on by name. */
+        strcpyn(name, sizeof(name), PropName(p));
+        remove_proplist_item(player, p, all);
+        p = next_node(DBFETCH(player)->properties, name);
     }
 
 #ifdef DISKBASE
@@ -438,7 +435,7 @@ remove_property_list(dbref player, int all)
 void
 remove_property_nofetch(dbref player, const char *pname)
 {
-    PropPtr l;
+    PropDirPtr l;
     char buf[BUFFER_LEN];
     char *w;
 
@@ -905,10 +902,10 @@ set_property_flags(dbref player, const char *pname, int flags)
  * @param copy_hidden_props if true, this copies hidden properties
  * @return a struct plist that is a copy of all properties on 'old'.
  */
-PropPtr
+PropDirPtr
 copy_prop(dbref old, int copy_hidden_props)
 {
-    PropPtr p, n = NULL;
+    PropDirPtr p, n = NULL;
 
 #ifdef DISKBASE
     fetchprops(old, NULL);
@@ -934,7 +931,7 @@ copy_prop(dbref old, int copy_hidden_props)
 void
 copy_properties_onto(dbref from, dbref to)
 {
-    PropPtr from_props;
+    PropDirPtr from_props;
 #ifdef DISKBASE
     fetchprops(from, NULL);
     fetchprops(to, NULL);
@@ -969,7 +966,7 @@ copy_properties_onto(dbref from, dbref to)
  *         name will be an empty string.
  */
 PropPtr
-first_prop_nofetch(dbref player, const char *dir, PropPtr * list, char *name, size_t maxlen)
+first_prop_nofetch(dbref player, const char *dir, PropDirPtr * list, char *name, size_t maxlen)
 {
     char buf[BUFFER_LEN];
     PropPtr p;
@@ -1000,9 +997,10 @@ first_prop_nofetch(dbref player, const char *dir, PropPtr * list, char *name, si
 
     /* Try to fetch our propdir element. */
     strcpyn(buf, sizeof(buf), dir);
-    *list = p = propdir_get_elem(DBFETCH(player)->properties, buf);
+    p = propdir_get_elem(DBFETCH(player)->properties, buf);
 
     if (!p) { /* Not found */
+        *list = NULL;
         *name = '\0';
         return NULL;
     }
@@ -1043,7 +1041,7 @@ first_prop_nofetch(dbref player, const char *dir, PropPtr * list, char *name, si
  *         name will be an empty string.
  */
 PropPtr
-first_prop(dbref player, const char *dir, PropPtr * list, char *name, size_t maxlen)
+first_prop(dbref player, const char *dir, PropDirPtr * list, char *name, size_t maxlen)
 {
 
 #ifdef DISKBASE
@@ -1057,7 +1055,7 @@ first_prop(dbref player, const char *dir, PropPtr * list, char *name, size_t max
  * next_prop is a wrapper around next_node to provide a slightly different
  * way to get the next property.
  *
- * Given the root of an AVL 'list' and a property 'prop', this function
+ * Given a property directory 'list' and a property 'prop', this function
  * returns the next property after 'prop' or NULL if there is no next
  * property.
  *
@@ -1068,7 +1066,7 @@ first_prop(dbref player, const char *dir, PropPtr * list, char *name, size_t max
  *
  * maxlen is the length of your buffer.
  *
- * @param list the AVL prop list root
+ * @param list the property directory
  * @param prop the 'previous' node - we will get the next node after this one
  * @param name a buffer to copy the property name into
  * @param maxlen the length of that buffer.
@@ -1076,7 +1074,7 @@ first_prop(dbref player, const char *dir, PropPtr * list, char *name, size_t max
  * @return the next property node or NULL if no more.
  */
 PropPtr
-next_prop(PropPtr list, PropPtr prop, char *name, size_t maxlen)
+next_prop(PropDirPtr list, PropPtr prop, char *name, size_t maxlen)
 {
     PropPtr p = prop;
 
@@ -1109,7 +1107,8 @@ next_prop_name(dbref player, char *outbuf, size_t outbuflen, char *name)
 {
     char *ptr;
     char buf[BUFFER_LEN];
-    PropPtr p, l;
+    PropPtr p;
+    PropDirPtr l;
 
 #ifdef DISKBASE
     fetchprops(player, propdir_name(name));
@@ -1215,7 +1214,7 @@ is_propdir(dbref player, const char *pname)
     if (!p)
         return 0;
 
-    return (PropDir(p) != (PropPtr) NULL);
+    return (PropDir(p) != NULL);
 }
 
 /**
@@ -1382,7 +1381,7 @@ displayprop(dbref player, dbref obj, const char *name, char *buf, size_t bufsiz)
  * @param f DB File handle.
  * @param obj DBREF of object who's properties we are loading.
  * @param pos Position to load the property from, or 0 to load in squence.
- * @param pnode If we have an existing property AVL node to load into.
+ * @param pnode If we have an existing property node to load into.
  *              This may be NULL if you do not have it.
  * @param pdir This is used exclusively for error display.  This is
  *             usually a propdir but can be NULL.
@@ -1536,7 +1535,7 @@ db_get_single_prop(FILE * f, dbref obj, long pos, PropPtr pnode, const char *pdi
                 flg &= ~PROP_ISUNLOADED;
 
                 if (pnode) {
-                    SetPDataStr(pnode, alloc_string(value));
+                    SetPDataStr(pnode, alloc_interned(value));
                     SetPFlagsRaw(pnode, flg);
                 } else {
                     mydat.flags = flg;
@@ -1732,20 +1731,20 @@ db_putprop(FILE * f, const char *dir, PropPtr p)
 
 /**
  * Recursively dumps properties on object 'obj' to file handle 'f'
- * statring with directory 'dir' that has propdir object 'p'.
+ * statring with directory 'dir' that has propdir object 'pdir'.
  *
  * You would normally kick this off by passing "/" to dir.
  *
  * @private
  * @param obj the DB object ref
  * @param f The file handle to write to.
- * @param dir the path that belongs to p
- * @param p The proptr that belongs to path.
+ * @param dir the path that belongs to pdir
+ * @param pdir The property directory that belongs to path.
  *
  * @return integer number of properties dumped.
  */
 static int
-db_dump_props_rec(dbref obj, FILE * f, const char *dir, PropPtr p)
+db_dump_props_rec(dbref obj, FILE * f, const char *dir, PropDirPtr pdir)
 {
     char buf[BUFFER_LEN];
 #ifdef DISKBASE
@@ -1756,59 +1755,59 @@ db_dump_props_rec(dbref obj, FILE * f, const char *dir, PropPtr p)
     int count = 0;
     int pdcount;
 
-    if (!p)
+    if (!pdir)
         return 0;
 
-    count += db_dump_props_rec(obj, f, dir, p->left);
+    for (unsigned int i = 0; i < pdir->count; i++) {
+        PropPtr p = &pdir->props[i];
 
 #ifdef DISKBASE
-    wastouched = (PropFlags(p) & PROP_TOUCHED);
+        wastouched = (PropFlags(p) & PROP_TOUCHED);
 
-    if (tp_diskbase_propvals) {
-        tpos = ftell(f);
-    }
+        if (tp_diskbase_propvals) {
+            tpos = ftell(f);
+        }
 
-    if (wastouched) {
-        count++;
-    }
+        if (wastouched) {
+            count++;
+        }
 
-    if (propfetch(obj, p)) {
-        fseek(f, 0L, SEEK_END);
-    }
+        if (propfetch(obj, p)) {
+            fseek(f, 0L, SEEK_END);
+        }
 #endif
 
-    db_putprop(f, dir, p);
+        db_putprop(f, dir, p);
 
 #ifdef DISKBASE
-    if (tp_diskbase_propvals && !wastouched) {
-        if (PropType(p) == PROP_STRTYP || PropType(p) == PROP_LOKTYP) {
-            flg = PropFlagsRaw(p) | PROP_ISUNLOADED;
-            clear_propnode(p);
-            SetPFlagsRaw(p, flg);
-            SetPDataVal(p, tpos);
+        if (tp_diskbase_propvals && !wastouched) {
+            if (PropType(p) == PROP_STRTYP || PropType(p) == PROP_LOKTYP) {
+                flg = PropFlagsRaw(p) | PROP_ISUNLOADED;
+                clear_propnode(p);
+                SetPFlagsRaw(p, flg);
+                SetPDataVal(p, tpos);
+            }
         }
-    }
 #endif
 
-    if (PropDir(p)) {
-        const char *iptr;
-        char *optr;
+        if (PropDir(p)) {
+            const char *iptr;
+            char *optr;
 
-        for (iptr = dir, optr = buf; *iptr;)
-            *optr++ = *iptr++;
+            for (iptr = dir, optr = buf; *iptr;)
+                *optr++ = *iptr++;
 
-        for (iptr = PropName(p); *iptr;)
-            *optr++ = *iptr++;
+            for (iptr = PropName(p); *iptr;)
+                *optr++ = *iptr++;
 
-        *optr++ = PROPDIR_DELIMITER;
-        *optr++ = '\0';
+            *optr++ = PROPDIR_DELIMITER;
+            *optr++ = '\0';
 
-        pdcount = db_dump_props_rec(obj, f, buf, PropDir(p));
-        count += pdcount;
+            pdcount = db_dump_props_rec(obj, f, buf, PropDir(p));
+            count += pdcount;
+        }
     }
 
-    count += db_dump_props_rec(obj, f, dir, p->right);
-
     return count;
 }
 
@@ -1834,18 +1833,18 @@ db_dump_props(FILE * f, dbref obj)
  * @see untouchprops_incremental
  *
  * @private
- * @param p the propdir AVL to work on.
+ * @param pdir the propdir to work on.
  */
 static void
-untouchprop_rec(PropPtr p)
+untouchprop_rec(PropDirPtr pdir)
 {
-    if (!p)
+    if (!pdir)
         return;
 
-    SetPFlags(p, (PropFlags(p) & ~PROP_TOUCHED));
-    untouchprop_rec(p->left);
-    untouchprop_rec(p->right);
-    untouchprop_rec(PropDir(p));
+    for (unsigned int i = 0; i < pdir->count; i++) {
+        SetPFlags(&pdir->props[i], (PropFlags(&pdir->props[i]) & ~PROP_TOUCHED));
+        untouchprop_rec(PropDir(&pdir->props[i]));
+    }
 }
 
 /**
@@ -1874,7 +1873,7 @@ static dbref untouch_lastdone = 0;
 void
 untouchprops_incremental(int limit)
 {
-    PropPtr p;
+    PropDirPtr p;
 
     while (untouch_lastdone < db_top) {
         /* clear the touch flags */
@@ -25,216 +25,71 @@
 #include "props.h"
 
 /**
- * Returns the AVL 'height' of a given node
- *
- * @private
- * @param node The node to check
- *
- * @return the node height or 0 if node is NULL.
- */
-static int
-height_of(PropPtr node)
-{
-    if (node)
-        return node->height;
-    else
-        return 0;
-}
-
-/**
- * Returns the AVL 'height' difference between a node's left and
- * right node.
- *
- * @private
- * @param node the node to check
- *
- * @return the difference in height between left and right.
- *         Positive numbers mean right is 'heigher', negative
- *         numbers mean left is heigher, 0 is perfect balance.
+ * @var changed whenever a property is added to or removed from any
+ *      directory, which may move the properties around it.  A PropPtr
+ *      saved along with this value is still good while it is unchanged.
  */
-static int
-height_diff(PropPtr node)
-{
-    if (node)
-        return (height_of(node->right) - height_of(node->left));
-    else
-        return 0;
-}
+unsigned int props_serial = 0;
 
 /**
- * Recompute the node's height as the larger of its two children + 1
+ * Free the data of a property, but not the property itself
  *
  * @private
- * @param node the node to fix the height of
+ * @param p the property
  */
 static void
-fixup_height(PropPtr node)
-{
-    if (node)
-        node->height = 1 + MAX(height_of(node->left), height_of(node->right));
-}
-
-/**
- * This does a single "left" rotation on a given node 'a'.  The rotated
- * node is returned.
- *
- * @private
- * @param a the node to rotate.
- * @return the rotated node
- */
-static PropPtr
-rotate_left_single(PropPtr a)
+free_propdata(PropPtr p)
 {
-    PropPtr b = a->right;
-
-    a->right = b->left;
-    b->left = a;
-
-    fixup_height(a);
-    fixup_height(b);
-
-    return b;
-}
-
-/**
- * This does a double "left" rotation on a given node 'a'.  The rotated
- * node is returned.
- *
- * @private
- * @param a the node to rotate.
- * @return the rotated node
- */
-static PropPtr
-rotate_left_double(PropPtr a)
-{
-    PropPtr b = a->right, c = b->left;
-
-    a->right = c->left;
-    b->left = c->right;
-    c->left = a;
-    c->right = b;
-
-    fixup_height(a);
-    fixup_height(b);
-    fixup_height(c);
-
-    return c;
-}
-
-/**
- * This does a single "right" rotation on a given node 'a'.  The rotated
- * node is returned.
- *
- * @private
- * @param a the node to rotate.
- * @return the rotated node
- */
-static PropPtr
-rotate_right_single(PropPtr a)
-{
-    PropPtr b = a->left;
-
-    a->left = b->right;
-    b->right = a;
-
-    fixup_height(a);
-    fixup_height(b);
-
-    return (b);
-}
-
-/**
- * This does a double "right" rotation on a given node 'a'.  The rotated
- * node is returned.
- *
- * @private
- * @param a the node to rotate.
- * @return the rotated node
- */
-static PropPtr
-rotate_right_double(PropPtr a)
-{
-    PropPtr b = a->left, c = b->right;
-
-    a->left = c->right;
-    b->right = c->left;
-    c->right = a;
-    c->left = b;
-
-    fixup_height(a);
-    fixup_height(b);
-    fixup_height(c);
+    if (!(PropFlags(p) & PROP_ISUNLOADED)) {
+        if (PropType(p) == PROP_STRTYP)
+            free_interned(PropDataStr(p));
 
-    return c;
+        if (PropType(p) == PROP_LOKTYP)
+            free_boolexp(PropDataLok(p));
+    }
 }
 
 /**
- * This call balances the AVL node 'a' and returns the balanced node.
+ * Set up a blank property with the given name.
  *
  * @private
- * @param a the node to balance
- * @return the balanced node
+ * @param p the property
+ * @param name the property name; an interned copy is used
  */
-static PropPtr
-balance_node(PropPtr a)
+static void
+init_propnode(PropPtr p, const char *name)
 {
-    int dh = height_diff(a);
-
-    if (abs(dh) < 2) {
-        fixup_height(a);
-    } else {
-        /* One might argue the brackets are not necessary here, but
-         * this looked like a train wreck without them :)
-         */
-        if (dh == 2) {
-            if (height_diff(a->right) >= 0) {
-                a = rotate_left_single(a);
-            } else {
-                a = rotate_left_double(a);
-            }
-        } else if (height_diff(a->left) <= 0) {
-            a = rotate_right_single(a);
-        } else {
-            a = rotate_right_double(a);
-        }
-    }
-
-    return a;
+    p->key = alloc_interned(name);
+    SetPFlagsRaw(p, PROP_DIRTYP);
+    SetPDataVal(p, 0);
+    SetPDir(p, NULL);
 }
 
 /**
- * This allocates a property node for use in the property AVL tree.  The
+ * This allocates a property node that is not in any directory.  The
  * note has the given name (memory is copied over) and is set dirty, but
- * otherwise is a blank slate ready to be added to the AVL.
+ * otherwise is a blank slate.  Property locks use these.
  *
  * Chances are, you do not want to use this method.  It is exposed because
- * it is used in boolexp.c and props.c
+ * it is used in boolexp.c
  *
  * @internal
- * @param name String property name (memory will be copied)
- * @return allocated PropPtr AVL node.
+ * @param name String property name (an interned copy is used)
+ * @return allocated PropPtr node.
  */
 PropPtr
 alloc_propnode(const char *name)
 {
     PropPtr new_node;
-    size_t nlen = strlen(name);
 
-    new_node = malloc(sizeof(struct plist) + nlen);
+    new_node = malloc(sizeof(struct plist));
 
     if (!new_node) {
         fprintf(stderr, "alloc_propnode(): Out of Memory!\n");
         abort();
     }
 
-    new_node->left = NULL;
-    new_node->right = NULL;
-    new_node->height = 1;
-
-    strcpyn(PropName(new_node), nlen + 1, name);
-    SetPFlagsRaw(new_node, PROP_DIRTYP);
-    SetPDataVal(new_node, 0);
-    SetPDir(new_node, NULL);
+    init_propnode(new_node, name);
     return new_node;
 }
 
@@ -248,25 +103,8 @@ alloc_propnode(const char *name)
 void
 free_propnode(PropPtr p)
 {
-    if (!(PropFlags(p) & PROP_ISUNLOADED)) {
-        if (PropType(p) == PROP_STRTYP)
-            free(PropDataStr(p));
-
-        if (PropType(p) == PROP_LOKTYP)
-            free_boolexp(PropDataLok(p));
-    }
-
-    /* @TODO: The PropPtr object has a 'key' field which is
-     *        set up like char key[1];  In alloc_propnode, we use
-     *        strncpy to copy the name of the prop to the key field.
-     *
-     *        I should think we would need to free the key or we would
-     *        have a leak.  However, I should have also thought the key
-     *        should be a char* ... I don't actually understand how this
-     *        works.  It seems like it should be segfaulting and/or
-     *        leaking memory.  I want to review this in greater depth
-     *        later.
-     */
+    free_propdata(p);
+    free_interned(p->key);
     free(p);
 }
 
@@ -284,7 +122,7 @@ clear_propnode(PropPtr p)
 {
     if (!(PropFlags(p) & PROP_ISUNLOADED)) {
         if (PropType(p) == PROP_STRTYP) {
-            free(PropDataStr(p));
+            free_interned(PropDataStr(p));
             PropDataStr(p) = NULL;
         }
 
@@ -298,245 +136,219 @@ clear_propnode(PropPtr p)
 }
 
 /**
- * Get the 'maximum' AVL node, with the search starting at 'avl'.  This
- * basically finds the right-mode node.
+ * Find where a name is, or would go, in a property directory
  *
  * @private
- * @param avl the node to search
- * @return the rightmode ("max") node.
+ * @param dir the property directory, which must not be NULL
+ * @param key the name to look for
+ * @param found set to whether the name is there
+ * @return the position of the name, or of the first name after it
  */
-static PropPtr
-getmax(PropPtr avl)
+static unsigned int
+propdir_search(PropDirPtr dir, const char *key, int *found)
 {
-    if (avl && avl->right)
-        return getmax(avl->right);
+    unsigned int lo = 0, hi = dir->count, mid;
+    int cmpval;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        cmpval = strcasecmp(key, PropName(&dir->props[mid]));
+
+        if (cmpval > 0) {
+            lo = mid + 1;
+        } else if (cmpval < 0) {
+            hi = mid;
+        } else {
+            *found = 1;
+            return mid;
+        }
+    }
 
-    return avl;
+    *found = 0;
+    return lo;
 }
 
 /**
- * Remove a propnode named 'key' from the AVL root 'root'.  This function
- * is recursive.
- *
- * The node (removed from the AVL structure) is returned, or NULL if it
- * was not found.
+ * Delete a property from the given prop set, with the given property
+ * name.  It removes it from the directory 'list'.  Does not save it to
+ * the database right away.
  *
- * @private
- * @param key the prop name to remove
- * @param root the root node to start the removal process from
+ * The directory under the property is not freed; the caller must deal
+ * with it first.
  *
- * @return the removed node - you should probably free it with free_propnode
+ * @param list Pointer to the property directory; it becomes NULL when
+ *             the last property is deleted.
+ * @param name The name of the property to delete
+ * @return Returns the pointer that 'list' is pointing to.  Because 'list'
+ *         is modified, there is probably no reason to use the return
+ *         value.
  */
-static PropPtr
-remove_propnode(char *key, PropPtr * root)
+PropDirPtr
+delete_prop(PropDirPtr * list, const char *name)
 {
-    PropPtr save;
-    PropPtr tmp;
-    PropPtr avl = *root;
-    int cmpval;
+    PropDirPtr dir = *list;
+    unsigned int i;
+    int found;
 
-    save = avl;
+    if (!dir)
+        return NULL;
 
-    if (avl) {
-        cmpval = strcasecmp(key, PropName(avl));
+    i = propdir_search(dir, name, &found);
 
-        if (cmpval < 0) {
-            save = remove_propnode(key, &(avl->left));
-        } else if (cmpval > 0) {
-            save = remove_propnode(key, &(avl->right));
-        } else if (!(avl->left)) {
-            avl = avl->right;
-        } else if (!(avl->right)) {
-            avl = avl->left;
-        } else {
-            tmp = remove_propnode(PropName(getmax(avl->left)), &(avl->left));
+    if (!found)
+        return dir;
 
-            if (!tmp) { /* this shouldn't be possible. */
-                panic("remove_propnode() returned NULL !");
-            }
+    props_serial++;
 
-            tmp->left = avl->left;
-            tmp->right = avl->right;
-            avl = tmp;
-        }
-
-        if (save) {
-            save->left = NULL;
-            save->right = NULL;
-        }
+    /* 'name' may be this property's own name, so it is no good after. */
+    free_propdata(&dir->props[i]);
+    free_interned(dir->props[i].key);
 
-        *root = balance_node(avl);
+    if (!--dir->count) {
+        free(dir);
+        *list = NULL;
+        return NULL;
     }
 
-    return save;
-}
-
-/**
- * This is a method to delete a particular key from the AVL list.  It
- * frees the memory of the deleted node.
- *
- * @private
- * @param key the key to delete
- * @param avl the AVL prop structure to delete the key from.
- * @return the updated prop structure ... which is probably not
- *         a necessary return since the 'avl' itself is mutated by
- *         this process.
- */
-static PropPtr
-delnode(char *key, PropPtr avl)
-{
-    PropPtr save;
-
-    save = remove_propnode(key, &avl);
-
-    if (save)
-        free_propnode(save);
-    return avl;
+    memmove(&dir->props[i], &dir->props[i + 1],
+            sizeof(struct plist) * (dir->count - i));
+    return dir;
 }
 
 /**
- * Recursively deletes an entire proplist AVL with 'p' as the root,
- * and frees 'p' itself.
+ * Recursively deletes an entire property directory, and frees the
+ * directory itself.
  *
- * @param p The proplist to delete.
+ * @param p The property directory to delete.
  */
 void
-delete_proplist(PropPtr p)
+delete_proplist(PropDirPtr p)
 {
     if (!p)
         return;
 
-    delete_proplist(p->left);
-    delete_proplist(PropDir(p));
-    delete_proplist(p->right);
-    free_propnode(p);
-}
+    props_serial++;
 
+    for (unsigned int i = 0; i < p->count; i++) {
+        delete_proplist(PropDir(&p->props[i]));
+        free_propdata(&p->props[i]);
+        free_interned(p->props[i].key);
+    }
+
+    free(p);
+}
 
 /**
- * This finds a prop named 'key' in the AVL proplist 'avl'.  It is basically
- * a primitive for looking up items in the AVLs.
+ * This finds a prop named 'key' in the property directory 'dir'.  It is
+ * basically a primitive for looking up items in the directories.
  *
- * @param avl the AVL to search
+ * @param dir the property directory to search
  * @param key the key to look up
  *
  * @return the found node, or NULL if not found.
  */
 PropPtr
-locate_prop(PropPtr avl, char *key)
+locate_prop(PropDirPtr dir, const char *key)
 {
-    int cmpval;
+    unsigned int i;
+    int found;
 
-    while (avl) {
-        cmpval = strcasecmp(key, PropName(avl));
-
-        if (cmpval > 0) {
-            avl = avl->right;
-        } else if (cmpval < 0) {
-            avl = avl->left;
-        } else {
-            break;
-        }
-    }
+    if (!dir)
+        return NULL;
 
-    return avl;
+    i = propdir_search(dir, key, &found);
+    return found ? &dir->props[i] : NULL;
 }
 
 /**
- * This creates a new node in the AVL then returns the created node
- * so that you might populate it with data.  If the key already
- * exists, then the existing node is returned.
+ * This creates a new node in a property directory then returns the
+ * created node so that you might populate it with data.  If the key
+ * already exists, then the existing node is returned.
  *
- * @param avl the AVL to add a property to.
- * @param key the key to add to the AVL.
+ * The directory may move to make room, so 'dir' is updated, and any
+ * other PropPtr into it is no longer good.
  *
- * @return the newly created AVL node.
+ * @param dir the property directory to add a property to.
+ * @param key the key to add to the directory.
+ *
+ * @return the newly created node.
  */
 PropPtr
-new_prop(PropPtr *avl, char *key)
+new_prop(PropDirPtr * dir, const char *key)
 {
-    PropPtr ret;
-    PropPtr p = *avl;
-    int cmp;
-    static short balancep;
-
-    if (p) {
-        cmp = strcasecmp(key, PropName(p));
-
-        if (cmp > 0) {
-            ret = new_prop(&(p->right), key);
-        } else if (cmp < 0) {
-            ret = new_prop(&(p->left), key);
-        } else {
-            balancep = 0;
-            return (p);
-        }
+    PropDirPtr d = *dir;
+    unsigned int i;
+    int found = 0;
+
+    if (!d) {
+        i = 0;
+    } else if (strcasecmp(key, PropName(&d->props[d->count - 1])) > 0) {
+        /* Loading a database adds properties in order. */
+        i = d->count;
+    } else {
+        i = propdir_search(d, key, &found);
+
+        if (found)
+            return &d->props[i];
+    }
+
+    props_serial++;
+
+    if (!d || d->count == d->size) {
+        unsigned int size = d ? d->size + d->size / 2 + 1 : 1;
 
-        if (balancep) {
-            *avl = balance_node(p);
+        d = realloc(d, sizeof(struct propdir) + sizeof(struct plist) * size);
+
+        if (!d) {
+            fprintf(stderr, "new_prop(): Out of Memory!\n");
+            abort();
         }
 
-        return ret;
-    } else {
-        p = *avl = alloc_propnode(key);
-        balancep = 1;
-        return (p);
+        if (!*dir)
+            d->count = 0;
+
+        d->size = size;
+        *dir = d;
     }
-}
 
-/**
- * Delete a property from the given prop set, with the given property
- * name.  It removes it from the AVL of 'list'.  Does not save it to
- * the database right away.
- *
- * @param list Pointer to a PropPtr which is (usually) the root of the
- *             property AVL tree.
- * @param name The name of the property to delete
- * @return Returns the pointer that 'list' is pointing to.  Because 'list'
- *         is modified, there is probably no reason to use the return
- *         value.
- */
-PropPtr
-delete_prop(PropPtr * list, char *name)
-{
-    *list = delnode(name, *list);
-    return (*list);
+    memmove(&d->props[i + 1], &d->props[i],
+            sizeof(struct plist) * (d->count - i));
+    d->count++;
+    init_propnode(&d->props[i], key);
+    return &d->props[i];
 }
 
 /**
- * Finds the first node ("leftmost") on the property AVL list 'p' or
- * returns NULL if p has no nodes on it.
+ * Finds the first node on the property directory 'p' or returns NULL if
+ * p has no nodes on it.
  *
- * @param p PropPtr of the root of the AVL property list you want to scan.
+ * @param list the property directory you want to scan.
  *
- * @return First/leftmost node on proplist.
+ * @return First node on proplist.
  */
 PropPtr
-first_node(PropPtr list)
+first_node(PropDirPtr list)
 {
     if (!list)
         return ((PropPtr) NULL);
 
-    while (list->left)
-        list = list->left;
-
-    return (list);
+    return &list->props[0];
 }
 
 /**
- * next_node locates and returns the next node in the AVL (prop directory)
+ * next_node locates and returns the next node in the prop directory
  * or NULL if there is no more.  It is used for traversing a prop directory.
  *
- * @param ptr the AVL to navigate
+ * @param ptr the property directory to navigate
  * @param name The "previous path" ... what is returned is the next path
  *        after this one
  * @return the property we found, or NULL
  */
 PropPtr
-next_node(PropPtr ptr, char *name)
+next_node(PropDirPtr ptr, const char *name)
 {
-    PropPtr from;
-    int cmpval;
+    unsigned int i;
+    int found;
 
     if (!ptr)
         return NULL;
@@ -544,37 +356,22 @@ next_node(PropPtr ptr, char *name)
     if (!name || !*name)
         return (PropPtr) NULL;
 
-    cmpval = strcasecmp(name, PropName(ptr));
-
-    if (cmpval < 0) {
-        from = next_node(ptr->left, name);
+    i = propdir_search(ptr, name, &found);
 
-        if (from)
-            return from;
+    if (found)
+        i++;
 
-        return ptr;
-    } else if (cmpval > 0) {
-        return next_node(ptr->right, name);
-    } else if (ptr->right) {
-        from = ptr->right;
-
-        while (from->left)
-            from = from->left;
-
-        return from;
-    } else {
-        return NULL;
-    }
+    return i < ptr->count ? &ptr->props[i] : NULL;
 }
 
 /**
  * This is the underpinning for both copy_prop and copy_properties_onto
  *
- * It recursively copies properties from obj (the "old" PropPtr should
+ * It recursively copies properties from obj (the "old" directory should
  * be the root properties from "obj") into a structure "newer".
  *
- * newer may be either NULL or an existing prop tree.  The 'obj' dbref is
- * needed for diskbase reasons, however it looks like all consumers of
+ * newer may be either NULL or an existing prop directory.  The 'obj' dbref
+ * is needed for diskbase reasons, however it looks like all consumers of
  * this call do the diskbase load so that could probably be refactored out
  * pretty easily.
  *
@@ -587,92 +384,101 @@ next_node(PropPtr ptr, char *name)
  * @internal
  * @param obj DBREF object that 'old' props belong to.
  * @param newer Essentially a pointer to a pointer; the target structure
- * @param old The source property list
+ * @param old The source property directory
  * @param copy_hidden_props if true, this copies hidden properties
  */
 void
-copy_proplist(dbref obj, PropPtr * nu, PropPtr old, int copy_hidden_props)
+copy_proplist(dbref obj, PropDirPtr * nu, PropDirPtr old, int copy_hidden_props)
 {
-    PropPtr p;
+    PropPtr p, o;
 
-    if (old) {
-        if (!copy_hidden_props && Prop_Hidden(PropName(old))) return;
+    if (!old)
+        return;
+
+    for (unsigned int i = 0; i < old->count; i++) {
+        o = &old->props[i];
+
+        if (!copy_hidden_props && Prop_Hidden(PropName(o)))
+            continue;
 
 #ifdef DISKBASE
-        propfetch(obj, old);
+        propfetch(obj, o);
 #endif
-        p = new_prop(nu, PropName(old));
+        p = new_prop(nu, PropName(o));
         clear_propnode(p);
-        SetPFlagsRaw(p, PropFlagsRaw(old));
+        SetPFlagsRaw(p, PropFlagsRaw(o));
 
-        switch (PropType(old)) {
+        switch (PropType(o)) {
             case PROP_STRTYP:
-                SetPDataStr(p, alloc_string(PropDataStr(old)));
+                SetPDataStr(p, PropDataStr(o));
+                hold_interned(PropDataStr(o), 1);
                 break;
             case PROP_LOKTYP:
-                if (PropFlags(old) & PROP_ISUNLOADED) {
+                if (PropFlags(o) & PROP_ISUNLOADED) {
                     SetPDataLok(p, TRUE_BOOLEXP);
                     SetPFlags(p, (PropFlags(p) & ~PROP_ISUNLOADED));
                 } else {
-                    SetPDataLok(p, copy_bool(PropDataLok(old)));
+                    SetPDataLok(p, copy_bool(PropDataLok(o)));
                 }
                 break;
             case PROP_DIRTYP:
                 SetPDataVal(p, 0);
                 break;
             case PROP_FLTTYP:
-                SetPDataFVal(p, PropDataFVal(old));
+                SetPDataFVal(p, PropDataFVal(o));
                 break;
             default:
-                SetPDataVal(p, PropDataVal(old));
+                SetPDataVal(p, PropDataVal(o));
                 break;
         }
 
-        copy_proplist(obj, &PropDir(p), PropDir(old), copy_hidden_props);
-        copy_proplist(obj, &(p->left), old->left, copy_hidden_props);
-        copy_proplist(obj, &(p->right), old->right, copy_hidden_props);
+        copy_proplist(obj, &PropDir(p), PropDir(o), copy_hidden_props);
     }
 }
 
 /**
- * Calculates the size of the given property directory AVL list.  This
- * will iterate over the entire structure to give the entire size.  It
- * is the low level equivalent of size_properties
+ * Calculates the size of the given property directory.  This will
+ * iterate over the entire structure to give the entire size.  It is the
+ * low level equivalent of size_properties.
+ *
+ * Names are shared between properties, so they are not counted.
  *
  * @see size_properties
  *
- * @param avl the Property directory AVL to check
+ * @param dir the Property directory to check
  * @return the size of the loaded properties in memory -- this does NOT
  *         do any diskbase loading.
  */
 size_t
-size_proplist(PropPtr avl)
+size_proplist(PropDirPtr dir)
 {
     size_t bytes = 0;
+    PropPtr p;
 
-    if (!avl)
+    if (!dir)
         return 0;
 
-    bytes += sizeof(struct plist);
-
-    bytes += strlen(PropName(avl));
-
-    if (!(PropFlags(avl) & PROP_ISUNLOADED)) {
-        switch (PropType(avl)) {
-            case PROP_STRTYP:
-                bytes += strlen(PropDataStr(avl)) + 1;
-                break;
-            case PROP_LOKTYP:
-                bytes += size_boolexp(PropDataLok(avl));
-                break;
-            default:
-                break;
+    bytes += sizeof(struct propdir) + sizeof(struct plist) * dir->size;
+
+    for (unsigned int i = 0; i < dir->count; i++) {
+        p = &dir->props[i];
+
+        if (!(PropFlags(p) & PROP_ISUNLOADED)) {
+            switch (PropType(p)) {
+                case PROP_STRTYP:
+                    bytes += strlen(PropDataStr(p)) + 1;
+                    break;
+                case PROP_LOKTYP:
+                    bytes += size_boolexp(PropDataLok(p));
+                    break;
+                default:
+                    break;
+            }
         }
+
+        bytes += size_proplist(PropDir(p));
     }
 
-    bytes += size_proplist(avl->left);
-    bytes += size_proplist(avl->right);
-    bytes += size_proplist(PropDir(avl));
     return bytes;
 }
 
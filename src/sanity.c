@@ -1124,7 +1124,7 @@ create_lostandfound(dbref * player, dbref * room)
     int player_name_len;
 
     *room = new_object(false);
-    NAME(*room) = alloc_string("lost+found");
+    NAME(*room) = alloc_interned("lost+found");
     LOCATION(*room) = GLOBAL_ENVIRONMENT;
     EXITS(*room) = NOTHING;
     DBFETCH(*room)->sp.room.dropto = NOTHING;
@@ -1151,7 +1151,7 @@ create_lostandfound(dbref * player, dbref * room)
     } else {
         const char *rpass;
         *player = new_object(true);
-        NAME(*player) = alloc_string(player_name);
+        NAME(*player) = alloc_interned(player_name);
         LOCATION(*player) = *room;
         FLAGS(*player) = TYPE_PLAYER | SANEBIT;
         OWNER(*player) = *player;
@@ -1318,7 +1318,7 @@ find_misplaced_objects(void)
         if (!NAME(loop) || !(*NAME(loop))) {
             switch OBJECT_TYPE(loop) {
                 case TYPE_GARBAGE:
-                    NAME(loop) = "<garbage>";
+                    NAME(loop) = alloc_interned("<garbage>");
                     break;
 
                 case TYPE_PLAYER: {
@@ -1334,14 +1334,14 @@ find_misplaced_objects(void)
                         }
                     }
 
-                    NAME(loop) = alloc_string(name);
+                    NAME(loop) = alloc_interned(name);
                     player_hash_add(loop);
                     free(name);
                     break;
                 }
 
                 default:
-                    NAME(loop) = alloc_string("Unnamed");
+                    NAME(loop) = alloc_interned("Unnamed");
             }
 
             SanFixed(loop, "Gave a name to %s");
@@ -1566,6 +1566,9 @@ do_sanfix(dbref player)
     adopt_orphans();
     clean_global_environment();
 
+    /* The fixes above edit owners and links directly */
+    db_reindex();
+
     for (dbref loop = 0; loop < db_top; loop++) {
         FLAGS(loop) &= ~SANEBIT;
     }
@@ -1691,7 +1694,7 @@ do_sanchange(dbref player, const char *command)
         SanPrint(player, "## Setting #%d's location to %s", d, unparse_buf);
     } else if (!strcasecmp(field, "owner")) {
         flag_unparse_object(NOTHING, OWNER(d), buf2, sizeof(buf2));
-        OWNER(d) = v;
+        db_set_owner(d, v);
         DBDIRTY(d);
         SanPrint(player, "## Setting #%d's owner to %s", d, unparse_buf);
     } else if (!strcasecmp(field, "home")) {
@@ -1709,7 +1712,7 @@ do_sanchange(dbref player, const char *command)
         }
 
         flag_unparse_object(NOTHING, *ip, buf2, sizeof(buf2));
-        *ip = v;
+        db_set_home(d, v);
         DBDIRTY(d);
         SanPrint(player, "## Setting #%d's home to: %s\n", d, unparse_buf);
     } else {
@@ -1837,25 +1840,26 @@ extract_prop(FILE * f, const char *dir, PropPtr p)
  * @param f the file handle to write to
  * @param obj the object to dump props for
  * @param dir the current propdir (should start with "/")
- * @param p the current prop pointer (should start with the root node)
+ * @param pdir the current propdir (should start with the root directory)
  */
 static void
-extract_props_rec(FILE * f, dbref obj, const char *dir, PropPtr p)
+extract_props_rec(FILE * f, dbref obj, const char *dir, PropDirPtr pdir)
 {
     char buf[BUFFER_LEN];
+    PropPtr p;
 
-    if (!p)
+    if (!pdir)
         return;
 
-    extract_props_rec(f, obj, dir, p->left);
-    extract_prop(f, dir, p);
+    for (unsigned int i = 0; i < pdir->count; i++) {
+        p = &pdir->props[i];
+        extract_prop(f, dir, p);
 
-    if (PropDir(p)) {
-        snprintf(buf, sizeof(buf), "%s%s%c", dir, PropName(p), PROPDIR_DELIMITER);
-        extract_props_rec(f, obj, buf, PropDir(p));
+        if (PropDir(p)) {
+            snprintf(buf, sizeof(buf), "%s%s%c", dir, PropName(p), PROPDIR_DELIMITER);
+            extract_props_rec(f, obj, buf, PropDir(p));
+        }
     }
-
-    extract_props_rec(f, obj, dir, p->right);
 }
 
 /**
@@ -102,10 +102,10 @@ do_name(int descr, dbref player, const char *name, char *newname)
     }
 
     /* everything ok, change the name */
-    free((void *) NAME(thing));
+    free_interned(NAME(thing));
 
     ts_modifyobject(thing);
-    NAME(thing) = alloc_string(newname);
+    NAME(thing) = alloc_interned(newname);
     notify(player, "Name set.");
     DBDIRTY(thing);
 }
@@ -157,10 +157,8 @@ _do_unlink(int descr, dbref player, const char *name, bool quiet)
                 }
 
                 ts_modifyobject(exit);
-                DBSTORE(exit, sp.exit.ndest, 0);
-
-                free(DBFETCH(exit)->sp.exit.dest);
-                DBSTORE(exit, sp.exit.dest, NULL);
+                db_set_exit_dests(exit, 0, NULL);
+                DBDIRTY(exit);
 
                 if (!quiet)
                     notify(player, "Unlinked.");
@@ -176,7 +174,8 @@ _do_unlink(int descr, dbref player, const char *name, bool quiet)
                 break;
             case TYPE_ROOM:
                 ts_modifyobject(exit);
-                DBSTORE(exit, sp.room.dropto, NOTHING);
+                db_set_dropto(exit, NOTHING);
+                DBDIRTY(exit);
 
                 if (!quiet)
                     notify(player, "Dropto removed.");
@@ -481,7 +480,7 @@ do_chown(int descr, dbref player, const char *name, const char *newowner)
             }
 
             ts_modifyobject(thing);
-            OWNER(thing) = OWNER(owner);
+            db_set_owner(thing, OWNER(owner));
             break;
         case TYPE_THING:
             if (!Wizard(OWNER(player)) && LOCATION(thing) != player) {
@@ -490,7 +489,7 @@ do_chown(int descr, dbref player, const char *name, const char *newowner)
             }
 
             ts_modifyobject(thing);
-            OWNER(thing) = OWNER(owner);
+            db_set_owner(thing, OWNER(owner));
             break;
         case TYPE_PLAYER:
             notify(player, "Players always own themselves.");
@@ -498,7 +497,7 @@ do_chown(int descr, dbref player, const char *name, const char *newowner)
         case TYPE_EXIT:
         case TYPE_PROGRAM:
             ts_modifyobject(thing);
-            OWNER(thing) = OWNER(owner);
+            db_set_owner(thing, OWNER(owner));
             break;
         case TYPE_GARBAGE:
             notify(player, "No one wants to own garbage.");
@@ -945,7 +944,8 @@ do_register(int descr, dbref player, char *arg1, const char *arg2)
     }
 
     if (!*arg2) {
-        PropPtr propadr, pptr;
+        PropPtr propadr;
+        PropDirPtr pptr;
         char dir[BUFFER_LEN+64], propname[BUFFER_LEN], detail[BUFFER_LEN+128];
         dbref detailref = -50, invalidref = -50;
 
@@ -960,7 +960,7 @@ do_register(int descr, dbref player, char *arg1, const char *arg2)
 
         propadr = first_prop(target, dir, &pptr, propname, sizeof(propname));
         while (propadr) {
-            char *strval;
+            const char *strval;
             snprintf(buf, sizeof(buf), "%s%c%s", dir, PROPDIR_DELIMITER, propname);
 
             if (!Prop_Hidden(buf) || Wizard(OWNER(player))) {
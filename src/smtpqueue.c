@@ -0,0 +1,430 @@
+/** @file smtpqueue.c
+ *
+ * Source for the outbound mail queue used by SMTP_SEND.
+ *
+ * Talking to a mail server can take a long time, especially if it is slow
+ * or unreachable, and the SMTP client library blocks while it does so.
+ * Rather than stall the whole MUCK, each queued mail is handed to a child
+ * process which sends it and writes a one byte status code back down a
+ * pipe.  The main loop watches those pipes and, when a job finishes, sends
+ * an "SMTP.<id>" event to the MUF program that queued it.
+ *
+ * Up to SMTP_QUEUE_WORKERS mails are sent at once; the rest wait in the
+ * queue, which holds at most SMTP_QUEUE_MAX jobs.
+ *
+ * Windows doesn't have fork(), so there the mail is sent right away and
+ * the event is delivered before SMTP_SEND returns.
+ *
+ * This file is part of Fuzzball MUCK.  Please see LICENSE.md for details.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+# include <fcntl.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+#include "config.h"
+
+#include "array.h"
+#include "fbsignal.h"
+#include "fbstrings.h"
+#include "game.h"
+#include "inst.h"
+#include "interp.h"
+#include "log.h"
+#include "mufevent.h"
+#include "netloop.h"
+#include "smtp.h"
+#include "smtpqueue.h"
+#include "timequeue.h"
+#include "tune.h"
+
+/*
+ * A mail waiting to be sent, or being sent.
+ */
+struct smtp_job {
+    struct smtp_job *next;  /* Next job in the queue */
+    int id;                 /* Job ID returned by SMTP_SEND */
+    int pid;                /* PID of the MUF program that queued it */
+    char *to;               /* Recipient email address */
+    char *to_name;          /* Recipient name, may be empty */
+    char *subject;          /* Subject line */
+    char *body;             /* Message body */
+#ifndef WIN32
+    int fd;                 /* Status pipe from the worker, or -1 */
+#endif
+};
+
+/**
+ * @private
+ * @var the ID given to the last job queued
+ */
+static int smtp_last_id = 0;
+
+/**
+ * @private
+ * @var the jobs waiting for a worker, oldest first
+ */
+static struct smtp_job *smtp_waiting = NULL;
+
+/**
+ * @private
+ * @var the last job in smtp_waiting, so new jobs can be appended quickly
+ */
+static struct smtp_job *smtp_waiting_tail = NULL;
+
+/**
+ * @private
+ * @var the number of jobs in smtp_waiting
+ */
+static int smtp_waiting_count = 0;
+
+#ifndef WIN32
+/**
+ * @private
+ * @var the jobs currently being sent by a worker
+ */
+static struct smtp_job *smtp_running[SMTP_QUEUE_WORKERS];
+#endif
+
+/**
+ * Free a mail job and all of its strings
+ *
+ * @private
+ * @param job the job to free
+ */
+static void
+smtp_job_free(struct smtp_job *job)
+{
+    free(job->to);
+    free(job->to_name);
+    free(job->subject);
+    free(job->body);
+    free(job);
+}
+
+/**
+ * Send a mail job using the current SMTP @tune settings
+ *
+ * This blocks until the mail is sent or the attempt fails.
+ *
+ * @private
+ * @param job the job to send
+ * @return an SMTP status code; SMTP_STATUS_OK on success
+ */
+static enum smtp_status_code
+smtp_job_send(struct smtp_job *job)
+{
+    struct smtp *smtp = NULL;
+    enum smtp_status_code rc;
+
+    /*
+     * This can support cert files as well, not sure what that is for or
+     * if we need it.  That's the NULL parameter here.
+     */
+    rc = smtp_open(tp_smtp_server, tp_smtp_port, tp_smtp_ssl_type,
+                   tp_smtp_no_verify_cert ? SMTP_NO_CERT_VERIFY : 0,
+                   NULL, &smtp);
+
+    if (rc == SMTP_STATUS_OK)
+        rc = smtp_auth(smtp, tp_smtp_auth_type, tp_smtp_user,
+                       tp_smtp_password);
+
+    if (rc == SMTP_STATUS_OK)
+        rc = smtp_address_add(smtp, SMTP_ADDRESS_FROM, tp_smtp_from_email,
+                              tp_smtp_from_name);
+
+    if (rc == SMTP_STATUS_OK)
+        rc = smtp_address_add(smtp, SMTP_ADDRESS_TO, job->to, job->to_name);
+
+    if (rc == SMTP_STATUS_OK)
+        rc = smtp_header_add(smtp, "Subject", job->subject);
+
+    if (rc == SMTP_STATUS_OK)
+        rc = smtp_mail(smtp, job->body);
+
+    if (rc == SMTP_STATUS_OK)
+        return smtp_close(smtp);
+
+    if (smtp)
+        smtp_close(smtp);
+
+    return rc;
+}
+
+/**
+ * Finish a mail job, logging any error and telling the MUF program
+ *
+ * The job is freed.
+ *
+ * @private
+ * @param job the job that finished
+ * @param error NULL if the mail was sent, otherwise why it was not
+ */
+static void
+smtp_job_finish(struct smtp_job *job, const char *error)
+{
+    struct frame *fr;
+
+    if (error) {
+        log_status("ERROR: email send failed: %s", error);
+    }
+
+    if ((fr = timequeue_pid_frame(job->pid))) {
+        char buf[32];
+        struct inst temp;
+
+        temp.type = PROG_ARRAY;
+        temp.data.array = new_array_dictionary(fr->pinning);
+        array_set_strkey_intval(&temp.data.array, "id", job->id);
+        array_set_strkey_intval(&temp.data.array, "status", error ? -2 : 0);
+        array_set_strkey_strval(&temp.data.array, "error", error ? error : "");
+
+        snprintf(buf, sizeof(buf), "SMTP.%d", job->id);
+        muf_event_add(fr, buf, &temp, 0);
+        CLEAR(&temp);
+    }
+
+    smtp_job_free(job);
+}
+
+#ifndef WIN32
+/**
+ * Start a worker process to send a mail job
+ *
+ * The worker is forked twice so that it is not our child and we never
+ * have to reap it; the intermediate process exits straight away.  The
+ * worker writes the SMTP status code down a pipe as a single byte, and
+ * the read end of that pipe is watched by the main loop.
+ *
+ * If the worker can't be started, the job is finished with an error.
+ *
+ * @private
+ * @param slot the smtp_running slot to put the job in
+ * @param job the job to start
+ */
+static void
+smtp_job_start(int slot, struct smtp_job *job)
+{
+    int fds[2];
+    pid_t child;
+    sigset_t chld, oldmask;
+
+    if (pipe(fds) == -1) {
+        smtp_job_finish(job, "Could not create a pipe for the mail worker.");
+        return;
+    }
+
+    /*
+     * Keep the SIGCHLD handler from reaping the intermediate process
+     * before we do.
+     */
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &chld, &oldmask);
+
+    if ((child = fork()) == 0) {
+        /* We are the intermediate process. */
+        close(fds[0]);
+
+        if (fork() == 0) {
+            /* We are the worker. */
+            unsigned char status;
+
+            forked_dump_process_flag = 1;
+            set_dumper_signals();
+            signal(SIGALRM, SIG_DFL);
+            sigemptyset(&chld);
+            sigprocmask(SIG_SETMASK, &chld, NULL);
+
+            /* Don't let a stuck mail server keep us around forever. */
+            alarm(SMTP_QUEUE_TIMEOUT);
+
+            status = (unsigned char) smtp_job_send(job);
+
+            if (write(fds[1], &status, 1) == -1) {
+                _exit(1);
+            }
+
+            _exit(0);
+        }
+
+        _exit(0);
+    }
+
+    close(fds[1]);
+
+    if (child > 0) {
+        while (waitpid(child, NULL, 0) == -1 && errno == EINTR) ;
+    }
+
+    sigprocmask(SIG_SETMASK, &oldmask, NULL);
+
+    if (child < 0) {
+        close(fds[0]);
+        smtp_job_finish(job, "Could not fork a mail worker.");
+        return;
+    }
+
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    job->fd = fds[0];
+    smtp_running[slot] = job;
+    netloop_set(job->fd, NETLOOP_READ);
+}
+
+/**
+ * Start waiting jobs while there are free worker slots
+ *
+ * @private
+ */
+static void
+smtp_queue_start_waiting(void)
+{
+    for (int slot = 0; slot < SMTP_QUEUE_WORKERS && smtp_waiting; slot++) {
+        struct smtp_job *job;
+
+        if (smtp_running[slot])
+            continue;
+
+        job = smtp_waiting;
+        smtp_waiting = job->next;
+        smtp_waiting_count--;
+
+        if (!smtp_waiting)
+            smtp_waiting_tail = NULL;
+
+        job->next = NULL;
+        smtp_job_start(slot, job);
+    }
+}
+#endif
+
+/**
+ * Add a mail to the outbound queue
+ *
+ * The current SMTP @tune settings are used to deliver the message.  If
+ * there is a free worker slot, delivery starts right away; otherwise the
+ * job waits in the queue until one frees up.
+ *
+ * When delivery finishes, an "SMTP.<id>" event is sent to the process
+ * in 'fr' if it is still around.  The event data is a dictionary with
+ * the keys "id", "status" (0 on success, -2 on failure) and "error".
+ *
+ * On Windows there are no worker processes, so the mail is sent before
+ * this call returns, but the event is delivered in the same way.
+ *
+ * @param fr the frame of the MUF program sending the mail
+ * @param to the recipient's email address
+ * @param to_name the recipient's name, which may be empty
+ * @param subject the subject line
+ * @param body the body of the message
+ * @return the job ID, which is always positive, or -2 if the queue is full
+ */
+int
+smtp_queue_add(struct frame *fr, const char *to, const char *to_name,
+               const char *subject, const char *body)
+{
+    struct smtp_job *job;
+    int id;
+
+    if (smtp_waiting_count >= SMTP_QUEUE_MAX) {
+        log_status("ERROR: email send failed: the mail queue is full");
+        return -2;
+    }
+
+    if ((job = malloc(sizeof(struct smtp_job))) == NULL) {
+        panic("smtp_queue_add(): Out of memory");
+    }
+
+    if (smtp_last_id == INT_MAX)
+        smtp_last_id = 0;
+
+    id = ++smtp_last_id;
+
+    job->next = NULL;
+    job->id = id;
+    job->pid = fr->pid;
+    job->to = strdup(to);
+    job->to_name = strdup(to_name);
+    job->subject = strdup(subject);
+    job->body = strdup(body);
+
+    if (!job->to || !job->to_name || !job->subject || !job->body) {
+        panic("smtp_queue_add(): Out of memory");
+    }
+
+#ifdef WIN32
+    {
+        enum smtp_status_code rc = smtp_job_send(job);
+
+        smtp_job_finish(job, rc == SMTP_STATUS_OK ? NULL
+                             : smtp_status_code_errstr(rc));
+    }
+#else
+    job->fd = -1;
+
+    if (smtp_waiting_tail)
+        smtp_waiting_tail->next = job;
+    else
+        smtp_waiting = job;
+
+    smtp_waiting_tail = job;
+    smtp_waiting_count++;
+
+    /* This may finish the job straight away if a worker can't start. */
+    smtp_queue_start_waiting();
+#endif
+
+    return id;
+}
+
+/**
+ * Check for finished mail jobs and start waiting ones
+ *
+ * This is called from the main loop after the network event loop has
+ * waited, and looks at the status pipes of the running workers.
+ */
+void
+smtp_queue_process(void)
+{
+#ifndef WIN32
+    for (int slot = 0; slot < SMTP_QUEUE_WORKERS; slot++) {
+        struct smtp_job *job = smtp_running[slot];
+        unsigned char status;
+        ssize_t got;
+
+        if (!job || !(netloop_ready(job->fd) & NETLOOP_READ))
+            continue;
+
+        got = read(job->fd, &status, 1);
+
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK
+                        || errno == EINTR))
+            continue;
+
+        netloop_forget(job->fd);
+        close(job->fd);
+        smtp_running[slot] = NULL;
+
+        if (got != 1) {
+            smtp_job_finish(job, "Mail worker exited without sending.");
+        } else if (status != SMTP_STATUS_OK) {
+            smtp_job_finish(job, smtp_status_code_errstr(status));
+        } else {
+            smtp_job_finish(job, NULL);
+        }
+    }
+
+    smtp_queue_start_waiting();
+#endif
+}
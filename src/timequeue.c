@@ -59,7 +59,11 @@
  * An entry on the timequeue
  */
 typedef struct timenode {
-    struct timenode *next;  /* Linked list                               */
+    struct timenode *next;  /* Process list, in queue order              */
+    struct timenode *prev;  /* Previous entry on the process list        */
+    struct timenode *pid_next;  /* Next entry in the same PID hash chain */
+    int heap_index;         /* Position in the run heap, -1 if not in it */
+    unsigned long seq;      /* Queue order, breaks ties on 'when'        */
     int typ;                /* One of the TQ_*_TYP constants             */
     int subtyp;             /* One of the TQ_*_(!TYP) constants          */
     time_t when;            /* When the item should run next if sleeping */
@@ -108,9 +112,80 @@ typedef struct timenode {
 /**
  * @private
  * @var the head of the timequeue
+ *
+ * This list holds every process on the timequeue.  Timed entries come
+ * first in the order they were queued, followed by READ entries in the
+ * order they were queued.  The order in which timed entries actually run
+ * is kept by tq_heap.
  */
 static timequeue tqhead = NULL;
 
+/**
+ * @private
+ * @var the last entry on the timequeue list
+ */
+static timequeue tqtail = NULL;
+
+/**
+ * @private
+ * @var the first READ entry on the timequeue list, or NULL if none
+ */
+static timequeue tq_first_read = NULL;
+
+/**
+ * @private
+ * @var binary min-heap of timed entries, ordered by 'when' then 'seq'
+ */
+static timequeue *tq_heap = NULL;
+
+/**
+ * @private
+ * @var the number of entries in tq_heap
+ */
+static int tq_heap_count = 0;
+
+/**
+ * @private
+ * @var the allocated size of tq_heap
+ */
+static int tq_heap_size = 0;
+
+/**
+ * @private
+ * @var hash table of timequeue entries by PID (eventnum)
+ */
+static timequeue *tq_pid_table = NULL;
+
+/**
+ * @private
+ * @var the number of buckets in tq_pid_table; always a power of two
+ */
+static int tq_pid_table_size = 0;
+
+/**
+ * @private
+ * @var the number of entries in tq_pid_table
+ */
+static int tq_pid_count = 0;
+
+/**
+ * @private
+ * @var the number of timequeue entries per uid, indexed by dbref
+ */
+static int *tq_uid_counts = NULL;
+
+/**
+ * @private
+ * @var the allocated size of tq_uid_counts
+ */
+static int tq_uid_counts_size = 0;
+
+/**
+ * @private
+ * @var the next sequence number to hand out to a timequeue entry
+ */
+static unsigned long tq_next_seq = 0;
+
 /**
  * @private
  * @var number of items on time queue
@@ -129,6 +204,378 @@ static timequeue free_timenode_list = NULL;
  */
 static int free_timenode_count = 0;
 
+/**
+ * Does timequeue entry 'a' run before timequeue entry 'b'?
+ *
+ * Entries run in order of their 'when' time.  Entries with the same time
+ * run in the order they were queued.
+ *
+ * @private
+ * @param a the first entry
+ * @param b the second entry
+ * @return boolean true if 'a' should run before 'b'
+ */
+static int
+tq_runs_before(timequeue a, timequeue b)
+{
+    if (a->when != b->when)
+        return a->when < b->when;
+
+    return a->seq < b->seq;
+}
+
+/**
+ * Store an entry at a given heap position and update its heap index
+ *
+ * @private
+ * @param i the heap position
+ * @param ptr the entry to put there
+ */
+static void
+tq_heap_place(int i, timequeue ptr)
+{
+    tq_heap[i] = ptr;
+    ptr->heap_index = i;
+}
+
+/**
+ * Move the heap entry at position i up until the heap is ordered
+ *
+ * @private
+ * @param i the heap position to sift up from
+ */
+static void
+tq_heap_sift_up(int i)
+{
+    timequeue ptr = tq_heap[i];
+
+    while (i > 0 && tq_runs_before(ptr, tq_heap[(i - 1) / 2])) {
+        tq_heap_place(i, tq_heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+
+    tq_heap_place(i, ptr);
+}
+
+/**
+ * Move the heap entry at position i down until the heap is ordered
+ *
+ * @private
+ * @param i the heap position to sift down from
+ */
+static void
+tq_heap_sift_down(int i)
+{
+    timequeue ptr = tq_heap[i];
+    int child;
+
+    while ((child = i * 2 + 1) < tq_heap_count) {
+        if (child + 1 < tq_heap_count
+            && tq_runs_before(tq_heap[child + 1], tq_heap[child]))
+            child++;
+
+        if (!tq_runs_before(tq_heap[child], ptr))
+            break;
+
+        tq_heap_place(i, tq_heap[child]);
+        i = child;
+    }
+
+    tq_heap_place(i, ptr);
+}
+
+/**
+ * Add a timed entry to the run heap
+ *
+ * @private
+ * @param ptr the entry to add
+ */
+static void
+tq_heap_push(timequeue ptr)
+{
+    if (tq_heap_count >= tq_heap_size) {
+        tq_heap_size = tq_heap_size ? tq_heap_size * 2 : 64;
+        tq_heap = realloc(tq_heap, sizeof(timequeue) * (size_t)tq_heap_size);
+
+        if (!tq_heap) {
+            panic("tq_heap_push(): Out of memory");
+        }
+    }
+
+    tq_heap_place(tq_heap_count, ptr);
+    tq_heap_sift_up(tq_heap_count++);
+}
+
+/**
+ * Remove an entry from the run heap
+ *
+ * @private
+ * @param ptr the entry to remove; it must be on the heap
+ */
+static void
+tq_heap_remove(timequeue ptr)
+{
+    int i = ptr->heap_index;
+    timequeue last = tq_heap[--tq_heap_count];
+
+    ptr->heap_index = -1;
+
+    if (last == ptr)
+        return;
+
+    tq_heap_place(i, last);
+
+    if (i > 0 && tq_runs_before(last, tq_heap[(i - 1) / 2])) {
+        tq_heap_sift_up(i);
+    } else {
+        tq_heap_sift_down(i);
+    }
+}
+
+/**
+ * Get the PID hash bucket for a given PID
+ *
+ * @private
+ * @param pid the PID
+ * @return the bucket number in tq_pid_table
+ */
+static int
+tq_pid_bucket(int pid)
+{
+    return (int)(((unsigned int)pid * 2654435761U)
+                 & (unsigned int)(tq_pid_table_size - 1));
+}
+
+/**
+ * Add an entry to the PID hash, growing the table if needed
+ *
+ * Several entries may share a PID, such as a sleeping program and its
+ * timers, so each bucket is a chain.
+ *
+ * @private
+ * @param ptr the entry to add
+ */
+static void
+tq_pid_insert(timequeue ptr)
+{
+    int bucket;
+
+    if (tq_pid_count >= tq_pid_table_size) {
+        timequeue *old = tq_pid_table;
+        int oldsize = tq_pid_table_size;
+
+        tq_pid_table_size = oldsize ? oldsize * 2 : 64;
+        tq_pid_table = calloc((size_t)tq_pid_table_size, sizeof(timequeue));
+
+        if (!tq_pid_table) {
+            panic("tq_pid_insert(): Out of memory");
+        }
+
+        for (int i = 0; i < oldsize; i++) {
+            timequeue nxt;
+
+            for (timequeue tmp = old[i]; tmp; tmp = nxt) {
+                nxt = tmp->pid_next;
+                bucket = tq_pid_bucket(tmp->eventnum);
+                tmp->pid_next = tq_pid_table[bucket];
+                tq_pid_table[bucket] = tmp;
+            }
+        }
+
+        free(old);
+    }
+
+    bucket = tq_pid_bucket(ptr->eventnum);
+    ptr->pid_next = tq_pid_table[bucket];
+    tq_pid_table[bucket] = ptr;
+    tq_pid_count++;
+}
+
+/**
+ * Remove an entry from the PID hash
+ *
+ * @private
+ * @param ptr the entry to remove
+ */
+static void
+tq_pid_remove(timequeue ptr)
+{
+    timequeue *link = &tq_pid_table[tq_pid_bucket(ptr->eventnum)];
+
+    while (*link && *link != ptr)
+        link = &(*link)->pid_next;
+
+    if (*link) {
+        *link = ptr->pid_next;
+        tq_pid_count--;
+    }
+
+    ptr->pid_next = NULL;
+}
+
+/**
+ * Find the first timequeue entry with a given PID
+ *
+ * @private
+ * @param pid the PID to look for
+ * @return the entry or NULL if there is none
+ */
+static timequeue
+tq_find_pid(int pid)
+{
+    timequeue ptr;
+
+    if (!tq_pid_count)
+        return NULL;
+
+    ptr = tq_pid_table[tq_pid_bucket(pid)];
+
+    while (ptr && ptr->eventnum != pid)
+        ptr = ptr->pid_next;
+
+    return ptr;
+}
+
+/**
+ * Get the number of timequeue entries a given uid has
+ *
+ * @private
+ * @param uid the dbref to check
+ * @return the number of entries on the timequeue run by 'uid'
+ */
+static int
+tq_uid_count(dbref uid)
+{
+    if (uid < 0 || uid >= tq_uid_counts_size)
+        return 0;
+
+    return tq_uid_counts[uid];
+}
+
+/**
+ * Adjust the number of timequeue entries a given uid has
+ *
+ * @private
+ * @param uid the dbref to adjust
+ * @param delta the amount to adjust by
+ */
+static void
+tq_uid_adjust(dbref uid, int delta)
+{
+    if (uid < 0)
+        return;
+
+    if (uid >= tq_uid_counts_size) {
+        int newsize = tq_uid_counts_size ? tq_uid_counts_size : 256;
+
+        while (newsize <= uid)
+            newsize *= 2;
+
+        tq_uid_counts = realloc(tq_uid_counts, sizeof(int) * (size_t)newsize);
+
+        if (!tq_uid_counts) {
+            panic("tq_uid_adjust(): Out of memory");
+        }
+
+        memset(tq_uid_counts + tq_uid_counts_size, 0,
+               sizeof(int) * (size_t)(newsize - tq_uid_counts_size));
+        tq_uid_counts_size = newsize;
+    }
+
+    tq_uid_counts[uid] += delta;
+}
+
+/**
+ * Is this timequeue entry a MUF READ?
+ *
+ * @private
+ * @param ptr the entry to check
+ * @return boolean true if it is a READ entry
+ */
+static int
+tq_is_read(timequeue ptr)
+{
+    return ptr->typ == TQ_MUF_TYP && ptr->subtyp == TQ_MUF_READ;
+}
+
+/**
+ * Put a newly allocated entry on the timequeue
+ *
+ * READ entries go on the end of the list.  Everything else goes just
+ * before the first READ entry and onto the run heap.  The entry is
+ * also added to the PID hash and counted against its uid.
+ *
+ * @private
+ * @param ptr the entry to add
+ */
+static void
+tq_link(timequeue ptr)
+{
+    timequeue before = tq_is_read(ptr) ? NULL : tq_first_read;
+
+    ptr->seq = tq_next_seq++;
+    ptr->next = before;
+    ptr->prev = before ? before->prev : tqtail;
+
+    if (ptr->prev) {
+        ptr->prev->next = ptr;
+    } else {
+        tqhead = ptr;
+    }
+
+    if (before) {
+        before->prev = ptr;
+    } else {
+        tqtail = ptr;
+    }
+
+    if (tq_is_read(ptr)) {
+        if (!tq_first_read)
+            tq_first_read = ptr;
+    } else {
+        tq_heap_push(ptr);
+    }
+
+    tq_pid_insert(ptr);
+    tq_uid_adjust(ptr->uid, 1);
+}
+
+/**
+ * Take an entry off the timequeue without freeing it
+ *
+ * This undoes everything tq_link did.  The entry's 'next' pointer is left
+ * alone so that a caller walking the list can still step past it.
+ *
+ * @private
+ * @param ptr the entry to remove
+ */
+static void
+tq_unlink(timequeue ptr)
+{
+    if (ptr == tq_first_read)
+        tq_first_read = ptr->next;
+
+    if (ptr->prev) {
+        ptr->prev->next = ptr->next;
+    } else {
+        tqhead = ptr->next;
+    }
+
+    if (ptr->next) {
+        ptr->next->prev = ptr->prev;
+    } else {
+        tqtail = ptr->prev;
+    }
+
+    ptr->prev = NULL;
+
+    if (ptr->heap_index >= 0)
+        tq_heap_remove(ptr);
+
+    tq_pid_remove(ptr);
+    tq_uid_adjust(ptr->uid, -1);
+}
+
 /**
  * Allocate a timequeue node, initialize it, and return it
  *
@@ -149,14 +596,12 @@ static int free_timenode_count = 0;
  * @param strdata the string metadata - CANNOT be NULL
  * @param strcmd the string command/event name or NULL if not applicable
  * @param str3 more metadata or NULL
- * @param nextone the next timequeue entry or NULL
  * @return allocated timequeue entry
  */
 static timequeue
 alloc_timenode(int typ, int subtyp, time_t mytime, int descr, dbref player,
 	       dbref loc, dbref trig, dbref program, struct frame *fr,
-	       const char *strdata, const char *strcmd, const char *str3,
-           timequeue nextone)
+	       const char *strdata, const char *strcmd, const char *str3)
 {
     timequeue ptr;
 
@@ -181,7 +626,10 @@ alloc_timenode(int typ, int subtyp, time_t mytime, int descr, dbref player,
     ptr->command = alloc_string(strcmd);
     ptr->str3 = alloc_string(str3);
     ptr->eventnum = (fr) ? fr->pid : top_pid++;
-    ptr->next = nextone;
+    ptr->next = NULL;
+    ptr->prev = NULL;
+    ptr->pid_next = NULL;
+    ptr->heap_index = -1;
     return (ptr);
 }
 
@@ -247,8 +695,8 @@ free_timenode(timequeue ptr)
 /**
  * Function to purge the free_timenode_list
  *
- * This is only used by the MUCK shutdown sequence, if MEMORY_CLEANUP is
- * defined.
+ * This also frees the timequeue's run heap and lookup tables.  It is only
+ * used by the MUCK shutdown sequence, if MEMORY_CLEANUP is defined.
  */
 void
 purge_timenode_free_pool(void)
@@ -264,6 +712,16 @@ purge_timenode_free_pool(void)
 
     free_timenode_count = 0;
     free_timenode_list = NULL;
+
+    free(tq_heap);
+    free(tq_pid_table);
+    free(tq_uid_counts);
+    tq_heap = NULL;
+    tq_pid_table = NULL;
+    tq_uid_counts = NULL;
+    tq_heap_count = tq_heap_size = 0;
+    tq_pid_count = tq_pid_table_size = 0;
+    tq_uid_counts_size = 0;
 }
 #endif
 
@@ -290,11 +748,7 @@ purge_timenode_free_pool(void)
 int
 control_process(dbref player, int pid)
 {
-    timequeue ptr = tqhead;
-
-    while ((ptr) && (pid != ptr->eventnum)) {
-        ptr = ptr->next;
-    }
+    timequeue ptr = tq_find_pid(pid);
 
     /*
      * If the process isn't in the timequeue, that means it's waiting for an
@@ -333,8 +787,9 @@ control_process(dbref player, int pid)
  * The exception to this is for TQ_MUF_TYP events with a subtype of
  * TQ_MUF_READ or TQ_MUF_TIMER,
  *
- * Timequeue entries are sorted by their 'when' time, with READ entries
- * being on the end of the queue.
+ * Timequeue entries run in order of their 'when' time, and in the order
+ * they were added when the times are equal.  READ entries are kept on the
+ * end of the queue and are never run by time.
  *
  * @see alloc_timenode
  *
@@ -359,18 +814,8 @@ add_event(int event_typ, int subtyp, int dtime, int descr, dbref player,
           const char *strdata, const char *strcmd, const char *str3)
 {
     timequeue ptr;
-    timequeue lastevent = NULL;
     time_t rtime = time((time_t *) NULL) + (time_t) dtime;
-    int mypids = 0;
-
-    if (tqhead) {
-        for (ptr = tqhead, mypids = 0; ptr; ptr = ptr->next) {
-            if (ptr->uid == player)
-                mypids++;
-
-            lastevent = ptr;
-        }
-    }
+    int mypids = tq_uid_count(player);
 
     /*
      * Read events go on the end of the queue and don't count towards
@@ -381,18 +826,10 @@ add_event(int event_typ, int subtyp, int dtime, int descr, dbref player,
      */
     if (event_typ == TQ_MUF_TYP && subtyp == TQ_MUF_READ) {
         process_count++;
-
-        if (lastevent) {
-            lastevent->next = alloc_timenode(event_typ, subtyp, rtime, descr,
-                                             player, loc, trig, program, fr,
-                                             strdata, strcmd, str3, NULL);
-            return (lastevent->next->eventnum);
-        } else {
-            tqhead = alloc_timenode(event_typ, subtyp, rtime, descr,
-                                    player, loc, trig, program, fr,
-                                    strdata, strcmd, str3, NULL);
-            return (tqhead->eventnum);
-        }
+        ptr = alloc_timenode(event_typ, subtyp, rtime, descr, player, loc,
+                             trig, program, fr, strdata, strcmd, str3);
+        tq_link(ptr);
+        return (ptr->eventnum);
     }
 
     /*
@@ -413,35 +850,11 @@ add_event(int event_typ, int subtyp, int dtime, int descr, dbref player,
         }
     }
 
-    /* Increment the count, then figure out where it goes on the list. */
     process_count++;
-
-    if (!tqhead) {
-        tqhead = alloc_timenode(event_typ, subtyp, rtime, descr, player, loc,
-                                trig, program, fr, strdata, strcmd, str3,
-                                NULL);
-        return (tqhead->eventnum);
-    }
-
-    if (rtime < tqhead->when ||
-        (tqhead->typ == TQ_MUF_TYP && tqhead->subtyp == TQ_MUF_READ)) {
-        tqhead = alloc_timenode(event_typ, subtyp, rtime, descr, player, loc,
-                                trig, program, fr, strdata, strcmd, str3,
-                                tqhead);
-        return (tqhead->eventnum);
-    }
-
-    ptr = tqhead;
-    while (ptr && ptr->next && rtime >= ptr->next->when &&
-           !(ptr->next->typ == TQ_MUF_TYP &&
-             ptr->next->subtyp == TQ_MUF_READ)) {
-        ptr = ptr->next;
-    }
-
-    ptr->next = alloc_timenode(event_typ, subtyp, rtime, descr, player, loc,
-                               trig, program, fr, strdata, strcmd, str3,
-                               ptr->next);
-    return (ptr->next->eventnum);
+    ptr = alloc_timenode(event_typ, subtyp, rtime, descr, player, loc, trig,
+                         program, fr, strdata, strcmd, str3);
+    tq_link(ptr);
+    return (ptr->eventnum);
 }
 
 /**
@@ -687,7 +1100,7 @@ void
 handle_read_event(int descr, dbref player, const char *command)
 {
     struct frame *fr;
-    timequeue ptr, lastevent;
+    timequeue ptr;
     int flag, nothing_flag;
     int oldflags;
     dbref prog;
@@ -701,17 +1114,10 @@ handle_read_event(int descr, dbref player, const char *command)
     oldflags = FLAGS(player);
     FLAGS(player) &= ~(INTERACTIVE | READMODE);
 
-    ptr = tqhead;
-    lastevent = NULL;
-
-    while (ptr) {
-        if (ptr->typ == TQ_MUF_TYP && ptr->subtyp == TQ_MUF_READ
-            && ptr->uid == player) {
+    for (ptr = tq_first_read; ptr; ptr = ptr->next) {
+        if (ptr->uid == player) {
             break;
         }
-
-        lastevent = ptr;
-        ptr = ptr->next;
     }
 
     /*
@@ -737,30 +1143,17 @@ handle_read_event(int descr, dbref player, const char *command)
 
         prog = ptr->called_prog;
 
-        if (command) {
-            /* remove the READ timequeue node from the timequeue */
-            process_count--;
-
-            if (lastevent) {
-                lastevent->next = ptr->next;
-            } else {
-                tqhead = ptr->next;
-            }
-        }
-
-        /* remember next timequeue node, to check for more READs later */
-        lastevent = ptr;
-        ptr = ptr->next;
-
         /* Make SURE not to let the program frame get freed.  We need it. */
-        lastevent->fr = NULL;
+        ptr->fr = NULL;
 
         if (command) {
             /*
-             * Free up the READ timequeue node
-             * we just removed from the queue.
+             * Remove the READ timequeue node from the timequeue and free
+             * it up.
              */
-            free_timenode(lastevent);
+            process_count--;
+            tq_unlink(ptr);
+            free_timenode(ptr);
         }
 
         if (fr->brkpt.debugging && !fr->brkpt.isread) {
@@ -792,8 +1185,8 @@ handle_read_event(int descr, dbref player, const char *command)
                 return;
             }
 
-            if ((fr->argument.top >= STACK_SIZE) ||
-                (nothing_flag && fr->argument.top >= STACK_SIZE - 1)) {
+            if (!grow_argument_stack(fr, fr->argument.top +
+                                     (nothing_flag ? 2 : 1), 0)) {
                 /*
                  * Uh oh! That MUF program's stack is full!
                  * Print an error, free the frame, and exit.
@@ -832,14 +1225,10 @@ handle_read_event(int descr, dbref player, const char *command)
          * Check for any other READ events for this player.
          * If there are any, set the READ related flags.
          */
-        while (ptr) {
-            if (ptr->typ == TQ_MUF_TYP && ptr->subtyp == TQ_MUF_READ) {
-                if (ptr->uid == player) {
-                    FLAGS(player) |= (INTERACTIVE | READMODE);
-                }
+        for (ptr = tq_first_read; ptr; ptr = ptr->next) {
+            if (ptr->uid == player) {
+                FLAGS(player) |= (INTERACTIVE | READMODE);
             }
-
-            ptr = ptr->next;
         }
     }
 }
@@ -850,8 +1239,11 @@ handle_read_event(int descr, dbref player, const char *command)
  * This is called by next_muckevent.  @see next_muckevent
  *
  * This will run up to 10 events before returning.  It runs MPI or MUF
- * that is waiting on the queue.  Chances are, you don't want to run
- * this function, it pretty much exists just for next_muckevent
+ * that is waiting on the queue.  Events that are queued while this is
+ * running are left for the next call, even if they are already due, so
+ * that a program which keeps re-queueing itself cannot starve everything
+ * else.  Chances are, you don't want to run this function, it pretty much
+ * exists just for next_muckevent
  *
  * @param now the current UNIX timestamp
  */
@@ -860,24 +1252,15 @@ next_timequeue_event(time_t now)
 {
     struct frame *tmpfr;
     int tmpbl, tmpfg;
-    timequeue lastevent, event;
-    int maxruns = 0;
+    timequeue event;
+    int maxruns = 10;
     int forced_pid = 0;
+    unsigned long lastseq = tq_next_seq;
 
-    lastevent = tqhead;
-
-    while ((lastevent) && (now >= lastevent->when) && (maxruns < 10)) {
-        lastevent = lastevent->next;
-        maxruns++;
-    }
-
-    while (tqhead && (tqhead != lastevent) && (maxruns--)) {
-        if (tqhead->typ == TQ_MUF_TYP && tqhead->subtyp == TQ_MUF_READ) {
-            break;
-        }
-
-        event = tqhead;
-        tqhead = tqhead->next;
+    while (tq_heap_count && now >= tq_heap[0]->when
+           && tq_heap[0]->seq < lastseq && (maxruns--)) {
+        event = tq_heap[0];
+        tq_unlink(event);
         process_count--;
         forced_pid = event->eventnum;
         event->eventnum = 0;
@@ -981,21 +1364,13 @@ next_timequeue_event(time_t now)
 int
 in_timequeue(int pid)
 {
-    timequeue ptr = tqhead;
-
     if (!pid)
         return 0;
 
     if (muf_event_pid_frame(pid))
         return 1;
 
-    if (!tqhead)
-        return 0;
-
-    while ((ptr) && (ptr->eventnum != pid))
-        ptr = ptr->next;
-
-    if (ptr)
+    if (tq_find_pid(pid))
         return 1;
 
     return 0;
@@ -1011,7 +1386,7 @@ struct frame *
 timequeue_pid_frame(int pid)
 {
     struct frame *out = NULL;
-    timequeue ptr = tqhead;
+    timequeue ptr;
 
     if (!pid)
         return NULL;
@@ -1021,11 +1396,7 @@ timequeue_pid_frame(int pid)
     if (out != NULL)
         return out;
 
-    if (!tqhead)
-        return NULL;
-
-    while ((ptr) && (ptr->eventnum != pid))
-        ptr = ptr->next;
+    ptr = tq_find_pid(pid);
 
     if (ptr)
         return ptr->fr;
@@ -1037,9 +1408,9 @@ timequeue_pid_frame(int pid)
  * Return the seconds until the the next event will run
  *
  * This may be -1 if either the next event is is set to when = -1, or
- * if there is nothing on the queue.  It could be 0 if there is something
- * available to run immediately.  Otherwise, it will be the seconds until
- * the next run.
+ * if there is nothing on the queue waiting to run by time; READ entries
+ * are not counted.  It could be 0 if there is something available to run
+ * immediately.  Otherwise, it will be the seconds until the next run.
  *
  * @param now the current timestamp
  * @return seconds until next run, -1, or 0
@@ -1047,13 +1418,15 @@ timequeue_pid_frame(int pid)
 time_t
 next_event_time(time_t now)
 {
-    if (tqhead) {
-        if (tqhead->when == -1) {
+    if (tq_heap_count) {
+        timequeue next = tq_heap[0];
+
+        if (next->when == -1) {
             return (time_t)-1;
-        } else if (now >= tqhead->when) {
+        } else if (now >= next->when) {
             return 0;
         } else {
-            return ((time_t) (tqhead->when - now));
+            return ((time_t) (next->when - now));
         }
     }
 
@@ -1121,16 +1494,17 @@ do_process_status(dbref player)
     char runstr[SMALL_BUFFER_LEN];
     char inststr[SMALL_BUFFER_LEN];
     char cpustr[SMALL_BUFFER_LEN];
+    char memstr[SMALL_BUFFER_LEN];
     char progstr[SMALL_BUFFER_LEN];
     char prognamestr[SMALL_BUFFER_LEN];
     int count = 0;
     time_t rtime = time((time_t *) NULL);
     time_t etime;
     double pcnt;
-    char *strfmt = "**%10s %4s %4s %6s %4s %7s %-10.10s %-12s %.512s";
+    char *strfmt = "**%10s %4s %4s %6s %4s %4s %7s %-10.10s %-12s %.512s";
 
     notifyf_nolisten(player, strfmt, "PID", "Next", "Run", "KInst", "%CPU",
-                     "Prog#", "ProgName", "Player", "");
+                     "KMem", "Prog#", "ProgName", "Player", "");
 
     for (timequeue ptr = tqhead; ptr; ptr = ptr->next) {
         if (!Wizard(OWNER(player)) && ptr->uid != player &&
@@ -1176,6 +1550,14 @@ do_process_status(dbref player)
 
         snprintf(cpustr, sizeof(cpustr), "%4.1f", pcnt);
 
+        /* Memory held by the frame and its stacks, rounded up */
+        if (ptr->fr) {
+            snprintf(memstr, sizeof(memstr), "%lu",
+                     (unsigned long) ((frame_memory(ptr->fr) + 1023) / 1024));
+        } else {
+            strcpyn(memstr, sizeof(memstr), "--");
+        }
+
         /* Get the dbref! */
         if (ptr->fr) {
             /* if it's a program... */
@@ -1207,8 +1589,8 @@ do_process_status(dbref player)
         }
 
         (void) snprintf(buf, sizeof(buf), strfmt, pidstr, duestr, runstr,
-                        inststr, cpustr, progstr, prognamestr, NAME(ptr->uid),
-                        DoNull(ptr->called_data));
+                        inststr, cpustr, memstr, progstr, prognamestr,
+                        NAME(ptr->uid), DoNull(ptr->called_data));
 
         notify_nolisten(player, buf, 1);
         count++;
@@ -1300,7 +1682,7 @@ get_pidinfo(int pid, int pin)
     time_t etime = 0;
     double pcnt = 0.0;
 
-    timequeue ptr = tqhead;
+    timequeue ptr = tq_find_pid(pid);
     nw = new_array_dictionary(pin);
 
     while (ptr) {
@@ -1310,7 +1692,7 @@ get_pidinfo(int pid, int pin)
             }
         }
 
-        ptr = ptr->next;
+        ptr = ptr->pid_next;
     }
 
     if (ptr && (ptr->eventnum == pid) &&
@@ -1491,15 +1873,9 @@ dequeue_prog_real(dbref program, int killmode, const char *file, const int line)
          * If prev is NULL, we're still at the head of the list, so the
          * logic has to be slightly different.
          */
-        if (prev) {
-            prev->next = ptr->next;
-            free_timenode(ptr);
-            ptr = prev->next;
-        } else {
-            tqhead = ptr->next;
-            free_timenode(ptr);
-            ptr = tqhead;
-        }
+        tq_unlink(ptr);
+        free_timenode(ptr);
+        ptr = prev ? prev->next : tqhead;
 
         /* Common book-keeping */
         process_count--;
@@ -1549,10 +1925,8 @@ dequeue_prog_real(dbref program, int killmode, const char *file, const int line)
      * these flags off a user and we need to put them back if they're still
      * in a READ state?  Just an educated guess. (tanabi)
      */
-    for (ptr = tqhead; ptr; ptr = ptr->next) {
-        if (ptr->typ == TQ_MUF_TYP && ptr->subtyp == TQ_MUF_READ) {
-            FLAGS(ptr->uid) |= (INTERACTIVE | READMODE);
-        }
+    for (ptr = tq_first_read; ptr; ptr = ptr->next) {
+        FLAGS(ptr->uid) |= (INTERACTIVE | READMODE);
     }
 
     /*
@@ -1580,7 +1954,7 @@ dequeue_prog_real(dbref program, int killmode, const char *file, const int line)
 int
 dequeue_process(int pid)
 {
-    timequeue tmp, ptr;
+    timequeue ptr;
     int deqflag = 0; /* Used to indicate if we decremented process count */
 
     if (!pid)
@@ -1595,26 +1969,15 @@ dequeue_process(int pid)
         deqflag = 1;
     }
 
-    /* Loop and find items to kill */
-    tmp = ptr = tqhead;
-    while (ptr) {
-        if (pid == ptr->eventnum) {
-            if (tmp == ptr) {
-                tqhead = tmp = tmp->next;
-                free_timenode(ptr);
-                ptr = tmp;
-            } else {
-                tmp->next = ptr->next;
-                free_timenode(ptr);
-                ptr = tmp->next;
-            }
-
-            process_count--;
-            deqflag = 1;
-        } else {
-            tmp = ptr;
-            ptr = ptr->next;
-        }
+    /*
+     * Find items to kill.  Look the PID up again each time, since freeing
+     * a node can also dequeue that process's timers.
+     */
+    while ((ptr = tq_find_pid(pid))) {
+        tq_unlink(ptr);
+        free_timenode(ptr);
+        process_count--;
+        deqflag = 1;
     }
 
     /* If we didn't delete anything, there's nothing further to do */
@@ -1628,10 +1991,8 @@ dequeue_process(int pid)
      * these flags off a user and we need to put them back if they're still
      * in a READ state?  Just an educated guess. (tanabi)
      */
-    for (ptr = tqhead; ptr; ptr = ptr->next) {
-        if (ptr->typ == TQ_MUF_TYP && ptr->subtyp == TQ_MUF_READ) {
-            FLAGS(ptr->uid) |= (INTERACTIVE | READMODE);
-        }
+    for (ptr = tq_first_read; ptr; ptr = ptr->next) {
+        FLAGS(ptr->uid) |= (INTERACTIVE | READMODE);
     }
 
     return 1;
@@ -1651,7 +2012,7 @@ int
 dequeue_timers(int pid, char *id)
 {
     char buf[40];
-    timequeue tmp, ptr;
+    timequeue ptr, nxt;
 
     /*
      * TODO: This would be more useful if we kept track of how many things
@@ -1667,31 +2028,18 @@ dequeue_timers(int pid, char *id)
     if (id)
         snprintf(buf, sizeof(buf), "TIMER.%.30s", id);
 
-    tmp = ptr = tqhead;
+    for (ptr = tq_find_pid(pid); ptr; ptr = nxt) {
+        nxt = ptr->pid_next;
 
-    while (ptr) {
         if (pid == ptr->eventnum &&
             ptr->typ == TQ_MUF_TYP && ptr->subtyp == TQ_MUF_TIMER &&
             (!id || !strcmp(ptr->called_data, buf))) {
-            if (tmp == ptr) {
-                tqhead = tmp = tmp->next;
-                ptr->fr->timercount--;
-                ptr->fr = NULL;
-                free_timenode(ptr);
-                ptr = tmp;
-            } else {
-                tmp->next = ptr->next;
-                ptr->fr->timercount--;
-                ptr->fr = NULL;
-                free_timenode(ptr);
-                ptr = tmp->next;
-            }
-
+            tq_unlink(ptr);
+            ptr->fr->timercount--;
+            ptr->fr = NULL;
+            free_timenode(ptr);
             process_count--;
             deqflag = 1;
-        } else {
-            tmp = ptr;
-            ptr = ptr->next;
         }
     }
 
@@ -1722,8 +2070,7 @@ do_kill_process(int descr, dbref player, const char *arg1)
     int count;
     dbref match;
     struct match_data md;
-    timequeue tmp, ptr = tqhead;
-
+    timequeue ptr;
 
     if (*arg1 == '\0') {
         notify_nolisten(player, "What event do you want to dequeue?", 1);
@@ -1736,18 +2083,15 @@ do_kill_process(int descr, dbref player, const char *arg1)
             return;
         }
 
-        while (ptr) {
-            tmp = ptr;
-            tqhead = ptr = ptr->next;
-            free_timenode(tmp);
+        while ((ptr = tqhead)) {
+            tq_unlink(ptr);
 
             /* free_timenode can free other things on the list when cleaning up
                timers for a backgrounded process */
-            ptr = tqhead;
+            free_timenode(ptr);
             process_count--;
         }
 
-        tqhead = NULL;
         muf_event_dequeue(NOTHING, 0);
         notify_nolisten(player, "Time queue cleared.", 1);
     } else {
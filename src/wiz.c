@@ -21,15 +21,18 @@
 #include "diskprop.h"
 #endif
 #include "fbstrings.h"
+#include "fbtime.h"
 #include "flags.h"
 #include "game.h"
 #include "interface.h"
+#include "interp.h"
 #include "log.h"
 #include "match.h"
 #include "move.h"
 #include "mpi.h"
 #include "player.h"
 #include "predicates.h"
+#include "profile.h"
 #include "props.h"
 #include "tune.h"
 
@@ -334,7 +337,8 @@ blessprops_wildcard(dbref player, dbref thing, const char *dir,
     char buf[BUFFER_LEN+1];
     char buf2[BUFFER_LEN+11];
     char *ptr, *wldcrd;
-    PropPtr propadr, pptr;
+    PropPtr propadr;
+    PropDirPtr pptr;
     int i, cnt = 0;
     int recurse = 0;
 
@@ -623,7 +627,8 @@ do_force(int descr, dbref player, const char *what, char *command)
  * stats on what a given player owns.
  *
  * The stats returned are basic counts -- numbeer of rooms, objects, etc.
- * It loops over the entire DB to get this information.
+ * It loops over the entire DB to get this information.  The global stats
+ * also say how much sharing names and property values has saved.
  *
  * This does do permission checking
  *
@@ -669,6 +674,15 @@ do_stats(dbref player, const char *name)
 
     notifyf(player, "%7d total %s",
             stats[0], PLURALFORM(stats[0], "object", "objects"));
+
+    if (owner == NOTHING) {
+        size_t strings, uses, bytes, saved;
+
+        interned_stats(&strings, &uses, &bytes, &saved);
+        notifyf(player, "%7lu shared strings, used %lu times (%luk, %luk saved)",
+                (unsigned long) strings, (unsigned long) uses,
+                (unsigned long) (bytes / 1024), (unsigned long) (saved / 1024));
+    }
 }
 
 /**
@@ -1116,6 +1130,57 @@ do_topprofs(dbref player, char *arg1)
     notify_nolisten(player, "*Done*", 1);
 }
 
+/**
+ * Implementation of the \@profile command
+ *
+ * This controls the sampling profiler.  'arg' may be "start", "stop",
+ * "clear" or "write"; anything else shows whether the profiler is running
+ * and how many samples it has taken.  "write" saves the samples to the
+ * file named by the file_profile tune, in collapsed stack format.
+ *
+ * This does not do any permission checking.
+ *
+ * @param player the player doing the call
+ * @param arg the action to take
+ */
+void
+do_profile(dbref player, const char *arg)
+{
+    int running, stacks, written;
+    long samples;
+    time_t started;
+
+    if (!strcasecmp(arg, "start")) {
+        if (!profile_start()) {
+            notify(player, "The profiler is not available on this system.");
+            return;
+        }
+
+        notifyf(player, "Profiler started, sampling every %d ms of CPU time.",
+                tp_profile_sample_msec > 0 ? tp_profile_sample_msec : 1);
+    } else if (!strcasecmp(arg, "stop")) {
+        profile_stop();
+        notify(player, "Profiler stopped.");
+    } else if (!strcasecmp(arg, "clear")) {
+        profile_clear();
+        notify(player, "Profiler samples cleared.");
+    } else if (!strcasecmp(arg, "write")) {
+        if ((written = profile_write(tp_file_profile)) < 0) {
+            notifyf(player, "Unable to write %s.", tp_file_profile);
+        } else {
+            notifyf(player, "Wrote %d stack%s to %s.", written,
+                    written == 1 ? "" : "s", tp_file_profile);
+        }
+    } else {
+        started = profile_status(&running, &samples, &stacks);
+
+        notifyf(player, "Profiler %s: %ld sample%s in %d stack%s over %s.",
+                running ? "running" : "stopped", samples,
+                samples == 1 ? "" : "s", stacks, stacks == 1 ? "" : "s",
+                time_format_2(started ? time(NULL) - started : 0));
+    }
+}
+
 #ifndef NO_MEMORY_COMMAND
 /**
  * Implementation of \@memory command
@@ -1195,6 +1260,26 @@ do_memory(dbref who)
     }
 #endif      /* HAVE_MALLINFO */
 
+    {
+        size_t strings, uses, bytes, saved;
+
+        interned_stats(&strings, &uses, &bytes, &saved);
+        notifyf(who, "Shared strings:                %6lu", (unsigned long) strings);
+        notifyf(who, "Shared string uses:            %6lu", (unsigned long) uses);
+        notifyf(who, "Shared string memory:          %6luk", (unsigned long) (bytes / 1024));
+        notifyf(who, "Memory saved by sharing:       %6luk", (unsigned long) (saved / 1024));
+    }
+
+    {
+        int inuse, pooled;
+        size_t bytes;
+
+        frame_stats(&inuse, &pooled, &bytes);
+        notifyf(who, "MUF frames in use:             %6d", inuse);
+        notifyf(who, "MUF frames pooled:             %6d", pooled);
+        notifyf(who, "MUF frame memory:              %6luk", (unsigned long) (bytes / 1024));
+    }
+
 #ifdef MALLOC_PROFILING
     notify(who, "  ");
     CrT_summarize(who);
@@ -0,0 +1,87 @@
+"""Benchmark for MPI evaluation, with and without the compiled MPI cache.
+
+This is not part of the regular test run.  It starts a server, stores a
+handful of MPI strings typical of room descriptions and messages, and then
+times a MUF loop that runs each of them through do_parse_mesg (via
+PARSEPROP) many times, first with the mpi_compile_cache @tune parameter off
+and then with it on.
+
+Run it from the tests directory after building the server:
+
+    python3 bench_mpi.py [iterations]
+"""
+
+import re
+import sys
+
+import test_util
+
+ITERATIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 5000
+
+SAMPLES = {
+    'desc': '{if:{eq:{&cmd},look},A quiet room.,A room.} '
+            '{if:{awake:me},{name:me} looks around.,}'
+            ' Exits: {list:_exits,here}',
+    'succ': '{with:n,{add:{prop:visits,me},1},'
+            'You have been here {&n} time{if:{ne:{&n},1},s,}.}',
+    'math': '{with:t,0,{for:i,1,10,1,{set:t,{add:{&t},{mult:{&i},2}}}}'
+            '{&t}}',
+    'text': 'A long message without any MPI in it at all, just text that '
+            'do_parse_mesg still has to copy through on every evaluation.',
+}
+
+BENCH_PROGRAM = r'''@program bench.muf
+i
+: main
+  pop
+  { "desc" "succ" "math" "text" }list
+  foreach swap pop
+    var! prop
+    systime_precise
+    1 {iterations} 1 for pop
+      me @ "_bench/" prop @ strcat "(Bench)" 0 parseprop pop
+    repeat
+    systime_precise swap -
+    1000000.0 * {iterations} / "RESULT " prop @ strcat " " strcat
+    swap ftostr strcat me @ swap notify
+  repeat
+;
+.
+c
+q
+@set bench.muf=W
+@act bench=here
+@link bench=bench.muf
+'''
+
+
+class MpiBenchmark(test_util.ServerTestBase):
+    params = {'max_instr_count': 100000000, 'instr_slice': 100000000}
+
+    def _timings(self, tune):
+        setup = ''.join('@set me=_bench/{}:{}\n'.format(k, v)
+                        for k, v in SAMPLES.items())
+        setup += '@set me=visits:0\n'
+        setup += BENCH_PROGRAM.replace('{iterations}', str(ITERATIONS))
+        command = '{}@tune mpi_compile_cache={}\nbench\n'.format(setup, tune)
+        output = test_util._text(
+            test_util._asyncio_run(self._run_command(command.encode())))
+        return dict(re.findall(r'RESULT (\w+) ([0-9.]+)', output))
+
+    def test_benchmark(self):
+        before = self._timings('no')
+        self.setUp()
+        after = self._timings('yes')
+        report = ['{:6} {:>12} {:>12}'.format('prop', 'uncached us',
+                                              'cached us')]
+
+        for name in SAMPLES:
+            report.append('{:6} {:>12.2f} {:>12.2f}'.format(
+                name, float(before[name]), float(after[name])))
+
+        sys.__stdout__.write('\n' + '\n'.join(report) + '\n')
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main(argv=sys.argv[:1])
@@ -0,0 +1,117 @@
+"""Micro-benchmarks for the MUF interpreter.
+
+This is not part of the regular test run.  It starts a server and times a
+few small MUF workloads -- a counting loop, string building, building
+4KB reports a line at a time with STRCAT, reading properties by constant
+paths, array building and walking, and dictionary building, lookup, and
+walking -- reporting how many instructions per second
+interp_loop ran for each, as counted by GETPIDINFO's INSTCNT.
+
+Run it from the tests directory after building the server:
+
+    python3 bench_muf.py [iterations]
+
+To compare dispatch modes, build once with MUF_THREADED_DISPATCH defined
+in config.h and once without.
+"""
+
+import re
+import sys
+
+import test_util
+
+ITERATIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+
+WORKLOADS = ['loop', 'string', 'report', 'props', 'array', 'dict']
+
+BENCH_PROGRAM = r'''@program bench.muf
+i
+: run-loop ( -- )
+  0 1 {iterations} 1 for + repeat pop
+;
+: run-string ( -- )
+  1 {iterations} 1 for intostr "item " swap strcat "m " instr pop repeat
+;
+: run-report ( -- )
+  1 {reports} 1 for pop
+    "" 1 64 1 for
+      intostr "Line " swap strcat
+      ": 0123456789012345678901234567890123456789012345678\r" strcat strcat
+    repeat pop
+  repeat
+;
+: run-props ( -- )
+  me @ "/bench/conf/name" "Bench" setprop
+  me @ "/bench/conf/count" 3 setprop
+  1 {iterations} 1 for pop
+    me @ "/bench/conf/name" getpropstr pop
+    me @ "/bench/conf/count" getpropval pop
+  repeat
+  me @ "/bench" remove_prop
+;
+: run-array ( -- )
+  { }list 1 {iterations} 1 for swap array_appenditem repeat
+  0 swap foreach swap pop + repeat pop
+;
+: run-dict ( -- )
+  { }dict 1 {iterations} 1 for
+    dup intostr "key" swap strcat rot swap array_setitem
+  repeat
+  1 {iterations} 1 for
+    intostr "KEY" swap strcat over swap array_getitem pop
+  repeat
+  0 swap foreach swap pop + repeat pop
+;
+: instcnt ( -- i )
+  pid getpidinfo "INSTCNT" array_getitem
+;
+: bench[ str:name addr:work -- ]
+  instcnt systime_precise
+  work @ execute
+  systime_precise swap - instcnt rot - swap
+  over intostr " " strcat rot float rot / ftostr strcat
+  "RESULT " name @ strcat " " strcat swap strcat me @ swap notify
+;
+: main
+  pop
+  "loop" 'run-loop bench
+  "string" 'run-string bench
+  "report" 'run-report bench
+  "props" 'run-props bench
+  "array" 'run-array bench
+  "dict" 'run-dict bench
+;
+.
+c
+q
+@set bench.muf=W
+@act bench=here
+@link bench=bench.muf
+'''
+
+
+class MufBenchmark(test_util.ServerTestBase):
+    params = {'max_instr_count': 2000000000, 'instr_slice': 2000000000}
+
+    def test_benchmark(self):
+        command = BENCH_PROGRAM.replace('{iterations}', str(ITERATIONS))
+        command = command.replace('{reports}',
+                                  str(max(1, ITERATIONS // 100)))
+        command += 'bench\n'
+        output = test_util._text(
+            test_util._asyncio_run(self._run_command(command.encode())))
+        results = {name: (int(count), float(rate)) for name, count, rate in
+                   re.findall(r'RESULT (\w+) (\d+) ([0-9.e+]+)', output)}
+        report = ['{:8} {:>12} {:>14}'.format('workload', 'instructions',
+                                              'instr/sec')]
+
+        for name in WORKLOADS:
+            count, rate = results[name]
+            report.append('{:8} {:>12} {:>14.0f}'.format(name, count, rate))
+
+        sys.__stdout__.write('\n' + '\n'.join(report) + '\n')
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main(argv=sys.argv[:1])
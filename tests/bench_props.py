@@ -0,0 +1,144 @@
+"""Memory and latency benchmark for property directories.
+
+This is not part of the regular test run.  It starts a server, makes a
+number of objects, and then gives each of them the sort of properties
+objects usually have: a description and success and fail messages under
+_/, a few top level props, and a small notes directory.  The growth of the
+server's resident set size over that step, divided by the number of
+properties set, is reported as the cost of a property.
+
+Then it fills one directory with a large number of properties and times
+getprop lookups in it and a nextprop walk over it.
+
+Run it from the tests directory after building the server:
+
+    python3 bench_props.py [objects] [directory size]
+
+The resident set size comes from /proc, so this only works on Linux.
+"""
+
+import re
+import sys
+
+import test_util
+
+OBJECTS = int(sys.argv[1]) if len(sys.argv) > 1 else 20000
+BIG_DIR = int(sys.argv[2]) if len(sys.argv) > 2 else 50000
+
+BENCH_PROGRAM = r'''@program bench.muf
+i
+: set-typical[ ref:obj -- ]
+  obj @ "_/de" "A plain, ordinary thing." setprop
+  obj @ "_/sc" "You pick it up." setprop
+  obj @ "_/osc" "picks it up." setprop
+  obj @ "_/fl" "You can't pick that up." setprop
+  obj @ "_/ofl" "tries to pick it up." setprop
+  obj @ "_/dr" "You drop it." setprop
+  obj @ "_/odr" "drops it." setprop
+  obj @ "@created" systime setprop
+  obj @ "weight" 5 setprop
+  obj @ "Notes/1" "First note." setprop
+  obj @ "Notes/2" "Second note." setprop
+  obj @ "Notes/3" "Third note." setprop
+;
+: make-objects ( -- )
+  1 {objects} 1 for
+    intostr "bench" swap strcat me @ swap newobject pop
+  repeat
+  "RESULT made" me @ swap notify
+;
+: set-props ( -- )
+  me @ contents begin dup ok? while
+    dup set-typical next
+  repeat pop
+  "RESULT props " {objects} 12 * intostr strcat me @ swap notify
+;
+: lookups ( -- )
+  1 {bigdir} 3 * 1 for
+    7919 * {bigdir} % 1 + intostr "/big/KEY" swap strcat
+    me @ swap getpropstr pop
+  repeat
+;
+: walk ( -- )
+  1 3 1 for pop
+    me @ "/big/" begin nextprop dup while me @ swap repeat pop
+  repeat
+;
+: time[ str:name addr:work -- ]
+  systime_precise work @ execute systime_precise swap -
+  {bigdir} 3 * float / 1000000000.0 * ftostr
+  "RESULT " name @ strcat " " strcat swap strcat me @ swap notify
+;
+: make-big ( -- )
+  1 {bigdir} 1 for
+    me @ over intostr "/big/key" swap strcat rot setprop
+  repeat
+  "lookup" 'lookups time
+  "walk" 'walk time
+;
+: main
+  dup "objects" strcmp not if pop make-objects exit then
+  dup "props" strcmp not if pop set-props exit then
+  "big" strcmp not if make-big exit then
+;
+.
+c
+q
+@set bench.muf=W
+@act bench=here
+@link bench=bench.muf
+'''
+
+
+def rss(pid):
+    """Return the resident set size of a process in bytes."""
+    with open('/proc/{}/status'.format(pid)) as status:
+        kb = re.search(r'VmRSS:\s+(\d+) kB', status.read()).group(1)
+    return int(kb) * 1024
+
+
+class PropsBenchmark(test_util.ServerTestBase):
+    params = {'max_instr_count': 2000000000, 'instr_slice': 2000000000}
+
+    async def _step(self, command):
+        output = await self._write_and_await_prompt(
+            command + self.done_command_command, self.done_command_prompt)
+        return test_util._text(output)
+
+    async def _bench(self):
+        program = BENCH_PROGRAM.replace('{objects}', str(OBJECTS))
+        program = program.replace('{bigdir}', str(BIG_DIR))
+        results = {}
+
+        await self._start_and_connect()
+        try:
+            await self._step(program.encode())
+            await self._step(b'bench objects\n')
+            before = rss(self._process.pid)
+            output = await self._step(b'bench props\n')
+            count = int(re.search(r'RESULT props (\d+)', output).group(1))
+            results['bytes/prop'] = (rss(self._process.pid) - before) / count
+            output = await self._step(b'bench big\n')
+            for name, value in re.findall(r'RESULT (\w+) ([0-9.e+]+)',
+                                          output):
+                results[name + ' ns'] = float(value)
+            await self._finish()
+        finally:
+            if self._process:
+                self._process.kill()
+                await self._process.wait()
+        return results
+
+    def test_benchmark(self):
+        results = test_util._asyncio_run(self._bench())
+        report = ['{:12} {:>10}'.format('measure', 'value')]
+
+        for name in ['bytes/prop', 'lookup ns', 'walk ns']:
+            report.append('{:12} {:>10.1f}'.format(name, results[name]))
+
+        sys.__stdout__.write('\n' + '\n'.join(report) + '\n')
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main(argv=sys.argv[:1])
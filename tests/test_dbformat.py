@@ -0,0 +1,106 @@
+"""Tests for the binary database dump format.
+
+The binary format holds the same information as the text format, so a
+database converted to binary and back must come out exactly as it went in.
+These tests use -convert to move databases between the formats, and run a
+server from a binary dump it saved itself.
+"""
+
+import os
+import shutil
+import subprocess
+
+import test_util
+
+STARTER_DATABASE = os.path.join(test_util.SOURCE_ROOT_DIR,
+                                'dbs/starterdb/data/starterdb.db')
+
+SETUP_COMMANDS = b'''@set me=_test/greeting:hello there
+@propset me=int:_test/number:42
+@propset me=dbref:_test/where:#0
+@lock me=me
+@create Widget
+'''
+
+CHECK_COMMANDS = b'''ex me=_test/
+ex me
+ex Widget
+'''
+
+
+class DatabaseFormatTest(test_util.ServerTestBase):
+    def setUp(self):
+        super().setUp()
+        # Most of these tests only run -convert, never a server.
+        self._process = None
+
+    def _convert(self, source, dest, dbformat):
+        subprocess.run([
+            test_util.SERVER_PATH,
+            '-convert',
+            '-dbformat', dbformat,
+            '-gamedir', self.game_dir,
+            '-dbin', source,
+            '-dbout', dest,
+        ], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, check=True)
+
+    def _read(self, path):
+        with open(path, 'rb') as fh:
+            return fh.read()
+
+    def _round_trip(self, database):
+        self._generate_files()
+        text = os.path.join(self.game_dir, 'text.db')
+        binary = os.path.join(self.game_dir, 'binary.db')
+        back = os.path.join(self.game_dir, 'back.db')
+
+        self._convert(database, text, 'text')
+        self._convert(text, binary, 'binary')
+        self._convert(binary, back, 'text')
+
+        self.assertTrue(self._read(binary).startswith(b'FBDBBIN\n'))
+        self.assertEqual(self._read(text), self._read(back))
+
+    def test_round_trip_minimal(self):
+        self._round_trip(self.input_database)
+
+    def test_round_trip_starter(self):
+        self._round_trip(STARTER_DATABASE)
+
+    def test_server_reloads_binary_dump(self):
+        self.params = {'dbdump_binary': 'yes'}
+        test_util._asyncio_run(self._run_command(SETUP_COMMANDS))
+
+        dump = os.path.join(self.game_dir, 'dbout')
+        self.assertTrue(self._read(dump).startswith(b'FBDBBIN\n'))
+
+        self.input_database = os.path.join(self.game_dir, 'saved.db')
+        shutil.copy(dump, self.input_database)
+        output = test_util._text(
+            test_util._asyncio_run(self._run_command(CHECK_COMMANDS)))
+
+        self.assertIn('str /_test/greeting:hello there', output)
+        self.assertIn('int /_test/number:42', output)
+        self.assertIn('ref /_test/where:', output)
+        self.assertRegex(output, r'Key: One\(#1')
+        self.assertRegex(output, r'Carrying:\r?\nWidget\(#2\)')
+        self.assertRegex(output, r'Location: One\(#1')
+
+    def test_truncated_binary_dump_fails(self):
+        self._generate_files()
+        binary = os.path.join(self.game_dir, 'binary.db')
+        truncated = os.path.join(self.game_dir, 'truncated.db')
+
+        self._convert(STARTER_DATABASE, binary, 'binary')
+
+        with open(truncated, 'wb') as fh:
+            fh.write(self._read(binary)[:-100])
+
+        with self.assertRaises(subprocess.CalledProcessError):
+            self._convert(truncated, os.path.join(self.game_dir, 'out.db'),
+                          'text')
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
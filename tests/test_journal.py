@@ -0,0 +1,86 @@
+"""Tests for the database change journal.
+
+Between dumps, changed objects are written to a journal next to the
+output database, and a server that is killed before it can dump replays
+the journal when it starts up again.  Killing the server and restarting it
+is more than the declarative command-cases can do.
+"""
+
+import asyncio
+import os
+import signal
+
+import test_util
+
+CHANGE_COMMANDS = b'''@set me=_journal/note:remember me
+@create Keepsake
+@create Rubbish
+@recycle Rubbish
+'''
+
+CHECK_COMMANDS = b'''ex me=_journal/
+ex #2
+ex #3
+'''
+
+
+class JournalTest(test_util.ServerTestBase):
+    params = {'dump_journal_interval': '1s'}
+
+    def _journal(self, suffix=''):
+        return os.path.join(self.game_dir, 'dbout.journal' + suffix)
+
+    def _change_and_crash(self):
+        async def run():
+            await self._start_and_connect()
+            await self._write_and_await_prompt(
+                CHANGE_COMMANDS + self.done_command_command,
+                self.done_command_prompt)
+
+            # Give the server time to write the changes to the journal.
+            await asyncio.sleep(2.5)
+
+            self._process.send_signal(signal.SIGKILL)
+            await asyncio.gather(self._process.wait(), self._stderr_future)
+            self._process = None
+
+        test_util._asyncio_run(run())
+
+    def _check(self):
+        return test_util._text(
+            test_util._asyncio_run(self._run_command(CHECK_COMMANDS)))
+
+    def test_replay_after_crash(self):
+        self._change_and_crash()
+        self.assertFalse(os.path.exists(os.path.join(self.game_dir, 'dbout')))
+        self.assertTrue(os.path.exists(self._journal()))
+
+        output = self._check()
+        self.assertIn('str /_journal/note:remember me', output)
+        self.assertIn('Keepsake(#2)', output)
+        self.assertIn('<garbage> is garbage.', output)
+
+        # A clean shutdown saves everything, so the journal goes away.
+        self.assertFalse(os.path.exists(self._journal()))
+        self.assertFalse(os.path.exists(self._journal('.old')))
+
+    def test_incomplete_batch_is_dropped(self):
+        self._change_and_crash()
+        size = os.path.getsize(self._journal())
+
+        # A batch that was cut short never got its length filled in.
+        with open(self._journal(), 'ab') as fh:
+            fh.write(b'*Batch* 0000000000\n4\n#2\nHalf written\n')
+
+        self.params = dict(self.params, dump_journal_interval='0s')
+        output = self._check()
+        self.assertIn('str /_journal/note:remember me', output)
+        self.assertIn('Keepsake(#2)', output)
+
+        with open(os.path.join(self.game_dir, 'logs/status')) as fh:
+            self.assertIn('Dropping', fh.read())
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
@@ -0,0 +1,55 @@
+"""Tests for the logger.
+
+Log lines are written by a background thread, so they have to be checked
+after the server has had a chance to write them, and rotating the logs
+means sending the server a signal.  Neither is something the declarative
+command-cases can do.
+"""
+
+import asyncio
+import os
+import signal
+
+import test_util
+
+
+class LogTest(test_util.ServerTestBase):
+    params = {'log_commands': 'yes', 'log_flush_msec': '0'}
+
+    def _log(self, name):
+        with open(os.path.join(self.game_dir, 'logs', name)) as fh:
+            return fh.read()
+
+    def _command(self, command):
+        return self._write_and_await_prompt(
+            command + self.done_command_command, self.done_command_prompt)
+
+    def test_lines_written_by_shutdown(self):
+        self.params = dict(self.params, log_flush_msec='60000')
+        test_util._asyncio_run(self._run_command(b'say First words\n'))
+        self.assertIn('say First words', self._log('commands'))
+
+    def test_reopen_on_sighup(self):
+        async def run():
+            await self._start_and_connect()
+            await self._command(b'say Before rotation\n')
+
+            # Give the writer time to catch up before moving the file.
+            await asyncio.sleep(0.5)
+            os.rename(os.path.join(self.game_dir, 'logs', 'commands'),
+                      os.path.join(self.game_dir, 'logs', 'commands.1'))
+            self._process.send_signal(signal.SIGHUP)
+
+            await self._command(b'say After rotation\n')
+            await self._finish()
+
+        test_util._asyncio_run(run())
+        self.assertIn('say Before rotation', self._log('commands.1'))
+        self.assertNotIn('say After rotation', self._log('commands.1'))
+        self.assertIn('say After rotation', self._log('commands'))
+        self.assertIn('Configuration reload requested', self._log('status'))
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
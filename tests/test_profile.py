@@ -0,0 +1,84 @@
+"""Tests for the sampling profiler.
+
+The profiler writes its samples to a file, and what it catches depends on
+how much CPU time the code it watches takes, so these tests run enough
+MUF and MPI to be sure of some samples and then read the file back.
+"""
+
+import os
+import re
+
+import test_util
+
+SPIN_PROGRAM = r'''@program prof.muf
+i
+: spin ( -- i )
+  0 1 2000 1 for + repeat
+;
+: main
+  pop
+  1 1500 1 for pop spin pop repeat
+  me @ "SPUN" notify
+;
+.
+c
+q
+@set prof.muf=W
+@act prof=here
+@link prof=prof.muf
+'''
+
+
+class ProfileTest(test_util.ServerTestBase):
+    params = {'profile_sample_msec': '1', 'mpi_max_commands': '1000000'}
+
+    def _profile(self):
+        with open(os.path.join(self.game_dir, 'logs', 'profile')) as fh:
+            return fh.read()
+
+    def test_samples_muf_and_mpi(self):
+        output = test_util._text(test_util._asyncio_run(self._run_command(
+            SPIN_PROGRAM.encode() +
+            b'@describe me={null:{for:i,1,500,1,{for:j,1,500,1,{add:1,2}}}}\n'
+            b'@profile start\n'
+            b'prof\n'
+            b'look me\n'
+            b'look me\n'
+            b'@profile stop\n'
+            b'@profile write\n'
+            b'@profile\n')))
+
+        self.assertIn('Profiler started', output)
+        self.assertIn('SPUN', output)
+        self.assertRegex(output, r'Wrote \d+ stacks? to logs/profile')
+        self.assertRegex(output, r'Profiler stopped: [1-9]\d* samples? in')
+
+        profile = self._profile()
+        lines = profile.splitlines()
+        self.assertTrue(lines)
+
+        for line in lines:
+            self.assertRegex(line, r'^\S.* [1-9]\d*$')
+
+        # MUF samples name the program and word of each frame, then the line.
+        self.assertRegex(profile, re.compile(
+            r'^prof\.muf\(#\d+\):main;prof\.muf\(#\d+\):spin;line \d+ \d+$',
+            re.MULTILINE))
+
+        # MPI samples name the object, then the running functions.
+        self.assertRegex(profile, re.compile(r'^One\(#1\);\{FOR\}',
+                                             re.MULTILINE))
+
+    def test_clear_keeps_running(self):
+        output = test_util._text(test_util._asyncio_run(self._run_command(
+            b'@profile start\n'
+            b'@profile clear\n'
+            b'@profile\n')))
+
+        self.assertIn('Profiler samples cleared.', output)
+        self.assertRegex(output, r'Profiler running: \d+ samples? in')
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
@@ -0,0 +1,62 @@
+"""Tests for looking up the host names of network connections.
+
+The command-cases only use the console connection, which is never looked
+up, so these open real connections to a port the server listens on.  The
+names end up in the DISCONNECT lines of the status log.  127.0.0.1 is
+expected to resolve to localhost, and nothing is expected to answer ident
+queries on it.
+"""
+
+import asyncio
+import os
+import re
+import socket
+
+import test_util
+
+CONNECTIONS = 20
+
+
+def _free_port():
+    with socket.socket() as s:
+        s.bind(('127.0.0.1', 0))
+        return s.getsockname()[1]
+
+
+class ResolverTest(test_util.ServerTestBase):
+    def setUp(self):
+        super().setUp()
+        self.port = _free_port()
+        self.server_args = ['-port', str(self.port)]
+
+    def _status_log(self):
+        with open(os.path.join(self.game_dir, 'logs', 'status')) as fh:
+            return fh.read()
+
+    def test_burst_of_connections_resolved(self):
+        async def run():
+            await self._start_and_connect()
+            streams = await asyncio.gather(*[
+                asyncio.open_connection('127.0.0.1', self.port)
+                for _ in range(CONNECTIONS)])
+
+            # Both lookups are local, so this leaves them plenty of time.
+            await asyncio.sleep(1)
+
+            for reader, writer in streams:
+                writer.close()
+
+            await asyncio.sleep(0.5)
+            await self._write_and_await_prompt(
+                self.done_command_command, self.done_command_prompt)
+            await self._finish()
+
+        test_util._asyncio_run(run())
+        hosts = re.findall(r'DISCONNECT: descriptor \d+ from (\S+)\(\d+\) '
+                           r'never connected', self._status_log())
+        self.assertEqual(hosts, ['localhost'] * CONNECTIONS)
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
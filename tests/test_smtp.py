@@ -0,0 +1,152 @@
+"""Tests for SMTP_SEND and the outbound mail queue.
+
+SMTP_SEND queues the mail and returns a job ID straight away; the mail is
+sent by a worker process and the calling program gets an "SMTP.<id>" event
+when it is done.  These tests point the server at a small stand-in SMTP
+listener running in a thread, so they need more than the declarative
+command-cases can offer.
+"""
+
+import re
+import socket
+import threading
+
+import test_util
+
+SEND_PROGRAM = r'''@program mail.muf
+i
+: main
+  pop
+  "bob@example.com" "Bob" "Hello there" { "line one" "line two" }list
+  smtp_send
+  dup intostr "QUEUED " swap strcat me @ swap notify
+  dup 0 > if
+    "SMTP." swap intostr strcat 1 array_make event_waitfor
+    "EVENT " swap strcat me @ swap notify
+    dup "status" [] intostr "STATUS " swap strcat me @ swap notify
+    "error" [] "ERROR " swap strcat me @ swap notify
+  else
+    pop
+  then
+  me @ "MAILDONE" notify
+;
+.
+c
+q
+@set mail.muf=W
+@act mail=here
+@link mail=mail.muf
+mail
+'''
+
+
+class StandInSmtpServer(threading.Thread):
+    """Accept SMTP connections on a local port and record each message."""
+
+    def __init__(self):
+        super().__init__(daemon=True)
+        self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.listener.bind(('127.0.0.1', 0))
+        self.listener.listen(5)
+        self.port = self.listener.getsockname()[1]
+        self.messages = []
+
+    def _session(self, conn):
+        reader = conn.makefile('rb')
+        conn.sendall(b'220 localhost stand-in\r\n')
+        message = {'rcpt': [], 'data': b''}
+
+        for line in reader:
+            command = line.strip().upper()
+
+            if command.startswith(b'EHLO') or command.startswith(b'HELO'):
+                conn.sendall(b'250 localhost\r\n')
+            elif command.startswith(b'MAIL FROM'):
+                message['from'] = line.strip()
+                conn.sendall(b'250 OK\r\n')
+            elif command.startswith(b'RCPT TO'):
+                message['rcpt'].append(line.strip())
+                conn.sendall(b'250 OK\r\n')
+            elif command == b'DATA':
+                conn.sendall(b'354 go ahead\r\n')
+
+                for data in reader:
+                    if data == b'.\r\n':
+                        break
+                    message['data'] += data
+
+                self.messages.append(message)
+                conn.sendall(b'250 queued\r\n')
+            elif command == b'QUIT':
+                conn.sendall(b'221 bye\r\n')
+                break
+            else:
+                conn.sendall(b'250 OK\r\n')
+
+    def run(self):
+        while True:
+            try:
+                conn, _ = self.listener.accept()
+            except OSError:
+                return
+
+            with conn:
+                self._session(conn)
+
+    def stop(self):
+        self.listener.close()
+
+
+class SmtpSendTest(test_util.ServerTestBase):
+    def _send(self, params):
+        self.params = dict(params, smtp_ssl_type=2, smtp_auth_type=1)
+
+        async def run():
+            await self._start_and_connect()
+            output = await self._write_and_await_prompt(
+                SEND_PROGRAM.encode(), b'MAILDONE')
+            await self._finish()
+            return test_util._text(output)
+
+        return test_util._asyncio_run(run())
+
+    def test_send_delivers_event(self):
+        server = StandInSmtpServer()
+        server.start()
+
+        try:
+            output = self._send({'smtp_server': '127.0.0.1',
+                                 'smtp_port': server.port})
+        finally:
+            server.stop()
+
+        job = re.search(r'QUEUED (\d+)', output).group(1)
+        self.assertGreater(int(job), 0)
+        self.assertIn('EVENT SMTP.' + job, output)
+        self.assertIn('STATUS 0', output)
+        self.assertEqual(len(server.messages), 1)
+        self.assertIn(b'bob@example.com', server.messages[0]['rcpt'][0])
+        self.assertIn(b'Subject: Hello there', server.messages[0]['data'])
+        self.assertIn(b'line one\r\nline two', server.messages[0]['data'])
+
+    def test_send_failure_delivers_event(self):
+        # Grab a port that nothing is listening on.
+        probe = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        probe.bind(('127.0.0.1', 0))
+        port = probe.getsockname()[1]
+        probe.close()
+
+        output = self._send({'smtp_server': '127.0.0.1', 'smtp_port': port})
+        job = re.search(r'QUEUED (\d+)', output).group(1)
+        self.assertIn('EVENT SMTP.' + job, output)
+        self.assertIn('STATUS -2', output)
+        self.assertRegex(output, r'ERROR \S')
+
+    def test_send_not_configured(self):
+        output = self._send({})
+        self.assertIn('QUEUED -1', output)
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
@@ -82,6 +82,9 @@ class ServerTestBase(unittest.TestCase):
     """@tune parameters to set via the -parmfile argument."""
     params = {}
 
+    """Extra command line arguments for the server, such as ports to listen on."""
+    server_args = []
+
     """Timezone to run the server in (via the TZ environment variable)."""
     timezone = 'UTC'
 
@@ -157,7 +160,7 @@ class ServerTestBase(unittest.TestCase):
            '-dbout', os.path.join(self.game_dir, 'dbout'),
            '-console',
            '-parmfile', 'test_parm_file',
-        ]
+        ] + list(self.server_args)
         my_env = os.environ.copy()
         my_env['MALLOC_CHECK_'] = '2'
         if self.timezone: